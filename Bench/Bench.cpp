@@ -0,0 +1,712 @@
+//
+// Bench.cpp
+// Microbenchmarks of FormatString, FormatStringF and ScanStringF against snprintf, sscanf, std::to_chars and std::from_chars
+//
+// Usage: Bench [filter] [--min-time=seconds] [--json=file] [--commit=id] [--no-counters]
+//   filter         Run only benchmarks whose name contains this text, eg. "format/f/" or "/snprintf"
+//   --min-time     Time spent on each benchmark, default 0.1 seconds
+//   --json         Also write the results as JSON, keyed by commit and benchmark name
+//   --commit       Commit recorded in the JSON, default the commit CMake found when configured
+//   --no-counters  Skip hardware performance counters
+//
+// Benchmarks are named <format|scan>/<conversion>/<variant>/<implementation>, each reports nanoseconds per
+// call and the bytes per second of output (format) or input (scan). Calls cycle through NUM_VALUES values
+// of mixed magnitude, so branches on digit counts and signs are not always predicted.
+//
+// Where perf_event_open is permitted (see PerfCounters.h) cycles, instructions, branch misses and L1 data
+// misses are counted around the timed loops only, and reported per call with instructions per cycle.
+// Otherwise the reason is printed once and only times are reported.
+//
+// Where an implementation has no exact equivalent the nearest is timed, eg. "%'.2f" for "{0:N2}" (no
+// grouping in the C locale), and combinations it can not express (eg. to_chars with a width) are skipped.
+// Conversion "m" is a fixed point decimal (Decimal64 in cents), timed against libc with the same value as a double.
+//
+// Known answers are checked before timing (see s_knownAnswers), Bench exits with 2 if any output is wrong so a fast
+// but incorrect conversion is never reported.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <charconv>
+#include <chrono>
+#include <vector>
+
+#include "../FormatStringLib/FormatString.h"
+#include "../FormatStringLib/FormatStringF.h"
+#include "../FormatStringLib/ScanStringF.h"
+#include "PerfCounters.h"
+
+#ifndef BENCH_COMMIT
+#define BENCH_COMMIT "unknown"
+#endif // BENCH_COMMIT
+
+USING_NAMESPACE_FORMATSTRINGLIB
+
+enum
+{
+  NUM_VALUES = 256,                               // Values cycled through, power of two
+  BUFFER_SIZE = 128,                              // Output buffer, large enough for every case
+  INPUT_SIZE = 64,                                // Scan input per value
+};
+
+enum ValueKind
+{
+  KIND_INT,                                       // fsInt64, signed and of every magnitude
+  KIND_UINT,                                      // fsUInt64
+  KIND_FLOAT,                                     // fsFloat64, 1e-6 to 1e9
+  KIND_STRING,
+  KIND_CHAR,
+  KIND_POINTER,
+  KIND_DECIMAL,                                   // Decimal64 in cents of the KIND_FLOAT values, libc gets them as fsFloat64
+};
+
+enum CharsMode
+{
+  CHARS_NONE,                                     // No std::to_chars / from_chars equivalent
+  CHARS_DECIMAL,
+  CHARS_HEX,
+  CHARS_FIXED,
+  CHARS_SCIENTIFIC,
+  CHARS_GENERAL,
+  CHARS_HEXFLOAT,                                 // Without the "0x" prefix
+};
+
+// One conversion with one alignment / precision combination, in the syntax of each implementation
+struct FormatCase
+{
+  const fsChar* m_conversion;
+  const fsChar* m_variant;
+  ValueKind m_kind;
+  const fsChar* m_braced;                         // FormatString, NULL if it has no equivalent
+  const fsChar* m_printf;                         // FormatStringF, NULL if it has no equivalent
+  const fsChar* m_libc;                           // snprintf
+  CharsMode m_chars;                              // std::to_chars
+  fsInt m_precision;                              // std::to_chars precision
+};
+
+struct ScanCase
+{
+  const fsChar* m_conversion;
+  const fsChar* m_variant;
+  ValueKind m_kind;
+  const fsChar* m_input;                          // snprintf format of the input text
+  const fsChar* m_scan;                           // ScanStringF
+  const fsChar* m_libc;                           // sscanf
+  CharsMode m_chars;                              // std::from_chars, ignores width
+};
+
+static const FormatCase s_formatCases[] =
+{
+  { "d", "plain",           KIND_INT,     "{0}",          "%d",       "%lld",     CHARS_DECIMAL,    0 },
+  { "d", "width",           KIND_INT,     "{0,12}",       "%12d",     "%12lld",   CHARS_NONE,       0 },
+  { "d", "left",            KIND_INT,     "{0,-12}",      "%-12d",    "%-12lld",  CHARS_NONE,       0 },
+  { "d", "precision",       KIND_INT,     "{0:D8}",       "%.8d",     "%.8lld",   CHARS_NONE,       0 },
+  { "d", "width_precision", KIND_INT,     "{0,12:D8}",    "%12.8d",   "%12.8lld", CHARS_NONE,       0 },
+  { "d", "length",          KIND_INT,     NULL,           "%lld",     "%lld",     CHARS_NONE,       0 },
+  { "d", "positional",      KIND_INT,     "{0}",          "%1$d",     "%1$lld",   CHARS_NONE,       0 },
+  { "x", "plain",           KIND_UINT,    "{0:x}",        "%x",       "%llx",     CHARS_HEX,        0 },
+  { "x", "width",           KIND_UINT,    "{0,12:x}",     "%12x",     "%12llx",   CHARS_NONE,       0 },
+  { "x", "left",            KIND_UINT,    "{0,-12:x}",    "%-12x",    "%-12llx",  CHARS_NONE,       0 },
+  { "x", "precision",       KIND_UINT,    "{0:x8}",       "%.8x",     "%.8llx",   CHARS_NONE,       0 },
+  { "x", "width_precision", KIND_UINT,    "{0,12:x8}",    "%12.8x",   "%12.8llx", CHARS_NONE,       0 },
+  { "f", "plain",           KIND_FLOAT,   "{0:F6}",       "%f",       "%f",       CHARS_FIXED,      6 },
+  { "f", "width",           KIND_FLOAT,   "{0,20:F6}",    "%20f",     "%20f",     CHARS_NONE,       0 },
+  { "f", "left",            KIND_FLOAT,   "{0,-20:F6}",   "%-20f",    "%-20f",    CHARS_NONE,       0 },
+  { "f", "precision",       KIND_FLOAT,   "{0:F2}",       "%.2f",     "%.2f",     CHARS_FIXED,      2 },
+  { "f", "width_precision", KIND_FLOAT,   "{0,20:F2}",    "%20.2f",   "%20.2f",   CHARS_NONE,       0 },
+  { "e", "plain",           KIND_FLOAT,   "{0:E6}",       "%e",       "%e",       CHARS_SCIENTIFIC, 6 },
+  { "e", "width",           KIND_FLOAT,   "{0,20:E6}",    "%20e",     "%20e",     CHARS_NONE,       0 },
+  { "e", "left",            KIND_FLOAT,   "{0,-20:E6}",   "%-20e",    "%-20e",    CHARS_NONE,       0 },
+  { "e", "precision",       KIND_FLOAT,   "{0:E2}",       "%.2e",     "%.2e",     CHARS_SCIENTIFIC, 2 },
+  { "e", "width_precision", KIND_FLOAT,   "{0,20:E2}",    "%20.2e",   "%20.2e",   CHARS_NONE,       0 },
+  { "g", "plain",           KIND_FLOAT,   "{0:G}",        "%g",       "%g",       CHARS_GENERAL,    6 },
+  { "g", "width",           KIND_FLOAT,   "{0,20:G}",     "%20g",     "%20g",     CHARS_NONE,       0 },
+  { "g", "left",            KIND_FLOAT,   "{0,-20:G}",    "%-20g",    "%-20g",    CHARS_NONE,       0 },
+  { "g", "precision",       KIND_FLOAT,   "{0:G4}",       "%.4g",     "%.4g",     CHARS_GENERAL,    4 },
+  { "g", "width_precision", KIND_FLOAT,   "{0,20:G4}",    "%20.4g",   "%20.4g",   CHARS_NONE,       0 },
+  { "a", "plain",           KIND_FLOAT,   "{0:a}",        "%a",       "%a",       CHARS_HEXFLOAT,   -1 },
+  { "a", "width",           KIND_FLOAT,   "{0,24:a}",     "%24a",     "%24a",     CHARS_NONE,       0 },
+  { "a", "precision",       KIND_FLOAT,   "{0:a4}",       "%.4a",     "%.4a",     CHARS_HEXFLOAT,   4 },
+  { "s", "plain",           KIND_STRING,  "{0}",          "%s",       "%s",       CHARS_NONE,       0 },
+  { "s", "width",           KIND_STRING,  "{0,20}",       "%20s",     "%20s",     CHARS_NONE,       0 },
+  { "s", "left",            KIND_STRING,  "{0,-20}",      "%-20s",    "%-20s",    CHARS_NONE,       0 },
+  { "s", "precision",       KIND_STRING,  NULL,           "%.5s",     "%.5s",     CHARS_NONE,       0 },
+  { "s", "width_precision", KIND_STRING,  NULL,           "%20.5s",   "%20.5s",   CHARS_NONE,       0 },
+  { "c", "plain",           KIND_CHAR,    "{0}",          "%c",       "%c",       CHARS_NONE,       0 },
+  { "c", "width",           KIND_CHAR,    "{0,5}",        "%5c",      "%5c",      CHARS_NONE,       0 },
+  { "c", "left",            KIND_CHAR,    "{0,-5}",       "%-5c",     "%-5c",     CHARS_NONE,       0 },
+  { "p", "plain",           KIND_POINTER, "{0}",          "%p",       "%p",       CHARS_NONE,       0 },
+  { "p", "width",           KIND_POINTER, "{0,20}",       "%20p",     "%20p",     CHARS_NONE,       0 },
+  { "p", "left",            KIND_POINTER, "{0,-20}",      "%-20p",    "%-20p",    CHARS_NONE,       0 },
+  { "N", "plain",           KIND_FLOAT,   "{0:N2}",       "%,.2f",    "%'.2f",    CHARS_FIXED,      2 },
+  { "N", "width",           KIND_FLOAT,   "{0,20:N2}",    "%,20.2f",  "%'20.2f",  CHARS_NONE,       0 },
+  { "N", "left",            KIND_FLOAT,   "{0,-20:N2}",   "%,-20.2f", "%'-20.2f", CHARS_NONE,       0 },
+  { "N", "precision",       KIND_FLOAT,   "{0:N0}",       "%,.0f",    "%'.0f",    CHARS_FIXED,      0 },
+  { "C", "plain",           KIND_FLOAT,   "{0:C}",        NULL,       "$%'.2f",   CHARS_FIXED,      2 },
+  { "C", "width",           KIND_FLOAT,   "{0,20:C}",     NULL,       "$%'19.2f", CHARS_NONE,       0 },
+  { "C", "precision",       KIND_FLOAT,   "{0:C0}",       NULL,       "$%'.0f",   CHARS_FIXED,      0 },
+  { "P", "plain",           KIND_FLOAT,   "{0:P}",        NULL,       "%.2f %%",  CHARS_FIXED,      2 },
+  { "P", "width",           KIND_FLOAT,   "{0,20:P}",     NULL,       "%18.2f %%", CHARS_NONE,      0 },
+  { "P", "precision",       KIND_FLOAT,   "{0:P0}",       NULL,       "%.0f %%",  CHARS_FIXED,      0 },
+  { "m", "plain",           KIND_DECIMAL, "{0:F}",        "%f",       "%.2f",     CHARS_NONE,       0 },
+  { "m", "width",           KIND_DECIMAL, "{0,20:F}",     "%20f",     "%20.2f",   CHARS_NONE,       0 },
+  { "m", "grouped",         KIND_DECIMAL, "{0:N}",        "%,f",      "%'.2f",    CHARS_NONE,       0 },
+};
+
+static const ScanCase s_scanCases[] =
+{
+  { "d", "plain",           KIND_INT,     "%lld",         "%d",       "%lld",     CHARS_DECIMAL },
+  { "d", "width",           KIND_INT,     "%lld",         "%8d",      "%8lld",    CHARS_NONE },
+  { "x", "plain",           KIND_UINT,    "%llx",         "%x",       "%llx",     CHARS_HEX },
+  { "x", "width",           KIND_UINT,    "%llx",         "%8x",      "%8llx",    CHARS_NONE },
+  { "f", "plain",           KIND_FLOAT,   "%f",           "%f",       "%lf",      CHARS_FIXED },
+  { "f", "width",           KIND_FLOAT,   "%f",           "%8f",      "%8lf",     CHARS_NONE },
+  { "e", "plain",           KIND_FLOAT,   "%e",           "%f",       "%lf",      CHARS_SCIENTIFIC },
+  { "g", "plain",           KIND_FLOAT,   "%g",           "%f",       "%lf",      CHARS_GENERAL },
+  { "a", "plain",           KIND_FLOAT,   "%a",           "%a",       "%la",      CHARS_HEXFLOAT },
+  { "m", "plain",           KIND_DECIMAL, "%.2f",         "%f",       "%lf",      CHARS_NONE },
+  { "s", "plain",           KIND_STRING,  "%s",           "%s",       "%63s",     CHARS_NONE },
+  { "s", "width",           KIND_STRING,  "%s",           "%5s",      "%5s",      CHARS_NONE },
+  { "c", "plain",           KIND_CHAR,    "%c",           "%c",       "%c",       CHARS_NONE },
+};
+
+// Values cycled through by every benchmark
+static fsInt64 s_ints[NUM_VALUES];
+static fsUInt64 s_uints[NUM_VALUES];
+static fsFloat64 s_floats[NUM_VALUES];
+static fsInt64 s_decimals[NUM_VALUES];            // Units of 0.01
+static fsFloat64 s_decimalFloats[NUM_VALUES];     // The same values as fsFloat64
+static const fsChar* s_strings[NUM_VALUES];
+static fsChar s_chars[NUM_VALUES];
+static const void* s_pointers[NUM_VALUES];
+static fsChar s_inputs[NUM_VALUES][INPUT_SIZE];   // Scan input of the current scan case
+
+static const fsChar* const s_words[] = { "a", "to", "the", "sale", "price", "moment", "printer", "register",
+                                         "formatted", "conversion", "bookkeeping", "microbenchmark", "x", "id" };
+
+static const fsChar* s_filter = NULL;
+static fsFloat64 s_minTime = 0.1;                 // Seconds per benchmark
+static volatile fsUInt64 s_sink;                  // Keeps results live
+
+// Measurements of one benchmark, kept for the JSON output
+struct BenchResult
+{
+  fsChar m_name[BUFFER_SIZE];
+  fsUInt64 m_calls;
+  fsUInt64 m_bytes;
+  fsFloat64 m_seconds;
+  fsBool m_counted;                               // m_counters were read
+  fsUInt64 m_counters[PerfCounters::NUM_COUNTERS];
+};
+
+static PerfCounters s_counters;
+static std::vector<BenchResult> s_results;
+
+
+// State passed to each timed call
+struct BenchContext
+{
+  const FormatCase* m_format;
+  const ScanCase* m_scan;
+  CompiledFormat m_compiled;
+  fsChar m_buffer[BUFFER_SIZE];
+};
+
+// One call for value a_index, returns the bytes output or scanned
+typedef size_t (*BenchFunc)(BenchContext& a_context, fsInt a_index);
+
+
+// xorshift64*, fixed seed so every run times the same values
+static fsUInt64 next_random()
+{
+  static fsUInt64 s_state = 0x9E3779B97F4A7C15ULL;
+  s_state ^= s_state >> 12;
+  s_state ^= s_state << 25;
+  s_state ^= s_state >> 27;
+  return s_state * 0x2545F4914F6CDD1DULL;
+}
+
+
+static void init_values()
+{
+  static const fsFloat64 s_scales[] = { 1e-6, 1e-3, 1e-1, 1.0, 1e1, 1e2, 1e3, 1e4, 1e6, 1e9 };
+  for( fsInt index = 0; index < NUM_VALUES; ++index )
+  {
+    fsUInt64 random = next_random();
+    s_uints[index] = random >> (random % 60);     // Every number of digits
+    s_ints[index] = (random & 1) ? -(fsInt64)(s_uints[index] >> 1) : (fsInt64)(s_uints[index] >> 1);
+    fsFloat64 mantissa = (fsFloat64)(next_random() >> 11) / (fsFloat64)(1ULL << 53);
+    s_floats[index] = ((random & 2) ? -1.0 : 1.0) * mantissa * s_scales[(random >> 8) % 10];
+    s_decimals[index] = (fsInt64)(s_floats[index] * 100.0);
+    s_decimalFloats[index] = (fsFloat64)s_decimals[index] / 100.0;
+    s_strings[index] = s_words[(random >> 16) % (sizeof(s_words) / sizeof(s_words[0]))];
+    s_chars[index] = (fsChar)('!' + (random >> 24) % 94);
+    s_pointers[index] = (const void*)(size_t)(random & ~(fsUInt64)7);
+  }
+}
+
+
+static Arg value_arg(ValueKind a_kind, fsInt a_index)
+{
+  switch( a_kind )
+  {
+  case KIND_INT:      return Arg(s_ints[a_index]);
+  case KIND_UINT:     return Arg(s_uints[a_index]);
+  case KIND_FLOAT:    return Arg(s_floats[a_index]);
+  case KIND_STRING:   return Arg(s_strings[a_index]);
+  case KIND_CHAR:     return Arg(s_chars[a_index]);
+  case KIND_DECIMAL:  return Arg(Decimal64(s_decimals[a_index], 2));
+  default:            return Arg(s_pointers[a_index]);
+  }
+}
+
+
+static fsInt libc_format(fsChar* a_str, const fsChar* a_fmt, ValueKind a_kind, fsInt a_index)
+{
+  switch( a_kind )
+  {
+  case KIND_INT:      return snprintf(a_str, BUFFER_SIZE, a_fmt, (long long)s_ints[a_index]);
+  case KIND_UINT:     return snprintf(a_str, BUFFER_SIZE, a_fmt, (unsigned long long)s_uints[a_index]);
+  case KIND_FLOAT:    return snprintf(a_str, BUFFER_SIZE, a_fmt, s_floats[a_index]);
+  case KIND_STRING:   return snprintf(a_str, BUFFER_SIZE, a_fmt, s_strings[a_index]);
+  case KIND_CHAR:     return snprintf(a_str, BUFFER_SIZE, a_fmt, s_chars[a_index]);
+  case KIND_DECIMAL:  return snprintf(a_str, BUFFER_SIZE, a_fmt, s_decimalFloats[a_index]);
+  default:            return snprintf(a_str, BUFFER_SIZE, a_fmt, s_pointers[a_index]);
+  }
+}
+
+
+static size_t bench_format_string(BenchContext& a_context, fsInt a_index)
+{
+  return FormatString(a_context.m_buffer, BUFFER_SIZE, a_context.m_format->m_braced, value_arg(a_context.m_format->m_kind, a_index));
+}
+
+
+static size_t bench_format_string_compiled(BenchContext& a_context, fsInt a_index)
+{
+  return FormatString(a_context.m_buffer, BUFFER_SIZE, a_context.m_compiled, value_arg(a_context.m_format->m_kind, a_index));
+}
+
+
+static size_t bench_format_string_f(BenchContext& a_context, fsInt a_index)
+{
+  return FormatStringF(a_context.m_buffer, BUFFER_SIZE, a_context.m_format->m_printf, value_arg(a_context.m_format->m_kind, a_index));
+}
+
+
+static size_t bench_format_string_f_compiled(BenchContext& a_context, fsInt a_index)
+{
+  return FormatStringF(a_context.m_buffer, BUFFER_SIZE, a_context.m_compiled, value_arg(a_context.m_format->m_kind, a_index));
+}
+
+
+static size_t bench_snprintf(BenchContext& a_context, fsInt a_index)
+{
+  return libc_format(a_context.m_buffer, a_context.m_format->m_libc, a_context.m_format->m_kind, a_index);
+}
+
+
+static size_t bench_to_chars(BenchContext& a_context, fsInt a_index)
+{
+  fsChar* first = a_context.m_buffer;
+  fsChar* last = a_context.m_buffer + BUFFER_SIZE - 1;
+  fsInt precision = a_context.m_format->m_precision;
+  std::to_chars_result result;
+  switch( a_context.m_format->m_chars )
+  {
+  case CHARS_DECIMAL:     result = std::to_chars(first, last, s_ints[a_index]); break;
+  case CHARS_HEX:         result = std::to_chars(first, last, s_uints[a_index], 16); break;
+  case CHARS_FIXED:       result = std::to_chars(first, last, s_floats[a_index], std::chars_format::fixed, precision); break;
+  case CHARS_SCIENTIFIC:  result = std::to_chars(first, last, s_floats[a_index], std::chars_format::scientific, precision); break;
+  case CHARS_HEXFLOAT:    result = (precision < 0) ? std::to_chars(first, last, s_floats[a_index], std::chars_format::hex)
+                                                   : std::to_chars(first, last, s_floats[a_index], std::chars_format::hex, precision); break;
+  default:                result = std::to_chars(first, last, s_floats[a_index], std::chars_format::general, precision); break;
+  }
+  *result.ptr = 0;
+  return result.ptr - first;
+}
+
+
+static size_t bench_scan_string_f(BenchContext& a_context, fsInt a_index)
+{
+  const ScanCase& scan = *a_context.m_scan;
+  fsInt64 intValue = 0;
+  fsUInt64 uintValue = 0;
+  fsFloat64 floatValue = 0.0;
+  fsChar charValue = 0;
+  fsInt converted;
+  switch( scan.m_kind )
+  {
+  case KIND_INT:      converted = ScanStringF(s_inputs[a_index], scan.m_scan, &intValue); break;
+  case KIND_UINT:     converted = ScanStringF(s_inputs[a_index], scan.m_scan, &uintValue); break;
+  case KIND_FLOAT:    converted = ScanStringF(s_inputs[a_index], scan.m_scan, &floatValue); break;
+  case KIND_STRING:   converted = ScanStringF(s_inputs[a_index], scan.m_scan, a_context.m_buffer); break;
+  case KIND_DECIMAL:  converted = ScanStringF(s_inputs[a_index], scan.m_scan, Decimal64Ptr(&intValue, 2)); break;
+  default:            converted = ScanStringF(s_inputs[a_index], scan.m_scan, &charValue); break;
+  }
+  s_sink += converted + intValue + uintValue + (fsUInt64)floatValue + charValue;
+  return strlen(s_inputs[a_index]);
+}
+
+
+static size_t bench_sscanf(BenchContext& a_context, fsInt a_index)
+{
+  const ScanCase& scan = *a_context.m_scan;
+  long long intValue = 0;
+  unsigned long long uintValue = 0;
+  fsFloat64 floatValue = 0.0;
+  fsChar charValue = 0;
+  fsInt converted;
+  switch( scan.m_kind )
+  {
+  case KIND_INT:      converted = sscanf(s_inputs[a_index], scan.m_libc, &intValue); break;
+  case KIND_UINT:     converted = sscanf(s_inputs[a_index], scan.m_libc, &uintValue); break;
+  case KIND_FLOAT:
+  case KIND_DECIMAL:  converted = sscanf(s_inputs[a_index], scan.m_libc, &floatValue); break;
+  case KIND_STRING:   converted = sscanf(s_inputs[a_index], scan.m_libc, a_context.m_buffer); break;
+  default:            converted = sscanf(s_inputs[a_index], scan.m_libc, &charValue); break;
+  }
+  s_sink += converted + intValue + uintValue + (fsUInt64)floatValue + charValue;
+  return strlen(s_inputs[a_index]);
+}
+
+
+static size_t bench_from_chars(BenchContext& a_context, fsInt a_index)
+{
+  const fsChar* first = s_inputs[a_index];
+  const fsChar* last = first + strlen(first);
+  fsInt64 intValue = 0;
+  fsUInt64 uintValue = 0;
+  fsFloat64 floatValue = 0.0;
+  switch( a_context.m_scan->m_chars )
+  {
+  case CHARS_DECIMAL:     std::from_chars(first, last, intValue); break;
+  case CHARS_HEX:         std::from_chars(first, last, uintValue, 16); break;
+  case CHARS_FIXED:       std::from_chars(first, last, floatValue, std::chars_format::fixed); break;
+  case CHARS_SCIENTIFIC:  std::from_chars(first, last, floatValue, std::chars_format::scientific); break;
+  case CHARS_HEXFLOAT:    std::from_chars(first + 2, last, floatValue, std::chars_format::hex); break; // Past the "0x"
+  default:                std::from_chars(first, last, floatValue, std::chars_format::general); break;
+  }
+  s_sink += intValue + uintValue + (fsUInt64)floatValue;
+  return last - first;
+}
+
+
+// Time a_func until s_minTime has passed, in batches doubling from 16 calls, and print its row
+static void run_benchmark(const fsChar* a_group, const fsChar* a_conversion, const fsChar* a_variant, const fsChar* a_implementation,
+                          BenchFunc a_func, BenchContext& a_context)
+{
+  fsChar name[BUFFER_SIZE];
+  snprintf(name, sizeof(name), "%s/%s/%s/%s", a_group, a_conversion, a_variant, a_implementation);
+  if( (s_filter != NULL) && (strstr(name, s_filter) == NULL) )
+  {
+    return;
+  }
+
+  for( fsInt index = 0; index < NUM_VALUES; ++index ) // Warm up caches and branch predictors
+  {
+    s_sink += a_func(a_context, index);
+  }
+
+  fsUInt64 calls = 0;
+  fsUInt64 bytes = 0;
+  fsFloat64 elapsed = 0.0;
+  s_counters.Reset();
+  for( fsUInt64 batch = 16; elapsed < s_minTime; batch = (batch < (1 << 20)) ? (batch * 2) : batch )
+  {
+    s_counters.Start();
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for( fsUInt64 call = 0; call < batch; ++call )
+    {
+      bytes += a_func(a_context, (fsInt)((calls + call) & (NUM_VALUES - 1)));
+    }
+    elapsed += std::chrono::duration<fsFloat64>(std::chrono::steady_clock::now() - start).count();
+    s_counters.Stop();
+    calls += batch;
+  }
+  s_sink += bytes + (fsUInt8)a_context.m_buffer[0];
+
+  BenchResult result;
+  memcpy(result.m_name, name, sizeof(name));
+  result.m_calls = calls;
+  result.m_bytes = bytes;
+  result.m_seconds = elapsed;
+  result.m_counted = s_counters.Read(result.m_counters);
+  s_results.push_back(result);
+
+  printf("%-52s %10.1f %10.1f", name, elapsed * 1e9 / (fsFloat64)calls, (fsFloat64)bytes / elapsed / 1e6);
+  if( result.m_counted )
+  {
+    const fsUInt64* counters = result.m_counters;
+    fsFloat64 perCall = 1.0 / (fsFloat64)calls;
+    fsFloat64 ipc = counters[PerfCounters::COUNTER_CYCLES] ? (fsFloat64)counters[PerfCounters::COUNTER_INSTRUCTIONS] / (fsFloat64)counters[PerfCounters::COUNTER_CYCLES] : 0.0;
+    printf(" %10.1f %10.1f %6.2f %10.3f %10.3f", counters[PerfCounters::COUNTER_CYCLES] * perCall, counters[PerfCounters::COUNTER_INSTRUCTIONS] * perCall, ipc,
+           counters[PerfCounters::COUNTER_BRANCH_MISSES] * perCall, counters[PerfCounters::COUNTER_L1D_MISSES] * perCall);
+  }
+  printf("\n");
+}
+
+
+// Write s_results as JSON: {"commit": ..., "benchmarks": {"<name>": {...}, ...}}, counters absent if not counted.
+// Returns false if the file can not be written.
+static fsBool write_json(const fsChar* a_path, const fsChar* a_commit)
+{
+  FILE* file = fopen(a_path, "w");
+  if( file == NULL )
+  {
+    return false;
+  }
+
+  fprintf(file, "{\n  \"commit\": \"");
+  for( const fsChar* pos = a_commit; *pos; ++pos ) // Escape for a JSON string
+  {
+    fprintf(file, ((*pos == '"') || (*pos == '\\')) ? "\\%c" : ((fsUInt8)*pos < 0x20) ? "?" : "%c", *pos);
+  }
+  fprintf(file, "\",\n  \"min_time\": %g,\n  \"benchmarks\": {", s_minTime);
+  for( size_t index = 0; index < s_results.size(); ++index )
+  {
+    const BenchResult& result = s_results[index];
+    fprintf(file, "%s\n    \"%s\": {\"calls\": %llu, \"ns_per_op\": %.3f, \"bytes_per_s\": %.0f",
+            index ? "," : "", result.m_name, (unsigned long long)result.m_calls,
+            result.m_seconds * 1e9 / (fsFloat64)result.m_calls, (fsFloat64)result.m_bytes / result.m_seconds);
+    if( result.m_counted )
+    {
+      for( fsInt counter = 0; counter < PerfCounters::NUM_COUNTERS; ++counter )
+      {
+        if( s_counters.IsAvailable(counter) )
+        {
+          fprintf(file, ", \"%s_per_op\": %.4f", PerfCounters::GetName(counter), (fsFloat64)result.m_counters[counter] / (fsFloat64)result.m_calls);
+        }
+      }
+      if( s_counters.IsAvailable(PerfCounters::COUNTER_CYCLES) && s_counters.IsAvailable(PerfCounters::COUNTER_INSTRUCTIONS) &&
+          result.m_counters[PerfCounters::COUNTER_CYCLES] )
+      {
+        fprintf(file, ", \"ipc\": %.4f", (fsFloat64)result.m_counters[PerfCounters::COUNTER_INSTRUCTIONS] / (fsFloat64)result.m_counters[PerfCounters::COUNTER_CYCLES]);
+      }
+    }
+    fprintf(file, "}");
+  }
+  fprintf(file, "\n  }\n}\n");
+  return fclose(file) == 0;
+}
+
+
+static void run_format_case(const FormatCase& a_case)
+{
+  BenchContext context;
+  context.m_format = &a_case;
+  context.m_scan = NULL;
+  if( a_case.m_braced != NULL )
+  {
+    run_benchmark("format", a_case.m_conversion, a_case.m_variant, "FormatString", bench_format_string, context);
+    if( CompileFormatString(a_case.m_braced, context.m_compiled) )
+    {
+      run_benchmark("format", a_case.m_conversion, a_case.m_variant, "FormatString_compiled", bench_format_string_compiled, context);
+    }
+  }
+  if( a_case.m_printf != NULL )
+  {
+    run_benchmark("format", a_case.m_conversion, a_case.m_variant, "FormatStringF", bench_format_string_f, context);
+    if( CompileFormatStringF(a_case.m_printf, context.m_compiled) )
+    {
+      run_benchmark("format", a_case.m_conversion, a_case.m_variant, "FormatStringF_compiled", bench_format_string_f_compiled, context);
+    }
+  }
+  run_benchmark("format", a_case.m_conversion, a_case.m_variant, "snprintf", bench_snprintf, context);
+  if( a_case.m_chars != CHARS_NONE )
+  {
+    run_benchmark("format", a_case.m_conversion, a_case.m_variant, "to_chars", bench_to_chars, context);
+  }
+}
+
+
+static void run_scan_case(const ScanCase& a_case)
+{
+  for( fsInt index = 0; index < NUM_VALUES; ++index )
+  {
+    switch( a_case.m_kind )
+    {
+    case KIND_INT:      snprintf(s_inputs[index], INPUT_SIZE, a_case.m_input, (long long)s_ints[index]); break;
+    case KIND_UINT:     snprintf(s_inputs[index], INPUT_SIZE, a_case.m_input, (unsigned long long)s_uints[index]); break;
+    case KIND_FLOAT:    snprintf(s_inputs[index], INPUT_SIZE, a_case.m_input, s_floats[index]); break;
+    case KIND_DECIMAL:  snprintf(s_inputs[index], INPUT_SIZE, a_case.m_input, s_decimalFloats[index]); break;
+    case KIND_STRING:   snprintf(s_inputs[index], INPUT_SIZE, a_case.m_input, s_strings[index]); break;
+    default:            snprintf(s_inputs[index], INPUT_SIZE, a_case.m_input, s_chars[index]); break;
+    }
+  }
+
+  BenchContext context;
+  context.m_format = NULL;
+  context.m_scan = &a_case;
+  run_benchmark("scan", a_case.m_conversion, a_case.m_variant, "ScanStringF", bench_scan_string_f, context);
+  run_benchmark("scan", a_case.m_conversion, a_case.m_variant, "sscanf", bench_sscanf, context);
+  if( a_case.m_chars != CHARS_NONE )
+  {
+    run_benchmark("scan", a_case.m_conversion, a_case.m_variant, "from_chars", bench_from_chars, context);
+  }
+}
+
+
+// Outputs that are easy to get wrong quickly. Float32 fixed point rounds the exact value, not the shortest decimal:
+// 2.675f is 2.67499995 and 1.0005f is 1.00049996, while 0.125f is an exact tie and rounds half up.
+// Standard letters without a conversion ("R" or unknown) use the default format, they are not custom patterns.
+// Integers without a length modifier keep their own size, "%x" of fsInt32 -1 is not 64bit.
+struct KnownAnswer
+{
+  fsBool m_braced;                                // FormatString, else FormatStringF
+  const fsChar* m_format;
+  fsFloat32 m_value;
+  const fsChar* m_expected;
+};
+
+struct KnownIntAnswer
+{
+  fsBool m_braced;                                // FormatString, else FormatStringF
+  const fsChar* m_format;
+  fsInt32 m_value;
+  const fsChar* m_expected;
+};
+
+static const KnownAnswer s_knownAnswers[] =
+{
+  { false, "%.2f",    2.675f,   "2.67" },
+  { false, "%.3f",    1.0005f,  "1.000" },
+  { false, "%.2f",    -2.675f,  "-2.67" },
+  { false, "%.1f",    1.45f,    "1.5" },         // 1.45000005
+  { false, "%.2f",    0.125f,   "0.13" },
+  { false, "%.0f",    0.5f,     "1" },
+  { false, "%.0f",    9.5f,     "10" },
+  { false, "%.2f",    99.995f,  "100.00" },      // 99.9950027
+  { false, "%f",      0.1f,     "0.100000" },
+  { true,  "{0:F2}",  2.675f,   "2.67" },
+  { true,  "{0:F3}",  1.0005f,  "1.000" },
+  { true,  "{0:N2}",  1234.565f, "1,234.56" },   // 1234.56494
+  { true,  "{0:R}",   1.5f,     "1.5" },
+  { true,  "{0:Z}",   1.5f,     "1.5" },
+  { true,  "{0:Q2}",  1.5f,     "1.5" },
+};
+
+static const KnownIntAnswer s_knownIntAnswers[] =
+{
+  { true,  "{0:R}",   -3,       "-3" },
+  { true,  "{0:Z}",   -3,       "-3" },
+  { true,  "{0:Q2}",  -3,       "-3" },
+  { false, "%x",      -1,       "ffffffff" },
+  { false, "%u",      -1,       "4294967295" },
+  { false, "%d",      -1,       "-1" },
+};
+
+
+// Returns the number of wrong outputs, each reported
+static int check_known_answers()
+{
+  int numWrong = 0;
+  for( size_t index = 0; index < sizeof(s_knownAnswers) / sizeof(s_knownAnswers[0]); ++index )
+  {
+    const KnownAnswer& answer = s_knownAnswers[index];
+    fsChar buffer[64];
+    if( answer.m_braced )
+    {
+      FormatString(buffer, sizeof(buffer), answer.m_format, answer.m_value);
+    }
+    else
+    {
+      FormatStringF(buffer, sizeof(buffer), answer.m_format, answer.m_value);
+    }
+    if( strcmp(buffer, answer.m_expected) != 0 )
+    {
+      fprintf(stderr, "Wrong output: \"%s\" of %.9g is \"%s\", expected \"%s\"\n", answer.m_format, answer.m_value, buffer, answer.m_expected);
+      ++numWrong;
+    }
+  }
+  for( size_t index = 0; index < sizeof(s_knownIntAnswers) / sizeof(s_knownIntAnswers[0]); ++index )
+  {
+    const KnownIntAnswer& answer = s_knownIntAnswers[index];
+    fsChar buffer[64];
+    if( answer.m_braced )
+    {
+      FormatString(buffer, sizeof(buffer), answer.m_format, answer.m_value);
+    }
+    else
+    {
+      FormatStringF(buffer, sizeof(buffer), answer.m_format, answer.m_value);
+    }
+    if( strcmp(buffer, answer.m_expected) != 0 )
+    {
+      fprintf(stderr, "Wrong output: \"%s\" of %d is \"%s\", expected \"%s\"\n", answer.m_format, answer.m_value, buffer, answer.m_expected);
+      ++numWrong;
+    }
+  }
+  return numWrong;
+}
+
+
+int main(int argc, char* argv[])
+{
+  const fsChar* jsonPath = NULL;
+  const fsChar* commit = BENCH_COMMIT;
+  fsBool useCounters = true;
+  for( int arg = 1; arg < argc; ++arg )
+  {
+    if( strncmp(argv[arg], "--min-time=", 11) == 0 )
+    {
+      s_minTime = atof(argv[arg] + 11);
+    }
+    else if( strncmp(argv[arg], "--json=", 7) == 0 )
+    {
+      jsonPath = argv[arg] + 7;
+    }
+    else if( strncmp(argv[arg], "--commit=", 9) == 0 )
+    {
+      commit = argv[arg] + 9;
+    }
+    else if( strcmp(argv[arg], "--no-counters") == 0 )
+    {
+      useCounters = false;
+    }
+    else if( argv[arg][0] == '-' )
+    {
+      fprintf(stderr, "Usage: %s [filter] [--min-time=seconds] [--json=file] [--commit=id] [--no-counters]\n", argv[0]);
+      return 1;
+    }
+    else
+    {
+      s_filter = argv[arg];
+    }
+  }
+
+  if( check_known_answers() > 0 )
+  {
+    return 2;
+  }
+
+  const fsChar* counterError = NULL;
+  if( useCounters && !s_counters.Open(&counterError) )
+  {
+    fprintf(stderr, "Hardware counters unavailable: %s\n", counterError);
+  }
+
+  init_values();
+  printf("%-52s %10s %10s", "Benchmark", "ns/op", "MB/s");
+  if( s_counters.IsAnyAvailable() )
+  {
+    printf(" %10s %10s %6s %10s %10s", "cycles/op", "instr/op", "IPC", "brmiss/op", "L1miss/op");
+  }
+  printf("\n");
+  for( size_t index = 0; index < sizeof(s_formatCases) / sizeof(s_formatCases[0]); ++index )
+  {
+    run_format_case(s_formatCases[index]);
+  }
+  for( size_t index = 0; index < sizeof(s_scanCases) / sizeof(s_scanCases[0]); ++index )
+  {
+    run_scan_case(s_scanCases[index]);
+  }
+
+  if( (jsonPath != NULL) && !write_json(jsonPath, commit) )
+  {
+    fprintf(stderr, "Failed to write '%s'\n", jsonPath);
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,176 @@
+//
+// PerfCounters.cpp
+// Hardware performance counters of the calling thread for the benchmarks, through perf_event_open on Linux
+//
+
+#include <errno.h>
+#include <string.h>
+#include "PerfCounters.h"
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#define PERFCOUNTERS_LINUX 1
+#else // __linux__
+#define PERFCOUNTERS_LINUX 0
+#endif // __linux__
+
+static const fsChar* const s_names[PerfCounters::NUM_COUNTERS] = { "cycles", "instructions", "branch_misses", "l1d_misses" };
+
+
+#if PERFCOUNTERS_LINUX
+// Open one counter of this thread on any CPU, user space only, disabled until Start()
+static int open_counter(fsUInt32 a_type, fsUInt64 a_config, int a_groupFd)
+{
+  struct perf_event_attr attr;
+  memset(&attr, 0, sizeof(attr));
+  attr.size = sizeof(attr);
+  attr.type = a_type;
+  attr.config = a_config;
+  attr.disabled = (a_groupFd < 0) ? 1 : 0;      // Members follow the leader
+  attr.exclude_kernel = 1;
+  attr.exclude_hv = 1;
+  attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+  return (int)syscall(__NR_perf_event_open, &attr, 0, -1, a_groupFd, 0);
+}
+#endif // PERFCOUNTERS_LINUX
+
+
+PerfCounters::PerfCounters()
+{
+  m_leader = -1;
+  for( fsInt counter = 0; counter < NUM_COUNTERS; ++counter )
+  {
+    m_fds[counter] = -1;
+    m_groupIndex[counter] = -1;
+  }
+}
+
+
+PerfCounters::~PerfCounters()
+{
+#if PERFCOUNTERS_LINUX
+  for( fsInt counter = 0; counter < NUM_COUNTERS; ++counter )
+  {
+    if( m_fds[counter] >= 0 )
+    {
+      close(m_fds[counter]);
+    }
+  }
+#endif // PERFCOUNTERS_LINUX
+}
+
+
+fsBool PerfCounters::Open(const fsChar** a_error)
+{
+#if PERFCOUNTERS_LINUX
+  static const fsUInt32 s_types[NUM_COUNTERS] = { PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE, PERF_TYPE_HW_CACHE };
+  static const fsUInt64 s_configs[NUM_COUNTERS] =
+  {
+    PERF_COUNT_HW_CPU_CYCLES,
+    PERF_COUNT_HW_INSTRUCTIONS,
+    PERF_COUNT_HW_BRANCH_MISSES,
+    PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16),
+  };
+
+  int firstErrno = 0;
+  fsInt numInGroup = 0;
+  for( fsInt counter = 0; counter < NUM_COUNTERS; ++counter )
+  {
+    int fd = open_counter(s_types[counter], s_configs[counter], m_leader);
+    if( fd < 0 )
+    {
+      firstErrno = firstErrno ? firstErrno : errno;
+      continue;
+    }
+    m_fds[counter] = fd;
+    m_groupIndex[counter] = numInGroup++;
+    if( m_leader < 0 )
+    {
+      m_leader = fd;
+    }
+  }
+
+  if( (m_leader < 0) && (a_error != NULL) )
+  {
+    *a_error = ((firstErrno == EACCES) || (firstErrno == EPERM)) ? "not permitted, see /proc/sys/kernel/perf_event_paranoid" :
+               (firstErrno == ENOENT) || (firstErrno == EOPNOTSUPP) ? "no hardware counters (eg. virtual machine)" :
+               (firstErrno == ENOSYS) ? "perf_event_open not supported by the kernel" : strerror(firstErrno);
+  }
+  return m_leader >= 0;
+#else // PERFCOUNTERS_LINUX
+  if( a_error != NULL )
+  {
+    *a_error = "only supported on Linux";
+  }
+  return false;
+#endif // PERFCOUNTERS_LINUX
+}
+
+
+void PerfCounters::Reset()
+{
+#if PERFCOUNTERS_LINUX
+  if( m_leader >= 0 )
+  {
+    ioctl(m_leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+  }
+#endif // PERFCOUNTERS_LINUX
+}
+
+
+void PerfCounters::Start()
+{
+#if PERFCOUNTERS_LINUX
+  if( m_leader >= 0 )
+  {
+    ioctl(m_leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+  }
+#endif // PERFCOUNTERS_LINUX
+}
+
+
+void PerfCounters::Stop()
+{
+#if PERFCOUNTERS_LINUX
+  if( m_leader >= 0 )
+  {
+    ioctl(m_leader, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+  }
+#endif // PERFCOUNTERS_LINUX
+}
+
+
+fsBool PerfCounters::Read(fsUInt64* a_values) const
+{
+  memset(a_values, 0, NUM_COUNTERS * sizeof(fsUInt64));
+#if PERFCOUNTERS_LINUX
+  // PERF_FORMAT_GROUP layout: count, time enabled, time running, then one value per counter in open order
+  fsUInt64 data[3 + NUM_COUNTERS];
+  if( (m_leader < 0) || (read(m_leader, data, sizeof(data)) < (ssize_t)(3 * sizeof(fsUInt64))) || (data[2] == 0) )
+  {
+    return false; // Not readable, or the group was never scheduled
+  }
+
+  // Scale up for the time the group was multiplexed out
+  fsFloat64 scale = ((data[2] > 0) && (data[2] < data[1])) ? (fsFloat64)data[1] / (fsFloat64)data[2] : 1.0;
+  for( fsInt counter = 0; counter < NUM_COUNTERS; ++counter )
+  {
+    if( (m_groupIndex[counter] >= 0) && ((fsUInt64)m_groupIndex[counter] < data[0]) )
+    {
+      a_values[counter] = (fsUInt64)((fsFloat64)data[3 + m_groupIndex[counter]] * scale);
+    }
+  }
+  return true;
+#else // PERFCOUNTERS_LINUX
+  return false;
+#endif // PERFCOUNTERS_LINUX
+}
+
+
+const fsChar* PerfCounters::GetName(fsInt a_counter)
+{
+  return s_names[a_counter];
+}
@@ -0,0 +1,63 @@
+#ifndef PERFCOUNTERS_H
+#define PERFCOUNTERS_H
+
+//
+// PerfCounters.h
+// Hardware performance counters of the calling thread for the benchmarks, through perf_event_open on Linux
+//
+
+#include "../FormatStringLib/Utils.h"
+
+//
+// The counters are opened as one group so they cover the same instructions. Counters the CPU, kernel or
+// container does not allow (eg. perf_event_paranoid, virtual machines without a PMU) are left out, and on
+// other platforms none are available, so callers check IsAvailable() and report the rest.
+// Counts are scaled up when the kernel multiplexed the group with other events.
+//
+// Eg. PerfCounters counters;
+//     counters.Open();
+//     counters.Reset(); counters.Start(); ... counters.Stop();
+//     fsUInt64 values[PerfCounters::NUM_COUNTERS];
+//     counters.Read(values);
+//
+
+class PerfCounters
+{
+public:
+
+  enum Counter
+  {
+    COUNTER_CYCLES,
+    COUNTER_INSTRUCTIONS,
+    COUNTER_BRANCH_MISSES,
+    COUNTER_L1D_MISSES,                           // L1 data cache read misses
+    NUM_COUNTERS,
+  };
+
+  PerfCounters();
+  ~PerfCounters();
+
+  // Open the counters of this thread. Returns false if none are available, a_error describes why.
+  fsBool Open(const fsChar** a_error = NULL);
+
+  fsBool IsAvailable(fsInt a_counter) const       { return m_fds[a_counter] >= 0; }
+  fsBool IsAnyAvailable() const                   { return m_leader >= 0; }
+
+  // Zero, start and stop counting, counts accumulate over Start() / Stop() pairs
+  void Reset();
+  void Start();
+  void Stop();
+
+  // Counts since Reset(), 0 for counters not available. Returns false if none are available.
+  fsBool Read(fsUInt64* a_values) const;
+
+  static const fsChar* GetName(fsInt a_counter);
+
+protected:
+
+  int m_fds[NUM_COUNTERS];                        // -1 if not available
+  int m_leader;                                   // Group leader, first available counter, or -1
+  fsInt m_groupIndex[NUM_COUNTERS];               // Position of each counter in a group read
+};
+
+#endif //PERFCOUNTERS_H
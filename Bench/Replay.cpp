@@ -0,0 +1,392 @@
+//
+// Replay.cpp
+// Replay a corpus recorded by FormatRecorder through FormatString, FormatStringF and ScanStringF at full speed
+//
+// Usage: Replay corpus [--min-time=seconds] [--compiled] [--cache] [--json=file] [--commit=id] [--no-counters]
+//   --min-time     Time spent on each benchmark, default 1 second
+//   --compiled     Format through formats compiled once up front, as callers of CompileFormatString() do
+//   --cache        Enable the FormatCache while replaying
+//   --json         Also write the results as JSON, in the layout of Bench --json
+//   --commit       Commit recorded in the JSON, default the commit CMake found when configured
+//   --no-counters  Skip hardware performance counters
+//
+// The recorded calls are loaded into memory, then replayed in recorded order until the minimum time has
+// passed, first all together and then separately per function. Each benchmark reports nanoseconds per call
+// and the bytes per second of output (format) or input (scan), plus the counters Bench reports.
+//
+// Formats are called with the recorded buffer size (0 replays as a Length call), scans write into scratch
+// storage of the recorded types. Rows are named replay/<all|FormatString|FormatStringF|ScanStringF>.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <memory>
+#include <vector>
+
+#include "../FormatStringLib/BinaryLog.h"
+#include "../FormatStringLib/FormatCache.h"
+#include "../FormatStringLib/FormatString.h"
+#include "../FormatStringLib/FormatStringF.h"
+#include "../FormatStringLib/ScanStringF.h"
+#include "PerfCounters.h"
+
+#ifndef BENCH_COMMIT
+#define BENCH_COMMIT "unknown"
+#endif // BENCH_COMMIT
+
+USING_NAMESPACE_FORMATSTRINGLIB
+
+enum
+{
+  MAX_BUFFER_SIZE = 64 * 1024,                    // Larger recorded buffer sizes are clamped
+  SLOT_SIZE = 16,                                 // Scratch bytes per scan output, fits fsInt128
+  NUM_GROUPS = 4,                                 // All, then one per BinaryLog::Syntax
+  GROUP_ALL = 3,
+};
+
+// One recorded call
+struct ReplayCall
+{
+  BinaryLog::Syntax m_syntax;
+  fsUInt32 m_formatId;
+  const fsChar* m_format;                         // In the mapped corpus
+  const CompiledFormat* m_compiled;               // With --compiled, else NULL
+  size_t m_count;                                 // Buffer size
+  const fsChar* m_input;                          // Scan input
+  ArgListFixed m_args;
+  std::shared_ptr<fsUInt8> m_storage;             // Scan outputs
+};
+
+// Measurements of one benchmark, kept for the JSON output
+struct ReplayResult
+{
+  fsChar m_name[64];
+  fsUInt64 m_calls;
+  fsUInt64 m_bytes;
+  fsFloat64 m_seconds;
+  fsBool m_counted;                               // m_counters were read
+  fsUInt64 m_counters[PerfCounters::NUM_COUNTERS];
+};
+
+static const fsChar* const s_groupNames[NUM_GROUPS] = { "FormatString", "FormatStringF", "ScanStringF", "all" };
+
+static fsFloat64 s_minTime = 1.0;                 // Seconds per benchmark
+static volatile fsUInt64 s_sink;                  // Keeps results live
+static fsChar s_buffer[MAX_BUFFER_SIZE];
+static PerfCounters s_counters;
+static std::vector<ReplayCall> s_calls;
+static std::vector<CompiledFormat> s_compiled;    // Indexed by format id, with --compiled
+static std::vector<ReplayResult> s_results;
+
+
+// Output argument for a recorded scan target, pointing at a_slot, or the null Arg if not a target type
+static Arg scan_target(const Arg& a_recorded, fsUInt8* a_slot, fsChar* a_text)
+{
+  switch( a_recorded.m_type )
+  {
+    case Arg::ARG_TYPE_CSTR:      return Arg(a_text);
+    case Arg::ARG_TYPE_INT16:     return Arg((fsInt16*)a_slot);
+    case Arg::ARG_TYPE_UINT16:    return Arg((fsUInt16*)a_slot);
+    case Arg::ARG_TYPE_INT32:     return Arg((fsInt32*)a_slot);
+    case Arg::ARG_TYPE_UINT32:    return Arg((fsUInt32*)a_slot);
+    case Arg::ARG_TYPE_INT64:     return Arg((fsInt64*)a_slot);
+    case Arg::ARG_TYPE_UINT64:    return Arg((fsUInt64*)a_slot);
+    case Arg::ARG_TYPE_FLOAT32:   return Arg((fsFloat32*)a_slot);
+    case Arg::ARG_TYPE_FLOAT64:   return Arg((fsFloat64*)a_slot);
+#if FS_HAS_INT128
+    case Arg::ARG_TYPE_INT128:    return Arg((fsInt128*)a_slot);
+    case Arg::ARG_TYPE_UINT128:   return Arg((fsUInt128*)a_slot);
+#endif // FS_HAS_INT128
+    case Arg::ARG_TYPE_CONST_PTR: return Arg((void*)a_slot);
+    case Arg::ARG_TYPE_DECIMAL64: return Arg(Decimal64Ptr((fsInt64*)a_slot, a_recorded.m_valueDecimal64.m_scale));
+    default:                      return Arg();
+  }
+}
+
+
+// Load every message of the corpus into s_calls. The reader must stay open while they are used.
+static fsBool load_corpus(BinaryLogReader& a_reader, fsBool a_compile)
+{
+  BinaryLogMessage message;
+  while( a_reader.ReadNext(message) )
+  {
+    ReplayCall call;
+    call.m_syntax = BinaryLog::SYNTAX_BRACED;
+    call.m_formatId = message.m_formatId;
+    call.m_format = a_reader.GetFormat(message.m_formatId, &call.m_syntax);
+    call.m_compiled = NULL;
+    call.m_count = (message.m_timestamp < MAX_BUFFER_SIZE) ? (size_t)message.m_timestamp : (size_t)MAX_BUFFER_SIZE;
+    call.m_input = NULL;
+    if( call.m_format == NULL )
+    {
+      continue;
+    }
+
+    if( call.m_syntax != BinaryLog::SYNTAX_SCAN )
+    {
+      call.m_args = message.m_args;
+      if( a_compile )
+      {
+        if( s_compiled.size() <= message.m_formatId )
+        {
+          s_compiled.resize(message.m_formatId + 1);
+        }
+        CompiledFormat& compiled = s_compiled[message.m_formatId];
+        if( !compiled.IsValid() && (call.m_syntax == BinaryLog::SYNTAX_PRINTF) )
+        {
+          CompileFormatStringF(call.m_format, compiled);
+        }
+        else if( !compiled.IsValid() )
+        {
+          CompileFormatString(call.m_format, compiled);
+        }
+      }
+    }
+    else if( message.m_args.Count() > 0 )
+    {
+      // Input first, then one slot per output, strings sized to the input so any token fits
+      call.m_input = message.m_args.GetAt(0).m_valueCString;
+      fsInt numTargets = message.m_args.Count() - 1;
+      size_t textSize = strlen(call.m_input) + 1;
+      call.m_storage.reset(new fsUInt8[numTargets * SLOT_SIZE + textSize * numTargets + 1], std::default_delete<fsUInt8[]>());
+      fsUInt8* slots = call.m_storage.get();
+      fsChar* text = (fsChar*)(slots + numTargets * SLOT_SIZE);
+      for( fsInt target = 0; target < numTargets; ++target )
+      {
+        call.m_args.Add(scan_target(message.m_args.GetAt(target + 1), slots + target * SLOT_SIZE, text + target * textSize));
+      }
+    }
+    s_calls.push_back(call);
+  }
+
+  // Compiled formats are only referenced once s_compiled stops growing
+  for( size_t index = 0; a_compile && (index < s_calls.size()); ++index )
+  {
+    ReplayCall& call = s_calls[index];
+    if( (call.m_syntax != BinaryLog::SYNTAX_SCAN) && s_compiled[call.m_formatId].IsValid() )
+    {
+      call.m_compiled = &s_compiled[call.m_formatId];
+    }
+  }
+  return !a_reader.IsCorrupt();
+}
+
+
+// Replay one call, returns the bytes output or scanned
+static inline size_t replay_call(ReplayCall& a_call)
+{
+  fsChar* buffer = a_call.m_count ? s_buffer : NULL;
+  a_call.m_args.Start();
+  switch( a_call.m_syntax )
+  {
+    case BinaryLog::SYNTAX_BRACED:
+    {
+      fsInt length = a_call.m_compiled ? FormatString(buffer, a_call.m_count, *a_call.m_compiled, a_call.m_args)
+                                       : FormatString(buffer, a_call.m_count, a_call.m_format, a_call.m_args);
+      return (length > 0) ? (size_t)length : 0;
+    }
+    case BinaryLog::SYNTAX_PRINTF:
+    {
+      fsInt length = a_call.m_compiled ? FormatStringF(buffer, a_call.m_count, *a_call.m_compiled, a_call.m_args)
+                                       : FormatStringF(buffer, a_call.m_count, a_call.m_format, a_call.m_args);
+      return (length > 0) ? (size_t)length : 0;
+    }
+    default:
+    {
+      s_sink += (fsUInt64)ScanStringF(a_call.m_input, a_call.m_format, a_call.m_args);
+      return strlen(a_call.m_input);
+    }
+  }
+}
+
+
+// Replay the calls of a_group in order until s_minTime has passed and print its row
+static void run_replay(fsInt a_group)
+{
+  std::vector<ReplayCall*> calls;
+  for( size_t index = 0; index < s_calls.size(); ++index )
+  {
+    if( (a_group == GROUP_ALL) || (s_calls[index].m_syntax == a_group) )
+    {
+      calls.push_back(&s_calls[index]);
+    }
+  }
+  if( calls.empty() )
+  {
+    return;
+  }
+
+  for( size_t index = 0; index < calls.size(); ++index ) // Warm up caches and branch predictors
+  {
+    s_sink += replay_call(*calls[index]);
+  }
+
+  fsUInt64 numCalls = 0;
+  fsUInt64 bytes = 0;
+  fsFloat64 elapsed = 0.0;
+  s_counters.Reset();
+  while( elapsed < s_minTime )
+  {
+    s_counters.Start();
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for( size_t index = 0; index < calls.size(); ++index )
+    {
+      bytes += replay_call(*calls[index]);
+    }
+    elapsed += std::chrono::duration<fsFloat64>(std::chrono::steady_clock::now() - start).count();
+    s_counters.Stop();
+    numCalls += calls.size();
+  }
+  s_sink += bytes + (fsUInt8)s_buffer[0];
+
+  ReplayResult result;
+  snprintf(result.m_name, sizeof(result.m_name), "replay/%s", s_groupNames[a_group]);
+  result.m_calls = numCalls;
+  result.m_bytes = bytes;
+  result.m_seconds = elapsed;
+  result.m_counted = s_counters.Read(result.m_counters);
+  s_results.push_back(result);
+
+  printf("%-28s %10zu %10.1f %10.1f", result.m_name, calls.size(), elapsed * 1e9 / (fsFloat64)numCalls, (fsFloat64)bytes / elapsed / 1e6);
+  if( result.m_counted )
+  {
+    const fsUInt64* counters = result.m_counters;
+    fsFloat64 perCall = 1.0 / (fsFloat64)numCalls;
+    fsFloat64 ipc = counters[PerfCounters::COUNTER_CYCLES] ? (fsFloat64)counters[PerfCounters::COUNTER_INSTRUCTIONS] / (fsFloat64)counters[PerfCounters::COUNTER_CYCLES] : 0.0;
+    printf(" %10.1f %10.1f %6.2f %10.3f %10.3f", counters[PerfCounters::COUNTER_CYCLES] * perCall, counters[PerfCounters::COUNTER_INSTRUCTIONS] * perCall, ipc,
+           counters[PerfCounters::COUNTER_BRANCH_MISSES] * perCall, counters[PerfCounters::COUNTER_L1D_MISSES] * perCall);
+  }
+  printf("\n");
+}
+
+
+// Write s_results as JSON, as Bench does. Returns false if the file can not be written.
+static fsBool write_json(const fsChar* a_path, const fsChar* a_commit)
+{
+  FILE* file = fopen(a_path, "w");
+  if( file == NULL )
+  {
+    return false;
+  }
+
+  fprintf(file, "{\n  \"commit\": \"");
+  for( const fsChar* pos = a_commit; *pos; ++pos ) // Escape for a JSON string
+  {
+    fprintf(file, ((*pos == '"') || (*pos == '\\')) ? "\\%c" : ((fsUInt8)*pos < 0x20) ? "?" : "%c", *pos);
+  }
+  fprintf(file, "\",\n  \"min_time\": %g,\n  \"benchmarks\": {", s_minTime);
+  for( size_t index = 0; index < s_results.size(); ++index )
+  {
+    const ReplayResult& result = s_results[index];
+    fprintf(file, "%s\n    \"%s\": {\"calls\": %llu, \"ns_per_op\": %.3f, \"bytes_per_s\": %.0f",
+            index ? "," : "", result.m_name, (unsigned long long)result.m_calls,
+            result.m_seconds * 1e9 / (fsFloat64)result.m_calls, (fsFloat64)result.m_bytes / result.m_seconds);
+    if( result.m_counted )
+    {
+      for( fsInt counter = 0; counter < PerfCounters::NUM_COUNTERS; ++counter )
+      {
+        if( s_counters.IsAvailable(counter) )
+        {
+          fprintf(file, ", \"%s_per_op\": %.4f", PerfCounters::GetName(counter), (fsFloat64)result.m_counters[counter] / (fsFloat64)result.m_calls);
+        }
+      }
+      if( s_counters.IsAvailable(PerfCounters::COUNTER_CYCLES) && s_counters.IsAvailable(PerfCounters::COUNTER_INSTRUCTIONS) &&
+          result.m_counters[PerfCounters::COUNTER_CYCLES] )
+      {
+        fprintf(file, ", \"ipc\": %.4f", (fsFloat64)result.m_counters[PerfCounters::COUNTER_INSTRUCTIONS] / (fsFloat64)result.m_counters[PerfCounters::COUNTER_CYCLES]);
+      }
+    }
+    fprintf(file, "}");
+  }
+  fprintf(file, "\n  }\n}\n");
+  return fclose(file) == 0;
+}
+
+
+int main(int argc, char* argv[])
+{
+  const fsChar* corpusPath = NULL;
+  const fsChar* jsonPath = NULL;
+  const fsChar* commit = BENCH_COMMIT;
+  fsBool useCounters = true;
+  fsBool compile = false;
+  for( int arg = 1; arg < argc; ++arg )
+  {
+    if( strncmp(argv[arg], "--min-time=", 11) == 0 )
+    {
+      s_minTime = atof(argv[arg] + 11);
+    }
+    else if( strcmp(argv[arg], "--compiled") == 0 )
+    {
+      compile = true;
+    }
+    else if( strcmp(argv[arg], "--cache") == 0 )
+    {
+      FormatCache::Enable();
+    }
+    else if( strncmp(argv[arg], "--json=", 7) == 0 )
+    {
+      jsonPath = argv[arg] + 7;
+    }
+    else if( strncmp(argv[arg], "--commit=", 9) == 0 )
+    {
+      commit = argv[arg] + 9;
+    }
+    else if( strcmp(argv[arg], "--no-counters") == 0 )
+    {
+      useCounters = false;
+    }
+    else if( (argv[arg][0] == '-') || (corpusPath != NULL) )
+    {
+      corpusPath = NULL;
+      break;
+    }
+    else
+    {
+      corpusPath = argv[arg];
+    }
+  }
+  if( corpusPath == NULL )
+  {
+    fprintf(stderr, "Usage: %s corpus [--min-time=seconds] [--compiled] [--cache] [--json=file] [--commit=id] [--no-counters]\n", argv[0]);
+    return 1;
+  }
+
+  BinaryLogReader reader;
+  if( !reader.OpenFile(corpusPath) )
+  {
+    fprintf(stderr, "Failed to open '%s'\n", corpusPath);
+    return 1;
+  }
+  if( !load_corpus(reader, compile) )
+  {
+    fprintf(stderr, "Corrupt record in '%s', replaying the %zu calls before it\n", corpusPath, s_calls.size());
+  }
+
+  const fsChar* counterError = NULL;
+  if( useCounters && !s_counters.Open(&counterError) )
+  {
+    fprintf(stderr, "Hardware counters unavailable: %s\n", counterError);
+  }
+
+  printf("%-28s %10s %10s %10s", "Benchmark", "calls", "ns/op", "MB/s");
+  if( s_counters.IsAnyAvailable() )
+  {
+    printf(" %10s %10s %6s %10s %10s", "cycles/op", "instr/op", "IPC", "brmiss/op", "L1miss/op");
+  }
+  printf("\n");
+  run_replay(GROUP_ALL);
+  for( fsInt group = 0; group < GROUP_ALL; ++group )
+  {
+    run_replay(group);
+  }
+
+  if( (jsonPath != NULL) && !write_json(jsonPath, commit) )
+  {
+    fprintf(stderr, "Failed to write '%s'\n", jsonPath);
+    return 1;
+  }
+  return 0;
+}
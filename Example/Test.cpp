@@ -7,7 +7,7 @@
 
 USING_NAMESPACE_FORMATSTRINGLIB
 
-void main()
+int main()
 {
   const int STR_NUM_BYTES = 256;
   char string1[STR_NUM_BYTES];
@@ -25,4 +25,5 @@ void main()
 
   // Wait for keypress in case windowed
   getchar();
+  return 0;
 }
@@ -80,6 +80,10 @@ fsBool Arg::WriteChar(const fsChar a_char)
     case ARG_TYPE_UINT32_PTR: (*m_valueUInt32Ptr) = (fsUInt32)a_char; return true;
     case ARG_TYPE_INT64_PTR: (*m_valueInt64Ptr) = (fsInt64)a_char; return true;
     case ARG_TYPE_UINT64_PTR: (*m_valueUInt64Ptr) = (fsUInt64)a_char; return true;
+#if FS_HAS_INT128
+    case ARG_TYPE_INT128_PTR: (*m_valueInt128Ptr) = (fsInt128)a_char; return true;
+    case ARG_TYPE_UINT128_PTR: (*m_valueUInt128Ptr) = (fsUInt128)a_char; return true;
+#endif // FS_HAS_INT128
 
     default: 
     {
@@ -19,6 +19,35 @@ class String; // NOTE: Must fwd declare as this header may be included by String
 
 BEGIN_NAMESPACE_FORMATSTRINGLIB
 
+// Fixed point decimal, a_units scaled by 10^-a_scale (eg. Decimal64(12345, 2) is 123.45), for prices and quantities
+// kept as integers. FormatString "F" / "N" / "C" and FormatStringF %f write its digits exactly, without converting
+// to floating point. The scale is 0 to 18, so a whole unit fits 64 bits.
+struct Decimal64
+{
+  fsInt64 m_units;
+  fsInt32 m_scale;
+
+  Decimal64(fsInt64 a_units, fsInt32 a_scale)
+  {
+    m_units = a_units;
+    m_scale = a_scale;
+  }
+};
+
+// Scan output for a fixed point decimal, ScanStringF stores the value read as units of a_scale (see Decimal64)
+struct Decimal64Ptr
+{
+  fsInt64* m_units;
+  fsInt32 m_scale;
+
+  Decimal64Ptr(fsInt64* a_units, fsInt32 a_scale)
+  {
+    m_units = a_units;
+    m_scale = a_scale;
+  }
+};
+
+
 // Box a argument / parameter in order to handle variable number of different type arguments / parameters.
 // Intended as C++ / Managed language compatible replacement for va_args
 class Arg
@@ -43,6 +72,8 @@ public:
     ARG_TYPE_FLOAT64,
     ARG_TYPE_CONST_PTR,
     ARG_TYPE_CSTR,
+    ARG_TYPE_INT128,                              // Only constructed when FS_HAS_INT128
+    ARG_TYPE_UINT128,
     
     ARG_TYPE_NONCONST_PTR,                        // Note, also readable
     ARG_TYPE_CHAR_PTR,                            // Non-const, c-string pointer WARNING: Care must be taken using this type
@@ -54,10 +85,15 @@ public:
     ARG_TYPE_UINT64_PTR,
     ARG_TYPE_FLOAT32_PTR,
     ARG_TYPE_FLOAT64_PTR,
+    ARG_TYPE_INT128_PTR,
+    ARG_TYPE_UINT128_PTR,
 #if HAS_CUSTOM_STRING_CLASS
     ARG_TYPE_STRING_PTR,
 #endif //HAS_CUSTOM_STRING_CLASS
 
+    ARG_TYPE_DECIMAL64 = 32,                      // Fixed point decimal. Note, after the others as type values are logged (see BinaryLog.h)
+    ARG_TYPE_DECIMAL64_PTR,
+
     ARG_TYPE_MAX
   };
 
@@ -78,6 +114,12 @@ public:
     fsFloat64 m_valueFloat64;
     const void* m_valueConstPtr;                  // (generic) Pointer to void
     const fsChar* m_valueCString;                 // Pointer to zero terminated string
+    fsUInt64 m_value128[2];                       // 128bit integer as low, high halves (see AsUInt128)
+    struct
+    {
+      fsInt64 m_units;
+      fsInt32 m_scale;
+    } m_valueDecimal64;                           // Fixed point decimal (see Decimal64)
 
     // Writable set
     void* m_valueNonConstPtr;                     // (generic) Pointer to void 
@@ -90,12 +132,21 @@ public:
     fsUInt64* m_valueUInt64Ptr;
     fsFloat32* m_valueFloat32Ptr;
     fsFloat64* m_valueFloat64Ptr;
+#if FS_HAS_INT128
+    fsInt128* m_valueInt128Ptr;
+    fsUInt128* m_valueUInt128Ptr;
+#endif // FS_HAS_INT128
 #if HAS_CUSTOM_STRING_CLASS
     fsString* m_valueStringPtr;
 #endif //HAS_CUSTOM_STRING_CLASS
+    struct
+    {
+      fsInt64* m_units;
+      fsInt32 m_scale;
+    } m_valueDecimal64Ptr;
   };
 
-  static Arg Arg::s_null;                     // Static 'null' instance
+  static Arg s_null;                          // Static 'null' instance
 
   // Default constructor
   Arg()
@@ -176,6 +227,22 @@ public:
     m_valueFloat64 = a_value;
   }
 
+#if FS_HAS_INT128
+  Arg(const fsUInt128 a_value)
+  {
+    m_type = ARG_TYPE_UINT128;
+    m_value128[0] = (fsUInt64)a_value;
+    m_value128[1] = (fsUInt64)(a_value >> 64);
+  }
+
+  Arg(const fsInt128 a_value)
+  {
+    m_type = ARG_TYPE_INT128;
+    m_value128[0] = (fsUInt64)a_value;
+    m_value128[1] = (fsUInt64)((fsUInt128)a_value >> 64);
+  }
+#endif // FS_HAS_INT128
+
   Arg(const void* a_value)
   {
     m_type = ARG_TYPE_CONST_PTR;
@@ -187,6 +254,13 @@ public:
     m_type = ARG_TYPE_CHAR;
     m_valueChar = a_value;
   }
+
+  Arg(const Decimal64& a_value)
+  {
+    m_type = ARG_TYPE_DECIMAL64;
+    m_valueDecimal64.m_units = a_value.m_units;
+    m_valueDecimal64.m_scale = a_value.m_scale;
+  }
   
   // Writable ptr types
 
@@ -250,6 +324,27 @@ public:
     m_valueFloat64Ptr = a_value;
   }
 
+#if FS_HAS_INT128
+  Arg(fsInt128* a_value)
+  {
+    m_type = ARG_TYPE_INT128_PTR;
+    m_valueInt128Ptr = a_value;
+  }
+
+  Arg(fsUInt128* a_value)
+  {
+    m_type = ARG_TYPE_UINT128_PTR;
+    m_valueUInt128Ptr = a_value;
+  }
+#endif // FS_HAS_INT128
+
+  Arg(const Decimal64Ptr& a_value)
+  {
+    m_type = ARG_TYPE_DECIMAL64_PTR;
+    m_valueDecimal64Ptr.m_units = a_value.m_units;
+    m_valueDecimal64Ptr.m_scale = a_value.m_scale;
+  }
+
 #if HAS_CUSTOM_STRING_CLASS
   Arg(String* a_value);
 #endif //HAS_CUSTOM_STRING_CLASS
@@ -264,7 +359,15 @@ public:
             || m_type == ARG_TYPE_INT32
             || m_type == ARG_TYPE_UINT32
             || m_type == ARG_TYPE_INT64
-            || m_type == ARG_TYPE_UINT64 );
+            || m_type == ARG_TYPE_UINT64
+            || m_type == ARG_TYPE_INT128
+            || m_type == ARG_TYPE_UINT128 );
+  }
+
+  fsBool Is128Bit() const
+  {
+    return (   m_type == ARG_TYPE_INT128
+            || m_type == ARG_TYPE_UINT128 );
   }
 
   fsBool IsFloat() const
@@ -273,9 +376,14 @@ public:
             || m_type == ARG_TYPE_FLOAT64 );
   }
 
+  fsBool IsDecimal() const
+  {
+    return (m_type == ARG_TYPE_DECIMAL64);
+  }
+
   fsBool IsNumber() const
   {
-    return ( IsFloat() || IsInteger() );
+    return ( IsFloat() || IsInteger() || IsDecimal() );
   }
   
   fsBool IsCString() const
@@ -296,6 +404,9 @@ public:
             || m_type == ARG_TYPE_UINT64_PTR
             || m_type == ARG_TYPE_FLOAT32_PTR
             || m_type == ARG_TYPE_FLOAT64_PTR
+            || m_type == ARG_TYPE_INT128_PTR
+            || m_type == ARG_TYPE_UINT128_PTR
+            || m_type == ARG_TYPE_DECIMAL64_PTR
 #if HAS_CUSTOM_STRING_CLASS
             || m_type == ARG_TYPE_STRING_PTR 
 #endif //HAS_CUSTOM_STRING_CLASS
@@ -318,6 +429,9 @@ public:
       case ARG_TYPE_UINT64: return (fsFloat64) m_valueUInt64;
       case ARG_TYPE_FLOAT32: return (fsFloat64) m_valueFloat32;
       case ARG_TYPE_FLOAT64: return (fsFloat64) m_valueFloat64;
+      case ARG_TYPE_INT128: return (fsFloat64) ((fsInt64)m_value128[1] * 18446744073709551616.0 + (fsFloat64)m_value128[0]);
+      case ARG_TYPE_UINT128: return (fsFloat64) ((fsFloat64)m_value128[1] * 18446744073709551616.0 + (fsFloat64)m_value128[0]);
+      case ARG_TYPE_DECIMAL64: return (fsFloat64) ((fsFloat64)m_valueDecimal64.m_units / (fsFloat64)DecimalScaleFactor(m_valueDecimal64.m_scale)); // Powers of ten to 10^18 are exact, so correctly rounded
       default: return 0;
     }
   }
@@ -338,6 +452,9 @@ public:
       case ARG_TYPE_UINT64: return (fsFloat32) m_valueUInt64;
       case ARG_TYPE_FLOAT32: return (fsFloat32) m_valueFloat32;
       case ARG_TYPE_FLOAT64: return (fsFloat32) m_valueFloat64;
+      case ARG_TYPE_INT128: return (fsFloat32) ((fsInt64)m_value128[1] * 18446744073709551616.0 + (fsFloat64)m_value128[0]);
+      case ARG_TYPE_UINT128: return (fsFloat32) ((fsFloat64)m_value128[1] * 18446744073709551616.0 + (fsFloat64)m_value128[0]);
+      case ARG_TYPE_DECIMAL64: return (fsFloat32) ((fsFloat64)m_valueDecimal64.m_units / (fsFloat64)DecimalScaleFactor(m_valueDecimal64.m_scale)); // Powers of ten to 10^18 are exact, so correctly rounded
       default: return 0;
     }
   }
@@ -358,8 +475,11 @@ public:
       case ARG_TYPE_UINT64: return (fsInt32) m_valueUInt64;
       case ARG_TYPE_FLOAT32: return (fsInt32) m_valueFloat32;
       case ARG_TYPE_FLOAT64: return (fsInt32) m_valueFloat64;
-      case ARG_TYPE_CONST_PTR: return (fsInt32) m_valueConstPtr;
-      case ARG_TYPE_NONCONST_PTR: return (fsInt32) m_valueNonConstPtr;
+      case ARG_TYPE_INT128: return (fsInt32) m_value128[0];
+      case ARG_TYPE_UINT128: return (fsInt32) m_value128[0];
+      case ARG_TYPE_DECIMAL64: return (fsInt32) (m_valueDecimal64.m_units / DecimalScaleFactor(m_valueDecimal64.m_scale));
+      case ARG_TYPE_CONST_PTR: return (fsInt32)(fsIntPtr)m_valueConstPtr;
+      case ARG_TYPE_NONCONST_PTR: return (fsInt32)(fsIntPtr)m_valueNonConstPtr;
       default: return 0;
     }
   }
@@ -380,12 +500,36 @@ public:
       case ARG_TYPE_UINT64: return (fsInt64) m_valueUInt64;
       case ARG_TYPE_FLOAT32: return (fsInt64) m_valueFloat32;
       case ARG_TYPE_FLOAT64: return (fsInt64) m_valueFloat64;
+      case ARG_TYPE_INT128: return (fsInt64) m_value128[0]; // Low 64 bits, see AsInt128
+      case ARG_TYPE_UINT128: return (fsInt64) m_value128[0];
+      case ARG_TYPE_DECIMAL64: return m_valueDecimal64.m_units / DecimalScaleFactor(m_valueDecimal64.m_scale); // Truncated
       case ARG_TYPE_CONST_PTR: return (fsInt64)(fsUIntPtr)m_valueConstPtr; // Prevent sign extension
       case ARG_TYPE_NONCONST_PTR: return (fsInt64)(fsUIntPtr)m_valueNonConstPtr; // Prevent sign extension
       default: return 0;
     }
   }
 
+#if FS_HAS_INT128
+  // Return integer type as 128bit, sign extending signed types
+  fsInt128 AsInt128() const
+  {
+    if( Is128Bit() )
+    {
+      return (fsInt128)(((fsUInt128)m_value128[1] << 64) | m_value128[0]);
+    }
+    if( m_type == ARG_TYPE_UINT64 )
+    {
+      return (fsInt128)m_valueUInt64;
+    }
+    return (fsInt128)AsInt64();
+  }
+
+  fsUInt128 AsUInt128() const
+  {
+    return (fsUInt128)AsInt128();
+  }
+#endif // FS_HAS_INT128
+
   // Write as float 32 value to all plausible types
   // WARNING: Output value may be truncated or bit-complemented if it does not fit destination type
   fsBool WriteAsFloat32(fsFloat32 a_value)
@@ -400,6 +544,10 @@ public:
       case ARG_TYPE_UINT64_PTR: (*m_valueUInt64Ptr) = (fsUInt64)a_value; return true;
       case ARG_TYPE_FLOAT32_PTR: (*m_valueFloat32Ptr) = (fsFloat32)a_value; return true;
       case ARG_TYPE_FLOAT64_PTR: (*m_valueFloat64Ptr) = (fsFloat64)a_value; return true;
+#if FS_HAS_INT128
+      case ARG_TYPE_INT128_PTR: (*m_valueInt128Ptr) = (fsInt128)a_value; return true;
+      case ARG_TYPE_UINT128_PTR: (*m_valueUInt128Ptr) = (fsUInt128)a_value; return true;
+#endif // FS_HAS_INT128
       default: return false;
     }
   }
@@ -418,6 +566,10 @@ public:
       case ARG_TYPE_UINT64_PTR: (*m_valueUInt64Ptr) = (fsUInt64)a_value; return true;
       case ARG_TYPE_FLOAT32_PTR: (*m_valueFloat32Ptr) = (fsFloat32)a_value; return true;
       case ARG_TYPE_FLOAT64_PTR: (*m_valueFloat64Ptr) = (fsFloat64)a_value; return true;
+#if FS_HAS_INT128
+      case ARG_TYPE_INT128_PTR: (*m_valueInt128Ptr) = (fsInt128)a_value; return true;
+      case ARG_TYPE_UINT128_PTR: (*m_valueUInt128Ptr) = (fsUInt128)a_value; return true;
+#endif // FS_HAS_INT128
       default: return false;
     }
   }
@@ -436,6 +588,10 @@ public:
       case ARG_TYPE_UINT64_PTR: (*m_valueUInt64Ptr) = (fsUInt64)a_value; return true;
       case ARG_TYPE_FLOAT32_PTR: (*m_valueFloat32Ptr) = (fsFloat32)a_value; return true;
       case ARG_TYPE_FLOAT64_PTR: (*m_valueFloat64Ptr) = (fsFloat64)a_value; return true;
+#if FS_HAS_INT128
+      case ARG_TYPE_INT128_PTR: (*m_valueInt128Ptr) = (fsInt128)a_value; return true;
+      case ARG_TYPE_UINT128_PTR: (*m_valueUInt128Ptr) = (fsUInt128)a_value; return true;
+#endif // FS_HAS_INT128
       default: return false;
     }
   }
@@ -454,6 +610,10 @@ public:
       case ARG_TYPE_UINT64_PTR: (*m_valueUInt64Ptr) = (fsUInt64)a_value; return true;
       case ARG_TYPE_FLOAT32_PTR: (*m_valueFloat32Ptr) = (fsFloat32)a_value; return true;
       case ARG_TYPE_FLOAT64_PTR: (*m_valueFloat64Ptr) = (fsFloat64)a_value; return true;
+#if FS_HAS_INT128
+      case ARG_TYPE_INT128_PTR: (*m_valueInt128Ptr) = (fsInt128)a_value; return true;
+      case ARG_TYPE_UINT128_PTR: (*m_valueUInt128Ptr) = (fsUInt128)a_value; return true;
+#endif // FS_HAS_INT128
       default: return false;
     }
   }
@@ -465,6 +625,7 @@ public:
     switch( m_type )
     {
       case ARG_TYPE_NONCONST_PTR: (*(fsIntPtr*)m_valueNonConstPtr) = (fsIntPtr)a_value; return true; // Allow generic pointer
+      case ARG_TYPE_DECIMAL64_PTR: (*m_valueDecimal64Ptr.m_units) = (fsInt64)a_value * DecimalScaleFactor(m_valueDecimal64Ptr.m_scale); return true; // Whole units
       case ARG_TYPE_INT16_PTR: (*m_valueInt16Ptr) = (fsInt16)a_value; return true;
       case ARG_TYPE_UINT16_PTR: (*m_valueUInt16Ptr) = (fsUInt16)a_value; return true;
       case ARG_TYPE_INT32_PTR: (*m_valueInt32Ptr) = (fsInt32)a_value; return true;
@@ -473,6 +634,10 @@ public:
       case ARG_TYPE_UINT64_PTR: (*m_valueUInt64Ptr) = (fsUInt64)a_value; return true;
       case ARG_TYPE_FLOAT32_PTR: (*m_valueFloat32Ptr) = (fsFloat32)a_value; return true;
       case ARG_TYPE_FLOAT64_PTR: (*m_valueFloat64Ptr) = (fsFloat64)a_value; return true;
+#if FS_HAS_INT128
+      case ARG_TYPE_INT128_PTR: (*m_valueInt128Ptr) = (fsInt128)a_value; return true;
+      case ARG_TYPE_UINT128_PTR: (*m_valueUInt128Ptr) = (fsUInt128)a_value; return true;
+#endif // FS_HAS_INT128
       default: return false;
     }
   }
@@ -484,6 +649,7 @@ public:
     switch( m_type )
     {
       case ARG_TYPE_NONCONST_PTR: (*(fsIntPtr*)m_valueNonConstPtr) = (fsIntPtr)a_value; return true; // Allow generic pointer
+      case ARG_TYPE_DECIMAL64_PTR: (*m_valueDecimal64Ptr.m_units) = (fsInt64)a_value * DecimalScaleFactor(m_valueDecimal64Ptr.m_scale); return true; // Whole units
       case ARG_TYPE_INT16_PTR: (*m_valueInt16Ptr) = (fsInt16)a_value; return true;
       case ARG_TYPE_UINT16_PTR: (*m_valueUInt16Ptr) = (fsUInt16)a_value; return true;
       case ARG_TYPE_INT32_PTR: (*m_valueInt32Ptr) = (fsInt32)a_value; return true;
@@ -492,10 +658,51 @@ public:
       case ARG_TYPE_UINT64_PTR: (*m_valueUInt64Ptr) = (fsUInt64)a_value; return true;
       case ARG_TYPE_FLOAT32_PTR: (*m_valueFloat32Ptr) = (fsFloat32)a_value; return true;
       case ARG_TYPE_FLOAT64_PTR: (*m_valueFloat64Ptr) = (fsFloat64)a_value; return true;
+#if FS_HAS_INT128
+      case ARG_TYPE_INT128_PTR: (*m_valueInt128Ptr) = (fsInt128)a_value; return true;
+      case ARG_TYPE_UINT128_PTR: (*m_valueUInt128Ptr) = (fsUInt128)a_value; return true;
+#endif // FS_HAS_INT128
       default: return false;
     }
   }
 
+#if FS_HAS_INT128
+  // Write as int 128 value to all plausible types
+  // WARNING: Output value may be truncated or bit-complemented if it does not fit destination type
+  fsBool WriteAsInt128(fsInt128 a_value)
+  {
+    switch( m_type )
+    {
+      case ARG_TYPE_INT128_PTR: (*m_valueInt128Ptr) = a_value; return true;
+      case ARG_TYPE_UINT128_PTR: (*m_valueUInt128Ptr) = (fsUInt128)a_value; return true;
+      default: return WriteAsInt64((fsInt64)a_value);
+    }
+  }
+
+  // Write as unsigned int 128 value to all plausible types
+  // WARNING: Output value may be truncated or bit-complemented if it does not fit destination type
+  fsBool WriteAsUInt128(fsUInt128 a_value)
+  {
+    switch( m_type )
+    {
+      case ARG_TYPE_INT128_PTR: (*m_valueInt128Ptr) = (fsInt128)a_value; return true;
+      case ARG_TYPE_UINT128_PTR: (*m_valueUInt128Ptr) = a_value; return true;
+      default: return WriteAsUInt64((fsUInt64)a_value);
+    }
+  }
+#endif // FS_HAS_INT128
+
+  // 10^a_scale for a Decimal64 scale, clamped to 0 to 18
+  static fsInt64 DecimalScaleFactor(fsInt32 a_scale)
+  {
+    fsInt64 factor = 1;
+    for( fsInt32 digit = 0; (digit < a_scale) && (digit < 18); ++digit )
+    {
+      factor *= 10;
+    }
+    return factor;
+  }
+
   fsBool WriteString(const fsChar* a_string, fsInt a_maxBytes);
 
   fsBool WriteString(const fsChar* a_string);
@@ -524,6 +731,8 @@ public:
   virtual Arg& GetNext()                  = 0;
   // Get argument by index.  Returns null arg if out of range.
   virtual Arg& GetAt(fsInt a_index)       = 0;
+  // Get name of argument by index (see ArgListNamed).  Returns NULL if unnamed or out of range.
+  virtual const fsChar* GetName(fsInt /*a_index*/) { return NULL; }
 
   //
   // Interface for construction
@@ -653,6 +862,87 @@ protected:
 };
 
 
+// Name tagged argument, binds to named fields (eg. "{user}") in FormatString formats
+// NOTE: The name is referenced, not copied (usually a literal).
+struct NamedArg
+{
+  const fsChar* m_name;
+  Arg m_value;
+
+  NamedArg(const fsChar* a_name, const Arg& a_value)
+  {
+    m_name = a_name;
+    m_value = a_value;
+  }
+};
+
+
+// Fixed size argument list with optional argument names
+// Eg. ArgListNamed args(NamedArg("user", userName), NamedArg("latency_ms", latency));
+//     FormatString(buffer, 512, "{user} took {latency_ms:F2}ms", args);
+class ArgListNamed : public ArgListFixed
+{
+public:
+
+  // Default constructor
+  ArgListNamed()
+  {
+  }
+
+  // Constructor overloads as per ArgListFixed
+  ArgListNamed(const NamedArg& a_p1)
+  { Add(a_p1); }
+  ArgListNamed(const NamedArg& a_p1, const NamedArg& a_p2)
+  { Add(a_p1); Add(a_p2); }
+  ArgListNamed(const NamedArg& a_p1, const NamedArg& a_p2, const NamedArg& a_p3)
+  { Add(a_p1); Add(a_p2); Add(a_p3); }
+  ArgListNamed(const NamedArg& a_p1, const NamedArg& a_p2, const NamedArg& a_p3, const NamedArg& a_p4)
+  { Add(a_p1); Add(a_p2); Add(a_p3); Add(a_p4); }
+  ArgListNamed(const NamedArg& a_p1, const NamedArg& a_p2, const NamedArg& a_p3, const NamedArg& a_p4, const NamedArg& a_p5)
+  { Add(a_p1); Add(a_p2); Add(a_p3); Add(a_p4); Add(a_p5); }
+  ArgListNamed(const NamedArg& a_p1, const NamedArg& a_p2, const NamedArg& a_p3, const NamedArg& a_p4, const NamedArg& a_p5, const NamedArg& a_p6)
+  { Add(a_p1); Add(a_p2); Add(a_p3); Add(a_p4); Add(a_p5); Add(a_p6); }
+  ArgListNamed(const NamedArg& a_p1, const NamedArg& a_p2, const NamedArg& a_p3, const NamedArg& a_p4, const NamedArg& a_p5, const NamedArg& a_p6, const NamedArg& a_p7)
+  { Add(a_p1); Add(a_p2); Add(a_p3); Add(a_p4); Add(a_p5); Add(a_p6); Add(a_p7); }
+  ArgListNamed(const NamedArg& a_p1, const NamedArg& a_p2, const NamedArg& a_p3, const NamedArg& a_p4, const NamedArg& a_p5, const NamedArg& a_p6, const NamedArg& a_p7, const NamedArg& a_p8)
+  { Add(a_p1); Add(a_p2); Add(a_p3); Add(a_p4); Add(a_p5); Add(a_p6); Add(a_p7); Add(a_p8); }
+
+  virtual const fsChar* GetName(fsInt a_index)
+  {
+    if( a_index < 0 || a_index >= m_count )
+    {
+      return NULL;
+    }
+    return m_names[a_index];
+  }
+
+  // Append unnamed arg, only usable by index
+  virtual fsBool Add(const Arg& a_arg)
+  {
+    return Add(a_arg, NULL);
+  }
+
+  fsBool Add(const NamedArg& a_arg)
+  {
+    return Add(a_arg.m_value, a_arg.m_name);
+  }
+
+  fsBool Add(const Arg& a_arg, const fsChar* a_name)
+  {
+    if( !ArgListFixed::Add(a_arg) )
+    {
+      return false;
+    }
+    m_names[m_count - 1] = a_name;
+    return true;
+  }
+
+protected:
+
+  const fsChar* m_names[MAX_FIXED_ARGS];
+};
+
+
 #if 0 // Only enable if we actually need this
 // Variable size argument list for extreme programming!
 class ArgListVariable : public ArgList
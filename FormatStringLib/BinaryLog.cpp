@@ -0,0 +1,679 @@
+//
+// BinaryLog.cpp
+// Compact binary log records, rendered to text later through FormatString / FormatStringF
+//
+
+#include <string.h>
+#include <stdlib.h>
+
+#include "BinaryLog.h"
+#include "FormatString.h"
+#include "FormatStringF.h"
+
+BEGIN_NAMESPACE_FORMATSTRINGLIB
+
+enum
+{
+  MAX_VARINT_BYTES = 10,                          // 64bit value, 7 bits per byte
+  MAX_RECORD_HEADER_BYTES = 1 + MAX_VARINT_BYTES, // Kind + payload length
+};
+
+
+//
+// Encoding helpers
+//
+
+static inline fsUInt64 zigzag_encode(fsInt64 a_value)
+{
+  return ((fsUInt64)a_value << 1) ^ (fsUInt64)(a_value >> 63);
+}
+
+static inline fsInt64 zigzag_decode(fsUInt64 a_value)
+{
+  return (fsInt64)(a_value >> 1) ^ -(fsInt64)(a_value & 1);
+}
+
+static inline fsUInt8* put_varint(fsUInt8* a_dest, fsUInt64 a_value)
+{
+  while( a_value >= 0x80 )
+  {
+    *a_dest++ = (fsUInt8)(a_value | 0x80);
+    a_value >>= 7;
+  }
+  *a_dest++ = (fsUInt8)a_value;
+  return a_dest;
+}
+
+static inline fsInt varint_size(fsUInt64 a_value)
+{
+  fsInt size = 1;
+  while( a_value >= 0x80 )
+  {
+    a_value >>= 7;
+    ++size;
+  }
+  return size;
+}
+
+// Read varint, returns NULL if it runs past a_end
+static inline const fsUInt8* get_varint(const fsUInt8* a_src, const fsUInt8* a_end, fsUInt64& a_value)
+{
+  fsUInt64 value = 0;
+  fsInt shift = 0;
+  while( a_src < a_end && shift < 64 )
+  {
+    fsUInt8 byte = *a_src++;
+    value |= (fsUInt64)(byte & 0x7f) << shift;
+    if( !(byte & 0x80) )
+    {
+      a_value = value;
+      return a_src;
+    }
+    shift += 7;
+  }
+  return NULL;
+}
+
+static inline fsUInt8* put_fixed(fsUInt8* a_dest, fsUInt64 a_bits, fsInt a_numBytes)
+{
+  for( fsInt byteIndex = 0; byteIndex < a_numBytes; ++byteIndex )
+  {
+    *a_dest++ = (fsUInt8)(a_bits >> (8 * byteIndex));
+  }
+  return a_dest;
+}
+
+static inline fsUInt64 get_fixed(const fsUInt8* a_src, fsInt a_numBytes)
+{
+  fsUInt64 bits = 0;
+  for( fsInt byteIndex = 0; byteIndex < a_numBytes; ++byteIndex )
+  {
+    bits |= (fsUInt64)a_src[byteIndex] << (8 * byteIndex);
+  }
+  return bits;
+}
+
+// Worst case encoded size of an argument, strings are measured
+static size_t arg_max_size(const Arg& a_arg)
+{
+  if( a_arg.IsCString() )
+  {
+    const fsChar* str = a_arg.m_valueCString ? a_arg.m_valueCString : "";
+    return 1 + MAX_VARINT_BYTES + strlen(str) + 1;
+  }
+  if( a_arg.Is128Bit() )
+  {
+    return 1 + 16;
+  }
+  if( a_arg.IsDecimal() )
+  {
+    return 1 + 2 * MAX_VARINT_BYTES;
+  }
+  return 1 + MAX_VARINT_BYTES;
+}
+
+// Encode argument type tag and value
+static fsUInt8* put_arg(fsUInt8* a_dest, const Arg& a_arg)
+{
+  switch( a_arg.m_type )
+  {
+    case Arg::ARG_TYPE_CHAR:
+    case Arg::ARG_TYPE_INT8:
+    case Arg::ARG_TYPE_INT16:
+    case Arg::ARG_TYPE_INT32:
+    case Arg::ARG_TYPE_INT64:
+    {
+      *a_dest++ = (fsUInt8)a_arg.m_type;
+      return put_varint(a_dest, zigzag_encode(a_arg.AsInt64()));
+    }
+    case Arg::ARG_TYPE_UINT8:
+    case Arg::ARG_TYPE_UINT16:
+    case Arg::ARG_TYPE_UINT32:
+    case Arg::ARG_TYPE_UINT64:
+    case Arg::ARG_TYPE_CONST_PTR:
+    case Arg::ARG_TYPE_NONCONST_PTR:
+    {
+      *a_dest++ = (fsUInt8)((a_arg.m_type == Arg::ARG_TYPE_NONCONST_PTR) ? Arg::ARG_TYPE_CONST_PTR : a_arg.m_type);
+      return put_varint(a_dest, (fsUInt64)a_arg.AsInt64());
+    }
+    case Arg::ARG_TYPE_FLOAT32:
+    {
+      fsUInt32 bits;
+      memcpy(&bits, &a_arg.m_valueFloat32, sizeof(bits));
+      *a_dest++ = (fsUInt8)a_arg.m_type;
+      return put_fixed(a_dest, bits, 4);
+    }
+    case Arg::ARG_TYPE_FLOAT64:
+    {
+      fsUInt64 bits;
+      memcpy(&bits, &a_arg.m_valueFloat64, sizeof(bits));
+      *a_dest++ = (fsUInt8)a_arg.m_type;
+      return put_fixed(a_dest, bits, 8);
+    }
+    case Arg::ARG_TYPE_INT128:
+    case Arg::ARG_TYPE_UINT128:
+    {
+      *a_dest++ = (fsUInt8)a_arg.m_type;
+      a_dest = put_fixed(a_dest, a_arg.m_value128[0], 8);
+      return put_fixed(a_dest, a_arg.m_value128[1], 8);
+    }
+    case Arg::ARG_TYPE_DECIMAL64:
+    {
+      *a_dest++ = (fsUInt8)a_arg.m_type;
+      a_dest = put_varint(a_dest, zigzag_encode(a_arg.m_valueDecimal64.m_units));
+      return put_varint(a_dest, zigzag_encode(a_arg.m_valueDecimal64.m_scale));
+    }
+    case Arg::ARG_TYPE_CSTR:
+    case Arg::ARG_TYPE_CHAR_PTR:
+    {
+      const fsChar* str = a_arg.m_valueCString ? a_arg.m_valueCString : "<NULL>";
+      size_t length = strlen(str);
+      *a_dest++ = (fsUInt8)Arg::ARG_TYPE_CSTR;
+      a_dest = put_varint(a_dest, length);
+      memcpy(a_dest, str, length + 1); // Include terminating zero so decoded args can point at log memory
+      return a_dest + length + 1;
+    }
+    default: // Output types are meaningless once logged
+    {
+      *a_dest++ = (fsUInt8)Arg::ARG_TYPE_INVALID;
+      return a_dest;
+    }
+  }
+}
+
+// Decode argument, returns NULL on malformed data
+static const fsUInt8* get_arg(const fsUInt8* a_src, const fsUInt8* a_end, Arg& a_arg)
+{
+  if( a_src >= a_end )
+  {
+    return NULL;
+  }
+
+  fsUInt8 type = *a_src++;
+  fsUInt64 value = 0;
+  switch( type )
+  {
+    case Arg::ARG_TYPE_CHAR:
+    case Arg::ARG_TYPE_INT8:
+    case Arg::ARG_TYPE_INT16:
+    case Arg::ARG_TYPE_INT32:
+    case Arg::ARG_TYPE_INT64:
+    case Arg::ARG_TYPE_UINT8:
+    case Arg::ARG_TYPE_UINT16:
+    case Arg::ARG_TYPE_UINT32:
+    case Arg::ARG_TYPE_UINT64:
+    case Arg::ARG_TYPE_CONST_PTR:
+    {
+      a_src = get_varint(a_src, a_end, value);
+      if( !a_src )
+      {
+        return NULL;
+      }
+      fsInt64 svalue = zigzag_decode(value);
+      switch( type )
+      {
+        case Arg::ARG_TYPE_CHAR: a_arg = Arg((fsChar)svalue); break;
+        case Arg::ARG_TYPE_INT8: a_arg = Arg((fsInt8)svalue); break;
+        case Arg::ARG_TYPE_INT16: a_arg = Arg((fsInt16)svalue); break;
+        case Arg::ARG_TYPE_INT32: a_arg = Arg((fsInt32)svalue); break;
+        case Arg::ARG_TYPE_INT64: a_arg = Arg((fsInt64)svalue); break;
+        case Arg::ARG_TYPE_UINT8: a_arg = Arg((fsUInt8)value); break;
+        case Arg::ARG_TYPE_UINT16: a_arg = Arg((fsUInt16)value); break;
+        case Arg::ARG_TYPE_UINT32: a_arg = Arg((fsUInt32)value); break;
+        case Arg::ARG_TYPE_UINT64: a_arg = Arg((fsUInt64)value); break;
+        default: a_arg = Arg((const void*)(fsUIntPtr)value); break;
+      }
+      return a_src;
+    }
+    case Arg::ARG_TYPE_FLOAT32:
+    {
+      if( a_end - a_src < 4 )
+      {
+        return NULL;
+      }
+      fsUInt32 bits = (fsUInt32)get_fixed(a_src, 4);
+      fsFloat32 fvalue;
+      memcpy(&fvalue, &bits, sizeof(fvalue));
+      a_arg = Arg(fvalue);
+      return a_src + 4;
+    }
+    case Arg::ARG_TYPE_FLOAT64:
+    {
+      if( a_end - a_src < 8 )
+      {
+        return NULL;
+      }
+      fsUInt64 bits = get_fixed(a_src, 8);
+      fsFloat64 fvalue;
+      memcpy(&fvalue, &bits, sizeof(fvalue));
+      a_arg = Arg(fvalue);
+      return a_src + 8;
+    }
+    case Arg::ARG_TYPE_INT128:
+    case Arg::ARG_TYPE_UINT128:
+    {
+      if( a_end - a_src < 16 )
+      {
+        return NULL;
+      }
+      a_arg.m_type = (Arg::ArgType)type;
+      a_arg.m_value128[0] = get_fixed(a_src, 8);
+      a_arg.m_value128[1] = get_fixed(a_src + 8, 8);
+      return a_src + 16;
+    }
+    case Arg::ARG_TYPE_DECIMAL64:
+    {
+      fsUInt64 scale = 0;
+      a_src = get_varint(a_src, a_end, value);
+      a_src = a_src ? get_varint(a_src, a_end, scale) : NULL;
+      if( !a_src )
+      {
+        return NULL;
+      }
+      a_arg = Arg(Decimal64(zigzag_decode(value), (fsInt32)zigzag_decode(scale)));
+      return a_src;
+    }
+    case Arg::ARG_TYPE_CSTR:
+    {
+      a_src = get_varint(a_src, a_end, value);
+      if( !a_src || value >= (fsUInt64)(a_end - a_src) || a_src[value] != '\0' )
+      {
+        return NULL;
+      }
+      a_arg = Arg((const fsChar*)a_src);
+      return a_src + value + 1;
+    }
+    case Arg::ARG_TYPE_INVALID:
+    {
+      a_arg = Arg();
+      return a_src;
+    }
+    default:
+    {
+      return NULL;
+    }
+  }
+}
+
+
+//
+// BinaryLogWriter
+//
+
+BinaryLogWriter::BinaryLogWriter()
+{
+  m_data = NULL;
+  m_capacity = 0;
+  m_size = 0;
+  m_lastTimestamp = 0;
+  m_nextFormatId = BinaryLog::INVALID_FORMAT_ID + 1;
+}
+
+
+BinaryLogWriter::~BinaryLogWriter()
+{
+  Close();
+}
+
+
+void BinaryLogWriter::OpenMemory(fsUInt8* a_buffer, size_t a_size)
+{
+  Close();
+  m_data = a_buffer;
+  m_capacity = a_size;
+  if( m_capacity > 0 )
+  {
+    m_data[0] = BinaryLog::RECORD_END;
+  }
+}
+
+
+fsBool BinaryLogWriter::OpenFile(const fsChar* a_path, size_t a_initialCapacity)
+{
+  Close();
+  if( a_initialCapacity < 4096 )
+  {
+    a_initialCapacity = 4096;
+  }
+  if( !m_file.OpenWrite(a_path, a_initialCapacity) )
+  {
+    return false;
+  }
+  m_data = m_file.GetData();
+  m_capacity = m_file.GetSize();
+  return true;
+}
+
+
+void BinaryLogWriter::Close()
+{
+  if( m_file.IsOpen() )
+  {
+    m_file.Resize(m_size); // Drop unused capacity
+    m_file.Close();
+  }
+  m_data = NULL;
+  m_capacity = 0;
+  m_size = 0;
+  m_lastTimestamp = 0;
+  m_nextFormatId = BinaryLog::INVALID_FORMAT_ID + 1;
+}
+
+
+fsBool BinaryLogWriter::InternalReserve(size_t a_numBytes)
+{
+  if( m_size + a_numBytes <= m_capacity )
+  {
+    return true;
+  }
+  if( !m_file.IsOpen() || (m_data == NULL) ) // Caller supplied memory can't grow, or growing failed before
+  {
+    return false;
+  }
+  size_t newCapacity = m_capacity * 2;
+  while( newCapacity < m_size + a_numBytes )
+  {
+    newCapacity *= 2;
+  }
+  if( !m_file.Resize(newCapacity) )
+  {
+    // Records written so far are kept, all later writes fail
+    m_data = NULL;
+    m_capacity = 0;
+    return false;
+  }
+  m_data = m_file.GetData();
+  m_capacity = newCapacity;
+  return true;
+}
+
+
+fsUInt32 BinaryLogWriter::RegisterFormat(const fsChar* a_format, BinaryLog::Syntax a_syntax)
+{
+  FS_ASSERT(a_format);
+
+  size_t length = strlen(a_format);
+  fsUInt32 formatId = m_nextFormatId;
+  size_t payloadLength = varint_size(formatId) + 1 + varint_size(length) + length + 1;
+  if( !InternalReserve(1 + varint_size(payloadLength) + payloadLength) )
+  {
+    return BinaryLog::INVALID_FORMAT_ID;
+  }
+
+  fsUInt8* dest = m_data + m_size;
+  *dest++ = BinaryLog::RECORD_FORMAT;
+  dest = put_varint(dest, payloadLength);
+  dest = put_varint(dest, formatId);
+  *dest++ = (fsUInt8)a_syntax;
+  dest = put_varint(dest, length);
+  memcpy(dest, a_format, length + 1);
+  dest += length + 1;
+
+  m_size = dest - m_data;
+  if( m_size < m_capacity )
+  {
+    m_data[m_size] = BinaryLog::RECORD_END;
+  }
+  ++m_nextFormatId;
+  return formatId;
+}
+
+
+fsBool BinaryLogWriter::Write(fsUInt32 a_formatId, fsUInt64 a_timestamp, ArgList& a_args)
+{
+  fsInt numArgs = a_args.Count();
+
+  // Worst case size, so the payload can be written in place
+  size_t maxPayload = 3 * MAX_VARINT_BYTES;
+  for( fsInt argIndex = 0; argIndex < numArgs; ++argIndex )
+  {
+    maxPayload += arg_max_size(a_args.GetAt(argIndex));
+  }
+  if( !InternalReserve(MAX_RECORD_HEADER_BYTES + maxPayload) )
+  {
+    return false;
+  }
+
+  // Write payload after space for the largest header, then close the gap once the length is known
+  fsUInt8* record = m_data + m_size;
+  fsUInt8* payload = record + MAX_RECORD_HEADER_BYTES;
+  fsUInt8* dest = payload;
+  dest = put_varint(dest, a_formatId);
+  dest = put_varint(dest, zigzag_encode((fsInt64)(a_timestamp - m_lastTimestamp)));
+  dest = put_varint(dest, numArgs);
+  for( fsInt argIndex = 0; argIndex < numArgs; ++argIndex )
+  {
+    dest = put_arg(dest, a_args.GetAt(argIndex));
+  }
+  size_t payloadLength = dest - payload;
+
+  fsUInt8* header = record;
+  *header++ = BinaryLog::RECORD_MESSAGE;
+  header = put_varint(header, payloadLength);
+  if( header != payload )
+  {
+    memmove(header, payload, payloadLength);
+  }
+
+  m_size = (header + payloadLength) - m_data;
+  if( m_size < m_capacity )
+  {
+    m_data[m_size] = BinaryLog::RECORD_END;
+  }
+  m_lastTimestamp = a_timestamp;
+  return true;
+}
+
+
+//
+// BinaryLogReader
+//
+
+BinaryLogReader::BinaryLogReader()
+{
+  m_data = NULL;
+  m_size = 0;
+  m_pos = 0;
+  m_lastTimestamp = 0;
+  m_corrupt = false;
+  m_formats = NULL;
+  m_maxFormats = 0;
+}
+
+
+BinaryLogReader::~BinaryLogReader()
+{
+  Close();
+}
+
+
+void BinaryLogReader::OpenMemory(const fsUInt8* a_data, size_t a_size)
+{
+  Close();
+  m_data = a_data;
+  m_size = a_size;
+}
+
+
+fsBool BinaryLogReader::OpenFile(const fsChar* a_path)
+{
+  Close();
+  if( !m_file.OpenRead(a_path) )
+  {
+    return false;
+  }
+  m_data = m_file.GetData();
+  m_size = m_file.GetSize();
+  return true;
+}
+
+
+void BinaryLogReader::Close()
+{
+  m_file.Close();
+  free(m_formats);
+  m_formats = NULL;
+  m_maxFormats = 0;
+  m_data = NULL;
+  m_size = 0;
+  m_pos = 0;
+  m_lastTimestamp = 0;
+  m_corrupt = false;
+}
+
+
+fsBool BinaryLogReader::ReadNext(BinaryLogMessage& a_message)
+{
+  while( m_pos < m_size )
+  {
+    const fsUInt8* cur = m_data + m_pos;
+    const fsUInt8* end = m_data + m_size;
+    fsUInt8 kind = *cur++;
+    if( kind == BinaryLog::RECORD_END )
+    {
+      return false;
+    }
+
+    fsUInt64 length = 0;
+    cur = get_varint(cur, end, length);
+    if( !cur || length > (fsUInt64)(end - cur) )
+    {
+      m_corrupt = true;
+      return false;
+    }
+    m_pos = (cur + length) - m_data;
+
+    if( kind == BinaryLog::RECORD_FORMAT )
+    {
+      if( !InternalReadFormat(cur, (size_t)length) )
+      {
+        m_corrupt = true;
+        return false;
+      }
+    }
+    else if( kind == BinaryLog::RECORD_MESSAGE )
+    {
+      if( !InternalReadMessage(cur, (size_t)length, a_message) )
+      {
+        m_corrupt = true;
+        return false;
+      }
+      return true;
+    }
+    // Skip unknown record kinds from newer writers
+  }
+  return false;
+}
+
+
+fsBool BinaryLogReader::InternalReadFormat(const fsUInt8* a_payload, size_t a_length)
+{
+  const fsUInt8* end = a_payload + a_length;
+  fsUInt64 formatId = 0;
+  fsUInt64 textLength = 0;
+  const fsUInt8* cur = get_varint(a_payload, end, formatId);
+  if( !cur || cur >= end || formatId == BinaryLog::INVALID_FORMAT_ID || formatId > 0xffffff )
+  {
+    return false;
+  }
+  fsUInt8 syntax = *cur++;
+  cur = get_varint(cur, end, textLength);
+  if( !cur || textLength >= (fsUInt64)(end - cur) || cur[textLength] != '\0' )
+  {
+    return false;
+  }
+
+  if( formatId >= m_maxFormats )
+  {
+    fsUInt32 newMax = m_maxFormats ? m_maxFormats : 64;
+    while( newMax <= formatId )
+    {
+      newMax *= 2;
+    }
+    FormatDef* newFormats = (FormatDef*)realloc(m_formats, newMax * sizeof(FormatDef));
+    if( !newFormats )
+    {
+      return false;
+    }
+    memset(newFormats + m_maxFormats, 0, (newMax - m_maxFormats) * sizeof(FormatDef));
+    m_formats = newFormats;
+    m_maxFormats = newMax;
+  }
+  m_formats[formatId].m_text = (const fsChar*)cur;
+  m_formats[formatId].m_syntax = ((syntax == BinaryLog::SYNTAX_PRINTF) || (syntax == BinaryLog::SYNTAX_SCAN)) ? (BinaryLog::Syntax)syntax : BinaryLog::SYNTAX_BRACED;
+  return true;
+}
+
+
+fsBool BinaryLogReader::InternalReadMessage(const fsUInt8* a_payload, size_t a_length, BinaryLogMessage& a_message)
+{
+  const fsUInt8* end = a_payload + a_length;
+  fsUInt64 formatId = 0;
+  fsUInt64 timeDelta = 0;
+  fsUInt64 numArgs = 0;
+  const fsUInt8* cur = a_payload;
+  if(    !(cur = get_varint(cur, end, formatId))
+      || !(cur = get_varint(cur, end, timeDelta))
+      || !(cur = get_varint(cur, end, numArgs)) )
+  {
+    return false;
+  }
+
+  m_lastTimestamp += (fsUInt64)zigzag_decode(timeDelta);
+  a_message.m_formatId = (fsUInt32)formatId;
+  a_message.m_timestamp = m_lastTimestamp;
+  a_message.m_args = ArgListFixed();
+
+  for( fsUInt64 argIndex = 0; argIndex < numArgs; ++argIndex )
+  {
+    Arg arg;
+    cur = get_arg(cur, end, arg);
+    if( !cur )
+    {
+      return false;
+    }
+    if( argIndex < ArgListFixed::MAX_FIXED_ARGS ) // Excess arguments can't be referenced by the format anyway
+    {
+      a_message.m_args.Add(arg);
+    }
+  }
+  return true;
+}
+
+
+const fsChar* BinaryLogReader::GetFormat(fsUInt32 a_formatId, BinaryLog::Syntax* a_syntax) const
+{
+  if( a_formatId >= m_maxFormats || !m_formats[a_formatId].m_text )
+  {
+    return NULL;
+  }
+  if( a_syntax )
+  {
+    *a_syntax = m_formats[a_formatId].m_syntax;
+  }
+  return m_formats[a_formatId].m_text;
+}
+
+
+fsInt BinaryLogReader::Render(BinaryLogMessage& a_message, fsChar* a_str, size_t a_count) const
+{
+  BinaryLog::Syntax syntax = BinaryLog::SYNTAX_BRACED;
+  const fsChar* format = GetFormat(a_message.m_formatId, &syntax);
+  if( !format )
+  {
+    return FormatStringF(a_str, a_count, "#err# unknown format %u", a_message.m_formatId);
+  }
+
+  a_message.m_args.Start(); // Rewind, message may be rendered more than once
+  if( syntax == BinaryLog::SYNTAX_PRINTF )
+  {
+    return FormatStringF(a_str, a_count, format, a_message.m_args);
+  }
+  if( syntax == BinaryLog::SYNTAX_SCAN )
+  {
+    return FormatStringF(a_str, a_count, "%s", a_message.m_args.GetAt(0));
+  }
+  return FormatString(a_str, a_count, format, a_message.m_args);
+}
+
+END_NAMESPACE_FORMATSTRINGLIB
@@ -0,0 +1,180 @@
+#ifndef BINARYLOG_H
+#define BINARYLOG_H
+
+//
+// BinaryLog.h
+// Compact binary log records, rendered to text later through FormatString / FormatStringF
+//
+
+#include "Arg.h"
+#include "MappedFile.h"
+
+//
+// Instead of formatting text at the log site, the writer stores the format string once and then
+// a small record per message holding the format id, a timestamp and the boxed argument values.
+// A reader (eg. the Tools/BinaryLogDecode tool) renders the records to text offline.
+//
+// Stream layout, all integers are LEB128 varints unless noted:
+//
+//   record  = kind:u8 payloadLength payload
+//   kind 0  = end of log (zero filled remainder of a mapped file)
+//   kind 1  = format definition: formatId syntax:u8 length text '\0'
+//   kind 2  = message: formatId timestampDelta(zigzag) argCount { argType:u8 value }*
+//
+// Argument values by Arg::ArgType tag:
+//   CHAR, INT8..INT64     zigzag varint
+//   UINT8..UINT64, PTR    varint
+//   FLOAT32 / FLOAT64     4 / 8 raw IEEE bytes, little endian
+//   CSTR                  length, bytes, '\0'   (decoded Arg points directly into the log memory)
+//   DECIMAL64             units and scale, zigzag varints
+//   output (pointer) types are not logged and decode as ARG_TYPE_INVALID
+//
+// Eg.
+//   static fsUInt32 s_fmtId = log.RegisterFormat("Count: {0} value: {1:F3}", BinaryLog::SYNTAX_BRACED);
+//   log.Write(s_fmtId, timeNowNS, 34, 123.456789);
+//
+
+BEGIN_NAMESPACE_FORMATSTRINGLIB
+
+class BinaryLog
+{
+public:
+
+  // Format string syntax, selects FormatString or FormatStringF for rendering
+  enum Syntax
+  {
+    SYNTAX_BRACED = 0,                            // FormatString "{0}"
+    SYNTAX_PRINTF = 1,                            // FormatStringF "%d"
+    SYNTAX_SCAN = 2,                              // ScanStringF "%d", first argument is the input (see FormatRecorder.h)
+  };
+
+  // Record kinds
+  enum RecordKind
+  {
+    RECORD_END = 0,
+    RECORD_FORMAT = 1,
+    RECORD_MESSAGE = 2,
+  };
+
+  enum
+  {
+    INVALID_FORMAT_ID = 0,
+  };
+};
+
+
+// Decoded message record
+struct BinaryLogMessage
+{
+  fsUInt32 m_formatId;                            // Id returned by BinaryLogWriter::RegisterFormat()
+  fsUInt64 m_timestamp;                           // Caller defined time units
+  ArgListFixed m_args;                            // Decoded arguments, strings reference log memory
+};
+
+
+// Write binary log records into memory or a memory-mapped file
+// Note, not designed for reentrant use.
+class BinaryLogWriter
+{
+public:
+
+  BinaryLogWriter();
+  ~BinaryLogWriter();
+
+  // Write records into caller supplied memory
+  void OpenMemory(fsUInt8* a_buffer, size_t a_size);
+
+  // Create a memory-mapped log file with initial capacity, the file grows as needed.
+  // If growing fails all later writes fail, records written before are kept.
+  fsBool OpenFile(const fsChar* a_path, size_t a_initialCapacity = 1024 * 1024);
+
+  // Finish writing. Mapped files are truncated to the used size.
+  void Close();
+
+  // Store format string in the log and return its id, or BinaryLog::INVALID_FORMAT_ID if out of space
+  fsUInt32 RegisterFormat(const fsChar* a_format, BinaryLog::Syntax a_syntax);
+
+  // Append message record. Returns true if succeeded.
+  fsBool Write(fsUInt32 a_formatId, fsUInt64 a_timestamp, ArgList& a_args);
+
+  // Message record with variable argument overloads
+  fsBool Write(fsUInt32 a_formatId, fsUInt64 a_timestamp)                                                                                  {  ArgListFixed args;                                                 return Write(a_formatId, a_timestamp, args); }
+  fsBool Write(fsUInt32 a_formatId, fsUInt64 a_timestamp, Arg a_p1)                                                                        {  ArgListFixed args(a_p1);                                           return Write(a_formatId, a_timestamp, args); }
+  fsBool Write(fsUInt32 a_formatId, fsUInt64 a_timestamp, Arg a_p1, Arg a_p2)                                                              {  ArgListFixed args(a_p1, a_p2);                                     return Write(a_formatId, a_timestamp, args); }
+  fsBool Write(fsUInt32 a_formatId, fsUInt64 a_timestamp, Arg a_p1, Arg a_p2, Arg a_p3)                                                    {  ArgListFixed args(a_p1, a_p2, a_p3);                               return Write(a_formatId, a_timestamp, args); }
+  fsBool Write(fsUInt32 a_formatId, fsUInt64 a_timestamp, Arg a_p1, Arg a_p2, Arg a_p3, Arg a_p4)                                          {  ArgListFixed args(a_p1, a_p2, a_p3, a_p4);                         return Write(a_formatId, a_timestamp, args); }
+  fsBool Write(fsUInt32 a_formatId, fsUInt64 a_timestamp, Arg a_p1, Arg a_p2, Arg a_p3, Arg a_p4, Arg a_p5)                                {  ArgListFixed args(a_p1, a_p2, a_p3, a_p4, a_p5);                   return Write(a_formatId, a_timestamp, args); }
+  fsBool Write(fsUInt32 a_formatId, fsUInt64 a_timestamp, Arg a_p1, Arg a_p2, Arg a_p3, Arg a_p4, Arg a_p5, Arg a_p6)                      {  ArgListFixed args(a_p1, a_p2, a_p3, a_p4, a_p5, a_p6);             return Write(a_formatId, a_timestamp, args); }
+  fsBool Write(fsUInt32 a_formatId, fsUInt64 a_timestamp, Arg a_p1, Arg a_p2, Arg a_p3, Arg a_p4, Arg a_p5, Arg a_p6, Arg a_p7)            {  ArgListFixed args(a_p1, a_p2, a_p3, a_p4, a_p5, a_p6, a_p7);       return Write(a_formatId, a_timestamp, args); }
+  fsBool Write(fsUInt32 a_formatId, fsUInt64 a_timestamp, Arg a_p1, Arg a_p2, Arg a_p3, Arg a_p4, Arg a_p5, Arg a_p6, Arg a_p7, Arg a_p8)  {  ArgListFixed args(a_p1, a_p2, a_p3, a_p4, a_p5, a_p6, a_p7, a_p8); return Write(a_formatId, a_timestamp, args); }
+
+  // Number of bytes written so far
+  size_t GetSize() const                          { return m_size; }
+
+protected:
+
+  fsUInt8* m_data;                                // Destination memory
+  size_t m_capacity;                              // Size of destination memory
+  size_t m_size;                                  // Bytes used
+  fsUInt64 m_lastTimestamp;                       // Previous timestamp, for delta encoding
+  fsUInt32 m_nextFormatId;                        // Id for next registered format
+  MappedFile m_file;                              // Used by OpenFile()
+
+  fsBool InternalReserve(size_t a_numBytes);
+};
+
+
+// Read and render binary log records
+// Note, not designed for reentrant use.
+class BinaryLogReader
+{
+public:
+
+  BinaryLogReader();
+  ~BinaryLogReader();
+
+  // Read records from memory. Memory must remain valid while messages are in use.
+  void OpenMemory(const fsUInt8* a_data, size_t a_size);
+
+  // Map log file read-only
+  fsBool OpenFile(const fsChar* a_path);
+
+  void Close();
+
+  // Read next message, format definitions are absorbed along the way.
+  // Returns false at end of log or on a corrupt record.
+  fsBool ReadNext(BinaryLogMessage& a_message);
+
+  // Look up a format definition seen so far. Returns NULL if unknown.
+  const fsChar* GetFormat(fsUInt32 a_formatId, BinaryLog::Syntax* a_syntax = NULL) const;
+
+  // Render message text through FormatString / FormatStringF, scans render their input. Returns length as per FormatString.
+  fsInt Render(BinaryLogMessage& a_message, fsChar* a_str, size_t a_count) const;
+
+  // True if reading stopped due to a malformed record
+  fsBool IsCorrupt() const                        { return m_corrupt; }
+
+protected:
+
+  struct FormatDef
+  {
+    const fsChar* m_text;
+    BinaryLog::Syntax m_syntax;
+  };
+
+  const fsUInt8* m_data;
+  size_t m_size;
+  size_t m_pos;                                   // Read position
+  fsUInt64 m_lastTimestamp;                       // Previous timestamp, for delta decoding
+  fsBool m_corrupt;
+  FormatDef* m_formats;                           // Format definitions indexed by id
+  fsUInt32 m_maxFormats;                          // Allocated size of m_formats
+  MappedFile m_file;                              // Used by OpenFile()
+
+  fsBool InternalReadFormat(const fsUInt8* a_payload, size_t a_length);
+  fsBool InternalReadMessage(const fsUInt8* a_payload, size_t a_length, BinaryLogMessage& a_message);
+};
+
+END_NAMESPACE_FORMATSTRINGLIB
+
+#endif //BINARYLOG_H
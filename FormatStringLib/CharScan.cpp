@@ -0,0 +1,96 @@
+//
+// CharScan.cpp
+// Vectorised search for format delimiters in zero terminated strings
+//
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#define CHARSCAN_USE_SSE2 1
+#include <emmintrin.h>
+#endif
+#if defined(__AVX2__)
+#define CHARSCAN_USE_AVX2 1
+#include <immintrin.h>
+#endif
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+#include <string.h>
+#include "CharScan.h"
+
+// Aligned block loads may read past the terminator within the block, which is safe but not to AddressSanitizer
+#if defined(__GNUC__) || defined(__clang__)
+#define CHARSCAN_NO_SANITIZE __attribute__((no_sanitize_address))
+#else
+#define CHARSCAN_NO_SANITIZE
+#endif
+
+BEGIN_NAMESPACE_FORMATSTRINGLIB
+
+#if CHARSCAN_USE_SSE2 || CHARSCAN_USE_AVX2
+// Index of lowest set bit of a non-zero mask
+static inline fsInt lowest_bit(fsUInt32 a_mask)
+{
+#if defined(__GNUC__) || defined(__clang__)
+  return __builtin_ctz(a_mask);
+#else
+  unsigned long index;
+  _BitScanForward(&index, a_mask);
+  return (fsInt)index;
+#endif
+}
+#endif // CHARSCAN_USE_SSE2 || CHARSCAN_USE_AVX2
+
+
+CHARSCAN_NO_SANITIZE
+const fsChar* CharScan::FindAny(const fsChar* a_str, fsChar a_char1, fsChar a_char2)
+{
+#if CHARSCAN_USE_AVX2
+  const size_t BLOCK = 32;
+  size_t misalign = (size_t)a_str & (BLOCK - 1);
+  const fsChar* block = a_str - misalign;
+  __m256i match1 = _mm256_set1_epi8(a_char1);
+  __m256i match2 = _mm256_set1_epi8(a_char2);
+  __m256i zero = _mm256_setzero_si256();
+  __m256i data = _mm256_load_si256((const __m256i*)block);
+  fsUInt32 mask = (fsUInt32)_mm256_movemask_epi8(_mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(data, match1),
+                                                                                 _mm256_cmpeq_epi8(data, match2)),
+                                                                 _mm256_cmpeq_epi8(data, zero)));
+  mask &= ~0U << misalign; // Ignore bytes before a_str
+  while( mask == 0 )
+  {
+    block += BLOCK;
+    data = _mm256_load_si256((const __m256i*)block);
+    mask = (fsUInt32)_mm256_movemask_epi8(_mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(data, match1),
+                                                                          _mm256_cmpeq_epi8(data, match2)),
+                                                          _mm256_cmpeq_epi8(data, zero)));
+  }
+  return block + lowest_bit(mask);
+#elif CHARSCAN_USE_SSE2
+  const size_t BLOCK = 16;
+  size_t misalign = (size_t)a_str & (BLOCK - 1);
+  const fsChar* block = a_str - misalign;
+  __m128i match1 = _mm_set1_epi8(a_char1);
+  __m128i match2 = _mm_set1_epi8(a_char2);
+  __m128i zero = _mm_setzero_si128();
+  __m128i data = _mm_load_si128((const __m128i*)block);
+  fsUInt32 mask = (fsUInt32)_mm_movemask_epi8(_mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(data, match1),
+                                                                        _mm_cmpeq_epi8(data, match2)),
+                                                           _mm_cmpeq_epi8(data, zero)));
+  mask &= ~0U << misalign; // Ignore bytes before a_str
+  while( mask == 0 )
+  {
+    block += BLOCK;
+    data = _mm_load_si128((const __m128i*)block);
+    mask = (fsUInt32)_mm_movemask_epi8(_mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(data, match1),
+                                                                 _mm_cmpeq_epi8(data, match2)),
+                                                    _mm_cmpeq_epi8(data, zero)));
+  }
+  return block + lowest_bit(mask);
+#else // CHARSCAN_USE_SSE2
+  fsChar set[3] = {a_char1, a_char2, 0};
+  return a_str + strcspn(a_str, set);
+#endif // CHARSCAN_USE_SSE2
+}
+
+END_NAMESPACE_FORMATSTRINGLIB
@@ -0,0 +1,32 @@
+#ifndef CHARSCAN_H
+#define CHARSCAN_H
+
+//
+// CharScan.h
+// Vectorised search for format delimiters in zero terminated strings
+//
+
+#include <stddef.h>
+#include "Utils.h"
+
+BEGIN_NAMESPACE_FORMATSTRINGLIB
+
+class CharScan
+{
+public:
+
+  // First occurrence of a_char1, a_char2 or the terminating zero in a_str.
+  // Checks 16 (SSE2) or 32 (AVX2) bytes at a time, otherwise uses strcspn.
+  // Vector loads are aligned so never cross a page past the terminator.
+  static const fsChar* FindAny(const fsChar* a_str, fsChar a_char1, fsChar a_char2);
+
+  // First occurrence of a_char or the terminating zero in a_str
+  static const fsChar* Find(const fsChar* a_str, fsChar a_char)
+  {
+    return FindAny(a_str, a_char, a_char);
+  }
+};
+
+END_NAMESPACE_FORMATSTRINGLIB
+
+#endif //CHARSCAN_H
@@ -0,0 +1,180 @@
+#ifndef COMPILEDFORMAT_H
+#define COMPILEDFORMAT_H
+
+//
+// CompiledFormat.h
+// Format string parsed once into literal runs and conversion fields, for repeated use
+//
+
+#include "Utils.h"
+
+BEGIN_NAMESPACE_FORMATSTRINGLIB
+
+// A run of literal text followed by an optional conversion.
+// Literal text references the original format string, escapes ("%%", "{{") split runs.
+struct FormatField
+{
+  enum
+  {
+    NO_ARG = -1,
+  };
+
+  fsInt32 m_literalOffset;                        // Offset of literal text in the format string
+  fsInt32 m_literalLength;                        // Number of literal chars output before the conversion
+  fsInt32 m_min;                                  // Minimum width / alignment
+  fsInt32 m_max;                                  // Precision, -1 for default
+  fsInt32 m_flags;                                // Formatting flags (front end specific)
+  fsInt16 m_argIndex;                             // Zero based argument to convert, NO_ARG if literal only
+  fsInt16 m_minArgIndex;                          // Argument supplying width ('*'), NO_ARG if none
+  fsInt16 m_maxArgIndex;                          // Argument supplying precision ('*'), NO_ARG if none
+  fsChar m_conversion;                            // Conversion type ('{' for braced fields), 0 if literal only
+  fsChar m_modifier;                              // Length modifier, or braced format type (front end specific)
+};
+
+
+// One bytecode instruction, its operands (literal, argument, width, precision, flags) are those of field m_field.
+// Compiling lowers the fields to ops specialized for common conversions, with a guard on the argument type that
+// falls back to OP_GENERIC, and fuses a conversion with the literal-only field after it.
+struct FormatOp
+{
+  enum Opcode
+  {
+    OP_END = 0,                                   // Terminate the output
+    OP_LITERAL,                                   // Literal run only
+    OP_INT_DEC,                                   // Literal, then an integer in decimal, no width, precision or flags
+    OP_INT_DEC_LITERAL,                           // OP_INT_DEC, then the literal of the next field
+    OP_STRING,                                    // Literal, then a string, no width, precision or flags
+    OP_STRING_LITERAL,                            // OP_STRING, then the literal of the next field
+    OP_FLOAT_FIXED,                               // Literal, then a fixed point float, with the field's width, precision and flags
+    OP_GENERIC,                                   // Literal, then the front end's full conversion
+    NUM_OPCODES
+  };
+
+  fsUInt8 m_opcode;                               // Opcode enum
+  fsUInt8 m_field;                                // Index into CompiledFormat::m_fields
+};
+
+
+// Read-only reference to a compiled format held elsewhere, a CompiledFormat (see GetView()) or a mapped
+// FormatCatalog. Formatting through a view runs the referenced bytecode in place.
+struct CompiledFormatView
+{
+  const fsChar* m_format;                         // Source format string, NULL if not valid
+  const FormatField* m_fields;
+  const FormatOp* m_code;                         // Ends with FormatOp::OP_END
+  fsInt m_syntax;                                 // CompiledFormat::Syntax enum
+  fsInt m_numFields;
+  fsInt m_numArgs;
+  fsBool m_named;
+
+  CompiledFormatView() : m_format(NULL), m_fields(NULL), m_code(NULL), m_syntax(0), m_numFields(0), m_numArgs(0), m_named(false) {}
+
+  fsBool IsValid() const                          { return m_format != NULL; }
+};
+
+
+// Format string compiled by CompileFormatString() or CompileFormatStringF()
+// NOTE: References the source format string, which must outlive this object (usually a literal).
+class CompiledFormat
+{
+public:
+
+  enum Syntax
+  {
+    SYNTAX_BRACED = 0,                            // FormatString "{0}"
+    SYNTAX_PRINTF = 1,                            // FormatStringF "%d"
+  };
+
+  enum
+  {
+    MAX_FIELDS = 64,                              // Literal runs + conversions
+  };
+
+  const fsChar* m_format;                         // Source format string, NULL if not compiled
+  fsInt m_syntax;                                 // Syntax enum
+  fsInt m_numFields;                              // Used entries in m_fields
+  fsInt m_numArgs;                                // Number of arguments referenced
+  fsBool m_named;                                 // Has braced fields bound by name, indices depend on the names compiled against
+  FormatField m_fields[MAX_FIELDS];
+  fsInt m_codeLength;                             // Used entries in m_code, including the OP_END
+  FormatOp m_code[MAX_FIELDS + 1];                // Bytecode run by FormatString() / FormatStringF()
+
+  CompiledFormat()
+  {
+    m_format = NULL;
+    m_syntax = SYNTAX_PRINTF;
+    m_numFields = 0;
+    m_numArgs = 0;
+    m_named = false;
+    m_codeLength = 1;
+    m_code[0].m_opcode = FormatOp::OP_END;
+    m_code[0].m_field = 0;
+  }
+
+  fsBool IsValid() const                          { return m_format != NULL; }
+
+  CompiledFormatView GetView() const
+  {
+    CompiledFormatView view;
+    view.m_format = m_format;
+    view.m_fields = m_fields;
+    view.m_code = m_code;
+    view.m_syntax = m_syntax;
+    view.m_numFields = m_numFields;
+    view.m_numArgs = m_numArgs;
+    view.m_named = m_named;
+    return view;
+  }
+
+  // Lower m_fields to m_code, a_opcodes holds the opcode the front end chose for each field
+  void EmitCode(const fsUInt8* a_opcodes)
+  {
+    m_codeLength = 0;
+    for( fsInt fieldIndex = 0; fieldIndex < m_numFields; ++fieldIndex )
+    {
+      fsUInt8 opcode = a_opcodes[fieldIndex];
+      if( (fieldIndex + 1 < m_numFields) && (a_opcodes[fieldIndex + 1] == FormatOp::OP_LITERAL) )
+      {
+        if( (opcode == FormatOp::OP_INT_DEC) || (opcode == FormatOp::OP_STRING) )
+        {
+          opcode = (opcode == FormatOp::OP_INT_DEC) ? FormatOp::OP_INT_DEC_LITERAL : FormatOp::OP_STRING_LITERAL;
+          m_code[m_codeLength].m_opcode = opcode;
+          m_code[m_codeLength++].m_field = (fsUInt8)fieldIndex++; // Next field is consumed
+          continue;
+        }
+      }
+      m_code[m_codeLength].m_opcode = opcode;
+      m_code[m_codeLength++].m_field = (fsUInt8)fieldIndex;
+    }
+    m_code[m_codeLength].m_opcode = FormatOp::OP_END;
+    m_code[m_codeLength++].m_field = 0;
+  }
+};
+
+
+// Threaded dispatch for the bytecode interpreters, one indirect jump per op through a table of label addresses
+// (GCC / Clang labels as values), otherwise a switch in a loop. The interpreter defines s_labels in opcode order.
+// Eg. FS_DISPATCH(op) FS_OP(OP_LITERAL, op_literal) { ...; FS_NEXT(op); } ... FS_OP(OP_END, op_end) {} FS_END_DISPATCH
+#ifndef FS_THREADED_DISPATCH
+#if defined(__GNUC__)
+#define FS_THREADED_DISPATCH 1
+#else
+#define FS_THREADED_DISPATCH 0
+#endif
+#endif // FS_THREADED_DISPATCH
+
+#if FS_THREADED_DISPATCH
+#define FS_DISPATCH(a_op)           goto *s_labels[(a_op)->m_opcode];
+#define FS_OP(a_opcode, a_label)    a_label:
+#define FS_NEXT(a_op)               goto *s_labels[(++(a_op))->m_opcode]
+#define FS_END_DISPATCH
+#else // FS_THREADED_DISPATCH
+#define FS_DISPATCH(a_op)           for(;;) { switch( (a_op)->m_opcode ) {
+#define FS_OP(a_opcode, a_label)    case FormatOp::a_opcode:
+#define FS_NEXT(a_op)               ++(a_op); continue
+#define FS_END_DISPATCH             default: break; } break; }
+#endif // FS_THREADED_DISPATCH
+
+END_NAMESPACE_FORMATSTRINGLIB
+
+#endif //COMPILEDFORMAT_H
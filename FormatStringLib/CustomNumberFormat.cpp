@@ -0,0 +1,676 @@
+//
+// CustomNumberFormat.cpp
+// .Net style custom numeric format strings, compiled once into a list of output ops
+//
+
+#include <mutex>
+#include <string.h>
+#include "CustomNumberFormat.h"
+#include "NumberFormat.h"
+
+BEGIN_NAMESPACE_FORMATSTRINGLIB
+
+// Decimal digits of a value, without leading or trailing zeros. Value is 0.digits * 10^m_point.
+struct CustomDigits
+{
+  enum
+  {
+    MAX_DIGITS = 48,                              // 128bit integer or float digits
+  };
+
+  fsChar m_digits[MAX_DIGITS];
+  fsInt m_numDigits;                              // 0 for zero
+  fsInt m_point;                                  // Digits before the decimal point, may be negative or beyond m_numDigits
+};
+
+std::atomic<CustomNumberFormat*> CustomNumberFormat::s_interned[MAX_INTERNED];
+std::atomic<fsUInt64> CustomNumberFormat::s_rejected[MAX_REJECTED];
+std::atomic<bool> CustomNumberFormat::s_internFull(false);
+static std::mutex s_internMutex;                  // Serialises Intern() inserts
+static fsInt s_numInterned = 0;                   // Patterns added, under s_internMutex
+
+static const fsUInt64 s_pow10[20] =
+{
+  1ULL, 10ULL, 100ULL, 1000ULL, 10000ULL, 100000ULL, 1000000ULL, 10000000ULL, 100000000ULL, 1000000000ULL,
+  10000000000ULL, 100000000000ULL, 1000000000000ULL, 10000000000000ULL, 100000000000000ULL,
+  1000000000000000ULL, 10000000000000000ULL, 100000000000000000ULL, 1000000000000000000ULL, 10000000000000000000ULL
+};
+
+
+// Drop trailing zeros, and leading zeros moving the decimal point
+static void normalize(CustomDigits& a_digits)
+{
+  fsInt leading = 0;
+  while( (leading < a_digits.m_numDigits) && (a_digits.m_digits[leading] == '0') )
+  {
+    ++leading;
+  }
+  if( leading > 0 )
+  {
+    memmove(a_digits.m_digits, a_digits.m_digits + leading, a_digits.m_numDigits - leading);
+    a_digits.m_numDigits -= leading;
+    a_digits.m_point -= leading;
+  }
+  while( (a_digits.m_numDigits > 0) && (a_digits.m_digits[a_digits.m_numDigits - 1] == '0') )
+  {
+    --a_digits.m_numDigits;
+  }
+}
+
+
+// Round half away from zero to a_keep leading digits
+static void round_digits(CustomDigits& a_digits, fsInt a_keep)
+{
+  if( a_keep >= a_digits.m_numDigits )
+  {
+    return;
+  }
+  if( a_keep < 0 )
+  {
+    a_digits.m_numDigits = 0;
+    return;
+  }
+
+  fsBool roundUp = (a_digits.m_digits[a_keep] >= '5');
+  a_digits.m_numDigits = a_keep;
+  if( roundUp )
+  {
+    fsInt index = a_keep - 1;
+    while( (index >= 0) && (a_digits.m_digits[index] == '9') )
+    {
+      --index;
+    }
+    if( index < 0 ) // All nines, carry into a new leading digit
+    {
+      a_digits.m_digits[0] = '1';
+      a_digits.m_numDigits = 1;
+      ++a_digits.m_point;
+    }
+    else
+    {
+      ++a_digits.m_digits[index];
+      a_digits.m_numDigits = index + 1;
+    }
+  }
+  normalize(a_digits);
+}
+
+
+// Multiply by 10^a_exponent, in two steps so intermediate powers stay finite
+static fsFloat64 scale_pow10(fsFloat64 a_value, fsInt a_exponent)
+{
+  fsInt half = a_exponent / 2;
+  return a_value * pow(10.0, half) * pow(10.0, a_exponent - half);
+}
+
+
+// a_numSignificant (1..17) rounded significant digits of a positive float
+static void float_significant(CustomDigits& a_digits, fsFloat64 a_value, fsInt a_numSignificant)
+{
+  fsInt exponent = (fsInt)floor(log10(a_value));
+  fsUInt64 mantissa = (fsUInt64)(scale_pow10(a_value, a_numSignificant - 1 - exponent) + 0.5);
+  if( mantissa >= s_pow10[a_numSignificant] ) // log10 rounded down a power of ten, or rounding carried
+  {
+    mantissa = (mantissa + 5) / 10;
+    ++exponent;
+  }
+  else if( mantissa < s_pow10[a_numSignificant - 1] )
+  {
+    --exponent;
+    mantissa = (fsUInt64)(scale_pow10(a_value, a_numSignificant - 1 - exponent) + 0.5);
+  }
+  a_digits.m_numDigits = NumberFormat::WriteDecimal(a_digits.m_digits, mantissa);
+  a_digits.m_point = exponent + 1;
+  normalize(a_digits);
+}
+
+
+// Digits of a positive float rounded to a_numFrac fraction digits, split into integer and fraction parts as fmtfp64() does
+static void float_fixed(CustomDigits& a_digits, fsFloat64 a_value, fsInt a_numFrac)
+{
+  fsInt numFrac = (a_numFrac < 16) ? a_numFrac : 16;
+  if( a_value >= 18446744073709551616.0 ) // Integer part does not fit 64 bits
+  {
+    float_significant(a_digits, a_value, 17);
+    round_digits(a_digits, a_digits.m_point + numFrac);
+    return;
+  }
+
+  fsUInt64 intPart = (fsUInt64)a_value;
+  fsUInt64 fracScale = s_pow10[numFrac];
+  fsUInt64 fracPart = (fsUInt64)((a_value - (fsFloat64)intPart) * (fsFloat64)fracScale + 0.5);
+  if( fracPart >= fracScale )
+  {
+    ++intPart;
+    fracPart -= fracScale;
+  }
+
+  fsInt numDigits = 0;
+  if( intPart != 0 )
+  {
+    numDigits = NumberFormat::WriteDecimal(a_digits.m_digits, intPart);
+  }
+  a_digits.m_point = numDigits;
+  for( fsInt index = numFrac - 1; index >= 0; --index ) // Fraction with leading zeros
+  {
+    a_digits.m_digits[numDigits + index] = (fsChar)('0' + fracPart % 10);
+    fracPart /= 10;
+  }
+  a_digits.m_numDigits = numDigits + numFrac;
+  normalize(a_digits);
+}
+
+
+// Bounded output
+struct CustomWriter
+{
+  fsChar* m_dest;
+  size_t m_length;
+
+  void Out(fsChar a_ch)
+  {
+    if( m_length < CustomNumberFormat::MAX_OUTPUT )
+    {
+      m_dest[m_length++] = a_ch;
+    }
+  }
+
+  void Out(const fsChar* a_text, size_t a_length)
+  {
+    if( a_length > CustomNumberFormat::MAX_OUTPUT - m_length )
+    {
+      a_length = CustomNumberFormat::MAX_OUTPUT - m_length;
+    }
+    memcpy(m_dest + m_length, a_text, a_length);
+    m_length += a_length;
+  }
+};
+
+
+CustomNumberFormat::CustomNumberFormat()
+{
+  m_numSections = 0;
+  m_numOps = 0;
+  m_textLength = 0;
+  m_pattern = NULL;
+  m_hash = 0;
+}
+
+
+CustomNumberFormat::~CustomNumberFormat()
+{
+  delete [] m_pattern;
+}
+
+
+fsBool CustomNumberFormat::AddOp(fsInt a_type, fsInt a_value, fsInt a_offset)
+{
+  if( (m_numOps >= MAX_OPS) || (a_value > 0xFF) )
+  {
+    return false;
+  }
+  Op& op = m_ops[m_numOps++];
+  op.m_type = (fsUInt8)a_type;
+  op.m_value = (fsUInt8)a_value;
+  op.m_offset = (fsUInt16)a_offset;
+  return true;
+}
+
+
+// Append literal text, extending the previous op if it is the literal just before
+fsBool CustomNumberFormat::AddLiteral(const fsChar* a_text, size_t a_length)
+{
+  if( a_length > (size_t)(MAX_TEXT - m_textLength) )
+  {
+    return false;
+  }
+  memcpy(m_text + m_textLength, a_text, a_length);
+  Op* last = (m_numOps > m_sections[m_numSections - 1].m_firstOp) ? &m_ops[m_numOps - 1] : NULL;
+  if( (last != NULL) && (last->m_type == OP_LITERAL) && (last->m_offset + last->m_value == m_textLength) && (last->m_value + a_length <= 0xFF) )
+  {
+    last->m_value = (fsUInt8)(last->m_value + a_length);
+  }
+  else if( !AddOp(OP_LITERAL, (fsInt)a_length, m_textLength) )
+  {
+    return false;
+  }
+  m_textLength += (fsInt)a_length;
+  return true;
+}
+
+
+// Compile one section, up to an unquoted ';' or the end. Returns the stop position, or NULL if out of space.
+const fsChar* CustomNumberFormat::CompileSection(const fsChar* a_pos, Section& a_section)
+{
+  a_section.m_firstOp = (fsInt16)m_numOps;
+  a_section.m_numInt = 0;
+  a_section.m_minInt = 0;
+  a_section.m_numFrac = 0;
+  a_section.m_minFrac = 0;
+  a_section.m_shift = 0;
+  a_section.m_expDigits = 0;
+  a_section.m_exponent = 0;
+  a_section.m_expPlus = false;
+  a_section.m_grouping = false;
+  a_section.m_empty = (*a_pos == '\0') || (*a_pos == ';');
+
+  const fsChar* pos = a_pos;
+  fsInt firstZero = -1;                           // Integer placeholder of the first '0'
+  fsInt pendingCommas = 0;                        // Commas since the last integer placeholder
+  fsBool inFraction = false;
+  fsBool ok = true;
+
+  while( ok && (*pos != '\0') && (*pos != ';') )
+  {
+    fsChar ch = *pos;
+    if( (ch == '0') || (ch == '#') )
+    {
+      if( inFraction )
+      {
+        if( ch == '0' )
+        {
+          a_section.m_minFrac = a_section.m_numFrac + 1;
+        }
+        ok = AddOp(OP_FRAC_DIGIT, a_section.m_numFrac++, 0);
+      }
+      else if( a_section.m_exponent == 0 )
+      {
+        if( (pendingCommas > 0) && (a_section.m_numInt > 0) )
+        {
+          a_section.m_grouping = true;
+        }
+        pendingCommas = 0;
+        if( (ch == '0') && (firstZero < 0) )
+        {
+          firstZero = a_section.m_numInt;
+        }
+        ok = AddOp(OP_INT_DIGIT, a_section.m_numInt++, 0);
+      }
+      ++pos;
+    }
+    else if( ch == '.' )
+    {
+      if( !inFraction && (a_section.m_exponent == 0) )
+      {
+        a_section.m_shift = (fsInt16)(a_section.m_shift - 3 * pendingCommas);
+        pendingCommas = 0;
+        if( a_section.m_numInt == 0 ) // Integer digits still go before the point
+        {
+          ok = AddOp(OP_INT_DIGIT, a_section.m_numInt++, 0);
+        }
+        ok = ok && AddOp(OP_POINT, 0, 0);
+        inFraction = true;
+      }
+      ++pos; // Further points are ignored
+    }
+    else if( ch == ',' )
+    {
+      if( !inFraction && (a_section.m_numInt > 0) ) // Commas before any digit placeholder are ignored
+      {
+        ++pendingCommas;
+      }
+      ++pos;
+    }
+    else if( ch == '%' )
+    {
+      a_section.m_shift += 2;
+      ok = AddLiteral(pos, 1);
+      ++pos;
+    }
+    else if( ((fsUInt8)ch == 0xE2) && ((fsUInt8)pos[1] == 0x80) && ((fsUInt8)pos[2] == 0xB0) ) // Per mille
+    {
+      a_section.m_shift += 3;
+      ok = AddLiteral(pos, 3);
+      pos += 3;
+    }
+    else if( ((ch == 'E') || (ch == 'e')) && (a_section.m_exponent == 0) &&
+             ((pos[1] == '0') || (((pos[1] == '+') || (pos[1] == '-')) && (pos[2] == '0'))) )
+    {
+      a_section.m_exponent = ch;
+      ++pos;
+      if( (*pos == '+') || (*pos == '-') )
+      {
+        a_section.m_expPlus = (*pos == '+');
+        ++pos;
+      }
+      while( *pos == '0' )
+      {
+        ++a_section.m_expDigits;
+        ++pos;
+      }
+      ok = AddOp(OP_EXPONENT, 0, 0);
+    }
+    else if( ch == '\\' )
+    {
+      if( pos[1] != '\0' )
+      {
+        ok = AddLiteral(pos + 1, 1);
+        ++pos;
+      }
+      ++pos;
+    }
+    else if( (ch == '\'') || (ch == '"') )
+    {
+      const fsChar* end = strchr(pos + 1, ch);
+      if( end == NULL )
+      {
+        end = pos + strlen(pos); // Unterminated, quote to the end
+      }
+      ok = AddLiteral(pos + 1, end - (pos + 1));
+      pos = (*end != '\0') ? end + 1 : end;
+    }
+    else
+    {
+      ok = AddLiteral(pos, 1);
+      ++pos;
+    }
+  }
+
+  if( !inFraction )
+  {
+    a_section.m_shift = (fsInt16)(a_section.m_shift - 3 * pendingCommas);
+  }
+  a_section.m_minInt = (fsInt16)((firstZero >= 0) ? a_section.m_numInt - firstZero : 0);
+  a_section.m_numOps = (fsInt16)(m_numOps - a_section.m_firstOp);
+  return ok ? pos : NULL;
+}
+
+
+fsBool CustomNumberFormat::Compile(const fsChar* a_pattern)
+{
+  m_numSections = 0;
+  m_numOps = 0;
+  m_textLength = 0;
+
+  const fsChar* pos = a_pattern;
+  while( m_numSections < MAX_SECTIONS ) // Sections after the third are ignored
+  {
+    Section& section = m_sections[m_numSections++];
+    pos = CompileSection(pos, section);
+    if( pos == NULL )
+    {
+      m_numSections = 0;
+      return false;
+    }
+    if( *pos != ';' )
+    {
+      break;
+    }
+    ++pos;
+  }
+  return true;
+}
+
+
+// Output a_digits with a section's ops
+size_t CustomNumberFormat::WriteSection(fsChar* a_dest, const Section& a_section, const CustomDigits& a_digits, fsBool a_minus) const
+{
+  CustomWriter writer = { a_dest, 0 };
+  if( a_minus )
+  {
+    writer.Out('-');
+  }
+
+  // Position of the decimal point within the digits, and the exponent that moved it
+  fsInt point = a_digits.m_point;
+  fsInt exponent = 0;
+  if( (a_section.m_exponent != 0) && (a_digits.m_numDigits > 0) )
+  {
+    fsInt numInt = (a_section.m_numInt > 0) ? a_section.m_numInt : 1;
+    exponent = point - numInt;
+    point = numInt;
+  }
+
+  // Integer digits are counted from the right, the first placeholder takes any extra leading digits
+  fsInt numIntDigits = (point > 0) ? point : 0;
+  fsInt intLength = (numIntDigits > a_section.m_minInt) ? numIntDigits : a_section.m_minInt;
+
+  // Fraction digits up to the last non-zero or forced digit
+  fsInt fracLength = a_section.m_numFrac;
+  while( fracLength > a_section.m_minFrac )
+  {
+    fsInt index = point + fracLength - 1;
+    if( (index >= 0) && (index < a_digits.m_numDigits) && (a_digits.m_digits[index] != '0') )
+    {
+      break;
+    }
+    --fracLength;
+  }
+
+  const NumberFormatProfile& profile = NumberFormat::GetProfile();
+  const Op* op = m_ops + a_section.m_firstOp;
+  const Op* opEnd = op + a_section.m_numOps;
+  for( ; op < opEnd; ++op )
+  {
+    switch( op->m_type )
+    {
+      case OP_LITERAL:
+      {
+        writer.Out(m_text + op->m_offset, op->m_value);
+        break;
+      }
+      case OP_INT_DIGIT:
+      {
+        fsInt position = a_section.m_numInt - 1 - op->m_value; // Digit position from the right
+        fsInt first = (op->m_value == 0) ? intLength - 1 : position;
+        for( fsInt digit = first; (digit >= position) && (digit < intLength); --digit )
+        {
+          fsInt index = numIntDigits - 1 - digit;
+          writer.Out(((index >= 0) && (index < a_digits.m_numDigits)) ? a_digits.m_digits[index] : '0');
+          if( a_section.m_grouping && (digit > 0) && (digit % 3 == 0) )
+          {
+            writer.Out(profile.m_groupSeparator, profile.m_groupSeparatorLength);
+          }
+        }
+        break;
+      }
+      case OP_POINT:
+      {
+        if( fracLength > 0 )
+        {
+          writer.Out(profile.m_decimalSeparator, profile.m_decimalSeparatorLength);
+        }
+        break;
+      }
+      case OP_FRAC_DIGIT:
+      {
+        if( op->m_value < fracLength )
+        {
+          fsInt index = point + op->m_value;
+          writer.Out(((index >= 0) && (index < a_digits.m_numDigits)) ? a_digits.m_digits[index] : '0');
+        }
+        break;
+      }
+      case OP_EXPONENT:
+      {
+        writer.Out(a_section.m_exponent);
+        if( exponent < 0 )
+        {
+          writer.Out('-');
+        }
+        else if( a_section.m_expPlus )
+        {
+          writer.Out('+');
+        }
+        fsChar expDigits[20];
+        fsInt numExpDigits = NumberFormat::WriteDecimal(expDigits, (fsUInt64)((exponent < 0) ? -exponent : exponent));
+        for( fsInt pad = numExpDigits; pad < a_section.m_expDigits; ++pad )
+        {
+          writer.Out('0');
+        }
+        writer.Out(expDigits, numExpDigits);
+        break;
+      }
+    }
+  }
+  return writer.m_length;
+}
+
+
+// Pick the section, round for it and output. a_exact holds integer digits, or NULL to convert a_float.
+size_t CustomNumberFormat::Write(fsChar* a_dest, const CustomDigits* a_exact, fsFloat64 a_float, fsBool a_negative) const
+{
+  if( m_numSections == 0 )
+  {
+    return 0;
+  }
+
+  fsInt sectionIndex = 0;
+  if( a_negative && (m_numSections >= 2) && !m_sections[1].m_empty )
+  {
+    sectionIndex = 1;
+  }
+  const Section& section = m_sections[sectionIndex];
+
+  CustomDigits digits;
+  if( a_exact != NULL )
+  {
+    digits = *a_exact;
+    digits.m_point += section.m_shift;
+  }
+  else if( a_float == 0.0 )
+  {
+    digits.m_numDigits = 0;
+    digits.m_point = 0;
+  }
+  else
+  {
+    fsFloat64 value = (a_float < 0.0) ? -a_float : a_float;
+    if( section.m_shift != 0 )
+    {
+      value = scale_pow10(value, section.m_shift);
+    }
+    if( section.m_exponent != 0 )
+    {
+      fsInt numSignificant = ((section.m_numInt > 0) ? section.m_numInt : 1) + section.m_numFrac;
+      float_significant(digits, value, (numSignificant < 17) ? numSignificant : 17);
+    }
+    else
+    {
+      float_fixed(digits, value, section.m_numFrac);
+    }
+  }
+
+  if( section.m_exponent != 0 )
+  {
+    round_digits(digits, ((section.m_numInt > 0) ? section.m_numInt : 1) + section.m_numFrac);
+  }
+  else
+  {
+    round_digits(digits, digits.m_point + section.m_numFrac);
+  }
+
+  if( digits.m_numDigits == 0 ) // Zero, or rounded to zero
+  {
+    digits.m_point = 0;
+    const Section& zeroSection = ((m_numSections >= 3) && !m_sections[2].m_empty) ? m_sections[2] : m_sections[0];
+    return WriteSection(a_dest, zeroSection, digits, false);
+  }
+  return WriteSection(a_dest, section, digits, a_negative && (sectionIndex == 0));
+}
+
+
+size_t CustomNumberFormat::WriteInteger(fsChar* a_dest, fsUInt64 a_magnitude, fsBool a_negative) const
+{
+  CustomDigits digits;
+  digits.m_numDigits = (a_magnitude != 0) ? NumberFormat::WriteDecimal(digits.m_digits, a_magnitude) : 0;
+  digits.m_point = digits.m_numDigits;
+  normalize(digits);
+  return Write(a_dest, &digits, 0.0, a_negative);
+}
+
+
+#if FS_HAS_INT128
+size_t CustomNumberFormat::WriteInteger128(fsChar* a_dest, fsUInt128 a_magnitude, fsBool a_negative) const
+{
+  fsChar converted[NumberFormat::MAX_CONVERT_CHARS_128];
+  CustomDigits digits;
+  digits.m_numDigits = (a_magnitude != 0) ? NumberFormat::WriteDecimal128(converted, a_magnitude) : 0;
+  memcpy(digits.m_digits, converted, digits.m_numDigits);
+  digits.m_point = digits.m_numDigits;
+  normalize(digits);
+  return Write(a_dest, &digits, 0.0, a_negative);
+}
+#endif // FS_HAS_INT128
+
+
+size_t CustomNumberFormat::WriteFloat(fsChar* a_dest, fsFloat64 a_value) const
+{
+  return Write(a_dest, NULL, a_value, a_value < 0.0);
+}
+
+
+fsInt CustomNumberFormat::Intern(const fsChar* a_pattern)
+{
+  fsUInt64 hash = 0xCBF29CE484222325ULL; // FNV-1a
+  for( const fsChar* pos = a_pattern; *pos != '\0'; ++pos )
+  {
+    hash = (hash ^ (fsUInt8)*pos) * 0x100000001B3ULL;
+  }
+
+  // Lock-free probe, entries are never removed or changed once published
+  fsInt slot = (fsInt)(hash & (MAX_INTERNED - 1));
+  for( fsInt probe = 0; probe < MAX_INTERNED; ++probe )
+  {
+    CustomNumberFormat* entry = s_interned[slot].load(std::memory_order_acquire);
+    if( entry == NULL )
+    {
+      break;
+    }
+    if( (entry->m_hash == hash) && (strcmp(entry->m_pattern, a_pattern) == 0) )
+    {
+      return slot;
+    }
+    slot = (slot + 1) & (MAX_INTERNED - 1);
+  }
+
+  // Not found. Known invalid patterns and a full table fail without the lock. A hash collision with an
+  // invalid pattern only costs the caller a local compile.
+  std::atomic<fsUInt64>& rejected = s_rejected[hash & (MAX_REJECTED - 1)];
+  if( rejected.load(std::memory_order_relaxed) == hash )
+  {
+    return INTERN_INVALID;
+  }
+  if( s_internFull.load(std::memory_order_relaxed) )
+  {
+    return INTERN_FULL;
+  }
+
+  // Probe again under the lock as another thread may have added it
+  std::lock_guard<std::mutex> lock(s_internMutex);
+  slot = (fsInt)(hash & (MAX_INTERNED - 1));
+  for( fsInt probe = 0; probe < MAX_INTERNED; ++probe )
+  {
+    CustomNumberFormat* entry = s_interned[slot].load(std::memory_order_relaxed);
+    if( entry == NULL )
+    {
+      if( s_numInterned >= MAX_INTERNED_PATTERNS )
+      {
+        s_internFull.store(true, std::memory_order_relaxed);
+        return INTERN_FULL;
+      }
+      CustomNumberFormat* added = new CustomNumberFormat;
+      if( !added->Compile(a_pattern) )
+      {
+        delete added;
+        rejected.store(hash, std::memory_order_relaxed);
+        return INTERN_INVALID;
+      }
+      ++s_numInterned;
+      size_t length = strlen(a_pattern);
+      added->m_pattern = new fsChar[length + 1];
+      memcpy(added->m_pattern, a_pattern, length + 1);
+      added->m_hash = hash;
+      s_interned[slot].store(added, std::memory_order_release);
+      return slot;
+    }
+    if( (entry->m_hash == hash) && (strcmp(entry->m_pattern, a_pattern) == 0) )
+    {
+      return slot;
+    }
+    slot = (slot + 1) & (MAX_INTERNED - 1);
+  }
+  return INTERN_FULL; // Not reached, at most MAX_INTERNED_PATTERNS slots are used
+}
+
+END_NAMESPACE_FORMATSTRINGLIB
@@ -0,0 +1,141 @@
+#ifndef CUSTOMNUMBERFORMAT_H
+#define CUSTOMNUMBERFORMAT_H
+
+//
+// CustomNumberFormat.h
+// .Net style custom numeric format strings, compiled once into a list of output ops
+//
+
+#include <atomic>
+#include <stddef.h>
+#include "Utils.h"
+
+//
+// Used by FormatString for any format that is not a standard numeric format, eg. "{0:#,##0.00}"
+//
+//   0 = Digit, or zero if the value has no digit in this position
+//   # = Digit if significant (leading and trailing zeros are not output)
+//   . = Decimal separator, the first one sets the position of the decimal point
+//   , = Group separator between digit placeholders, or divide by 1000 for each one just left of the decimal point
+//   % = Multiply by 100 and output '%'
+//   ‰ = Multiply by 1000 (per mille, UTF-8 E2 80 B0) and output it
+//   E0, E+0, E-0, e0, e+0, e-0 = Exponent notation, zeros give the minimum exponent digits
+//   \c, 'text', "text" = Literal text
+//   ; = Section separator: positive;negative;zero. The negative section replaces the minus sign,
+//       a value that rounds to zero uses the zero section. Empty sections use the first section.
+//   Anything else is output as is.
+//
+// Eg. FormatString(buffer, 512, "{0:#,##0.00}", 1234.5);       output: "1,234.50"
+//     FormatString(buffer, 512, "{0:0000}", 42);               output: "0042"
+//     FormatString(buffer, 512, "{0:0.##%}", 0.1234);          output: "12.34%"
+//     FormatString(buffer, 512, "{0:#,##0;(#,##0);Nil}", -5);  output: "(5)"
+//
+// Integers are converted exactly, scaling moves the decimal point. Floats are scaled in double precision
+// and rounded to the fraction digits of the pattern, up to 16 digits, as for "F".
+// Separators come from the number format profile, see NumberFormat.h
+//
+// FormatString interns each distinct pattern applied to a number, so it is compiled on first use and later
+// uses (and compiled formats) only look up its ops.
+//
+
+BEGIN_NAMESPACE_FORMATSTRINGLIB
+
+struct CustomDigits;
+
+class CustomNumberFormat
+{
+public:
+
+  enum
+  {
+    MAX_SECTIONS = 3,                             // positive;negative;zero
+    MAX_OPS = 64,                                 // Ops of all sections
+    MAX_TEXT = 128,                               // Literal bytes of all sections
+    MAX_OUTPUT = 256,                             // Bytes written per value, longer output is truncated
+    MAX_INTERNED = 256,                           // Intern() table slots
+    MAX_INTERNED_PATTERNS = MAX_INTERNED * 3 / 4, // Patterns kept, so a miss ends at an empty slot
+    MAX_REJECTED = 64,                            // Patterns remembered as not compiling
+
+    INTERN_FULL = -1,                             // Intern() results
+    INTERN_INVALID = -2,
+  };
+
+  CustomNumberFormat();
+  ~CustomNumberFormat();
+
+  // Compile a_pattern. Returns false if it has more ops or literal text than fits.
+  fsBool Compile(const fsChar* a_pattern);
+
+  // Write a value, not terminated. Returns bytes written, a_dest must hold MAX_OUTPUT.
+  size_t WriteInteger(fsChar* a_dest, fsUInt64 a_magnitude, fsBool a_negative) const;
+#if FS_HAS_INT128
+  size_t WriteInteger128(fsChar* a_dest, fsUInt128 a_magnitude, fsBool a_negative) const;
+#endif // FS_HAS_INT128
+  // Finite values only, the caller formats infinity and NaN
+  size_t WriteFloat(fsChar* a_dest, fsFloat64 a_value) const;
+
+  // Index of a_pattern in the process-wide table, compiling and adding it on first use. Returns INTERN_FULL
+  // when the table is full (compile it locally instead) or INTERN_INVALID if the pattern can not be compiled.
+  // Lookups are lock-free, and once the table is full or a pattern is known invalid so are failures.
+  static fsInt Intern(const fsChar* a_pattern);
+
+  // Interned pattern, a_index as returned by Intern()
+  static const CustomNumberFormat& Get(fsInt a_index) { return *s_interned[a_index].load(std::memory_order_acquire); }
+
+protected:
+
+  enum OpType
+  {
+    OP_LITERAL,                                   // m_value bytes of m_text from m_offset
+    OP_INT_DIGIT,                                 // Integer placeholder m_value, from the left
+    OP_POINT,                                     // Decimal separator, if any fraction digits are output
+    OP_FRAC_DIGIT,                                // Fraction placeholder m_value
+    OP_EXPONENT,                                  // Exponent, see Section
+  };
+
+  struct Op
+  {
+    fsUInt8 m_type;                               // OpType
+    fsUInt8 m_value;
+    fsUInt16 m_offset;
+  };
+
+  struct Section
+  {
+    fsInt16 m_firstOp;                            // Ops of this section in m_ops
+    fsInt16 m_numOps;
+    fsInt16 m_numInt;                             // Integer placeholders
+    fsInt16 m_minInt;                             // Integer digits always output, from the first '0'
+    fsInt16 m_numFrac;                            // Fraction placeholders
+    fsInt16 m_minFrac;                            // Fraction digits always output, up to the last '0'
+    fsInt16 m_shift;                              // Decimal point shift from % (2), ‰ (3) and scaling commas (-3 each)
+    fsInt16 m_expDigits;                          // Minimum exponent digits
+    fsChar m_exponent;                            // 'E' or 'e', 0 for fixed point
+    fsBool m_expPlus;                             // Output '+' for positive exponents
+    fsBool m_grouping;                            // Group separators between integer digits
+    fsBool m_empty;                               // No pattern text, the first section is used
+  };
+
+  const fsChar* CompileSection(const fsChar* a_pos, Section& a_section);
+  fsBool AddOp(fsInt a_type, fsInt a_value, fsInt a_offset);
+  fsBool AddLiteral(const fsChar* a_text, size_t a_length);
+  size_t Write(fsChar* a_dest, const CustomDigits* a_exact, fsFloat64 a_float, fsBool a_negative) const;
+  size_t WriteSection(fsChar* a_dest, const Section& a_section, const CustomDigits& a_digits, fsBool a_minus) const;
+
+  Section m_sections[MAX_SECTIONS];
+  fsInt m_numSections;
+  Op m_ops[MAX_OPS];
+  fsInt m_numOps;
+  fsChar m_text[MAX_TEXT];
+  fsInt m_textLength;
+  fsChar* m_pattern;                              // Copy of the pattern when interned, else NULL
+  fsUInt64 m_hash;
+
+  static std::atomic<CustomNumberFormat*> s_interned[MAX_INTERNED];
+  static std::atomic<fsUInt64> s_rejected[MAX_REJECTED]; // Hashes of invalid patterns, direct mapped
+  static std::atomic<bool> s_internFull;
+};
+
+END_NAMESPACE_FORMATSTRINGLIB
+
+#endif //CUSTOMNUMBERFORMAT_H
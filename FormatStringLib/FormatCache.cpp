@@ -0,0 +1,342 @@
+//
+// FormatCache.cpp
+// Process-wide cache of compiled format strings, keyed by format string pointer
+//
+
+#include <mutex>
+#include <string.h>
+#include "FormatCache.h"
+#include "FormatString.h"
+#include "FormatStringF.h"
+
+BEGIN_NAMESPACE_FORMATSTRINGLIB
+
+enum
+{
+  NOT_CACHEABLE = -1,                             // Entry m_numFields of a format the caller must not compile again
+};
+
+enum LookupResult
+{
+  LOOKUP_MISS,
+  LOOKUP_HIT,
+  LOOKUP_NOT_CACHEABLE,
+};
+
+// One cached format. Lookups copy the payload while an insert may be writing it (a seqlock),
+// the sequence count tells a lookup whether what it copied is consistent.
+struct CacheEntry
+{
+  std::atomic<fsUInt32> m_sequence;               // Odd while being written
+  std::atomic<fsUInt32> m_referenced;             // Clock bit, set by lookups, cleared by the eviction scan
+  std::atomic<const fsChar*> m_format;            // Key, NULL if empty
+  fsUInt64 m_hash;                                // Hash of the format text
+  fsInt32 m_syntax;                               // CompiledFormat::Syntax
+  std::atomic<fsInt32> m_numFields;               // Or NOT_CACHEABLE, atomic so the bounds checked count is the one copied
+  fsInt32 m_numArgs;
+  fsInt32 m_named;                                // Braced fields bound by name, resolved for the names hashed in m_namesHash
+  fsUInt64 m_namesHash;
+  FormatField m_fields[FormatCache::MAX_CACHED_FIELDS];
+  fsInt32 m_codeLength;
+  FormatOp m_code[FormatCache::MAX_CACHED_FIELDS + 1]; // Bytecode, at most one op per field plus OP_END
+};
+
+struct CacheTable
+{
+  CacheEntry* m_entries;                          // Sets of WAYS entries
+  fsUInt8* m_hands;                               // Clock hand per set, guarded by s_insertMutex
+  fsUInt64 m_setMask;                             // Number of sets - 1
+};
+
+std::atomic<bool> FormatCache::s_enabled(false);
+static std::atomic<CacheTable*> s_table(NULL);    // Allocated once, never freed
+static std::mutex s_insertMutex;                  // Serialises writers
+
+
+// Set index from the format pointer
+static fsUInt64 pointer_hash(const fsChar* a_fmt, fsInt a_syntax)
+{
+  fsUInt64 key = ((fsUInt64)(size_t)a_fmt ^ (fsUInt64)a_syntax) * 0x9E3779B97F4A7C15ULL;
+  return key ^ (key >> 32);
+}
+
+
+// Hash of the format text, 16 bytes at a time in two lanes
+static fsUInt64 text_hash(const fsChar* a_fmt)
+{
+  size_t length = strlen(a_fmt);
+  fsUInt64 hash = 0x9E3779B97F4A7C15ULL ^ length;
+  fsUInt64 hash2 = 0xC2B2AE3D27D4EB4FULL;        // Second lane, shortens the multiply chain
+  const fsChar* pos = a_fmt;
+  for( ; length >= 16; pos += 16, length -= 16 )
+  {
+    fsUInt64 word;
+    fsUInt64 word2;
+    memcpy(&word, pos, 8);
+    memcpy(&word2, pos + 8, 8);
+    hash = (hash ^ word) * 0xFF51AFD7ED558CCDULL;
+    hash2 = (hash2 ^ word2) * 0xC4CEB9FE1A85EC53ULL;
+    hash ^= hash >> 32;
+    hash2 ^= hash2 >> 29;
+  }
+  fsUInt64 tail = 0;
+  fsUInt64 tail2 = 0;
+  if( length >= 8 )
+  {
+    memcpy(&tail, pos, 8);
+    pos += 8;
+    length -= 8;
+  }
+  for( size_t index = 0; index < length; ++index )
+  {
+    tail2 |= (fsUInt64)(fsUInt8)pos[index] << (index * 8);
+  }
+  hash = (hash ^ tail ^ (hash2 >> 7)) * 0xFF51AFD7ED558CCDULL;
+  hash2 = (hash2 ^ tail2) * 0xC4CEB9FE1A85EC53ULL;
+  hash ^= hash2 ^ (hash >> 32);
+  return hash;
+}
+
+
+// Hash of the argument name pointers, in argument order
+static fsUInt64 names_hash(ArgList* a_args)
+{
+  fsUInt64 hash = 0x9E3779B97F4A7C15ULL;
+  if( a_args != NULL )
+  {
+    for( fsInt index = 0; index < a_args->Count(); ++index )
+    {
+      hash = (hash ^ (fsUInt64)(size_t)a_args->GetName(index)) * 0xFF51AFD7ED558CCDULL;
+      hash ^= hash >> 32;
+    }
+  }
+  return hash;
+}
+
+
+// Copy the entry into a_compiled if it is a consistent entry for a_fmt
+static LookupResult read_entry(CacheEntry& a_entry, const fsChar* a_fmt, fsInt a_syntax, fsUInt64 a_hash, ArgList* a_args, CompiledFormat& a_compiled)
+{
+  fsUInt32 sequence = a_entry.m_sequence.load(std::memory_order_acquire);
+  if( (sequence & 1) || (a_entry.m_format.load(std::memory_order_relaxed) != a_fmt) )
+  {
+    return LOOKUP_MISS;
+  }
+
+  // Values read here may be torn by a concurrent insert, they are only trusted once the sequence is rechecked
+  LookupResult result;
+  fsInt numFields = a_entry.m_numFields.load(std::memory_order_relaxed);
+  fsInt codeLength = a_entry.m_codeLength;
+  if( (a_entry.m_syntax != a_syntax) || (a_entry.m_hash != a_hash) )
+  {
+    result = LOOKUP_MISS;
+  }
+  else if( a_entry.m_named && (a_entry.m_namesHash != names_hash(a_args)) )
+  {
+    result = LOOKUP_MISS; // Indices were resolved for other argument names
+  }
+  else if( (numFields >= 0) && (numFields <= FormatCache::MAX_CACHED_FIELDS) && (codeLength > 0) && (codeLength <= numFields + 1) )
+  {
+    memcpy(a_compiled.m_fields, a_entry.m_fields, numFields * sizeof(FormatField));
+    memcpy(a_compiled.m_code, a_entry.m_code, codeLength * sizeof(FormatOp));
+    a_compiled.m_codeLength = codeLength;
+    a_compiled.m_syntax = a_syntax;
+    a_compiled.m_numFields = numFields;
+    a_compiled.m_numArgs = a_entry.m_numArgs;
+    a_compiled.m_named = (a_entry.m_named != 0);
+    result = LOOKUP_HIT;
+  }
+  else
+  {
+    result = LOOKUP_NOT_CACHEABLE;
+  }
+
+  std::atomic_thread_fence(std::memory_order_acquire);
+  if( a_entry.m_sequence.load(std::memory_order_relaxed) != sequence )
+  {
+    return LOOKUP_MISS; // Overwritten while copying
+  }
+  if( result == LOOKUP_HIT )
+  {
+    a_compiled.m_format = a_fmt;
+  }
+  return result;
+}
+
+
+// Overwrite an entry, a_compiled NULL to mark the format not cacheable. Called with s_insertMutex held.
+static void write_entry(CacheEntry& a_entry, const fsChar* a_fmt, fsInt a_syntax, fsUInt64 a_hash, fsUInt64 a_namesHash, const CompiledFormat* a_compiled)
+{
+  fsUInt32 sequence = a_entry.m_sequence.load(std::memory_order_relaxed);
+  a_entry.m_sequence.store(sequence + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+
+  a_entry.m_referenced.store(0, std::memory_order_relaxed);
+  a_entry.m_format.store(a_fmt, std::memory_order_relaxed);
+  a_entry.m_hash = a_hash;
+  a_entry.m_syntax = a_syntax;
+  if( a_compiled != NULL )
+  {
+    memcpy(a_entry.m_fields, a_compiled->m_fields, a_compiled->m_numFields * sizeof(FormatField));
+    memcpy(a_entry.m_code, a_compiled->m_code, a_compiled->m_codeLength * sizeof(FormatOp));
+    a_entry.m_codeLength = a_compiled->m_codeLength;
+    a_entry.m_numFields.store(a_compiled->m_numFields, std::memory_order_relaxed);
+    a_entry.m_numArgs = a_compiled->m_numArgs;
+    a_entry.m_named = a_compiled->m_named;
+    a_entry.m_namesHash = a_namesHash;
+  }
+  else
+  {
+    a_entry.m_numFields.store(NOT_CACHEABLE, std::memory_order_relaxed);
+    a_entry.m_numArgs = 0;
+    a_entry.m_codeLength = 0;
+    a_entry.m_named = false;
+    a_entry.m_namesHash = 0;
+  }
+
+  a_entry.m_sequence.store(sequence + 2, std::memory_order_release);
+}
+
+
+// Way to overwrite: a stale entry for the same format, an empty way, or the first unreferenced way from the clock hand.
+// Called with s_insertMutex held.
+static fsInt choose_victim(CacheTable* a_table, fsUInt64 a_setIndex, const fsChar* a_fmt, fsInt a_syntax)
+{
+  CacheEntry* set = a_table->m_entries + a_setIndex * FormatCache::WAYS;
+  for( fsInt way = 0; way < FormatCache::WAYS; ++way )
+  {
+    if( (set[way].m_format.load(std::memory_order_relaxed) == a_fmt) && (set[way].m_syntax == a_syntax) )
+    {
+      return way;
+    }
+  }
+  for( fsInt way = 0; way < FormatCache::WAYS; ++way )
+  {
+    if( set[way].m_format.load(std::memory_order_relaxed) == NULL )
+    {
+      return way;
+    }
+  }
+
+  fsUInt8& hand = a_table->m_hands[a_setIndex];
+  for( fsInt step = 0; step < 2 * FormatCache::WAYS; ++step ) // Bounded, lookups may set bits again while scanning
+  {
+    CacheEntry& entry = set[hand];
+    if( entry.m_referenced.load(std::memory_order_relaxed) == 0 )
+    {
+      break;
+    }
+    entry.m_referenced.store(0, std::memory_order_relaxed);
+    hand = (fsUInt8)((hand + 1) % FormatCache::WAYS);
+  }
+  fsInt way = hand;
+  hand = (fsUInt8)((hand + 1) % FormatCache::WAYS);
+  return way;
+}
+
+
+void FormatCache::Enable(fsInt a_capacity)
+{
+  std::lock_guard<std::mutex> lock(s_insertMutex);
+  if( s_table.load(std::memory_order_relaxed) == NULL )
+  {
+    fsUInt64 numSets = 1;
+    while( numSets * WAYS < (fsUInt64)((a_capacity > 0) ? a_capacity : DEFAULT_CAPACITY) )
+    {
+      numSets <<= 1;
+    }
+
+    CacheTable* table = new CacheTable;
+    table->m_entries = new CacheEntry[numSets * WAYS];
+    table->m_hands = new fsUInt8[numSets];
+    table->m_setMask = numSets - 1;
+    for( fsUInt64 index = 0; index < numSets * WAYS; ++index )
+    {
+      CacheEntry& entry = table->m_entries[index];
+      entry.m_sequence.store(0, std::memory_order_relaxed);
+      entry.m_referenced.store(0, std::memory_order_relaxed);
+      entry.m_format.store(NULL, std::memory_order_relaxed);
+      entry.m_hash = 0;
+      entry.m_syntax = 0;
+      entry.m_numFields.store(NOT_CACHEABLE, std::memory_order_relaxed);
+      entry.m_numArgs = 0;
+      entry.m_codeLength = 0;
+      entry.m_named = false;
+      entry.m_namesHash = 0;
+    }
+    memset(table->m_hands, 0, (size_t)numSets);
+    s_table.store(table, std::memory_order_release);
+  }
+  s_enabled.store(true, std::memory_order_release);
+}
+
+
+void FormatCache::Disable()
+{
+  s_enabled.store(false, std::memory_order_relaxed);
+}
+
+
+void FormatCache::Clear()
+{
+  std::lock_guard<std::mutex> lock(s_insertMutex);
+  CacheTable* table = s_table.load(std::memory_order_relaxed);
+  if( table != NULL )
+  {
+    for( fsUInt64 index = 0; index <= table->m_setMask; ++index )
+    {
+      table->m_hands[index] = 0;
+      for( fsInt way = 0; way < WAYS; ++way )
+      {
+        write_entry(table->m_entries[index * WAYS + way], NULL, 0, 0, 0, NULL);
+      }
+    }
+  }
+}
+
+
+fsBool FormatCache::Lookup(const fsChar* a_fmt, fsInt a_syntax, CompiledFormat& a_compiled, ArgList* a_args)
+{
+  CacheTable* table = s_table.load(std::memory_order_acquire);
+  if( !IsEnabled() || (table == NULL) || (a_fmt == NULL) )
+  {
+    return false;
+  }
+
+  fsUInt64 setIndex = pointer_hash(a_fmt, a_syntax) & table->m_setMask;
+  CacheEntry* set = table->m_entries + setIndex * WAYS;
+  fsUInt64 hash = text_hash(a_fmt);
+  for( fsInt way = 0; way < WAYS; ++way )
+  {
+    LookupResult result = read_entry(set[way], a_fmt, a_syntax, hash, a_args, a_compiled);
+    if( result != LOOKUP_MISS )
+    {
+      if( set[way].m_referenced.load(std::memory_order_relaxed) == 0 )
+      {
+        set[way].m_referenced.store(1, std::memory_order_relaxed);
+      }
+      return (result == LOOKUP_HIT);
+    }
+  }
+
+  // Miss, compile for this call and insert unless another thread is inserting
+  fsBool compiled;
+  if( a_syntax == CompiledFormat::SYNTAX_BRACED )
+  {
+    compiled = (a_args != NULL) ? CompileFormatString(a_fmt, a_compiled, *a_args) : CompileFormatString(a_fmt, a_compiled);
+  }
+  else
+  {
+    compiled = CompileFormatStringF(a_fmt, a_compiled);
+  }
+  std::unique_lock<std::mutex> lock(s_insertMutex, std::try_to_lock);
+  if( lock.owns_lock() )
+  {
+    fsBool cacheable = compiled && (a_compiled.m_numFields <= MAX_CACHED_FIELDS);
+    fsUInt64 namesHash = (compiled && a_compiled.m_named) ? names_hash(a_args) : 0;
+    write_entry(set[choose_victim(table, setIndex, a_fmt, a_syntax)], a_fmt, a_syntax, hash, namesHash, cacheable ? &a_compiled : NULL);
+  }
+  return compiled;
+}
+
+END_NAMESPACE_FORMATSTRINGLIB
@@ -0,0 +1,72 @@
+#ifndef FORMATCACHE_H
+#define FORMATCACHE_H
+
+//
+// FormatCache.h
+// Process-wide cache of compiled format strings, keyed by format string pointer
+//
+
+#include <atomic>
+#include "Arg.h"
+#include "CompiledFormat.h"
+
+//
+// Format strings are almost always literals, so the pointer identifies the format. When enabled,
+// FormatString() and FormatStringF() (and the Length, Stream and IoVec functions taking a format string)
+// look the format up here and use its compiled fields, so each format is parsed once per process.
+// A hash of the format text is stored with each entry and checked on every hit, a buffer reused for a
+// different format is compiled again rather than formatted with stale fields.
+//
+// Lookups are lock-free. Entries are copied out under a per entry sequence count, a lookup that races
+// with an insert into the same entry misses and compiles the format itself. Inserts are serialised by
+// a mutex and skipped (not waited for) when another thread is inserting.
+// The table has a fixed number of entries in sets of WAYS, a full set evicts by clock (second chance).
+//
+// Eg. FormatCache::Enable(); // Once at startup
+//     FormatStringF(buffer, 512, "Count: %d value: %.3f", 34, 123.456789); // Parsed on first call only
+//
+// Braced formats with named params are compiled against the names of the call's arguments. The entry keeps a hash of
+// the name pointers (names are expected to be literals, like formats), so a call naming its arguments differently
+// compiles again rather than using indices resolved for other names.
+//
+// NOTE: Disabled by default. Formats with more than MAX_CACHED_FIELDS fields are remembered as not cacheable.
+//
+
+BEGIN_NAMESPACE_FORMATSTRINGLIB
+
+class FormatCache
+{
+public:
+
+  enum
+  {
+    DEFAULT_CAPACITY = 256,                       // Entries
+    WAYS = 4,                                     // Entries per set
+    MAX_CACHED_FIELDS = 16,                       // Literal runs + conversions per cached format
+  };
+
+  // Enable lookups. The first call allocates a_capacity entries (rounded up to a power of two),
+  // the table is kept for the life of the process so lookups in flight never see it freed.
+  static void Enable(fsInt a_capacity = DEFAULT_CAPACITY);
+
+  // Stop lookups, entries are kept for a later Enable()
+  static void Disable();
+
+  static fsBool IsEnabled()                       { return s_enabled.load(std::memory_order_relaxed); }
+
+  // Remove all entries, eg. after freeing memory that held format strings
+  static void Clear();
+
+  // Copy the compiled a_fmt into a_compiled, compiling and inserting it on a miss.
+  // a_syntax is CompiledFormat::SYNTAX_BRACED or SYNTAX_PRINTF, a_args supplies names for braced named params.
+  // Returns false if disabled or the format can not be compiled or cached, use the uncompiled path.
+  static fsBool Lookup(const fsChar* a_fmt, fsInt a_syntax, CompiledFormat& a_compiled, ArgList* a_args = NULL);
+
+protected:
+
+  static std::atomic<bool> s_enabled;
+};
+
+END_NAMESPACE_FORMATSTRINGLIB
+
+#endif //FORMATCACHE_H
@@ -0,0 +1,409 @@
+//
+// FormatCatalog.cpp
+// Compiled formats persisted to a file and mapped read-only, so processes skip compiling them at startup
+//
+
+#include <algorithm>
+#include <string.h>
+#include "FormatCatalog.h"
+#include "FormatString.h"
+#include "FormatStringF.h"
+
+BEGIN_NAMESPACE_FORMATSTRINGLIB
+
+enum
+{
+  SECTION_ALIGN = 8,                              // Alignment of the sections, the widest member is 64bit
+};
+
+
+static inline size_t align_up(size_t a_offset)
+{
+  return (a_offset + (SECTION_ALIGN - 1)) & ~(size_t)(SECTION_ALIGN - 1);
+}
+
+
+// Index order, equal hashes in entry order so Find() returns the first added
+static bool index_less(const FormatCatalog::IndexEntry& a_left, const FormatCatalog::IndexEntry& a_right)
+{
+  return (a_left.m_hash < a_right.m_hash) || ((a_left.m_hash == a_right.m_hash) && (a_left.m_entry < a_right.m_entry));
+}
+
+
+// Section [a_offset, a_end) inside a file of a_size bytes, starting a_align aligned
+static inline fsBool valid_section(fsUInt32 a_offset, fsUInt32 a_end, size_t a_size, size_t a_align)
+{
+  return (a_offset <= a_end) && (a_end <= a_size) && ((a_offset & (a_align - 1)) == 0);
+}
+
+
+//
+// FormatCatalog
+//
+
+FormatCatalog::FormatCatalog()
+{
+  m_data = NULL;
+  m_header = NULL;
+  m_entries = NULL;
+  m_index = NULL;
+}
+
+
+FormatCatalog::~FormatCatalog()
+{
+  Close();
+}
+
+
+fsBool FormatCatalog::OpenFile(const fsChar* a_path, fsUInt32 a_flags)
+{
+  Close();
+  if( !m_file.OpenRead(a_path) )
+  {
+    return false;
+  }
+  if( !InternalOpen(m_file.GetData(), m_file.GetSize(), a_flags) )
+  {
+    Close();
+    return false;
+  }
+  return true;
+}
+
+
+fsBool FormatCatalog::OpenMemory(const void* a_data, size_t a_size, fsUInt32 a_flags)
+{
+  Close();
+  return InternalOpen((const fsUInt8*)a_data, a_size, a_flags);
+}
+
+
+void FormatCatalog::Close()
+{
+  m_file.Close();
+  m_data = NULL;
+  m_header = NULL;
+  m_entries = NULL;
+  m_index = NULL;
+}
+
+
+fsBool FormatCatalog::InternalOpen(const fsUInt8* a_data, size_t a_size, fsUInt32 a_flags)
+{
+  if( (a_data == NULL) || (a_size < sizeof(Header)) || (((size_t)a_data & (SECTION_ALIGN - 1)) != 0) )
+  {
+    return false;
+  }
+
+  const Header* header = (const Header*)a_data;
+  if(    (header->m_magic != MAGIC)
+      || (header->m_version != VERSION)
+      || (header->m_fieldSize != sizeof(FormatField))
+      || (header->m_opSize != sizeof(FormatOp))
+      || (header->m_entrySize != sizeof(Entry))
+      || (header->m_fileSize != a_size) )
+  {
+    return false; // Not a catalog, or written by a build with a different layout
+  }
+
+  // Sections in file order, each inside the file and ending where the next starts
+  fsUInt64 entriesEnd = (fsUInt64)header->m_entriesOffset + (fsUInt64)header->m_numFormats * sizeof(Entry);
+  fsUInt64 indexEnd = (fsUInt64)header->m_indexOffset + (fsUInt64)header->m_numFormats * sizeof(IndexEntry);
+  if(    (header->m_entriesOffset < sizeof(Header))
+      || (entriesEnd > header->m_indexOffset)
+      || (indexEnd > header->m_fieldsOffset)
+      || !valid_section(header->m_entriesOffset, header->m_indexOffset, a_size, SECTION_ALIGN)
+      || !valid_section(header->m_indexOffset, header->m_fieldsOffset, a_size, SECTION_ALIGN)
+      || !valid_section(header->m_fieldsOffset, header->m_codeOffset, a_size, SECTION_ALIGN)
+      || !valid_section(header->m_codeOffset, header->m_poolOffset, a_size, SECTION_ALIGN)
+      || !valid_section(header->m_poolOffset, header->m_fileSize, a_size, 1) )
+  {
+    return false;
+  }
+
+  m_data = a_data;
+  m_header = header;
+  m_entries = (const Entry*)(a_data + header->m_entriesOffset);
+  m_index = (const IndexEntry*)(a_data + header->m_indexOffset);
+
+  if( (a_flags & TRUSTED) == 0 )
+  {
+    for( fsUInt32 entryIndex = 0; entryIndex < header->m_numFormats; ++entryIndex )
+    {
+      const IndexEntry& index = m_index[entryIndex];
+      if(    !InternalValidateEntry(m_entries[entryIndex])
+          || (index.m_entry >= header->m_numFormats)
+          || (index.m_hash != m_entries[index.m_entry].m_hash)
+          || ((entryIndex > 0) && !index_less(m_index[entryIndex - 1], index)) )
+      {
+        Close();
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+
+// Everything the interpreters and Find() read through the entry must lie inside its sections
+fsBool FormatCatalog::InternalValidateEntry(const Entry& a_entry) const
+{
+  const Header& header = *m_header;
+  fsUInt64 poolSize = header.m_fileSize - header.m_poolOffset;
+  fsUInt64 fieldsSize = header.m_codeOffset - header.m_fieldsOffset;
+  fsUInt64 codeSize = header.m_poolOffset - header.m_codeOffset;
+
+  if(    (a_entry.m_syntax > CompiledFormat::SYNTAX_PRINTF)
+      || ((fsUInt64)a_entry.m_textOffset + a_entry.m_textLength >= poolSize)
+      || (m_data[header.m_poolOffset + a_entry.m_textOffset + a_entry.m_textLength] != 0)
+      || (a_entry.m_numFields > CompiledFormat::MAX_FIELDS)
+      || ((a_entry.m_fieldsOffset % sizeof(fsInt32)) != 0)
+      || ((fsUInt64)a_entry.m_fieldsOffset + (fsUInt64)a_entry.m_numFields * sizeof(FormatField) > fieldsSize)
+      || (a_entry.m_codeLength < 1)
+      || (a_entry.m_codeLength > a_entry.m_numFields + 1)
+      || ((fsUInt64)a_entry.m_codeOffset + (fsUInt64)a_entry.m_codeLength * sizeof(FormatOp) > codeSize) )
+  {
+    return false;
+  }
+  const fsChar* text = (const fsChar*)(m_data + header.m_poolOffset + a_entry.m_textOffset);
+  if( HashText(text, a_entry.m_textLength) != a_entry.m_hash )
+  {
+    return false;
+  }
+
+  const FormatField* fields = (const FormatField*)(m_data + header.m_fieldsOffset + a_entry.m_fieldsOffset);
+  for( fsInt fieldIndex = 0; fieldIndex < a_entry.m_numFields; ++fieldIndex )
+  {
+    const FormatField& field = fields[fieldIndex];
+    if(    (field.m_literalOffset < 0)
+        || (field.m_literalLength < 0)
+        || ((fsUInt64)field.m_literalOffset + (fsUInt64)field.m_literalLength > a_entry.m_textLength) )
+    {
+      return false;
+    }
+  }
+
+  const FormatOp* code = (const FormatOp*)(m_data + header.m_codeOffset + a_entry.m_codeOffset);
+  fsInt last = a_entry.m_codeLength - 1;
+  for( fsInt opIndex = 0; opIndex < last; ++opIndex )
+  {
+    const FormatOp& op = code[opIndex];
+    fsBool fused = (op.m_opcode == FormatOp::OP_INT_DEC_LITERAL) || (op.m_opcode == FormatOp::OP_STRING_LITERAL);
+    if(    (op.m_opcode == FormatOp::OP_END)
+        || (op.m_opcode >= FormatOp::NUM_OPCODES)
+        || (op.m_field + (fused ? 1 : 0) >= a_entry.m_numFields) )
+    {
+      return false;
+    }
+  }
+  if( code[last].m_opcode != FormatOp::OP_END )
+  {
+    return false;
+  }
+
+  CompiledFormatView view = Get((fsInt)(&a_entry - m_entries));
+  return IsPortableCompiledFormat(view);
+}
+
+
+CompiledFormatView FormatCatalog::Get(fsInt a_index) const
+{
+  CompiledFormatView view;
+  if( (m_header == NULL) || (a_index < 0) || ((fsUInt32)a_index >= m_header->m_numFormats) )
+  {
+    return view;
+  }
+  const Entry& entry = m_entries[a_index];
+  view.m_format = (const fsChar*)(m_data + m_header->m_poolOffset + entry.m_textOffset);
+  view.m_fields = (const FormatField*)(m_data + m_header->m_fieldsOffset + entry.m_fieldsOffset);
+  view.m_code = (const FormatOp*)(m_data + m_header->m_codeOffset + entry.m_codeOffset);
+  view.m_syntax = entry.m_syntax;
+  view.m_numFields = entry.m_numFields;
+  view.m_numArgs = entry.m_numArgs;
+  view.m_named = false;
+  return view;
+}
+
+
+fsInt FormatCatalog::Find(const fsChar* a_format, CompiledFormat::Syntax a_syntax) const
+{
+  if( (m_header == NULL) || (a_format == NULL) )
+  {
+    return NOT_FOUND;
+  }
+  size_t length = strlen(a_format);
+  IndexEntry key;
+  key.m_hash = HashText(a_format, length);
+  key.m_entry = 0;
+  key.m_reserved = 0;
+
+  const IndexEntry* end = m_index + m_header->m_numFormats;
+  for( const IndexEntry* index = std::lower_bound(m_index, end, key, index_less); (index != end) && (index->m_hash == key.m_hash); ++index )
+  {
+    const Entry& entry = m_entries[index->m_entry];
+    if(    (entry.m_syntax == (fsUInt16)a_syntax)
+        && (entry.m_textLength == length)
+        && (memcmp(m_data + m_header->m_poolOffset + entry.m_textOffset, a_format, length) == 0) )
+    {
+      return (fsInt)index->m_entry;
+    }
+  }
+  return NOT_FOUND;
+}
+
+
+fsUInt64 FormatCatalog::HashText(const fsChar* a_format, size_t a_length)
+{
+  fsUInt64 hash = 0xCBF29CE484222325ULL;
+  for( size_t index = 0; index < a_length; ++index )
+  {
+    hash = (hash ^ (fsUInt8)a_format[index]) * 0x100000001B3ULL;
+  }
+  return hash;
+}
+
+
+//
+// FormatCatalogWriter
+//
+
+fsInt FormatCatalogWriter::Add(const fsChar* a_format, CompiledFormat::Syntax a_syntax)
+{
+  if( (a_format == NULL) || (a_syntax < CompiledFormat::SYNTAX_BRACED) || (a_syntax > CompiledFormat::SYNTAX_PRINTF) )
+  {
+    return -1;
+  }
+  std::unordered_map<std::string, fsInt>::iterator found = m_indices[a_syntax].find(a_format);
+  if( found != m_indices[a_syntax].end() )
+  {
+    return found->second;
+  }
+
+  Format format;
+  format.m_text = a_format;
+  fsBool compiled = (a_syntax == CompiledFormat::SYNTAX_BRACED) ? CompileFormatString(a_format, format.m_compiled)
+                                                                : CompileFormatStringF(a_format, format.m_compiled);
+  if(    !compiled
+      || !IsPortableCompiledFormat(format.m_compiled.GetView())
+      || (format.m_text.size() >= 0xFFFFFFFFu)
+      || (format.m_compiled.m_numArgs > 0xFFFF) )
+  {
+    return -1;
+  }
+
+  fsInt index = (fsInt)m_formats.size();
+  m_formats.push_back(format);
+  m_indices[a_syntax][format.m_text] = index;
+  return index;
+}
+
+
+size_t FormatCatalogWriter::GetSize() const
+{
+  size_t numFields = 0;
+  size_t numOps = 0;
+  size_t poolSize = 0;
+  for( size_t index = 0; index < m_formats.size(); ++index )
+  {
+    numFields += m_formats[index].m_compiled.m_numFields;
+    numOps += m_formats[index].m_compiled.m_codeLength;
+    poolSize += m_formats[index].m_text.size() + 1;
+  }
+  size_t size = align_up(sizeof(FormatCatalog::Header));
+  size += m_formats.size() * (sizeof(FormatCatalog::Entry) + sizeof(FormatCatalog::IndexEntry));
+  size = align_up(size) + numFields * sizeof(FormatField);
+  size = align_up(size) + numOps * sizeof(FormatOp);
+  return align_up(size) + poolSize;
+}
+
+
+fsBool FormatCatalogWriter::Write(void* a_buffer, size_t a_size) const
+{
+  size_t size = GetSize();
+  if( (a_buffer == NULL) || (a_size < size) || (size > 0xFFFFFFFFu) )
+  {
+    return false;
+  }
+  fsUInt8* data = (fsUInt8*)a_buffer;
+  memset(data, 0, size);
+
+  size_t numFields = 0;
+  size_t numOps = 0;
+  for( size_t index = 0; index < m_formats.size(); ++index )
+  {
+    numFields += m_formats[index].m_compiled.m_numFields;
+    numOps += m_formats[index].m_compiled.m_codeLength;
+  }
+
+  FormatCatalog::Header* header = (FormatCatalog::Header*)data;
+  header->m_magic = FormatCatalog::MAGIC;
+  header->m_version = FormatCatalog::VERSION;
+  header->m_fieldSize = sizeof(FormatField);
+  header->m_opSize = sizeof(FormatOp);
+  header->m_entrySize = sizeof(FormatCatalog::Entry);
+  header->m_numFormats = (fsUInt32)m_formats.size();
+  header->m_entriesOffset = (fsUInt32)align_up(sizeof(FormatCatalog::Header));
+  header->m_indexOffset = header->m_entriesOffset + (fsUInt32)(m_formats.size() * sizeof(FormatCatalog::Entry));
+  header->m_fieldsOffset = (fsUInt32)align_up(header->m_indexOffset + m_formats.size() * sizeof(FormatCatalog::IndexEntry));
+  header->m_codeOffset = (fsUInt32)align_up(header->m_fieldsOffset + numFields * sizeof(FormatField));
+  header->m_poolOffset = (fsUInt32)align_up(header->m_codeOffset + numOps * sizeof(FormatOp));
+  header->m_fileSize = (fsUInt32)size;
+
+  FormatCatalog::Entry* entries = (FormatCatalog::Entry*)(data + header->m_entriesOffset);
+  FormatCatalog::IndexEntry* indices = (FormatCatalog::IndexEntry*)(data + header->m_indexOffset);
+  fsUInt32 fieldsOffset = 0;
+  fsUInt32 codeOffset = 0;
+  fsUInt32 textOffset = 0;
+  for( size_t index = 0; index < m_formats.size(); ++index )
+  {
+    const Format& format = m_formats[index];
+    const CompiledFormat& compiled = format.m_compiled;
+    FormatCatalog::Entry& entry = entries[index];
+    entry.m_hash = FormatCatalog::HashText(format.m_text.c_str(), format.m_text.size());
+    entry.m_textOffset = textOffset;
+    entry.m_textLength = (fsUInt32)format.m_text.size();
+    entry.m_fieldsOffset = fieldsOffset;
+    entry.m_codeOffset = codeOffset;
+    entry.m_numFields = (fsUInt16)compiled.m_numFields;
+    entry.m_codeLength = (fsUInt16)compiled.m_codeLength;
+    entry.m_numArgs = (fsUInt16)compiled.m_numArgs;
+    entry.m_syntax = (fsUInt16)compiled.m_syntax;
+
+    memcpy(data + header->m_poolOffset + textOffset, format.m_text.c_str(), format.m_text.size() + 1);
+    memcpy(data + header->m_fieldsOffset + fieldsOffset, compiled.m_fields, compiled.m_numFields * sizeof(FormatField));
+    memcpy(data + header->m_codeOffset + codeOffset, compiled.m_code, compiled.m_codeLength * sizeof(FormatOp));
+    textOffset += entry.m_textLength + 1;
+    fieldsOffset += (fsUInt32)(compiled.m_numFields * sizeof(FormatField));
+    codeOffset += (fsUInt32)(compiled.m_codeLength * sizeof(FormatOp));
+
+    indices[index].m_hash = entry.m_hash;
+    indices[index].m_entry = (fsUInt32)index;
+  }
+  std::sort(indices, indices + m_formats.size(), index_less);
+  return true;
+}
+
+
+fsBool FormatCatalogWriter::Save(const fsChar* a_path) const
+{
+  MappedFile file;
+  size_t size = GetSize();
+  if( !file.OpenWrite(a_path, size) )
+  {
+    return false;
+  }
+  fsBool written = Write(file.GetData(), file.GetSize());
+  file.Close();
+  return written;
+}
+
+
+void FormatCatalogWriter::Clear()
+{
+  m_formats.clear();
+  m_indices[CompiledFormat::SYNTAX_BRACED].clear();
+  m_indices[CompiledFormat::SYNTAX_PRINTF].clear();
+}
+
+END_NAMESPACE_FORMATSTRINGLIB
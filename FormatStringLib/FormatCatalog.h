@@ -0,0 +1,176 @@
+#ifndef FORMATCATALOG_H
+#define FORMATCATALOG_H
+
+//
+// FormatCatalog.h
+// Compiled formats persisted to a file and mapped read-only, so processes skip compiling them at startup
+//
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "CompiledFormat.h"
+#include "MappedFile.h"
+
+//
+// A catalog is built offline (FormatCatalogWriter, or the Tools/FormatCatalogBuild tool from a list of formats)
+// and mapped by each process. Entries are CompiledFormatView references straight into the mapping, passed to the
+// FormatString() / FormatStringF() view overloads, so nothing is parsed or copied and the pages are shared.
+//
+// File layout, native byte order, all offsets are from the start of the file (position independent):
+//
+//   header   magic version sizeof(FormatField) sizeof(FormatOp) sizeof(entry) numFormats section offsets fileSize
+//   entries  per format: text offset and length, fields offset, code offset, numFields codeLength numArgs syntax hash
+//   index    { hash, entry } sorted by hash then entry, for Find()
+//   fields   FormatField arrays, 8 byte aligned
+//   code     FormatOp arrays, each ending with OP_END
+//   pool     format text, '\0' terminated, referenced by the entries and by the fields' literal offsets
+//
+// Opening checks the header and every entry (offsets in bounds, opcodes and field indices valid, literals inside their
+// text), so a damaged or foreign file is rejected rather than read out of bounds. TRUSTED skips the entry checks.
+//
+// Eg. Build: FormatCatalogWriter writer; writer.Add("Count: %d value: %.3f", CompiledFormat::SYNTAX_PRINTF);
+//            writer.Save("formats.fscat");
+//     Use:   static FormatCatalog s_catalog; s_catalog.OpenFile("formats.fscat");
+//            fsInt index = s_catalog.Find("Count: %d value: %.3f", CompiledFormat::SYNTAX_PRINTF);
+//            FormatStringF(buffer, sizeof(buffer), s_catalog.Get(index), 34, 123.456789);
+//
+// NOTE: The file depends on the FormatField / FormatOp layout and the opcode set, a catalog from another build
+// (version or sizes differ) fails to open and must be rebuilt. Formats with named params or custom numeric
+// patterns can not be persisted (see IsPortableCompiledFormat()).
+//
+
+BEGIN_NAMESPACE_FORMATSTRINGLIB
+
+class FormatCatalog
+{
+public:
+
+  enum
+  {
+    MAGIC = 0x54414346,                           // "FCAT" as read in native byte order
+    VERSION = 3,                                  // Bump when FormatField, FormatOp or the opcode set change
+    NOT_FOUND = -1,
+  };
+
+  enum Flags
+  {
+    TRUSTED = 1 << 0,                             // Skip validating the entries, eg. a catalog this build just wrote
+  };
+
+  // On-disk structures, see the file layout above
+  struct Header
+  {
+    fsUInt32 m_magic;
+    fsUInt16 m_version;
+    fsUInt16 m_fieldSize;                         // sizeof(FormatField)
+    fsUInt16 m_opSize;                            // sizeof(FormatOp)
+    fsUInt16 m_entrySize;                         // sizeof(Entry)
+    fsUInt32 m_numFormats;
+    fsUInt32 m_entriesOffset;
+    fsUInt32 m_indexOffset;
+    fsUInt32 m_fieldsOffset;
+    fsUInt32 m_codeOffset;
+    fsUInt32 m_poolOffset;
+    fsUInt32 m_fileSize;
+  };
+
+  struct Entry
+  {
+    fsUInt64 m_hash;                              // HashText() of the format text
+    fsUInt32 m_textOffset;                        // In the pool section
+    fsUInt32 m_textLength;                        // Excluding the terminator
+    fsUInt32 m_fieldsOffset;                      // In the fields section
+    fsUInt32 m_codeOffset;                        // In the code section
+    fsUInt16 m_numFields;
+    fsUInt16 m_codeLength;                        // Including the OP_END
+    fsUInt16 m_numArgs;
+    fsUInt16 m_syntax;                            // CompiledFormat::Syntax
+  };
+
+  struct IndexEntry
+  {
+    fsUInt64 m_hash;
+    fsUInt32 m_entry;                             // Index into the entries
+    fsUInt32 m_reserved;
+  };
+
+  FormatCatalog();
+  ~FormatCatalog();
+
+  // Map a catalog file read-only. Returns false if it can not be read or is not a valid catalog for this build.
+  fsBool OpenFile(const fsChar* a_path, fsUInt32 a_flags = 0);
+
+  // Use a catalog in memory, 8 byte aligned, which must remain valid while the catalog and its views are in use
+  fsBool OpenMemory(const void* a_data, size_t a_size, fsUInt32 a_flags = 0);
+
+  // Views from Get() are invalid after closing
+  void Close();
+
+  fsBool IsOpen() const                           { return m_header != NULL; }
+  fsInt GetNumFormats() const                     { return (m_header != NULL) ? (fsInt)m_header->m_numFormats : 0; }
+
+  // Compiled format at a_index, an invalid view if out of range
+  CompiledFormatView Get(fsInt a_index) const;
+
+  // Index of a format by text and syntax, NOT_FOUND if not in the catalog
+  fsInt Find(const fsChar* a_format, CompiledFormat::Syntax a_syntax) const;
+
+  // Hash of format text stored in the entries, stable across builds and platforms (FNV-1a)
+  static fsUInt64 HashText(const fsChar* a_format, size_t a_length);
+
+protected:
+
+  const fsUInt8* m_data;
+  const Header* m_header;                         // NULL if not open
+  const Entry* m_entries;
+  const IndexEntry* m_index;
+  MappedFile m_file;                              // Used by OpenFile()
+
+  fsBool InternalOpen(const fsUInt8* a_data, size_t a_size, fsUInt32 a_flags);
+  fsBool InternalValidateEntry(const Entry& a_entry) const;
+
+private:
+  FormatCatalog(const FormatCatalog&);            // Not copyable, views point into the mapping
+  FormatCatalog& operator=(const FormatCatalog&);
+};
+
+
+// Compile formats and write them as a catalog
+// Note, not designed for reentrant use.
+class FormatCatalogWriter
+{
+public:
+
+  // Compile and add a format, or find it if already added. Returns its index in the catalog, or -1 if the format
+  // does not compile or is not portable (see IsPortableCompiledFormat()).
+  fsInt Add(const fsChar* a_format, CompiledFormat::Syntax a_syntax);
+
+  fsInt GetNumFormats() const                     { return (fsInt)m_formats.size(); }
+
+  // Size of the catalog file
+  size_t GetSize() const;
+
+  // Write the catalog into a_buffer of at least GetSize() bytes, 8 byte aligned. Returns false if too small.
+  fsBool Write(void* a_buffer, size_t a_size) const;
+
+  // Write the catalog to a file. Returns true if succeeded.
+  fsBool Save(const fsChar* a_path) const;
+
+  void Clear();
+
+protected:
+
+  struct Format
+  {
+    std::string m_text;
+    CompiledFormat m_compiled;                    // m_format is not used, the text may have moved
+  };
+
+  std::vector<Format> m_formats;
+  std::unordered_map<std::string, fsInt> m_indices[2]; // Format text to index, per syntax
+};
+
+END_NAMESPACE_FORMATSTRINGLIB
+
+#endif //FORMATCATALOG_H
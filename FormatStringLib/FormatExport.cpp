@@ -0,0 +1,315 @@
+//
+// FormatExport.cpp
+// Parallel export of column arrays to text through FormatStringFBatch
+//
+
+#include <stdlib.h>
+#include <string.h>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#include <io.h>
+#else // _WIN32
+#include <unistd.h>
+#endif // _WIN32
+
+#include "FormatExport.h"
+#include "MappedFile.h"
+
+BEGIN_NAMESPACE_FORMATSTRINGLIB
+
+// Shared state of one export
+struct ExportJob
+{
+  const CompiledFormat* m_compiled;
+  const FormatColumn* m_columns;
+  fsInt m_numColumns;
+  fsInt64 m_numRows;
+  fsInt m_rowsPerChunk;
+  fsInt64 m_numChunks;
+  const fsChar* m_rowSeparator;
+
+  int m_fd;                                       // Output descriptor, or -1 if writing m_file
+  MappedFile* m_file;                             // Output mapped file, or NULL if writing m_fd
+  fsUInt64 m_outputSize;                          // Bytes output so far, only touched by the committing thread
+
+  std::atomic<fsInt64> m_nextChunk;               // Next chunk to be formatted
+  std::atomic<bool> m_failed;                     // Stop all workers
+  fsInt64 m_commitChunk;                          // Next chunk to be written, guarded by m_mutex
+  std::mutex m_mutex;
+  std::condition_variable m_committed;
+};
+
+
+// Element size of a column, used to offset columns to the first row of a chunk
+static size_t column_stride(const FormatColumn& a_column)
+{
+  switch( a_column.m_type )
+  {
+  case FormatColumn::COLUMN_INT64:    return sizeof(fsInt64);
+  case FormatColumn::COLUMN_FLOAT64:  return sizeof(fsFloat64);
+  case FormatColumn::COLUMN_CSTR:     return sizeof(const fsChar*);
+  default:                            return 0;
+  }
+}
+
+
+static fsBool write_fd(int a_fd, const fsChar* a_data, size_t a_size)
+{
+  while( a_size > 0 )
+  {
+#ifdef _WIN32
+    int written = _write(a_fd, a_data, (unsigned int)a_size);
+#else // _WIN32
+    ssize_t written = write(a_fd, a_data, a_size);
+#endif // _WIN32
+    if( written <= 0 )
+    {
+      return false;
+    }
+    a_data += written;
+    a_size -= (size_t)written;
+  }
+  return true;
+}
+
+
+// Append a formatted chunk to the output. Called by one thread at a time, in chunk order.
+static fsBool commit_chunk(ExportJob& a_job, const fsChar* a_data, size_t a_size)
+{
+  if( a_job.m_file == NULL )
+  {
+    if( !write_fd(a_job.m_fd, a_data, a_size) )
+    {
+      return false;
+    }
+  }
+  else
+  {
+    fsUInt64 required = a_job.m_outputSize + a_size;
+    if( required > a_job.m_file->GetSize() )
+    {
+      size_t newSize = a_job.m_file->GetSize() * 2;
+      if( newSize < required )
+      {
+        newSize = (size_t)required;
+      }
+      if( !a_job.m_file->Resize(newSize) )
+      {
+        return false;
+      }
+    }
+    memcpy(a_job.m_file->GetData() + a_job.m_outputSize, a_data, a_size);
+  }
+  a_job.m_outputSize += a_size;
+  return true;
+}
+
+
+static void export_worker(ExportJob* a_job)
+{
+  ExportJob& job = *a_job;
+  FormatColumn* columns = (FormatColumn*)malloc(sizeof(FormatColumn) * (job.m_numColumns > 0 ? job.m_numColumns : 1));
+  size_t capacity = (size_t)job.m_rowsPerChunk * 64; // Guess, grows to fit
+  fsChar* buffer = (fsChar*)malloc(capacity);
+  if( !columns || !buffer )
+  {
+    job.m_failed = true;
+  }
+
+  while( !job.m_failed )
+  {
+    fsInt64 chunk = job.m_nextChunk++;
+    if( chunk >= job.m_numChunks )
+    {
+      break;
+    }
+
+    // Format slice into own buffer
+    fsInt64 firstRow = chunk * job.m_rowsPerChunk;
+    fsInt numRows = (fsInt)(((job.m_numRows - firstRow) < job.m_rowsPerChunk) ? (job.m_numRows - firstRow) : job.m_rowsPerChunk);
+    for( fsInt columnIndex = 0; columnIndex < job.m_numColumns; ++columnIndex )
+    {
+      columns[columnIndex] = job.m_columns[columnIndex];
+      columns[columnIndex].m_data = (const fsUInt8*)job.m_columns[columnIndex].m_data + firstRow * column_stride(job.m_columns[columnIndex]);
+    }
+    fsInt length = FormatStringFBatch(buffer, capacity, *job.m_compiled, columns, job.m_numColumns, numRows, job.m_rowSeparator);
+    if( (size_t)length >= capacity ) // Grow and format again rather than truncate
+    {
+      capacity = (size_t)length + 1 + (length / 4);
+      fsChar* newBuffer = (fsChar*)realloc(buffer, capacity);
+      if( !newBuffer )
+      {
+        job.m_failed = true;
+        break;
+      }
+      buffer = newBuffer;
+      length = FormatStringFBatch(buffer, capacity, *job.m_compiled, columns, job.m_numColumns, numRows, job.m_rowSeparator);
+    }
+
+    // Wait for our turn, then write in row order
+    std::unique_lock<std::mutex> lock(job.m_mutex);
+    while( (job.m_commitChunk != chunk) && !job.m_failed )
+    {
+      job.m_committed.wait(lock);
+    }
+    if( job.m_failed )
+    {
+      break;
+    }
+    lock.unlock();
+    fsBool succeeded = commit_chunk(job, buffer, (size_t)length);
+    lock.lock();
+    if( !succeeded )
+    {
+      job.m_failed = true;
+    }
+    ++job.m_commitChunk;
+    job.m_committed.notify_all();
+  }
+
+  if( job.m_failed )
+  {
+    std::lock_guard<std::mutex> lock(job.m_mutex); // Wake any waiting workers
+    job.m_committed.notify_all();
+  }
+  free(buffer);
+  free(columns);
+}
+
+
+static fsBool run_export(ExportJob& a_job, fsInt a_numThreads)
+{
+  a_job.m_numChunks = (a_job.m_numRows + a_job.m_rowsPerChunk - 1) / a_job.m_rowsPerChunk;
+  a_job.m_nextChunk = 0;
+  a_job.m_commitChunk = 0;
+  a_job.m_failed = false;
+  a_job.m_outputSize = 0;
+
+  fsInt numThreads = a_numThreads;
+  if( numThreads <= 0 )
+  {
+    numThreads = (fsInt)std::thread::hardware_concurrency();
+  }
+  if( (fsInt64)numThreads > a_job.m_numChunks )
+  {
+    numThreads = (fsInt)a_job.m_numChunks;
+  }
+
+  if( numThreads <= 1 )
+  {
+    export_worker(&a_job);
+  }
+  else
+  {
+    std::vector<std::thread> workers;
+    for( fsInt threadIndex = 0; threadIndex < numThreads; ++threadIndex )
+    {
+      workers.push_back(std::thread(export_worker, &a_job));
+    }
+    for( size_t threadIndex = 0; threadIndex < workers.size(); ++threadIndex )
+    {
+      workers[threadIndex].join();
+    }
+  }
+  return !a_job.m_failed;
+}
+
+
+FormatExporter::FormatExporter()
+{
+  m_numThreads = 0;
+  m_rowsPerChunk = DEFAULT_ROWS_PER_CHUNK;
+  m_bytesWritten = 0;
+}
+
+
+fsBool FormatExporter::ExportToFd(int a_fd, const CompiledFormat& a_compiled, const FormatColumn* a_columns, fsInt a_numColumns, fsInt64 a_numRows, const fsChar* a_rowSeparator)
+{
+  m_bytesWritten = 0;
+  FS_ASSERT( a_compiled.IsValid() );
+  if( !a_compiled.IsValid() || (a_fd < 0) )
+  {
+    return false;
+  }
+
+  ExportJob job;
+  job.m_compiled = &a_compiled;
+  job.m_columns = a_columns;
+  job.m_numColumns = a_numColumns;
+  job.m_numRows = a_numRows;
+  job.m_rowsPerChunk = m_rowsPerChunk;
+  job.m_rowSeparator = a_rowSeparator;
+  job.m_fd = a_fd;
+  job.m_file = NULL;
+
+  fsBool succeeded = run_export(job, m_numThreads);
+  m_bytesWritten = job.m_outputSize;
+  return succeeded;
+}
+
+
+fsBool FormatExporter::ExportToFd(int a_fd, const fsChar* a_fmt, const FormatColumn* a_columns, fsInt a_numColumns, fsInt64 a_numRows, const fsChar* a_rowSeparator)
+{
+  CompiledFormat compiled;
+  if( !CompileFormatStringF(a_fmt, compiled) )
+  {
+    m_bytesWritten = 0;
+    return false;
+  }
+  return ExportToFd(a_fd, compiled, a_columns, a_numColumns, a_numRows, a_rowSeparator);
+}
+
+
+fsBool FormatExporter::ExportToFile(const fsChar* a_path, const CompiledFormat& a_compiled, const FormatColumn* a_columns, fsInt a_numColumns, fsInt64 a_numRows, const fsChar* a_rowSeparator)
+{
+  m_bytesWritten = 0;
+  FS_ASSERT( a_compiled.IsValid() );
+  if( !a_compiled.IsValid() )
+  {
+    return false;
+  }
+
+  MappedFile file;
+  if( !file.OpenWrite(a_path, 1024 * 1024) )
+  {
+    return false;
+  }
+
+  ExportJob job;
+  job.m_compiled = &a_compiled;
+  job.m_columns = a_columns;
+  job.m_numColumns = a_numColumns;
+  job.m_numRows = a_numRows;
+  job.m_rowsPerChunk = m_rowsPerChunk;
+  job.m_rowSeparator = a_rowSeparator;
+  job.m_fd = -1;
+  job.m_file = &file;
+
+  fsBool succeeded = run_export(job, m_numThreads);
+  if( !file.Resize((size_t)job.m_outputSize) ) // Trim unused capacity
+  {
+    succeeded = false;
+  }
+  file.Close();
+  m_bytesWritten = job.m_outputSize;
+  return succeeded;
+}
+
+
+fsBool FormatExporter::ExportToFile(const fsChar* a_path, const fsChar* a_fmt, const FormatColumn* a_columns, fsInt a_numColumns, fsInt64 a_numRows, const fsChar* a_rowSeparator)
+{
+  CompiledFormat compiled;
+  if( !CompileFormatStringF(a_fmt, compiled) )
+  {
+    m_bytesWritten = 0;
+    return false;
+  }
+  return ExportToFile(a_path, compiled, a_columns, a_numColumns, a_numRows, a_rowSeparator);
+}
+
+END_NAMESPACE_FORMATSTRINGLIB
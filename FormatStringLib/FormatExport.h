@@ -0,0 +1,62 @@
+#ifndef FORMATEXPORT_H
+#define FORMATEXPORT_H
+
+//
+// FormatExport.h
+// Parallel export of column arrays to text (eg. CSV) through FormatStringFBatch
+//
+
+#include "FormatStringF.h"
+
+//
+// The row range is split into chunks. A pool of worker threads takes chunks in turn and formats
+// each into its own buffer, then the buffers are written to the output strictly in row order,
+// one write (or one copy into the mapped file) per chunk.
+//
+// Eg.
+//   FormatColumn columns[] = { FormatColumn(ids), FormatColumn(prices), FormatColumn(names) };
+//   FormatExporter exporter;
+//   exporter.ExportToFile("eod.csv", "%d,%.4f,%s", columns, 3, numRows);
+//
+
+BEGIN_NAMESPACE_FORMATSTRINGLIB
+
+// Note, one export at a time per instance.
+class FormatExporter
+{
+public:
+
+  enum
+  {
+    DEFAULT_ROWS_PER_CHUNK = 16384,
+  };
+
+  FormatExporter();
+
+  // Number of worker threads, 0 (default) for one per hardware thread
+  void SetThreadCount(fsInt a_numThreads)         { m_numThreads = a_numThreads; }
+
+  // Rows formatted per chunk, larger chunks mean fewer writes and more buffer memory per thread
+  void SetRowsPerChunk(fsInt a_rowsPerChunk)      { m_rowsPerChunk = (a_rowsPerChunk > 0) ? a_rowsPerChunk : DEFAULT_ROWS_PER_CHUNK; }
+
+  // Export rows to an open file descriptor. Returns true if succeeded.
+  fsBool ExportToFd(int a_fd, const CompiledFormat& a_compiled, const FormatColumn* a_columns, fsInt a_numColumns, fsInt64 a_numRows, const fsChar* a_rowSeparator = "\n");
+  fsBool ExportToFd(int a_fd, const fsChar* a_fmt, const FormatColumn* a_columns, fsInt a_numColumns, fsInt64 a_numRows, const fsChar* a_rowSeparator = "\n");
+
+  // Export rows to a new memory-mapped file, truncated to the output size when done. Returns true if succeeded.
+  fsBool ExportToFile(const fsChar* a_path, const CompiledFormat& a_compiled, const FormatColumn* a_columns, fsInt a_numColumns, fsInt64 a_numRows, const fsChar* a_rowSeparator = "\n");
+  fsBool ExportToFile(const fsChar* a_path, const fsChar* a_fmt, const FormatColumn* a_columns, fsInt a_numColumns, fsInt64 a_numRows, const fsChar* a_rowSeparator = "\n");
+
+  // Bytes output by the last export
+  fsUInt64 GetBytesWritten() const                { return m_bytesWritten; }
+
+protected:
+
+  fsInt m_numThreads;                             // Worker threads, 0 for hardware concurrency
+  fsInt m_rowsPerChunk;                           // Rows per chunk
+  fsUInt64 m_bytesWritten;                        // Result of last export
+};
+
+END_NAMESPACE_FORMATSTRINGLIB
+
+#endif //FORMATEXPORT_H
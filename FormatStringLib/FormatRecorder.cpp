@@ -0,0 +1,196 @@
+//
+// FormatRecorder.cpp
+// Sample live FormatString, FormatStringF and ScanStringF calls into a corpus file for replay benchmarks
+//
+
+#include <mutex>
+#include <string>
+#include <string.h>
+#include <unordered_map>
+#include "FormatRecorder.h"
+
+BEGIN_NAMESPACE_FORMATSTRINGLIB
+
+enum
+{
+  NUM_SYNTAXES = 3,                               // BinaryLog::Syntax values recorded
+};
+
+// Corpus being written, guarded by s_mutex
+struct RecorderState
+{
+  BinaryLogWriter m_writer;
+  std::unordered_map<std::string, fsUInt32> m_formatIds[NUM_SYNTAXES]; // Registered format text to id
+  fsUInt32 m_flags;
+  size_t m_maxBytes;
+  fsUInt64 m_numRecorded;
+  fsBool m_open;
+
+  RecorderState() : m_flags(0), m_maxBytes(0), m_numRecorded(0), m_open(false) {}
+};
+
+std::atomic<bool> FormatRecorder::s_recording(false);
+static std::atomic<fsInt> s_sampleEvery(FormatRecorder::DEFAULT_SAMPLE_EVERY);
+static std::mutex s_mutex;
+static RecorderState s_state;
+static thread_local fsInt t_countdown = 0;        // Calls on this thread until the next sample
+
+
+// Scan input with letters other than hex digits replaced, so numbers still parse. 'p' is kept for hex float exponents.
+static void redact_input(const fsChar* a_input, std::string& a_redacted)
+{
+  a_redacted.assign(a_input);
+  for( size_t index = 0; index < a_redacted.size(); ++index )
+  {
+    fsChar ch = a_redacted[index];
+    if( (((ch >= 'g') && (ch <= 'z')) || ((ch >= 'G') && (ch <= 'Z'))) && (ch != 'p') && (ch != 'P') )
+    {
+      a_redacted[index] = 'x';
+    }
+  }
+}
+
+
+// Value recorded for a scan output argument, a zero of the type written
+static Arg scan_target(const Arg& a_arg)
+{
+  switch( a_arg.m_type )
+  {
+    case Arg::ARG_TYPE_CHAR_PTR:      return Arg("");
+    case Arg::ARG_TYPE_INT16_PTR:     return Arg((fsInt16)0);
+    case Arg::ARG_TYPE_UINT16_PTR:    return Arg((fsUInt16)0);
+    case Arg::ARG_TYPE_INT32_PTR:     return Arg((fsInt32)0);
+    case Arg::ARG_TYPE_UINT32_PTR:    return Arg((fsUInt32)0);
+    case Arg::ARG_TYPE_INT64_PTR:     return Arg((fsInt64)0);
+    case Arg::ARG_TYPE_UINT64_PTR:    return Arg((fsUInt64)0);
+    case Arg::ARG_TYPE_FLOAT32_PTR:   return Arg((fsFloat32)0);
+    case Arg::ARG_TYPE_FLOAT64_PTR:   return Arg((fsFloat64)0);
+#if FS_HAS_INT128
+    case Arg::ARG_TYPE_INT128_PTR:    return Arg((fsInt128)0);
+    case Arg::ARG_TYPE_UINT128_PTR:   return Arg((fsUInt128)0);
+#endif // FS_HAS_INT128
+    case Arg::ARG_TYPE_NONCONST_PTR:  return Arg((const void*)NULL);
+    case Arg::ARG_TYPE_DECIMAL64_PTR: return Arg(Decimal64(0, a_arg.m_valueDecimal64Ptr.m_scale));
+    default:                          return Arg();
+  }
+}
+
+
+fsBool FormatRecorder::Start(const fsChar* a_path, fsInt a_sampleEvery, fsUInt32 a_flags, size_t a_maxBytes)
+{
+  std::lock_guard<std::mutex> lock(s_mutex);
+  if( s_state.m_open || !s_state.m_writer.OpenFile(a_path, (a_maxBytes < 1024 * 1024) ? a_maxBytes : 1024 * 1024) )
+  {
+    return false;
+  }
+
+  for( fsInt syntax = 0; syntax < NUM_SYNTAXES; ++syntax )
+  {
+    s_state.m_formatIds[syntax].clear();
+  }
+  s_state.m_flags = a_flags;
+  s_state.m_maxBytes = a_maxBytes;
+  s_state.m_numRecorded = 0;
+  s_state.m_open = true;
+  s_sampleEvery.store((a_sampleEvery > 0) ? a_sampleEvery : 1, std::memory_order_relaxed);
+  s_recording.store(true, std::memory_order_relaxed);
+  return true;
+}
+
+
+void FormatRecorder::Stop()
+{
+  std::lock_guard<std::mutex> lock(s_mutex);
+  s_recording.store(false, std::memory_order_relaxed);
+  if( s_state.m_open )
+  {
+    s_state.m_writer.Close();
+    s_state.m_open = false;
+  }
+}
+
+
+fsUInt64 FormatRecorder::GetNumRecorded()
+{
+  std::lock_guard<std::mutex> lock(s_mutex);
+  return s_state.m_numRecorded;
+}
+
+
+void FormatRecorder::Sample(BinaryLog::Syntax a_syntax, const fsChar* a_format, size_t a_count, const fsChar* a_input, ArgList& a_args)
+{
+  if( --t_countdown > 0 )
+  {
+    return;
+  }
+  t_countdown = s_sampleEvery.load(std::memory_order_relaxed);
+
+  if( (a_format == NULL) || ((a_args.Count() > 0) && (a_args.GetName(0) != NULL)) )
+  {
+    return; // Named arguments can't be replayed positionally
+  }
+
+  std::lock_guard<std::mutex> lock(s_mutex);
+  if( !s_state.m_open || !s_recording.load(std::memory_order_relaxed) )
+  {
+    return;
+  }
+  fsBool redact = (s_state.m_flags & REDACT_STRINGS) != 0;
+
+  // Redacted copies must stay put until written, sized up front
+  std::string redacted[ArgListFixed::MAX_FIXED_ARGS];
+  ArgListFixed recorded;
+  fsInt numArgs = a_args.Count();
+  if( a_syntax == BinaryLog::SYNTAX_SCAN )
+  {
+    const fsChar* input = (a_input != NULL) ? a_input : "";
+    if( redact )
+    {
+      redact_input(input, redacted[0]);
+      input = redacted[0].c_str();
+    }
+    recorded.Add(Arg(input));
+  }
+  for( fsInt argIndex = 0; (argIndex < numArgs) && (recorded.Count() < ArgListFixed::MAX_FIXED_ARGS); ++argIndex )
+  {
+    const Arg& arg = a_args.GetAt(argIndex);
+    if( a_syntax == BinaryLog::SYNTAX_SCAN )
+    {
+      recorded.Add(scan_target(arg));
+    }
+    else if( redact && arg.IsCString() )
+    {
+      std::string& text = redacted[recorded.Count()];
+      text.assign((arg.m_valueCString != NULL) ? strlen(arg.m_valueCString) : 0, 'x');
+      recorded.Add(Arg(text.c_str()));
+    }
+    else
+    {
+      recorded.Add(arg);
+    }
+  }
+
+  std::unordered_map<std::string, fsUInt32>& formatIds = s_state.m_formatIds[a_syntax];
+  std::unordered_map<std::string, fsUInt32>::iterator found = formatIds.find(a_format);
+  fsUInt32 formatId = (found != formatIds.end()) ? found->second : (fsUInt32)BinaryLog::INVALID_FORMAT_ID;
+  if( formatId == BinaryLog::INVALID_FORMAT_ID )
+  {
+    formatId = s_state.m_writer.RegisterFormat(a_format, a_syntax);
+    if( formatId != BinaryLog::INVALID_FORMAT_ID )
+    {
+      formatIds[a_format] = formatId;
+    }
+  }
+
+  // Buffer size in place of the timestamp
+  if(    (formatId == BinaryLog::INVALID_FORMAT_ID)
+      || (s_state.m_writer.GetSize() >= s_state.m_maxBytes)
+      || !s_state.m_writer.Write(formatId, (fsUInt64)a_count, recorded) )
+  {
+    s_recording.store(false, std::memory_order_relaxed); // Full, the corpus is kept until Stop()
+    return;
+  }
+  ++s_state.m_numRecorded;
+}
+
+END_NAMESPACE_FORMATSTRINGLIB
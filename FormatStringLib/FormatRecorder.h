@@ -0,0 +1,82 @@
+#ifndef FORMATRECORDER_H
+#define FORMATRECORDER_H
+
+//
+// FormatRecorder.h
+// Sample live FormatString, FormatStringF and ScanStringF calls into a corpus file for replay benchmarks
+//
+
+#include <atomic>
+#include "Arg.h"
+#include "BinaryLog.h"
+
+// Instrument FormatString(), FormatStringF() and ScanStringF() for recording.
+// When 1 each call tests FormatRecorder::IsRecording() (a relaxed load), define as 0 to compile the test out.
+#ifndef FS_RECORDER
+#define FS_RECORDER 1
+#endif // FS_RECORDER
+
+//
+// While recording, one call in every a_sampleEvery on each thread is written to the corpus: the format text,
+// the argument types and values and the buffer size. Bench/Replay runs a corpus back through the same
+// functions, so optimisations can be judged on the real mix of formats and arguments.
+//
+// The corpus is a binary log (see BinaryLog.h), readable with BinaryLogReader and Tools/BinaryLogDecode:
+//   format definitions   syntax SYNTAX_BRACED (FormatString), SYNTAX_PRINTF (FormatStringF) or SYNTAX_SCAN (ScanStringF)
+//   message timestamp    buffer size of the call, 0 for the Length functions and scans
+//   message arguments    the call's arguments. Scans start with the input string, and their output arguments are
+//                        recorded as zero values of the type written (eg. fsInt32* as fsInt32 0, fsChar* as "").
+//
+// With REDACT_STRINGS string arguments are recorded as 'x' repeated to their length, and scan inputs have
+// letters other than hex digits and 'p' replaced by 'x' (digits, signs and punctuation are kept so numbers still parse).
+//
+// Eg. FormatRecorder::Start("corpus.fslog", 1000, FormatRecorder::REDACT_STRINGS); // Record 1 in 1000 calls
+//     ...
+//     FormatRecorder::Stop();
+//     // Bench/Replay corpus.fslog
+//
+// NOTE: Writes are serialised by a mutex, sampled calls only. Calls with named arguments (ArgListNamed, or formats
+// compiled against names) are not recorded, at most ArgListFixed::MAX_FIXED_ARGS arguments are kept, and recording
+// stops once the corpus reaches its size limit.
+//
+
+BEGIN_NAMESPACE_FORMATSTRINGLIB
+
+class FormatRecorder
+{
+public:
+
+  enum
+  {
+    DEFAULT_SAMPLE_EVERY = 100,
+    DEFAULT_MAX_BYTES = 64 * 1024 * 1024,         // Corpus size limit
+  };
+
+  enum Flags
+  {
+    REDACT_STRINGS = 1 << 0,                      // Record strings as their length only
+  };
+
+  // Start recording to a new corpus file. Returns false if already recording or the file can not be created.
+  static fsBool Start(const fsChar* a_path, fsInt a_sampleEvery = DEFAULT_SAMPLE_EVERY, fsUInt32 a_flags = 0,
+                      size_t a_maxBytes = DEFAULT_MAX_BYTES);
+
+  // Stop recording and close the corpus
+  static void Stop();
+
+  static fsBool IsRecording()                     { return s_recording.load(std::memory_order_relaxed); }
+
+  // Calls written to the current (or last) corpus
+  static fsUInt64 GetNumRecorded();
+
+  // Used by the instrumented functions. a_syntax selects the function, a_input is the scan input (else NULL).
+  static void Sample(BinaryLog::Syntax a_syntax, const fsChar* a_format, size_t a_count, const fsChar* a_input, ArgList& a_args);
+
+protected:
+
+  static std::atomic<bool> s_recording;
+};
+
+END_NAMESPACE_FORMATSTRINGLIB
+
+#endif //FORMATRECORDER_H
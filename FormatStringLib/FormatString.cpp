@@ -9,7 +9,15 @@
 //
 
 #include <iostream> // For standard library string functions
+#include <string.h>
 #include "FormatString.h"
+#include "CharScan.h"
+#include "CustomNumberFormat.h"
+#include "FormatCache.h"
+#include "FormatRecorder.h"
+#include "FormatTelemetry.h"
+#include "NumberFormat.h"
+#include "Utf8.h"
 
 BEGIN_NAMESPACE_FORMATSTRINGLIB
 
@@ -80,6 +88,11 @@ static int fmtstr(char *buffer, size_t *currlen, size_t maxlen, const char *valu
 
 static int fmtint(char *buffer, size_t *currlen, size_t maxlen, long value, int base, int min, int max, int flags);
 static int fmtint_64(char *buffer, size_t *currlen, size_t maxlen, fsInt64 a_value, int base, int min, int max, int flags);
+#if FS_HAS_INT128
+static int fmtint_128(char *buffer, size_t *currlen, size_t maxlen, fsInt128 a_value, int base, int min, int max, int flags);
+#endif // FS_HAS_INT128
+static int fmtint_out(char *buffer, size_t *currlen, size_t maxlen, char signvalue, const char *convert, int place,
+                      int forwardLength, bool measureOnly, int min, int max, int flags);
 
 static int fmtfp(char *buffer, size_t *currlen, size_t maxlen, LDOUBLE fvalue, int min, int max, int flags, bool a_checkFPException = false, bool a_allowTrailingZeros = true);
 static int fmtfp_gen(char *buffer, size_t *currlen, size_t maxlen, LDOUBLE fvalue, int min, int max, int flags, bool a_checkFPException = true);
@@ -89,7 +102,13 @@ static int fmtfp64(char *buffer, size_t *currlen, size_t maxlen, LDOUBLE fvalue,
 static int fmtfp64_gen(char *buffer, size_t *currlen, size_t maxlen, LDOUBLE fvalue, int min, int max, int flags, bool a_checkFPException = true);
 static int fmtfp64_exp(char *buffer, size_t *currlen, size_t maxlen, LDOUBLE fvalue, int min, int max, int flags, bool a_checkFPException = true);
 
+static int fmtfp32(char *buffer, size_t *currlen, size_t maxlen, fsFloat32 fvalue, int min, int max, int flags);
+static int fmtfp32_gen(char *buffer, size_t *currlen, size_t maxlen, fsFloat32 fvalue, int min, int flags);
+static int fmtfp_hex(char *buffer, size_t *currlen, size_t maxlen, fsFloat64 fvalue, int min, int max, int flags);
+static int fmtdec(char *buffer, size_t *currlen, size_t maxlen, fsInt64 units, int scale, int min, int max, int flags);
+
 static int dopr_outch(char *buffer, size_t *currlen, size_t maxlen, char c );
+static int dopr_outstr(char *buffer, size_t *currlen, size_t maxlen, const char *str, size_t len);
 
 static int isfpexception(LDOUBLE fvalue);
 static int fmtfp_exception(char *buffer, size_t *currlen, size_t maxlen, LDOUBLE fvalue, int min, int max, int flags);
@@ -98,6 +117,13 @@ static int fmtfp_exception(char *buffer, size_t *currlen, size_t maxlen, LDOUBLE
 static int fmt_braced(char* a_buffer, size_t* a_currlen, size_t a_maxlen, 
                       int a_paramIndex, int a_alignment, const char* a_format,
                       ArgList& a_argList);
+static int fmt_braced_value(char* a_buffer, size_t* a_currlen, size_t a_maxlen, const Arg& a_param,
+                            int a_alignment, int a_formatType, int a_max, int a_flags);
+static void ParseStandardNumericFormat(const char* a_formatString, int& a_formatType, int& a_max, int& a_flags);
+static void dopr_terminate(char *buffer, size_t currlen, size_t maxlen);
+static int find_named_arg(const char* a_name, size_t a_length, const fsChar* const* a_names, fsInt a_numNames, ArgList* a_argList);
+static int fmt_custom(char* a_buffer, size_t* a_currlen, size_t a_maxlen, const Arg& a_param,
+                      int a_alignment, int a_flags, const CustomNumberFormat& a_custom);
 
 //
 // dopr(): poor man's version of doprintf
@@ -113,9 +139,11 @@ enum
   FORMAT_TYPE_FIXEDPOINT,             // Floating point, fixed point style
   FORMAT_TYPE_GENERAL,                // Numeric general
   FORMAT_TYPE_HEXADECIMAL,            // Hexadecimal
+  FORMAT_TYPE_BINARY,                 // Binary
   FORMAT_TYPE_STRING,                 // String
   FORMAT_TYPE_PERCENT,                // Percent
-  FORMAT_TYPE_CUSTOM                  // Unknown or custom format
+  FORMAT_TYPE_CUSTOM,                 // Unknown or custom format
+  FORMAT_TYPE_HEXFLOAT                // Floating point, hexadecimal (after CUSTOM, compiled values are persisted)
 };
 
 
@@ -135,14 +163,17 @@ enum
 #define char_to_int(p) (p - '0')
 #define MAX(p,q) ((p >= q) ? p : q)
 #define MIN(p,q) ((p <= q) ? p : q)
+#define is_name_start(p) (isalpha((unsigned char)(p)) || (p) == '_')
+#define is_name_char(p) (isalnum((unsigned char)(p)) || (p) == '_')
 
-// The syntax for a format is "{[param],[alignment]:[format]}".
+// The syntax for a format is "{[param],[alignment]:[format]}", param is an index or a name.
 static int dopr(char *buffer, size_t maxlen, const char *format, ArgList& a_argList)
 {
   // Parse states
   enum
   {
     DP_S_DEFAULT = 0,
+    DP_S_PARAM_START,
     DP_S_PARAM,
     DP_S_ALIGNMENT_START,
     DP_S_ALIGNMENT_SIGN,
@@ -186,7 +217,7 @@ static int dopr(char *buffer, size_t maxlen, const char *format, ArgList& a_argL
           }
           else
           {
-            state = DP_S_PARAM;
+            state = DP_S_PARAM_START;
           }
         }
         else if( ch == '}' )
@@ -202,13 +233,34 @@ static int dopr(char *buffer, size_t maxlen, const char *format, ArgList& a_argL
             state = DP_S_ERROR;
           }
         }
-        else 
+        else // Literal run, output up to the next brace at once
         {
-          total += dopr_outch(buffer, &currlen, maxlen, ch);
+          const char* literalEnd = CharScan::FindAny(format, '{', '}');
+          total += dopr_outstr(buffer, &currlen, maxlen, format - 1, literalEnd - (format - 1));
+          format = literalEnd;
         }
         ch = *format++;
         break;
       }
+      case DP_S_PARAM_START:
+      {
+        if( is_name_start(ch) ) // Named parameter, matched against the argument names
+        {
+          const char* name = format - 1;
+          while( is_name_char(*format) )
+          {
+            ++format;
+          }
+          paramIndex = find_named_arg(name, format - name, NULL, 0, &a_argList);
+          ch = *format++;
+          state = DP_S_ALIGNMENT_START;
+        }
+        else
+        {
+          state = DP_S_PARAM;
+        }
+        break;
+      }
       case DP_S_PARAM:
       {
         if( isdigit(ch) )
@@ -362,18 +414,19 @@ static int dopr(char *buffer, size_t maxlen, const char *format, ArgList& a_argL
       break; // some picky compilers need this 
     }
   }
-  if (buffer != NULL)
+  dopr_terminate(buffer, currlen, maxlen);
+  return total;
+}
+
+
+// Is the text only digits (a standard specifier's precision)
+static bool is_digits_only(const char* a_text)
+{
+  while( isdigit(*a_text) )
   {
-    if (currlen < maxlen - 1)
-    { 
-      buffer[currlen] = '\0';
-    }
-    else 
-    {
-      buffer[maxlen - 1] = '\0';
-    }
+    ++a_text;
   }
-  return total;
+  return (*a_text == '\0');
 }
 
 
@@ -426,9 +479,30 @@ static void ParseStandardNumericFormat(const char* a_formatString, int& a_format
           case 'P': { a_formatType = FORMAT_TYPE_PERCENT; a_flags |= DP_F_UP; state = SF_STATE_MAX_OR_PRECISION; break; }
           case 'x': { a_formatType = FORMAT_TYPE_HEXADECIMAL; state = SF_STATE_MAX_OR_PRECISION; break; }
           case 'X': { a_formatType = FORMAT_TYPE_HEXADECIMAL; a_flags |= DP_F_UP; state = SF_STATE_MAX_OR_PRECISION; break; }
+          case 'b': { a_formatType = FORMAT_TYPE_BINARY; state = SF_STATE_MAX_OR_PRECISION; break; }
+          case 'B': { a_formatType = FORMAT_TYPE_BINARY; a_flags |= DP_F_UP; state = SF_STATE_MAX_OR_PRECISION; break; }
           case 's': { a_formatType = FORMAT_TYPE_STRING; state = SF_STATE_MAX_OR_PRECISION; break; }
           case 'S': { a_formatType = FORMAT_TYPE_STRING; a_flags |= DP_F_UP; state = SF_STATE_MAX_OR_PRECISION; break; }
-          default: { a_formatType = FORMAT_TYPE_CUSTOM; state = SF_STATE_DONE; break; } // Don't parse custom format further
+          case 'a': case 'A': // Only with a precision or alone, other text starting with 'a' is a custom pattern (eg. "abc")
+          {
+            if( is_digits_only(format) )
+            {
+              a_formatType = FORMAT_TYPE_HEXFLOAT;
+              a_flags |= (ch == 'A') ? DP_F_UP : 0;
+              state = SF_STATE_MAX_OR_PRECISION;
+              break;
+            }
+            a_formatType = FORMAT_TYPE_CUSTOM;
+            state = SF_STATE_DONE;
+            break;
+          }
+          case 'r': case 'R': // Round-trip, same as the default format
+          default: // Other letters alone or with digits are unsupported standard formats and use the default format.
+          {        // Any other text is a custom pattern, interned by the caller when used for a number.
+            a_formatType = (isalpha(ch) && is_digits_only(format)) ? FORMAT_TYPE_DEFAULT : FORMAT_TYPE_CUSTOM;
+            state = SF_STATE_DONE;
+            break;
+          }
         }
         ch = *format++;
         break;
@@ -470,19 +544,65 @@ static void ParseStandardNumericFormat(const char* a_formatString, int& a_format
 }
 
 
+// Index of the argument named a_name (a_length chars, not terminated), from a_names if given else a_argList.
+// Returns -1 if there is no such argument.
+static int find_named_arg(const char* a_name, size_t a_length, const fsChar* const* a_names, fsInt a_numNames, ArgList* a_argList)
+{
+  fsInt count = (a_names != NULL) ? a_numNames : a_argList->Count();
+  for( fsInt index = 0; index < count; ++index )
+  {
+    const fsChar* name = (a_names != NULL) ? a_names[index] : a_argList->GetName(index);
+    if( (name != NULL) && (strncmp(name, a_name, a_length) == 0) && (name[a_length] == '\0') )
+    {
+      return index;
+    }
+  }
+  return -1;
+}
+
+
 static int fmt_braced(char* a_buffer, size_t* a_currlen, size_t a_maxlen, 
                       int a_paramIndex, int a_alignment, const char* a_format,
                       ArgList& a_argList)
 {
-  int total = 0;
-  int flags = 0;
-
   // Is parameter index valid
   if( a_paramIndex < 0 || a_paramIndex >= a_argList.Count() )
   {
-    return total;
+    return 0;
+  }
+
+  int formatType = FORMAT_TYPE_DEFAULT;
+  int max = -1;
+  int flags = 0;
+  ParseStandardNumericFormat(a_format, formatType, max, flags);
+
+  const Arg& param = a_argList.GetAt(a_paramIndex);
+  if( (formatType == FORMAT_TYPE_CUSTOM) && param.IsNumber() && (param.m_type != Arg::ARG_TYPE_CHAR) ) // Other types ignore the pattern
+  {
+    max = CustomNumberFormat::Intern(a_format);
+    if( max == CustomNumberFormat::INTERN_FULL ) // Compile for this call
+    {
+      CustomNumberFormat custom;
+      if( custom.Compile(a_format) )
+      {
+        return fmt_custom(a_buffer, a_currlen, a_maxlen, param, a_alignment, flags, custom);
+      }
+    }
   }
 
+  return fmt_braced_value(a_buffer, a_currlen, a_maxlen, param, a_alignment, formatType, max, flags);
+}
+
+
+// Convert one parameter with its standard numeric format already parsed (as done once by CompileFormatString())
+static int fmt_braced_value(char* a_buffer, size_t* a_currlen, size_t a_maxlen, const Arg& a_param,
+                            int a_alignment, int a_formatType, int a_max, int a_flags)
+{
+  int total = 0;
+  int flags = a_flags;
+  int formatType = a_formatType;
+  int max = a_max;
+
   // Helper functions take flags, not negative numbers
   if( a_alignment < 0 )
   {
@@ -490,13 +610,19 @@ static int fmt_braced(char* a_buffer, size_t* a_currlen, size_t a_maxlen,
     a_alignment = -a_alignment;
   }
 
-  const Arg& param = a_argList.GetAt(a_paramIndex);
+  // Custom numeric format, a_max is the interned pattern index (see CustomNumberFormat::Intern())
+  if( formatType == FORMAT_TYPE_CUSTOM )
+  {
+    if( (max >= 0) && a_param.IsNumber() && (a_param.m_type != Arg::ARG_TYPE_CHAR) )
+    {
+      return fmt_custom(a_buffer, a_currlen, a_maxlen, a_param, a_alignment, flags, CustomNumberFormat::Get(max));
+    }
+    max = -1; // Default format for other types
+  }
+
+  const Arg& param = a_param;
   if( param.m_type == Arg::ARG_TYPE_CHAR )
   {
-    int formatType = FORMAT_TYPE_DEFAULT;
-    int max = -1;
-    ParseStandardNumericFormat(a_format, formatType, max, flags);
-    
     switch( formatType )
     {
       case FORMAT_TYPE_NUMBER:
@@ -514,6 +640,11 @@ static int fmt_braced(char* a_buffer, size_t* a_currlen, size_t a_maxlen,
         total += fmtint_64(a_buffer, a_currlen, a_maxlen, param.AsInt64(), 16, a_alignment, max, flags);
         break;
       }
+      case FORMAT_TYPE_BINARY:
+      {
+        total += fmtint_64(a_buffer, a_currlen, a_maxlen, param.AsInt64(), 2, a_alignment, max, flags);
+        break;
+      }
       default: // Char as string
       {
         char charString[2] = {param.m_valueChar, 0};
@@ -524,10 +655,6 @@ static int fmt_braced(char* a_buffer, size_t* a_currlen, size_t a_maxlen,
   }
   else if( param.IsCString() )
   {
-    int formatType = FORMAT_TYPE_DEFAULT;
-    int max = -1;
-    ParseStandardNumericFormat(a_format, formatType, max, flags);
-
     switch( formatType )
     {
       case FORMAT_TYPE_HEXADECIMAL:
@@ -535,6 +662,11 @@ static int fmt_braced(char* a_buffer, size_t* a_currlen, size_t a_maxlen,
         total += fmtint_64(a_buffer, a_currlen, a_maxlen, param.AsInt64(), 16, a_alignment, max, flags);
         break;
       }
+      case FORMAT_TYPE_BINARY:
+      {
+        total += fmtint_64(a_buffer, a_currlen, a_maxlen, param.AsInt64(), 2, a_alignment, max, flags);
+        break;
+      }
       default: // String
       {
         total += fmtstr(a_buffer, a_currlen, a_maxlen, param.m_valueCString, flags, a_alignment, max);
@@ -542,18 +674,52 @@ static int fmt_braced(char* a_buffer, size_t* a_currlen, size_t a_maxlen,
       }
     }
   }
-  else if( param.IsInteger() )
+#if FS_HAS_INT128
+  else if( param.Is128Bit() )
   {
-    int formatType = FORMAT_TYPE_DEFAULT;
-    int max = -1;
-    ParseStandardNumericFormat(a_format, formatType, max, flags);
+    if( param.m_type == Arg::ARG_TYPE_UINT128 )
+    {
+      flags |= DP_F_UNSIGNED;
+    }
 
     switch( formatType )
     {
       case FORMAT_TYPE_CURRENCY:
       {
-        total += dopr_outch(a_buffer, a_currlen, a_maxlen, '$'); // NOTE: Not taking into account locale etc.
+        const NumberFormatProfile& profile = NumberFormat::GetProfile();
+        total += dopr_outstr(a_buffer, a_currlen, a_maxlen, profile.m_currencyPrefix, profile.m_currencyPrefixLength);
+        total += fmtint_128(a_buffer, a_currlen, a_maxlen, param.AsInt128(), 10, a_alignment, max, flags | DP_F_SEPARATORS);
+        total += dopr_outstr(a_buffer, a_currlen, a_maxlen, profile.m_currencySuffix, profile.m_currencySuffixLength);
+        break;
+      }
+      case FORMAT_TYPE_HEXADECIMAL:
+      {
+        total += fmtint_128(a_buffer, a_currlen, a_maxlen, param.AsInt128(), 16, a_alignment, max, flags);
+        break;
+      }
+      case FORMAT_TYPE_BINARY:
+      {
+        total += fmtint_128(a_buffer, a_currlen, a_maxlen, param.AsInt128(), 2, a_alignment, max, flags);
+        break;
+      }
+      default: // Decimal or number
+      {
+        total += fmtint_128(a_buffer, a_currlen, a_maxlen, param.AsInt128(), 10, a_alignment, max, flags);
+        break;
+      }
+    }
+  }
+#endif // FS_HAS_INT128
+  else if( param.IsInteger() )
+  {
+    switch( formatType )
+    {
+      case FORMAT_TYPE_CURRENCY:
+      {
+        const NumberFormatProfile& profile = NumberFormat::GetProfile();
+        total += dopr_outstr(a_buffer, a_currlen, a_maxlen, profile.m_currencyPrefix, profile.m_currencyPrefixLength);
         total += fmtint_64(a_buffer, a_currlen, a_maxlen, param.AsInt64(), 10, a_alignment, max, flags | DP_F_SEPARATORS);
+        total += dopr_outstr(a_buffer, a_currlen, a_maxlen, profile.m_currencySuffix, profile.m_currencySuffixLength);
         break;
       }
       case FORMAT_TYPE_HEXADECIMAL:
@@ -561,6 +727,11 @@ static int fmt_braced(char* a_buffer, size_t* a_currlen, size_t a_maxlen,
         total += fmtint_64(a_buffer, a_currlen, a_maxlen, param.AsInt64(), 16, a_alignment, max, flags);
         break;
       }
+      case FORMAT_TYPE_BINARY:
+      {
+        total += fmtint_64(a_buffer, a_currlen, a_maxlen, param.AsInt64(), 2, a_alignment, max, flags);
+        break;
+      }
       default: // Decimal
       {
         total += fmtint_64(a_buffer, a_currlen, a_maxlen, param.AsInt64(), 10, a_alignment, max, flags);
@@ -568,13 +739,48 @@ static int fmt_braced(char* a_buffer, size_t* a_currlen, size_t a_maxlen,
       }
     }
   }
-  else if( param.IsFloat() )
+  else if( param.IsDecimal() )
   {
-    int formatType = FORMAT_TYPE_DEFAULT;
-    int max = -1;
-    ParseStandardNumericFormat(a_format, formatType, max, flags);
+    fsInt64 units = param.m_valueDecimal64.m_units;
+    int scale = param.m_valueDecimal64.m_scale;
 
+    switch( formatType )
+    {
+      case FORMAT_TYPE_CURRENCY:
+      {
+        const NumberFormatProfile& profile = NumberFormat::GetProfile();
+        total += dopr_outstr(a_buffer, a_currlen, a_maxlen, profile.m_currencyPrefix, profile.m_currencyPrefixLength);
+        total += fmtdec(a_buffer, a_currlen, a_maxlen, units, scale, a_alignment, max, flags | DP_F_SEPARATORS);
+        total += dopr_outstr(a_buffer, a_currlen, a_maxlen, profile.m_currencySuffix, profile.m_currencySuffixLength);
+        break;
+      }
+      case FORMAT_TYPE_PERCENT:
+      {
+        total += fmtdec(a_buffer, a_currlen, a_maxlen, units, scale - 2, a_alignment, max, flags); // Times 100, exact
+        total += dopr_outch(a_buffer, a_currlen, a_maxlen, '%');
+        break;
+      }
+      case FORMAT_TYPE_EXPONENT:
+      {
+        total += fmtfp64_exp(a_buffer, a_currlen, a_maxlen, param.AsFloat64(), a_alignment, max, flags);
+        break;
+      }
+      case FORMAT_TYPE_HEXFLOAT:
+      {
+        total += fmtfp_hex(a_buffer, a_currlen, a_maxlen, param.AsFloat64(), a_alignment, max, flags);
+        break;
+      }
+      default: // Fixed point, number (grouped) or general, all digits of the scale by default
+      {
+        total += fmtdec(a_buffer, a_currlen, a_maxlen, units, scale, a_alignment, max, flags);
+        break;
+      }
+    }
+  }
+  else if( param.IsFloat() )
+  {
     fsFloat64 fValue = param.AsFloat64();
+    bool native32 = (param.m_type == Arg::ARG_TYPE_FLOAT32) && !isfpexception(fValue); // Float32 digits, not promoted
 
     switch( formatType )
     {
@@ -590,8 +796,17 @@ static int fmt_braced(char* a_buffer, size_t* a_currlen, size_t a_maxlen,
         }
         else
         {
-          total += dopr_outch(a_buffer, a_currlen, a_maxlen, '$'); // NOTE: Not taking into account locale etc.
-          total += fmtfp(a_buffer, a_currlen, a_maxlen, fValue, a_alignment, max, flags | DP_F_SEPARATORS);
+          const NumberFormatProfile& profile = NumberFormat::GetProfile();
+          total += dopr_outstr(a_buffer, a_currlen, a_maxlen, profile.m_currencyPrefix, profile.m_currencyPrefixLength);
+          if( native32 )
+          {
+            total += fmtfp32(a_buffer, a_currlen, a_maxlen, param.m_valueFloat32, a_alignment, max, flags | DP_F_SEPARATORS);
+          }
+          else
+          {
+            total += fmtfp(a_buffer, a_currlen, a_maxlen, fValue, a_alignment, max, flags | DP_F_SEPARATORS);
+          }
+          total += dopr_outstr(a_buffer, a_currlen, a_maxlen, profile.m_currencySuffix, profile.m_currencySuffixLength);
         }
         break;
       }
@@ -618,6 +833,10 @@ static int fmt_braced(char* a_buffer, size_t* a_currlen, size_t a_maxlen,
         {
           total += fmtfp_exception(a_buffer, a_currlen, a_maxlen, fValue, a_alignment, max, flags | DP_F_UP); // Note, using upper case as default for float exception format
         }
+        else if( native32 )
+        {
+          total += fmtfp32(a_buffer, a_currlen, a_maxlen, param.m_valueFloat32, a_alignment, max, flags);
+        }
         else
         {
           total += fmtfp64(a_buffer, a_currlen, a_maxlen, fValue, a_alignment, max, flags);
@@ -629,24 +848,46 @@ static int fmt_braced(char* a_buffer, size_t* a_currlen, size_t a_maxlen,
         total += fmtfp64_exp(a_buffer, a_currlen, a_maxlen, fValue, a_alignment, max, flags);
         break;
       }
+      case FORMAT_TYPE_HEXFLOAT:
+      {
+        if( isfpexception(fValue) ) // Check for FP exception
+        {
+          total += fmtfp_exception(a_buffer, a_currlen, a_maxlen, fValue, a_alignment, max, flags);
+        }
+        else
+        {
+          total += fmtfp_hex(a_buffer, a_currlen, a_maxlen, fValue, a_alignment, max, flags);
+        }
+        break;
+      }
       case FORMAT_TYPE_NUMBER:
       {
-        total += fmtfp64(a_buffer, a_currlen, a_maxlen, fValue, a_alignment, max, flags);
+        if( native32 )
+        {
+          total += fmtfp32(a_buffer, a_currlen, a_maxlen, param.m_valueFloat32, a_alignment, max, flags);
+        }
+        else
+        {
+          total += fmtfp64(a_buffer, a_currlen, a_maxlen, fValue, a_alignment, max, flags);
+        }
         break;
       }
       default: // General
       {
-        total += fmtfp64_gen(a_buffer, a_currlen, a_maxlen, fValue, a_alignment, max, flags);
+        if( native32 && (max < 0) ) // Shortest round trip digits
+        {
+          total += fmtfp32_gen(a_buffer, a_currlen, a_maxlen, param.m_valueFloat32, a_alignment, flags);
+        }
+        else
+        {
+          total += fmtfp64_gen(a_buffer, a_currlen, a_maxlen, fValue, a_alignment, max, flags);
+        }
         break;
       }
     }
   }
   else if( param.m_type == Arg::ARG_TYPE_CONST_PTR ||  param.m_type == Arg::ARG_TYPE_NONCONST_PTR)
   {
-    int formatType = FORMAT_TYPE_DEFAULT;
-    int max = -1;
-    ParseStandardNumericFormat(a_format, formatType, max, flags);
-
     switch( formatType )
     {
       case FORMAT_TYPE_DECIMAL:
@@ -654,6 +895,11 @@ static int fmt_braced(char* a_buffer, size_t* a_currlen, size_t a_maxlen,
         total += fmtint_64(a_buffer, a_currlen, a_maxlen, param.AsInt64(), 10, a_alignment, max, flags);
         break;
       }
+      case FORMAT_TYPE_BINARY:
+      {
+        total += fmtint_64(a_buffer, a_currlen, a_maxlen, param.AsInt64(), 2, a_alignment, max, flags);
+        break;
+      }
       default: // Hex
       {
         total += fmtint_64(a_buffer, a_currlen, a_maxlen, param.AsInt64(), 16, a_alignment, max, flags);
@@ -666,10 +912,48 @@ static int fmt_braced(char* a_buffer, size_t* a_currlen, size_t a_maxlen,
 }
 
 
+// Convert a number with a compiled custom numeric format, then align it as a string
+static int fmt_custom(char* a_buffer, size_t* a_currlen, size_t a_maxlen, const Arg& a_param,
+                      int a_alignment, int a_flags, const CustomNumberFormat& a_custom)
+{
+  char converted[CustomNumberFormat::MAX_OUTPUT + 1];
+  size_t length;
+  if( a_param.IsFloat() || a_param.IsDecimal() )
+  {
+    fsFloat64 fValue = a_param.AsFloat64();
+    if( isfpexception(fValue) ) // Check for FP exception
+    {
+      return fmtfp_exception(a_buffer, a_currlen, a_maxlen, fValue, a_alignment, -1, a_flags | DP_F_UP);
+    }
+    length = a_custom.WriteFloat(converted, fValue);
+  }
+#if FS_HAS_INT128
+  else if( a_param.Is128Bit() )
+  {
+    fsInt128 value = a_param.AsInt128();
+    fsBool negative = (a_param.m_type == Arg::ARG_TYPE_INT128) && (value < 0);
+    length = a_custom.WriteInteger128(converted, negative ? (fsUInt128)0 - (fsUInt128)value : (fsUInt128)value, negative);
+  }
+#endif // FS_HAS_INT128
+  else if( a_param.m_type == Arg::ARG_TYPE_UINT64 )
+  {
+    length = a_custom.WriteInteger(converted, a_param.m_valueUInt64, false);
+  }
+  else
+  {
+    fsInt64 value = a_param.AsInt64();
+    length = a_custom.WriteInteger(converted, (value < 0) ? (fsUInt64)0 - (fsUInt64)value : (fsUInt64)value, value < 0);
+  }
+  converted[length] = '\0';
+  return fmtstr(a_buffer, a_currlen, a_maxlen, converted, a_flags, a_alignment, -1);
+}
+
+
 static int fmtstr(char *buffer, size_t *currlen, size_t maxlen,
                   const char *value, int flags, int min, int max)
 {
   int padlen, strln;     // amount to pad 
+  int numBytes;          // chars of value output
   int cnt = 0;
   int total = 0;
   
@@ -678,21 +962,31 @@ static int fmtstr(char *buffer, size_t *currlen, size_t maxlen,
     value = "<NULL>";
   }
 
+#if FS_UTF8_MODE
+  size_t numUnits; // Width and precision count code points (or columns), never split a code point
+  numBytes = (int)Utf8::Prefix(value, strlen(value), max, FS_UTF8_MODE, &numUnits);
+  strln = (int)numUnits;
+#else // FS_UTF8_MODE
   for (strln = 0; value[strln]; ++strln); // strlen
   if (max >= 0 && max < strln)
     strln = max;
+  numBytes = strln;
+#endif // FS_UTF8_MODE
   padlen = min - strln;
   if (padlen < 0) 
     padlen = 0;
   if (flags & DP_F_MINUS) 
     padlen = -padlen; // Left Justify
 
+  if (*currlen + 1 >= maxlen) // Measuring or full, nothing more can be written
+    return numBytes + ((padlen < 0) ? -padlen : padlen);
+
   while (padlen > 0)
   {
     total += dopr_outch(buffer, currlen, maxlen, ' ');
     --padlen;
   }
-  while (*value && ((max < 0) || (cnt < max)))
+  while (cnt < numBytes)
   {
     total += dopr_outch(buffer, currlen, maxlen, *value++);
     ++cnt;
@@ -705,6 +999,30 @@ static int fmtstr(char *buffer, size_t *currlen, size_t maxlen,
   return total;
 }
 
+// Number of digits of a_value in a_base, without converting
+static int count_digits(fsUInt64 a_value, int a_base)
+{
+  int digits = 1;
+  if (a_base == 10)
+  {
+    fsUInt64 power = 10;
+    while ((digits < 20) && (a_value >= power)) // Compare with powers of ten rather than divide
+    {
+      ++digits;
+      power *= 10;
+    }
+  }
+  else
+  {
+    while (a_value >= (unsigned)a_base)
+    {
+      a_value /= (unsigned)a_base;
+      ++digits;
+    }
+  }
+  return digits;
+}
+
 // Have to handle DP_F_NUM (ie 0x and 0 alternates) 
 
 static int fmtint_64(char *buffer, size_t *currlen, size_t maxlen,
@@ -715,10 +1033,7 @@ static int fmtint_64(char *buffer, size_t *currlen, size_t maxlen,
   const int MAX_CONVERT_CHARS = 64;
   char convert[MAX_CONVERT_CHARS];
   int place = 0;
-  int spadlen = 0; // amount to space pad 
-  int zpadlen = 0; // amount to zero pad 
   int caps = 0;
-  int total = 0;
 
   if (max < 0)
     max = 0;
@@ -742,25 +1057,102 @@ static int fmtint_64(char *buffer, size_t *currlen, size_t maxlen,
 
   if (flags & DP_F_UP) caps = 1; // Should characters be upper case? 
 
-  int digitIndex = 0;
-  do 
+  bool measureOnly = (*currlen + 1 >= maxlen); // Measuring or full, only the length is needed
+  bool grouped = (flags & DP_F_SEPARATORS) && (base == 10);
+  int bitsPerDigit = (base == 16) ? 4 : (base == 8) ? 3 : (base == 2) ? 1 : 0; // Power of two bases shift and mask
+  bool forward = grouped || (bitsPerDigit > 0);
+  int forwardLength = 0; // Bytes of digits written forward into convert, otherwise convert is reversed
+  if (grouped) // Number format, thousands groups from the number format profile
+  {
+    if (measureOnly)
+      forwardLength = (int)NumberFormat::GroupedLength(uvalue, NumberFormat::GetProfile(), &place);
+    else
+      forwardLength = (int)NumberFormat::WriteGrouped(convert, uvalue, NumberFormat::GetProfile(), &place);
+  }
+  else if (bitsPerDigit > 0)
+  {
+    if (measureOnly)
+      place = NumberFormat::Pow2Length(uvalue, bitsPerDigit);
+    else
+      place = NumberFormat::WritePow2(convert, uvalue, bitsPerDigit, caps != 0);
+    forwardLength = place;
+  }
+  else if (measureOnly)
+  {
+    place = count_digits(uvalue, base);
+  }
+  else if (base == 10) // Two digits per division, 32bit once the value fits (see NumberFormat::WriteDecimal())
   {
-    convert[place++] =
-      (caps? "0123456789ABCDEF":"0123456789abcdef")
-      [uvalue % (unsigned)base  ];
-    uvalue = (uvalue / (unsigned)base );
+    place = forwardLength = NumberFormat::WriteDecimal(convert, uvalue);
+    forward = true;
+  }
+  else
+  {
+    do 
+    {
+      convert[place++] =
+        (caps? "0123456789ABCDEF":"0123456789abcdef")
+        [uvalue % (unsigned)base  ];
+      uvalue = (uvalue / (unsigned)base );
+    } while(uvalue && (place < MAX_CONVERT_CHARS));
+    if (place == MAX_CONVERT_CHARS) place--;
+    convert[place] = 0;
+  }
+
+  return fmtint_out(buffer, currlen, maxlen, signvalue, convert, place, forward ? forwardLength : 0, measureOnly, min, max, flags);
+}
+
+#if FS_HAS_INT128
+
+// 128bit integer, decimal is converted in 19 digit chunks
+static int fmtint_128(char *buffer, size_t *currlen, size_t maxlen,
+                      fsInt128 a_value, int base, int min, int max, int flags)
+{
+  char signvalue = 0;
+  fsUInt128 uvalue = (fsUInt128)a_value;
+  char convert[NumberFormat::MAX_CONVERT_CHARS_128];
+  int place = 0;
+  int forwardLength = 0;
+
+  if (max < 0)
+    max = 0;
 
-    if( (flags & DP_F_SEPARATORS) && (base == 10) && (uvalue > 0) ) // Number format
+  if(!(flags & DP_F_UNSIGNED))
+  {
+    if( a_value < 0 ) 
     {
-      ++digitIndex;
-      if( (digitIndex % 3) == 0 ) // Insert comma every 3 places
-      {
-        convert[place++] = ',';
-      }
+      signvalue = '-';
+      uvalue = 0 - uvalue;
     }
-  } while(uvalue && (place < MAX_CONVERT_CHARS));
-  if (place == MAX_CONVERT_CHARS) place--;
-  convert[place] = 0;
+    else
+      if (flags & DP_F_PLUS)  // Do a sign (+/i) 
+        signvalue = '+';
+      else
+        if (flags & DP_F_SPACE)
+          signvalue = ' ';
+  }
+
+  int bitsPerDigit = (base == 16) ? 4 : (base == 8) ? 3 : (base == 2) ? 1 : 0;
+  if ((flags & DP_F_SEPARATORS) && (base == 10)) // Number format, thousands groups from the number format profile
+    forwardLength = (int)NumberFormat::WriteGrouped128(convert, uvalue, NumberFormat::GetProfile(), &place);
+  else if (bitsPerDigit > 0)
+    place = forwardLength = NumberFormat::WritePow2_128(convert, uvalue, bitsPerDigit, (flags & DP_F_UP) != 0);
+  else
+    place = forwardLength = NumberFormat::WriteDecimal128(convert, uvalue);
+
+  return fmtint_out(buffer, currlen, maxlen, signvalue, convert, place, forwardLength, (*currlen + 1 >= maxlen), min, max, flags);
+}
+
+#endif // FS_HAS_INT128
+
+// Pad and output converted integer digits. forwardLength is the bytes of digits in order in convert,
+// or 0 when convert holds place digits in reverse. place is the width of the digits for alignment.
+static int fmtint_out(char *buffer, size_t *currlen, size_t maxlen, char signvalue, const char *convert, int place,
+                      int forwardLength, bool measureOnly, int min, int max, int flags)
+{
+  int spadlen = 0; // amount to space pad 
+  int zpadlen = 0; // amount to zero pad 
+  int total = 0;
 
   zpadlen = max - place;
   spadlen = min - MAX (max, place) - (signvalue ? 1 : 0);
@@ -774,6 +1166,9 @@ static int fmtint_64(char *buffer, size_t *currlen, size_t maxlen,
   if (flags & DP_F_MINUS) 
     spadlen = -spadlen; // Left Justify 
 
+  if (measureOnly)
+    return ((spadlen < 0) ? -spadlen : spadlen) + (signvalue ? 1 : 0) + zpadlen + (forwardLength ? forwardLength : place);
+
 #ifdef DEBUG_SNPRINTF
   dprint (1, (debugfile, "zpad: %d, spad: %d, min: %d, max: %d, place: %d\n", zpadlen, spadlen, min, max, place));
 #endif
@@ -800,8 +1195,11 @@ static int fmtint_64(char *buffer, size_t *currlen, size_t maxlen,
   }
 
   // Digits 
-  while (place > 0) 
-    total += dopr_outch(buffer, currlen, maxlen, convert[--place]);
+  if (forwardLength)
+    total += dopr_outstr(buffer, currlen, maxlen, convert, forwardLength);
+  else
+    while (place > 0) 
+      total += dopr_outch(buffer, currlen, maxlen, convert[--place]);
 
   // Left Justified spaces 
   while (spadlen < 0) 
@@ -848,25 +1246,30 @@ static int fmtint(char *buffer, size_t *currlen, size_t maxlen,
 
   if (flags & DP_F_UP) caps = 1; // Should characters be upper case? 
 
-  int digitIndex = 0;
-  do 
+  bool grouped = (flags & DP_F_SEPARATORS) && (base == 10);
+  int bitsPerDigit = (base == 16) ? 4 : (base == 8) ? 3 : (base == 2) ? 1 : 0; // Power of two bases shift and mask
+  bool forward = grouped || (bitsPerDigit > 0);
+  int forwardLength = 0; // Bytes of digits written forward into convert, otherwise convert is reversed
+  if (grouped) // Number format, thousands groups from the number format profile
   {
-    convert[place++] =
-      (caps? "0123456789ABCDEF":"0123456789abcdef")
-      [uvalue % (unsigned)base  ];
-    uvalue = (uvalue / (unsigned)base );
-
-    if( (flags & DP_F_SEPARATORS) && (base == 10) && (uvalue > 0) ) // Number format
+    forwardLength = (int)NumberFormat::WriteGrouped(convert, uvalue, NumberFormat::GetProfile(), &place);
+  }
+  else if (bitsPerDigit > 0)
+  {
+    place = forwardLength = NumberFormat::WritePow2(convert, uvalue, bitsPerDigit, caps != 0);
+  }
+  else
+  {
+    do 
     {
-      ++digitIndex;
-      if( (digitIndex % 3) == 0 ) // Insert comma every 3 places
-      {
-        convert[place++] = ',';
-      }
-    }
-  } while(uvalue && (place < MAX_CONVERT_CHARS));
-  if (place == MAX_CONVERT_CHARS) place--;
-  convert[place] = 0;
+      convert[place++] =
+        (caps? "0123456789ABCDEF":"0123456789abcdef")
+        [uvalue % (unsigned)base  ];
+      uvalue = (uvalue / (unsigned)base );
+    } while(uvalue && (place < MAX_CONVERT_CHARS));
+    if (place == MAX_CONVERT_CHARS) place--;
+    convert[place] = 0;
+  }
 
   zpadlen = max - place;
   spadlen = min - MAX (max, place) - (signvalue ? 1 : 0);
@@ -906,8 +1309,11 @@ static int fmtint(char *buffer, size_t *currlen, size_t maxlen,
   }
 
   // Digits 
-  while (place > 0) 
-    total += dopr_outch(buffer, currlen, maxlen, convert[--place]);
+  if (forward)
+    total += dopr_outstr(buffer, currlen, maxlen, convert, forwardLength);
+  else
+    while (place > 0) 
+      total += dopr_outch(buffer, currlen, maxlen, convert[--place]);
 
   // Left Justified spaces 
   while (spadlen < 0) 
@@ -1174,25 +1580,24 @@ static int fmtfp(char *buffer, size_t *currlen, size_t maxlen,
 #endif
 
   // Convert integer part 
-  int digitIndex = 0;
-  do 
+  const NumberFormatProfile& profile = NumberFormat::GetProfile();
+  bool grouped = (flags & DP_F_SEPARATORS) != 0;
+  int groupedLength = 0; // Bytes of grouped digits, written forward into iconvert
+  if (grouped) // Number format, thousands groups from the number format profile
   {
-    iconvert[iplace++] =
-      (caps? "0123456789ABCDEF":"0123456789abcdef")[intpart % 10];
-    intpart = (intpart / 10);
-
-    if( (flags & DP_F_SEPARATORS) && (intpart > 0) ) // Number format
+    groupedLength = (int)NumberFormat::WriteGrouped(iconvert, (fsUInt64)intpart, profile, &iplace);
+  }
+  else
+  {
+    do 
     {
-      ++digitIndex;
-      if( (digitIndex % 3) == 0 ) // Insert comma every 3 places
-      {
-        iconvert[iplace++] = ',';
-      }
-    }
-
-  } while(intpart && (iplace < MAX_CONVERT_CHARS));
-  if (iplace == MAX_CONVERT_CHARS) iplace--;
-  iconvert[iplace] = 0;
+      iconvert[iplace++] =
+        (caps? "0123456789ABCDEF":"0123456789abcdef")[intpart % 10];
+      intpart = (intpart / 10);
+    } while(intpart && (iplace < MAX_CONVERT_CHARS));
+    if (iplace == MAX_CONVERT_CHARS) iplace--;
+    iconvert[iplace] = 0;
+  }
 
   // Convert fractional part 
 #if 1 // Configurable trailing zeros for general numbers
@@ -1224,7 +1629,7 @@ static int fmtfp(char *buffer, size_t *currlen, size_t maxlen,
   //  -1 for decimal point if there are any, another -1 if we are printing a sign 
   padlen = min - iplace - max; 
   if( (max > 0) && (fplace > 0) ) // decimal point
-    { padlen -= 1; }
+    { padlen -= grouped ? profile.m_decimalSeparatorWidth : 1; }
   if( signvalue ) // sign
     { padlen -= 1; }
 
@@ -1265,8 +1670,11 @@ static int fmtfp(char *buffer, size_t *currlen, size_t maxlen,
   if (signvalue) 
     total += dopr_outch(buffer, currlen, maxlen, signvalue);
 
-  while (iplace > 0) 
-    total += dopr_outch(buffer, currlen, maxlen, iconvert[--iplace]);
+  if (grouped)
+    total += dopr_outstr(buffer, currlen, maxlen, iconvert, groupedLength);
+  else
+    while (iplace > 0) 
+      total += dopr_outch(buffer, currlen, maxlen, iconvert[--iplace]);
 
   //
   // Decimal point.  This should probably use locale to find the correct
@@ -1274,7 +1682,10 @@ static int fmtfp(char *buffer, size_t *currlen, size_t maxlen,
   //
   if( (max > 0) && (fplace > 0) )
   {
-    total += dopr_outch(buffer, currlen, maxlen, '.');
+    if (grouped)
+      total += dopr_outstr(buffer, currlen, maxlen, profile.m_decimalSeparator, profile.m_decimalSeparatorLength);
+    else
+      total += dopr_outch(buffer, currlen, maxlen, '.');
 
     while (fplace > 0) 
       total += dopr_outch(buffer, currlen, maxlen, fconvert[--fplace]);
@@ -1431,25 +1842,24 @@ LDOUBLE pow10Max = pow10(max);
 #endif
 
   // Convert integer part 
-  int digitIndex = 0;
-  do 
+  const NumberFormatProfile& profile = NumberFormat::GetProfile();
+  bool grouped = (flags & DP_F_SEPARATORS) != 0;
+  int groupedLength = 0; // Bytes of grouped digits, written forward into iconvert
+  if (grouped) // Number format, thousands groups from the number format profile
   {
-    iconvert[iplace++] =
-      (caps? "0123456789ABCDEF":"0123456789abcdef")[intpart % 10];
-    intpart = (intpart / 10);
-
-    if( (flags & DP_F_SEPARATORS) && (intpart > 0) ) // Number format
+    groupedLength = (int)NumberFormat::WriteGrouped(iconvert, (fsUInt64)intpart, profile, &iplace);
+  }
+  else
+  {
+    do 
     {
-      ++digitIndex;
-      if( (digitIndex % 3) == 0 ) // Insert comma every 3 places
-      {
-        iconvert[iplace++] = ',';
-      }
-    }
-
-  } while(intpart && (iplace < MAX_CONVERT_CHARS));
-  if (iplace == MAX_CONVERT_CHARS) iplace--;
-  iconvert[iplace] = 0;
+      iconvert[iplace++] =
+        (caps? "0123456789ABCDEF":"0123456789abcdef")[intpart % 10];
+      intpart = (intpart / 10);
+    } while(intpart && (iplace < MAX_CONVERT_CHARS));
+    if (iplace == MAX_CONVERT_CHARS) iplace--;
+    iconvert[iplace] = 0;
+  }
 
   // Convert fractional part 
 #if 1 // Configurable trailing zeros for general numbers
@@ -1481,7 +1891,7 @@ LDOUBLE pow10Max = pow10(max);
   //  -1 for decimal point if there are any, another -1 if we are printing a sign 
   padlen = min - iplace - max; 
   if( (max > 0) && (fplace > 0) ) // decimal point
-    { padlen -= 1; }
+    { padlen -= grouped ? profile.m_decimalSeparatorWidth : 1; }
   if( signvalue ) // sign
     { padlen -= 1; }
 
@@ -1522,8 +1932,11 @@ LDOUBLE pow10Max = pow10(max);
   if (signvalue) 
     total += dopr_outch(buffer, currlen, maxlen, signvalue);
 
-  while (iplace > 0) 
-    total += dopr_outch(buffer, currlen, maxlen, iconvert[--iplace]);
+  if (grouped)
+    total += dopr_outstr(buffer, currlen, maxlen, iconvert, groupedLength);
+  else
+    while (iplace > 0) 
+      total += dopr_outch(buffer, currlen, maxlen, iconvert[--iplace]);
 
   //
   // Decimal point.  This should probably use locale to find the correct
@@ -1531,7 +1944,10 @@ LDOUBLE pow10Max = pow10(max);
   //
   if( (max > 0) && (fplace > 0) )
   {
-    total += dopr_outch(buffer, currlen, maxlen, '.');
+    if (grouped)
+      total += dopr_outstr(buffer, currlen, maxlen, profile.m_decimalSeparator, profile.m_decimalSeparatorLength);
+    else
+      total += dopr_outch(buffer, currlen, maxlen, '.');
 
     while (fplace > 0) 
       total += dopr_outch(buffer, currlen, maxlen, fconvert[--fplace]);
@@ -1553,6 +1969,141 @@ LDOUBLE pow10Max = pow10(max);
 }
 
 
+// Sign, padding and trailing zeros around the unsigned digits of a float32 or fixed point decimal conversion
+static int fmtfp32_out(char *buffer, size_t *currlen, size_t maxlen, bool negative, const char *convert, size_t length,
+                       int width, int zpadlen, int min, int flags)
+{
+  int total = 0;
+  char signvalue = negative ? '-' : (flags & DP_F_PLUS) ? '+' : (flags & DP_F_SPACE) ? ' ' : 0;
+  int padlen = min - width - zpadlen - (signvalue ? 1 : 0);
+  if (padlen < 0)
+    padlen = 0;
+  if (flags & DP_F_MINUS)
+    padlen = -padlen; // Left Justify
+
+  if ((flags & DP_F_ZERO) && (padlen > 0))
+  {
+    if (signvalue)
+    {
+      total += dopr_outch(buffer, currlen, maxlen, signvalue);
+      signvalue = 0;
+    }
+    while (padlen > 0)
+    {
+      total += dopr_outch(buffer, currlen, maxlen, '0');
+      --padlen;
+    }
+  }
+  while (padlen > 0)
+  {
+    total += dopr_outch(buffer, currlen, maxlen, ' ');
+    --padlen;
+  }
+  if (signvalue)
+    total += dopr_outch(buffer, currlen, maxlen, signvalue);
+
+  total += dopr_outstr(buffer, currlen, maxlen, convert, length);
+  while (zpadlen > 0)
+  {
+    total += dopr_outch(buffer, currlen, maxlen, '0');
+    --zpadlen;
+  }
+
+  while (padlen < 0)
+  {
+    total += dopr_outch(buffer, currlen, maxlen, ' ');
+    ++padlen;
+  }
+  return total;
+}
+
+
+// Float32 in fixed point, from its shortest decimal in 32bit arithmetic rather than promoted to double,
+// so no digits past float precision are shown. Finite values only.
+static int fmtfp32(char *buffer, size_t *currlen, size_t maxlen, fsFloat32 fvalue, int min, int max, int flags)
+{
+  if (max < 0)
+    max = 6;
+
+  char convert[NumberFormat::MAX_FLOAT32_FIXED_CHARS];
+  int fractionDigits;
+  int width;
+  const NumberFormatProfile* profile = (flags & DP_F_SEPARATORS) ? &NumberFormat::GetProfile() : NULL;
+  size_t length = NumberFormat::WriteFloat32Fixed(convert, fvalue, max, profile, &fractionDigits, &width);
+  return fmtfp32_out(buffer, currlen, maxlen, fvalue < 0, convert, length, width, max - fractionDigits, min, flags);
+}
+
+
+// Float32 general format with default precision, the shortest decimal that reads back as the same float. Finite values only.
+static int fmtfp32_gen(char *buffer, size_t *currlen, size_t maxlen, fsFloat32 fvalue, int min, int flags)
+{
+  char convert[NumberFormat::MAX_FLOAT32_GENERAL_CHARS];
+  size_t length = NumberFormat::WriteFloat32General(convert, fvalue, (flags & DP_F_UP) != 0);
+  return fmtfp32_out(buffer, currlen, maxlen, fvalue < 0, convert, length, (int)length, 0, min, flags);
+}
+
+
+// Hexadecimal float, as C99 %a: the digits come straight from the IEEE bits. Zero padding goes between the "0x" and the
+// digits, and precision past the float64 mantissa pads fraction zeros before the exponent. Finite values only.
+static int fmtfp_hex(char *buffer, size_t *currlen, size_t maxlen, fsFloat64 fvalue, int min, int max, int flags)
+{
+  char convert[NumberFormat::MAX_HEX_FLOAT64_CHARS];
+  int precision = (max > NumberFormat::HEX_FLOAT64_DIGITS) ? (int)NumberFormat::HEX_FLOAT64_DIGITS : max;
+  size_t length = NumberFormat::WriteHexFloat64(convert, fvalue, precision, (flags & DP_F_UP) != 0);
+  size_t mantissaLength = (const char*)memchr(convert, (flags & DP_F_UP) ? 'P' : 'p', length) - convert;
+  int zpadlen = max - precision;
+  char signvalue = FS_FLOAT64_SIGN_BIT_SET(fvalue) ? '-' : (flags & DP_F_PLUS) ? '+' : (flags & DP_F_SPACE) ? ' ' : 0;
+  int padlen = min - (int)length - zpadlen - (signvalue ? 1 : 0);
+  if (padlen < 0)
+    padlen = 0;
+
+  int total = 0;
+  bool zeroPad = (flags & DP_F_ZERO) && !(flags & DP_F_MINUS);
+  if (!zeroPad && !(flags & DP_F_MINUS))
+  {
+    for (; padlen > 0; --padlen)
+      total += dopr_outch(buffer, currlen, maxlen, ' ');
+  }
+  if (signvalue)
+    total += dopr_outch(buffer, currlen, maxlen, signvalue);
+  total += dopr_outstr(buffer, currlen, maxlen, convert, 2);
+  if (zeroPad)
+  {
+    for (; padlen > 0; --padlen)
+      total += dopr_outch(buffer, currlen, maxlen, '0');
+  }
+  total += dopr_outstr(buffer, currlen, maxlen, convert + 2, mantissaLength - 2);
+  for (; zpadlen > 0; --zpadlen)
+    total += dopr_outch(buffer, currlen, maxlen, '0');
+  total += dopr_outstr(buffer, currlen, maxlen, convert + mantissaLength, length - mantissaLength);
+  for (; padlen > 0; --padlen)
+    total += dopr_outch(buffer, currlen, maxlen, ' ');
+  return total;
+}
+
+
+
+// Fixed point decimal (units * 10^-scale) from its integer digits, exact. Precision defaults to the scale, and digits
+// past the scale are zeros. A negative scale adds zeros to the integer.
+static int fmtdec(char *buffer, size_t *currlen, size_t maxlen, fsInt64 units, int scale, int min, int max, int flags)
+{
+  if (scale > NumberFormat::MAX_DECIMAL64_SCALE)
+    scale = NumberFormat::MAX_DECIMAL64_SCALE;
+  else if (scale < -NumberFormat::MAX_DECIMAL64_SCALE)
+    scale = -NumberFormat::MAX_DECIMAL64_SCALE;
+  if (max < 0)
+    max = (scale > 0) ? scale : 0;
+
+  char convert[NumberFormat::MAX_DECIMAL64_FIXED_CHARS];
+  int fractionDigits;
+  int width;
+  const NumberFormatProfile* profile = (flags & DP_F_SEPARATORS) ? &NumberFormat::GetProfile() : NULL;
+  fsUInt64 magnitude = (units < 0) ? (fsUInt64)0 - (fsUInt64)units : (fsUInt64)units;
+  size_t length = NumberFormat::WriteDecimal64Fixed(convert, magnitude, scale, max, profile, &fractionDigits, &width);
+  return fmtfp32_out(buffer, currlen, maxlen, units < 0, convert, length, width, max - fractionDigits, min, flags);
+}
+
+
 static int dopr_outch(char *buffer, size_t *currlen, size_t maxlen, char c)
 {
   if (*currlen + 1 < maxlen)
@@ -1561,10 +2112,55 @@ static int dopr_outch(char *buffer, size_t *currlen, size_t maxlen, char c)
 }
 
 
-// GD Our wrapper
-fsInt FormatString(fsChar* a_str, size_t a_count, const fsChar* a_fmt, ArgList& a_args)
+// Output a run of chars, truncated the same as repeated dopr_outch()
+static int dopr_outstr(char *buffer, size_t *currlen, size_t maxlen, const char *str, size_t len)
+{
+  if (*currlen + len < maxlen)
+  {
+    memcpy(buffer + *currlen, str, len);
+    *currlen += len;
+  }
+  else if (*currlen + 1 < maxlen)
+  {
+    size_t avail = maxlen - 1 - *currlen;
+    memcpy(buffer + *currlen, str, avail);
+    *currlen += avail;
+  }
+  return (int)len;
+}
+
+
+static void dopr_terminate(char *buffer, size_t currlen, size_t maxlen)
+{
+  if ((buffer != NULL) && (maxlen > 0))
+  {
+    if (currlen < maxlen - 1)
+    { 
+      buffer[currlen] = '\0';
+    }
+    else 
+    {
+      buffer[maxlen - 1] = '\0';
+    }
+  }
+}
+
+
+static fsInt format_compiled(fsChar* a_str, size_t a_count, const CompiledFormatView& a_compiled, ArgList& a_args);
+
+
+static fsInt format_string(fsChar* a_str, size_t a_count, const fsChar* a_fmt, ArgList& a_args)
 {
-  if( a_str != NULL )
+  if( FormatCache::IsEnabled() )
+  {
+    CompiledFormat compiled;
+    if( FormatCache::Lookup(a_fmt, CompiledFormat::SYNTAX_BRACED, compiled, &a_args) )
+    {
+      return format_compiled(a_str, a_count, compiled.GetView(), a_args);
+    }
+  }
+
+  if( (a_str != NULL) && (a_count > 0) )
   {
     a_str[0] = 0;
   }
@@ -1573,4 +2169,430 @@ fsInt FormatString(fsChar* a_str, size_t a_count, const fsChar* a_fmt, ArgList&
 }
 
 
+// GD Our wrapper
+fsInt FormatString(fsChar* a_str, size_t a_count, const fsChar* a_fmt, ArgList& a_args)
+{
+#if FS_RECORDER
+  if( FormatRecorder::IsRecording() )
+  {
+    FormatRecorder::Sample(BinaryLog::SYNTAX_BRACED, a_fmt, (a_str != NULL) ? a_count : 0, NULL, a_args);
+  }
+#endif // FS_RECORDER
+#if FS_TELEMETRY
+  if( FormatTelemetry::IsEnabled() )
+  {
+    fsUInt64 start = FormatTelemetry::Now();
+    fsInt result = format_string(a_str, a_count, a_fmt, a_args);
+    FormatTelemetry::Record(a_fmt, FormatTelemetry::FUNCTION_FORMAT_STRING, start, result, (a_str != NULL) && (result >= 0) && ((size_t)result >= a_count), false);
+    return result;
+  }
+#endif // FS_TELEMETRY
+  return format_string(a_str, a_count, a_fmt, a_args);
+}
+
+
+fsInt FormatStringLength(const fsChar* a_fmt, ArgList& a_args)
+{
+  return FormatString(NULL, 0, a_fmt, a_args);
+}
+
+
+fsInt FormatStringLength(const CompiledFormat& a_compiled, ArgList& a_args)
+{
+  return FormatString(NULL, 0, a_compiled, a_args);
+}
+
+
+// Bytecode op for a compiled field, see FormatOp. Argument types are only known per call, so the specialized
+// ops guard on the type and fall back to fmt_braced_value().
+static fsUInt8 braced_opcode(const FormatField& a_field)
+{
+  if( !a_field.m_conversion )
+  {
+    return FormatOp::OP_LITERAL;
+  }
+  fsBool plain = (a_field.m_min == 0) && (a_field.m_max < 0) && (a_field.m_flags == 0);
+  switch( a_field.m_modifier )
+  {
+    case FORMAT_TYPE_DEFAULT:
+    case FORMAT_TYPE_DECIMAL:     return plain ? FormatOp::OP_INT_DEC : FormatOp::OP_GENERIC;
+    case FORMAT_TYPE_STRING:      return plain ? FormatOp::OP_STRING : FormatOp::OP_GENERIC;
+    case FORMAT_TYPE_FIXEDPOINT:  return (a_field.m_min >= 0) ? FormatOp::OP_FLOAT_FIXED : FormatOp::OP_GENERIC;
+    default:                      return FormatOp::OP_GENERIC;
+  }
+}
+
+
+// Parse format into literal runs and conversion fields, mirrors the dopr() state machine.
+// The standard numeric format of each field is parsed here too, into m_modifier (format type), m_max and m_flags
+// (m_max is the interned pattern of a custom numeric format),
+// and named params are resolved to argument indices from a_names, or else the names in a_argList.
+static fsBool compile_braced(const fsChar* a_fmt, CompiledFormat& a_compiled, const fsChar* const* a_names, fsInt a_numNames, ArgList* a_argList)
+{
+  a_compiled.m_format = NULL;
+  a_compiled.m_syntax = CompiledFormat::SYNTAX_BRACED;
+  a_compiled.m_numFields = 0;
+  a_compiled.m_numArgs = 0;
+  a_compiled.m_named = false;
+
+  if( a_fmt == NULL )
+  {
+    return false;
+  }
+
+  const fsChar* literal = a_fmt;   // Start of current literal run
+  const fsChar* pos = a_fmt;       // Scan position
+  fsInt numArgs = 0;
+
+  for(;;)
+  {
+    pos = CharScan::FindAny(pos, '{', '}');
+
+    if( a_compiled.m_numFields >= CompiledFormat::MAX_FIELDS )
+    {
+      return false; // Format too complex, use FormatString() directly
+    }
+    FormatField& field = a_compiled.m_fields[a_compiled.m_numFields];
+    field.m_literalOffset = (fsInt32)(literal - a_fmt);
+    field.m_literalLength = (fsInt32)(pos - literal);
+    field.m_min = 0;
+    field.m_max = -1;
+    field.m_flags = 0;
+    field.m_argIndex = FormatField::NO_ARG;
+    field.m_minArgIndex = FormatField::NO_ARG;
+    field.m_maxArgIndex = FormatField::NO_ARG;
+    field.m_conversion = 0;
+    field.m_modifier = FORMAT_TYPE_DEFAULT;
+
+    if( *pos == '\0' )
+    {
+      if( field.m_literalLength > 0 )
+      {
+        ++a_compiled.m_numFields;
+      }
+      break;
+    }
+    if( pos[1] == pos[0] ) // Escaped "{{" or "}}", second brace starts the next run
+    {
+      ++a_compiled.m_numFields;
+      literal = pos + 1;
+      pos += 2;
+      continue;
+    }
+    if( *pos == '}' )
+    {
+      return false; // Single close brace, leave dopr() to report it
+    }
+    ++pos; // Skip '{'
+
+    // Parameter index or name
+    int paramIndex = 0;
+    if( is_name_start(*pos) )
+    {
+      if( (a_names == NULL) && (a_argList == NULL) )
+      {
+        return false; // Nothing to resolve the name against
+      }
+      const fsChar* name = pos;
+      while( is_name_char(*pos) )
+      {
+        ++pos;
+      }
+      paramIndex = find_named_arg(name, pos - name, a_names, a_numNames, a_argList);
+      a_compiled.m_named = true;
+    }
+    while( isdigit(*pos) )
+    {
+      paramIndex = 10 * paramIndex + char_to_int(*pos);
+      ++pos;
+    }
+
+    // Alignment
+    int alignment = 0;
+    if( *pos == ',' )
+    {
+      ++pos;
+      bool leftJustify = (*pos == '-');
+      if( leftJustify )
+      {
+        ++pos;
+      }
+      while( isdigit(*pos) )
+      {
+        alignment = 10 * alignment + char_to_int(*pos);
+        ++pos;
+      }
+      if( leftJustify )
+      {
+        alignment = -alignment;
+      }
+    }
+
+    // Format, with "}}" escapes
+    const int MAX_FORMAT_STRING = 256;
+    char formatStringBuffer[MAX_FORMAT_STRING];
+    size_t currFormatLen = 0;
+    if( *pos == ':' )
+    {
+      ++pos;
+      while( (*pos != '\0') && ((*pos != '}') || (pos[1] == '}')) )
+      {
+        dopr_outch(formatStringBuffer, &currFormatLen, MAX_FORMAT_STRING, *pos);
+        pos += (*pos == '}') ? 2 : 1;
+      }
+    }
+    formatStringBuffer[currFormatLen] = '\0';
+
+    if( *pos == '\0' )
+    {
+      ++a_compiled.m_numFields; // Incomplete field at end, dopr() outputs nothing for it
+      break;
+    }
+    if( *pos != '}' )
+    {
+      return false; // Expected close brace, leave dopr() to report it
+    }
+    ++pos;
+
+    int formatType = FORMAT_TYPE_DEFAULT;
+    int max = -1;
+    int flags = 0;
+    ParseStandardNumericFormat(formatStringBuffer, formatType, max, flags);
+    if( formatType == FORMAT_TYPE_CUSTOM ) // Interned once here, argument types are only known per call
+    {
+      max = CustomNumberFormat::Intern(formatStringBuffer);
+      if( max < 0 )
+      {
+        return false; // Custom pattern not interned, leave dopr() to compile it per call
+      }
+    }
+
+    field.m_conversion = '{';
+    field.m_modifier = (fsChar)formatType;
+    field.m_min = alignment;
+    field.m_max = max;
+    field.m_flags = flags;
+    field.m_argIndex = (paramIndex <= 0x7FFF) ? (fsInt16)paramIndex : (fsInt16)FormatField::NO_ARG;
+    if( (paramIndex <= 0x7FFF) && (paramIndex >= numArgs) )
+    {
+      numArgs = paramIndex + 1;
+    }
+    ++a_compiled.m_numFields;
+    literal = pos;
+  }
+
+  fsUInt8 opcodes[CompiledFormat::MAX_FIELDS];
+  for( fsInt fieldIndex = 0; fieldIndex < a_compiled.m_numFields; ++fieldIndex )
+  {
+    opcodes[fieldIndex] = braced_opcode(a_compiled.m_fields[fieldIndex]);
+  }
+  a_compiled.EmitCode(opcodes);
+  a_compiled.m_numArgs = numArgs;
+  a_compiled.m_format = a_fmt;
+  return true;
+}
+
+
+// Full conversion of a compiled field, the OP_GENERIC case and the fallback of the specialized ops
+static inline int fmt_field(char* a_buffer, size_t* a_currlen, size_t a_maxlen, const FormatField& a_field, ArgList& a_args)
+{
+  if( (a_field.m_argIndex < 0) || (a_field.m_argIndex >= a_args.Count()) )
+  {
+    return 0;
+  }
+  return fmt_braced_value(a_buffer, a_currlen, a_maxlen, a_args.GetAt(a_field.m_argIndex), a_field.m_min, a_field.m_modifier, a_field.m_max, a_field.m_flags);
+}
+
+
+// Integer types converted by OP_INT_DEC, chars and 128bit integers take the full path
+static inline fsBool is_plain_integer(const Arg& a_arg)
+{
+  return (a_arg.m_type >= Arg::ARG_TYPE_INT8) && (a_arg.m_type <= Arg::ARG_TYPE_UINT64);
+}
+
+
+// Decimal integer with no width, precision or flags, as fmtint_64() would output it
+static inline int fmt_int_dec(char* a_buffer, size_t* a_currlen, size_t a_maxlen, fsInt64 a_value)
+{
+  fsUInt64 uvalue = (a_value < 0) ? (0 - (fsUInt64)a_value) : (fsUInt64)a_value;
+  if( *a_currlen + 1 >= a_maxlen ) // Measuring or full, only the length is needed
+  {
+    return NumberFormat::DecimalLength(uvalue) + ((a_value < 0) ? 1 : 0);
+  }
+  char convert[24];
+  int length = 0;
+  if( a_value < 0 )
+  {
+    convert[length++] = '-';
+  }
+  length += NumberFormat::WriteDecimal(convert + length, uvalue);
+  return dopr_outstr(a_buffer, a_currlen, a_maxlen, convert, length);
+}
+
+
+// Run the compiled bytecode, one dispatch per op (see FormatOp)
+static fsInt format_compiled(fsChar* a_str, size_t a_count, const CompiledFormatView& a_compiled, ArgList& a_args)
+{
+  if( (a_str != NULL) && (a_count > 0) )
+  {
+    a_str[0] = 0;
+  }
+  FS_ASSERT( a_compiled.IsValid() && (a_compiled.m_syntax == CompiledFormat::SYNTAX_BRACED) );
+  if( !a_compiled.IsValid() || (a_compiled.m_syntax != CompiledFormat::SYNTAX_BRACED) )
+  {
+    return 0;
+  }
+
+#if FS_THREADED_DISPATCH
+  static void* const s_labels[FormatOp::NUM_OPCODES] =
+  {
+    &&op_end, &&op_literal, &&op_int_dec, &&op_int_dec_literal, &&op_string, &&op_string_literal, &&op_float_fixed, &&op_generic
+  };
+#endif // FS_THREADED_DISPATCH
+
+  const fsChar* format = a_compiled.m_format;
+  const FormatField* fields = a_compiled.m_fields;
+  const FormatOp* op = a_compiled.m_code;
+  size_t currlen = 0;
+  int total = 0;
+
+  FS_DISPATCH(op)
+  FS_OP(OP_LITERAL, op_literal)
+  {
+    const FormatField& field = fields[op->m_field];
+    total += dopr_outstr(a_str, &currlen, a_count, format + field.m_literalOffset, field.m_literalLength);
+    FS_NEXT(op);
+  }
+  FS_OP(OP_INT_DEC, op_int_dec)
+  {
+    const FormatField& field = fields[op->m_field];
+    total += dopr_outstr(a_str, &currlen, a_count, format + field.m_literalOffset, field.m_literalLength);
+    const Arg& arg = a_args.GetAt(field.m_argIndex);
+    total += is_plain_integer(arg) ? fmt_int_dec(a_str, &currlen, a_count, arg.AsInt64()) : fmt_field(a_str, &currlen, a_count, field, a_args);
+    FS_NEXT(op);
+  }
+  FS_OP(OP_INT_DEC_LITERAL, op_int_dec_literal)
+  {
+    const FormatField& field = fields[op->m_field];
+    total += dopr_outstr(a_str, &currlen, a_count, format + field.m_literalOffset, field.m_literalLength);
+    const Arg& arg = a_args.GetAt(field.m_argIndex);
+    total += is_plain_integer(arg) ? fmt_int_dec(a_str, &currlen, a_count, arg.AsInt64()) : fmt_field(a_str, &currlen, a_count, field, a_args);
+    const FormatField& next = fields[op->m_field + 1];
+    total += dopr_outstr(a_str, &currlen, a_count, format + next.m_literalOffset, next.m_literalLength);
+    FS_NEXT(op);
+  }
+  FS_OP(OP_STRING, op_string)
+  {
+    const FormatField& field = fields[op->m_field];
+    total += dopr_outstr(a_str, &currlen, a_count, format + field.m_literalOffset, field.m_literalLength);
+    const Arg& arg = a_args.GetAt(field.m_argIndex);
+    total += (arg.IsCString() && arg.m_valueCString) ? dopr_outstr(a_str, &currlen, a_count, arg.m_valueCString, strlen(arg.m_valueCString))
+                                                     : fmt_field(a_str, &currlen, a_count, field, a_args);
+    FS_NEXT(op);
+  }
+  FS_OP(OP_STRING_LITERAL, op_string_literal)
+  {
+    const FormatField& field = fields[op->m_field];
+    total += dopr_outstr(a_str, &currlen, a_count, format + field.m_literalOffset, field.m_literalLength);
+    const Arg& arg = a_args.GetAt(field.m_argIndex);
+    total += (arg.IsCString() && arg.m_valueCString) ? dopr_outstr(a_str, &currlen, a_count, arg.m_valueCString, strlen(arg.m_valueCString))
+                                                     : fmt_field(a_str, &currlen, a_count, field, a_args);
+    const FormatField& next = fields[op->m_field + 1];
+    total += dopr_outstr(a_str, &currlen, a_count, format + next.m_literalOffset, next.m_literalLength);
+    FS_NEXT(op);
+  }
+  FS_OP(OP_FLOAT_FIXED, op_float_fixed)
+  {
+    const FormatField& field = fields[op->m_field];
+    total += dopr_outstr(a_str, &currlen, a_count, format + field.m_literalOffset, field.m_literalLength);
+    const Arg& arg = a_args.GetAt(field.m_argIndex);
+    if( (arg.m_type == Arg::ARG_TYPE_FLOAT32) && !isfpexception(arg.AsFloat64()) )
+    {
+      total += fmtfp32(a_str, &currlen, a_count, arg.m_valueFloat32, field.m_min, field.m_max, field.m_flags);
+    }
+    else if( arg.IsFloat() && !isfpexception(arg.AsFloat64()) )
+    {
+      total += fmtfp64(a_str, &currlen, a_count, arg.AsFloat64(), field.m_min, field.m_max, field.m_flags);
+    }
+    else
+    {
+      total += fmt_field(a_str, &currlen, a_count, field, a_args);
+    }
+    FS_NEXT(op);
+  }
+  FS_OP(OP_GENERIC, op_generic)
+  {
+    const FormatField& field = fields[op->m_field];
+    total += dopr_outstr(a_str, &currlen, a_count, format + field.m_literalOffset, field.m_literalLength);
+    total += fmt_field(a_str, &currlen, a_count, field, a_args);
+    FS_NEXT(op);
+  }
+  FS_OP(OP_END, op_end)
+  {
+  }
+  FS_END_DISPATCH
+
+  dopr_terminate(a_str, currlen, a_count);
+  return total;
+}
+
+
+fsInt FormatString(fsChar* a_str, size_t a_count, const CompiledFormat& a_compiled, ArgList& a_args)
+{
+  return FormatString(a_str, a_count, a_compiled.GetView(), a_args);
+}
+
+
+fsInt FormatString(fsChar* a_str, size_t a_count, const CompiledFormatView& a_compiled, ArgList& a_args)
+{
+#if FS_RECORDER
+  if( FormatRecorder::IsRecording() )
+  {
+    FormatRecorder::Sample(BinaryLog::SYNTAX_BRACED, a_compiled.m_named ? NULL : a_compiled.m_format, (a_str != NULL) ? a_count : 0, NULL, a_args);
+  }
+#endif // FS_RECORDER
+#if FS_TELEMETRY
+  if( FormatTelemetry::IsEnabled() )
+  {
+    fsUInt64 start = FormatTelemetry::Now();
+    fsInt result = format_compiled(a_str, a_count, a_compiled, a_args);
+    FormatTelemetry::Record(a_compiled.m_format, FormatTelemetry::FUNCTION_FORMAT_STRING, start, result, (a_str != NULL) && (result >= 0) && ((size_t)result >= a_count), false);
+    return result;
+  }
+#endif // FS_TELEMETRY
+  return format_compiled(a_str, a_count, a_compiled, a_args);
+}
+
+fsBool CompileFormatString(const fsChar* a_fmt, CompiledFormat& a_compiled, const fsChar* const* a_names, fsInt a_numNames)
+{
+  return compile_braced(a_fmt, a_compiled, a_names, a_numNames, NULL);
+}
+
+
+fsBool CompileFormatString(const fsChar* a_fmt, CompiledFormat& a_compiled, ArgList& a_namedArgs)
+{
+  return compile_braced(a_fmt, a_compiled, NULL, 0, &a_namedArgs);
+}
+
+
+fsBool IsPortableCompiledFormat(const CompiledFormatView& a_compiled)
+{
+  if( !a_compiled.IsValid() || a_compiled.m_named )
+  {
+    return false;
+  }
+  if( a_compiled.m_syntax == CompiledFormat::SYNTAX_BRACED )
+  {
+    for( fsInt fieldIndex = 0; fieldIndex < a_compiled.m_numFields; ++fieldIndex )
+    {
+      const FormatField& field = a_compiled.m_fields[fieldIndex];
+      if( (field.m_conversion == '{') && (field.m_modifier == FORMAT_TYPE_CUSTOM) )
+      {
+        return false; // m_max is an index into this process's interned patterns
+      }
+    }
+  }
+  return true;
+}
+
 END_NAMESPACE_FORMATSTRINGLIB
\ No newline at end of file
@@ -7,12 +7,13 @@
 //
 
 #include "Arg.h"
+#include "CompiledFormat.h"
 
 //
 // The syntax for a format is "{param[,alignment][:format]}"
 // .Net style formatting with support for standard numeric format strings
 //
-// param - Zero based parameter index
+// param - Zero based parameter index, or name of a named argument (see ArgListNamed in Arg.h)
 // alignment - Optional minimum width of converted value, negative for left justification
 // format - Optional format string eg. 'F3' for fixed point with 3 decimal places of precision
 //
@@ -24,11 +25,33 @@
 //   f/F = Fixed point real number
 //   e/E = Exponential (scientific) real number
 //   g/G = General real number
+//   a/A = Hexadecimal real number, "0x1.8p+1", exact and read back by ScanStringF
 //   x/X = Hexadecimal integer
+//   b/B = Binary integer
 //   s/S = String
 //   p/P = Percentage
-//   n/N = Number (only comma group separators)
-//   c/C = Currency (only $)
+//   n/N = Number with group separators
+//   c/C = Currency
+//   Fixed point decimals (Decimal64, see Arg.h) are written from their integer digits, exactly, by all but e/E and a/A,
+//   with the scale as the default precision. Eg. FormatString(buffer, 512, "{0:N}", Decimal64(123456789, 2)) is "1,234,567.89"
+//   Separators and currency symbols come from the number format profile, see NumberFormat.h
+//   Any other format is a custom numeric format, eg. "{0:#,##0.00}" or "{0:0.##%}", see CustomNumberFormat.h
+//
+// Alignment and precision of strings count bytes, or UTF-8 code points or columns when enabled (see FS_UTF8_MODE in Utf8.h)
+//
+// Repeated use of the same format can skip parsing by compiling it once.
+// Eg. static CompiledFormat s_fmt; if( !s_fmt.IsValid() ) CompileFormatString("Count: {0} value: {1:F3}", s_fmt);
+//     FormatString(buffer, 512, s_fmt, 34, 123.456789);
+// Or enable the process-wide FormatCache (see FormatCache.h) to compile formats passed to FormatString() on first use.
+// FormatTelemetry (see FormatTelemetry.h) counts calls, output and time per format when enabled.
+//
+// Named params are matched against the argument names on each call of the uncompiled path. Compiling resolves them
+// to indices once, after which formatting is the same as for "{0}" style params.
+// Eg. static const fsChar* s_names[] = { "user", "latency_ms" };
+//     static CompiledFormat s_fmt; if( !s_fmt.IsValid() ) CompileFormatString("{user} took {latency_ms:F2}ms", s_fmt, s_names, 2);
+//     FormatString(buffer, 512, s_fmt, userName, latency);
+// Or bind by name, eg. ArgListNamed args(NamedArg("user", userName), NamedArg("latency_ms", latency));
+//     FormatString(buffer, 512, "{user} took {latency_ms:F2}ms", args);
 //
 
 BEGIN_NAMESPACE_FORMATSTRINGLIB
@@ -48,6 +71,62 @@ inline fsInt FormatString(fsChar* a_str, size_t a_count, const fsChar* a_fmt, Ar
 inline fsInt FormatString(fsChar* a_str, size_t a_count, const fsChar* a_fmt, Arg a_p1, Arg a_p2, Arg a_p3, Arg a_p4, Arg a_p5, Arg a_p6, Arg a_p7)            {  ArgListFixed args(a_p1, a_p2, a_p3, a_p4, a_p5, a_p6, a_p7);       return FormatString(a_str, a_count, a_fmt,  args); }
 inline fsInt FormatString(fsChar* a_str, size_t a_count, const fsChar* a_fmt, Arg a_p1, Arg a_p2, Arg a_p3, Arg a_p4, Arg a_p5, Arg a_p6, Arg a_p7, Arg a_p8)  {  ArgListFixed args(a_p1, a_p2, a_p3, a_p4, a_p5, a_p6, a_p7, a_p8); return FormatString(a_str, a_count, a_fmt,  args); }
 
+
+// Parse format once for repeated use. Returns false if the format is invalid or has too many fields.
+// Named params are resolved against a_names, the argument names in argument order. A format with named params
+// can not be compiled without names. Names not found convert to nothing, as with out of range indices.
+fsBool CompileFormatString(const fsChar* a_fmt, CompiledFormat& a_compiled, const fsChar* const* a_names = NULL, fsInt a_numNames = 0);
+
+// Parse format once, resolving named params against the names of a_namedArgs (see ArgListNamed)
+fsBool CompileFormatString(const fsChar* a_fmt, CompiledFormat& a_compiled, ArgList& a_namedArgs);
+
+// True if a compiled format (eg. CompiledFormat::GetView()) depends only on its text and so can be persisted (see FormatCatalog.h).
+// Formats with named params or custom numeric patterns (interned per process) are not portable.
+fsBool IsPortableCompiledFormat(const CompiledFormatView& a_compiled);
+
+// Format string with compiled format and argument list
+fsInt FormatString(fsChar* a_str, size_t a_count, const CompiledFormat& a_compiled, ArgList& a_args);
+
+// Compiled format with variable argument overloads
+inline fsInt FormatString(fsChar* a_str, size_t a_count, const CompiledFormat& a_compiled)                                                                                  {  ArgListFixed args;                                                 return FormatString(a_str, a_count, a_compiled,  args); }
+inline fsInt FormatString(fsChar* a_str, size_t a_count, const CompiledFormat& a_compiled, Arg a_p1)                                                                        {  ArgListFixed args(a_p1);                                           return FormatString(a_str, a_count, a_compiled,  args); }
+inline fsInt FormatString(fsChar* a_str, size_t a_count, const CompiledFormat& a_compiled, Arg a_p1, Arg a_p2)                                                              {  ArgListFixed args(a_p1, a_p2);                                     return FormatString(a_str, a_count, a_compiled,  args); }
+inline fsInt FormatString(fsChar* a_str, size_t a_count, const CompiledFormat& a_compiled, Arg a_p1, Arg a_p2, Arg a_p3)                                                    {  ArgListFixed args(a_p1, a_p2, a_p3);                               return FormatString(a_str, a_count, a_compiled,  args); }
+inline fsInt FormatString(fsChar* a_str, size_t a_count, const CompiledFormat& a_compiled, Arg a_p1, Arg a_p2, Arg a_p3, Arg a_p4)                                          {  ArgListFixed args(a_p1, a_p2, a_p3, a_p4);                         return FormatString(a_str, a_count, a_compiled,  args); }
+inline fsInt FormatString(fsChar* a_str, size_t a_count, const CompiledFormat& a_compiled, Arg a_p1, Arg a_p2, Arg a_p3, Arg a_p4, Arg a_p5)                                {  ArgListFixed args(a_p1, a_p2, a_p3, a_p4, a_p5);                   return FormatString(a_str, a_count, a_compiled,  args); }
+inline fsInt FormatString(fsChar* a_str, size_t a_count, const CompiledFormat& a_compiled, Arg a_p1, Arg a_p2, Arg a_p3, Arg a_p4, Arg a_p5, Arg a_p6)                      {  ArgListFixed args(a_p1, a_p2, a_p3, a_p4, a_p5, a_p6);             return FormatString(a_str, a_count, a_compiled,  args); }
+inline fsInt FormatString(fsChar* a_str, size_t a_count, const CompiledFormat& a_compiled, Arg a_p1, Arg a_p2, Arg a_p3, Arg a_p4, Arg a_p5, Arg a_p6, Arg a_p7)            {  ArgListFixed args(a_p1, a_p2, a_p3, a_p4, a_p5, a_p6, a_p7);       return FormatString(a_str, a_count, a_compiled,  args); }
+inline fsInt FormatString(fsChar* a_str, size_t a_count, const CompiledFormat& a_compiled, Arg a_p1, Arg a_p2, Arg a_p3, Arg a_p4, Arg a_p5, Arg a_p6, Arg a_p7, Arg a_p8)  {  ArgListFixed args(a_p1, a_p2, a_p3, a_p4, a_p5, a_p6, a_p7, a_p8); return FormatString(a_str, a_count, a_compiled,  args); }
+
+// Format string with a compiled format view, eg. an entry of a FormatCatalog (see FormatCatalog.h)
+fsInt FormatString(fsChar* a_str, size_t a_count, const CompiledFormatView& a_view, ArgList& a_args);
+
+inline fsInt FormatString(fsChar* a_str, size_t a_count, const CompiledFormatView& a_view)                                                                                  {  ArgListFixed args;                                                 return FormatString(a_str, a_count, a_view,  args); }
+inline fsInt FormatString(fsChar* a_str, size_t a_count, const CompiledFormatView& a_view, Arg a_p1)                                                                        {  ArgListFixed args(a_p1);                                           return FormatString(a_str, a_count, a_view,  args); }
+inline fsInt FormatString(fsChar* a_str, size_t a_count, const CompiledFormatView& a_view, Arg a_p1, Arg a_p2)                                                              {  ArgListFixed args(a_p1, a_p2);                                     return FormatString(a_str, a_count, a_view,  args); }
+inline fsInt FormatString(fsChar* a_str, size_t a_count, const CompiledFormatView& a_view, Arg a_p1, Arg a_p2, Arg a_p3)                                                    {  ArgListFixed args(a_p1, a_p2, a_p3);                               return FormatString(a_str, a_count, a_view,  args); }
+inline fsInt FormatString(fsChar* a_str, size_t a_count, const CompiledFormatView& a_view, Arg a_p1, Arg a_p2, Arg a_p3, Arg a_p4)                                          {  ArgListFixed args(a_p1, a_p2, a_p3, a_p4);                         return FormatString(a_str, a_count, a_view,  args); }
+inline fsInt FormatString(fsChar* a_str, size_t a_count, const CompiledFormatView& a_view, Arg a_p1, Arg a_p2, Arg a_p3, Arg a_p4, Arg a_p5)                                {  ArgListFixed args(a_p1, a_p2, a_p3, a_p4, a_p5);                   return FormatString(a_str, a_count, a_view,  args); }
+inline fsInt FormatString(fsChar* a_str, size_t a_count, const CompiledFormatView& a_view, Arg a_p1, Arg a_p2, Arg a_p3, Arg a_p4, Arg a_p5, Arg a_p6)                      {  ArgListFixed args(a_p1, a_p2, a_p3, a_p4, a_p5, a_p6);             return FormatString(a_str, a_count, a_view,  args); }
+inline fsInt FormatString(fsChar* a_str, size_t a_count, const CompiledFormatView& a_view, Arg a_p1, Arg a_p2, Arg a_p3, Arg a_p4, Arg a_p5, Arg a_p6, Arg a_p7)            {  ArgListFixed args(a_p1, a_p2, a_p3, a_p4, a_p5, a_p6, a_p7);       return FormatString(a_str, a_count, a_view,  args); }
+inline fsInt FormatString(fsChar* a_str, size_t a_count, const CompiledFormatView& a_view, Arg a_p1, Arg a_p2, Arg a_p3, Arg a_p4, Arg a_p5, Arg a_p6, Arg a_p7, Arg a_p8)  {  ArgListFixed args(a_p1, a_p2, a_p3, a_p4, a_p5, a_p6, a_p7, a_p8); return FormatString(a_str, a_count, a_view,  args); }
+
+
+// Length of formatted output (excluding terminator) without writing anything, for sizing buffers exactly
+fsInt FormatStringLength(const fsChar* a_fmt, ArgList& a_args);
+fsInt FormatStringLength(const CompiledFormat& a_compiled, ArgList& a_args);
+
+// Length of formatted output with variable argument overloads
+inline fsInt FormatStringLength(const fsChar* a_fmt)                                                                                  {  ArgListFixed args;                                                 return FormatStringLength(a_fmt,  args); }
+inline fsInt FormatStringLength(const fsChar* a_fmt, Arg a_p1)                                                                        {  ArgListFixed args(a_p1);                                           return FormatStringLength(a_fmt,  args); }
+inline fsInt FormatStringLength(const fsChar* a_fmt, Arg a_p1, Arg a_p2)                                                              {  ArgListFixed args(a_p1, a_p2);                                     return FormatStringLength(a_fmt,  args); }
+inline fsInt FormatStringLength(const fsChar* a_fmt, Arg a_p1, Arg a_p2, Arg a_p3)                                                    {  ArgListFixed args(a_p1, a_p2, a_p3);                               return FormatStringLength(a_fmt,  args); }
+inline fsInt FormatStringLength(const fsChar* a_fmt, Arg a_p1, Arg a_p2, Arg a_p3, Arg a_p4)                                          {  ArgListFixed args(a_p1, a_p2, a_p3, a_p4);                         return FormatStringLength(a_fmt,  args); }
+inline fsInt FormatStringLength(const fsChar* a_fmt, Arg a_p1, Arg a_p2, Arg a_p3, Arg a_p4, Arg a_p5)                                {  ArgListFixed args(a_p1, a_p2, a_p3, a_p4, a_p5);                   return FormatStringLength(a_fmt,  args); }
+inline fsInt FormatStringLength(const fsChar* a_fmt, Arg a_p1, Arg a_p2, Arg a_p3, Arg a_p4, Arg a_p5, Arg a_p6)                      {  ArgListFixed args(a_p1, a_p2, a_p3, a_p4, a_p5, a_p6);             return FormatStringLength(a_fmt,  args); }
+inline fsInt FormatStringLength(const fsChar* a_fmt, Arg a_p1, Arg a_p2, Arg a_p3, Arg a_p4, Arg a_p5, Arg a_p6, Arg a_p7)            {  ArgListFixed args(a_p1, a_p2, a_p3, a_p4, a_p5, a_p6, a_p7);       return FormatStringLength(a_fmt,  args); }
+inline fsInt FormatStringLength(const fsChar* a_fmt, Arg a_p1, Arg a_p2, Arg a_p3, Arg a_p4, Arg a_p5, Arg a_p6, Arg a_p7, Arg a_p8)  {  ArgListFixed args(a_p1, a_p2, a_p3, a_p4, a_p5, a_p6, a_p7, a_p8); return FormatStringLength(a_fmt,  args); }
+
 END_NAMESPACE_FORMATSTRINGLIB
 
-#endif FORMATSTRING_H
\ No newline at end of file
+#endif //FORMATSTRING_H
\ No newline at end of file
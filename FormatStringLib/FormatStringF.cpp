@@ -11,6 +11,7 @@
 // basic support for float exception formats (Ind, Inf, Nan) with signs.
 // fixed critical bug where leading zeros in fraction part of float were lost (eg. 1.002 became 1.2)
 // experimental support for ',' separator
+// %a / %A hexadecimal floats
 //
 // NOTE: Still missing newer multi byte modifiers like 'llu' (long long unsigned decimal).
 //       Note that the new type extensions are unnecessary as types are auto detected.
@@ -22,7 +23,14 @@
 //
 
 #include <iostream>
+#include <string.h>
 #include "FormatStringF.h"
+#include "CharScan.h"
+#include "FormatCache.h"
+#include "FormatRecorder.h"
+#include "FormatTelemetry.h"
+#include "NumberFormat.h"
+#include "Utf8.h"
 
 BEGIN_NAMESPACE_FORMATSTRINGLIB
 
@@ -91,10 +99,19 @@ BEGIN_NAMESPACE_FORMATSTRINGLIB
 #endif
 
 static int dopr(char *buffer, size_t maxlen, const char *format, ArgList& a_argList); //va_list args);
+static int parse_modifier(const char** a_pos);
+static int parse_position(const char** a_pos);
+static bool is_conversion(char ch);
+static int fmt_conversion(char *buffer, size_t *currlen, size_t maxlen, char ch, const Arg& a_arg, int min, int max, int flags, int cflags);
 static int fmtstr(char *buffer, size_t *currlen, size_t maxlen, const char *value, int flags, int min, int max);
 
 static int fmtint(char *buffer, size_t *currlen, size_t maxlen, long value, int base, int min, int max, int flags);
 static int fmtint_64(char *buffer, size_t *currlen, size_t maxlen, fsInt64 a_value, int base, int min, int max, int flags);
+#if FS_HAS_INT128
+static int fmtint_128(char *buffer, size_t *currlen, size_t maxlen, fsInt128 a_value, int base, int min, int max, int flags);
+#endif // FS_HAS_INT128
+static int fmtint_out(char *buffer, size_t *currlen, size_t maxlen, char signvalue, const char *convert, int place,
+                      int forwardLength, bool measureOnly, int min, int max, int flags);
 
 static int fmtfp(char *buffer, size_t *currlen, size_t maxlen, LDOUBLE fvalue, int min, int max, int flags, bool a_checkFPException = false, bool a_allowTrailingZeros = true);
 static int fmtfp_gen(char *buffer, size_t *currlen, size_t maxlen, LDOUBLE fvalue, int min, int max, int flags, bool a_checkFPException = true);
@@ -104,10 +121,18 @@ static int fmtfp64(char *buffer, size_t *currlen, size_t maxlen, LDOUBLE fvalue,
 static int fmtfp64_gen(char *buffer, size_t *currlen, size_t maxlen, LDOUBLE fvalue, int min, int max, int flags, bool a_checkFPException = true);
 static int fmtfp64_exp(char *buffer, size_t *currlen, size_t maxlen, LDOUBLE fvalue, int min, int max, int flags, bool a_checkFPException = true);
 
+static int fmtfp32(char *buffer, size_t *currlen, size_t maxlen, fsFloat32 fvalue, int min, int max, int flags);
+static int fmtfp32_gen(char *buffer, size_t *currlen, size_t maxlen, fsFloat32 fvalue, int min, int flags);
+static int fmtfp_hex(char *buffer, size_t *currlen, size_t maxlen, fsFloat64 fvalue, int min, int max, int flags);
+static int fmtdec(char *buffer, size_t *currlen, size_t maxlen, fsInt64 units, int scale, int min, int max, int flags);
+
 static int dopr_outch(char *buffer, size_t *currlen, size_t maxlen, char c );
+static int dopr_outstr(char *buffer, size_t *currlen, size_t maxlen, const char *str, size_t len);
+static void dopr_terminate(char *buffer, size_t currlen, size_t maxlen);
 
 static int isfpexception(LDOUBLE fvalue);
 static int fmtfp_exception(char *buffer, size_t *currlen, size_t maxlen, LDOUBLE fvalue, int min, int max, int flags);
+static char* fmt_dec_fast(char* a_end, fsInt64 a_value);
 
 
 //
@@ -134,10 +159,20 @@ static int fmtfp_exception(char *buffer, size_t *currlen, size_t maxlen, LDOUBLE
 #define DP_F_UNSIGNED (1 << 6)                    // Numeric parameter value is unsigned
 #define DP_F_SEPARATORS (1 << 7)                  // EXTENSION: decimal separators (eg. 23,456.34)
 
-// Conversion Flags 
-#define DP_C_SHORT   1
-#define DP_C_LONG    2
-#define DP_C_LDOUBLE 3
+// Conversion Flags, the length modifier
+#define DP_C_SHORT   1                            // h
+#define DP_C_LONG    2                            // l
+#define DP_C_LDOUBLE 3                            // L
+#define DP_C_CHAR    4                            // hh
+#define DP_C_LLONG   5                            // ll
+#define DP_C_SIZE    6                            // z
+#define DP_C_INTMAX  7                            // j
+#define DP_C_PTRDIFF 8                            // t
+
+// Positional argument, "%N$" or "*N$"
+#define DP_P_NONE     (-1)                        // Sequential, the next argument
+#define DP_P_INVALID  (-2)                        // "0$" or beyond DP_P_MAX
+#define DP_P_MAX      0x7FFF                      // Highest position, FormatField indices are 16bit
 
 #define char_to_int(p) (p - '0')
 #define MAX(p,q) ((p >= q) ? p : q)
@@ -147,21 +182,17 @@ static int fmtfp_exception(char *buffer, size_t *currlen, size_t maxlen, LDOUBLE
 static int dopr(char *buffer, size_t maxlen, const char *format, ArgList& a_argList) //va_list args)
 {
   char ch;
-#if !UDFS_USE_64BIT
-  long ivalue;
-#endif
-#if !UDFS_USE_MOREFLOAT
-  LDOUBLE fvalue;
-#endif
   int min;
   int max;
   int state;
   int flags;
   int cflags;
+  int position;
   int total;
   size_t currlen;
 
   state = DP_S_DEFAULT;
+  position = DP_P_NONE;
   currlen = flags = cflags = min = 0;
   max = -1;
   ch = *format++;
@@ -176,9 +207,16 @@ static int dopr(char *buffer, size_t maxlen, const char *format, ArgList& a_argL
     {
     case DP_S_DEFAULT:
       if (ch == '%') 
+      {
         state = DP_S_FLAGS;
-      else 
-        total += dopr_outch (buffer, &currlen, maxlen, ch);
+        position = parse_position(&format);
+      }
+      else // Literal run, output up to the next '%' at once
+      {
+        const char *literalEnd = CharScan::Find(format, '%');
+        total += dopr_outstr(buffer, &currlen, maxlen, format - 1, literalEnd - (format - 1));
+        format = literalEnd;
+      }
       ch = *format++;
       break;
     case DP_S_FLAGS:
@@ -222,7 +260,8 @@ static int dopr(char *buffer, size_t maxlen, const char *format, ArgList& a_argL
       } 
       else if (ch == '*') 
       {
-        min = a_argList.GetNext().m_valueInt32; //va_arg (args, int);
+        int widthPosition = parse_position(&format);
+        min = ((widthPosition != DP_P_NONE) ? a_argList.GetAt(widthPosition) : a_argList.GetNext()).m_valueInt32; //va_arg (args, int);
         ch = *format++;
         state = DP_S_DOT;
       } 
@@ -248,7 +287,8 @@ static int dopr(char *buffer, size_t maxlen, const char *format, ArgList& a_argL
       } 
       else if (ch == '*') 
       {
-        max = a_argList.GetNext().m_valueInt32; //va_arg (args, int);
+        int precisionPosition = parse_position(&format);
+        max = ((precisionPosition != DP_P_NONE) ? a_argList.GetAt(precisionPosition) : a_argList.GetNext()).m_valueInt32; //va_arg (args, int);
         ch = *format++;
         state = DP_S_MOD;
       } 
@@ -256,228 +296,397 @@ static int dopr(char *buffer, size_t maxlen, const char *format, ArgList& a_argL
         state = DP_S_MOD;
       break;
     case DP_S_MOD:
-      // Currently, we don't support Long Long, bummer 
-      switch (ch) 
       {
-      case 'h':
-        cflags = DP_C_SHORT;
-        ch = *format++;
-        break;
-      case 'l':
-        cflags = DP_C_LONG;
-        ch = *format++;
-        break;
-      case 'L':
-        cflags = DP_C_LDOUBLE;
+        const char* modifier = format - 1; // At ch
+        cflags = parse_modifier(&modifier);
+        format = modifier;
         ch = *format++;
-        break;
-      default:
-        break;
       }
       state = DP_S_CONV;
       break;
     case DP_S_CONV:
-      switch (ch) 
-      {
-      case 'd':
-      case 'i':
+      if (ch == '%')
+        total += dopr_outch(buffer, &currlen, maxlen, ch);
+      else if (ch == 'w')
+        ch = *format++; // not supported yet, treat as next char 
+      else if (is_conversion(ch))
+        total += fmt_conversion(buffer, &currlen, maxlen, ch, (position != DP_P_NONE) ? a_argList.GetAt(position) : a_argList.GetNext(), min, max, flags, cflags);
+      // else Unknown, skip 
+      ch = *format++;
+      state = DP_S_DEFAULT;
+      flags = cflags = min = 0;
+      max = -1;
+      position = DP_P_NONE;
+      break;
+    case DP_S_DONE:
+      break;
+    default:
+      // hmm? 
+      break; // some picky compilers need this 
+    }
+  }
+  dopr_terminate(buffer, currlen, maxlen);
+  return total;
+}
+
+// Parse a POSIX argument position ("N$", 1 based) at *a_pos and step past it. Returns the zero based argument index,
+// DP_P_NONE if there is none (*a_pos is unchanged) or DP_P_INVALID for "0$" and positions beyond DP_P_MAX.
+static int parse_position(const char** a_pos)
+{
+  const char* pos = *a_pos;
+  int position = 0;
+  while (isdigit(*pos))
+  {
+    if (position <= DP_P_MAX)
+      position = 10 * position + char_to_int(*pos);
+    ++pos;
+  }
+  if ((*pos != '$') || (pos == *a_pos))
+    return DP_P_NONE;
+  *a_pos = pos + 1;
+  return ((position < 1) || (position > DP_P_MAX)) ? DP_P_INVALID : position - 1;
+}
+
+// Parse a length modifier (hh, h, l, ll, L, j, z or t) at *a_pos and step past it. Returns the DP_C_ flag, 0 if none.
+static int parse_modifier(const char** a_pos)
+{
+  const char* pos = *a_pos;
+  int cflags = 0;
+  switch (*pos)
+  {
+  case 'h': cflags = (pos[1] == 'h') ? DP_C_CHAR : DP_C_SHORT; break;
+  case 'l': cflags = (pos[1] == 'l') ? DP_C_LLONG : DP_C_LONG; break;
+  case 'L': cflags = DP_C_LDOUBLE; break;
+  case 'j': cflags = DP_C_INTMAX; break;
+  case 'z': cflags = DP_C_SIZE; break;
+  case 't': cflags = DP_C_PTRDIFF; break;
+  default: return 0;
+  }
+  *a_pos = pos + (((cflags == DP_C_CHAR) || (cflags == DP_C_LLONG)) ? 2 : 1);
+  return cflags;
+}
+
+// Bytes of the integer type a length modifier selects, 0 if the argument keeps its own size
+static int modifier_bytes(int a_cflags)
+{
+  switch (a_cflags)
+  {
+  case DP_C_CHAR:     return 1;
+  case DP_C_SHORT:    return 2;
+  case DP_C_LONG:     return (int)sizeof(long);
+  case DP_C_LLONG:
+  case DP_C_LDOUBLE:                              // As ll for integers, like glibc
+  case DP_C_INTMAX:   return 8;
+  case DP_C_SIZE:     return (int)sizeof(size_t);
+  case DP_C_PTRDIFF:  return (int)sizeof(ptrdiff_t);
+  default:            return 0;
+  }
+}
+
+// Size of an integer argument's own type, 8 for others (converted in full)
+static int arg_bytes(const Arg& a_arg)
+{
+  switch (a_arg.m_type)
+  {
+  case Arg::ARG_TYPE_CHAR:
+  case Arg::ARG_TYPE_INT8:
+  case Arg::ARG_TYPE_UINT8:   return 1;
+  case Arg::ARG_TYPE_INT16:
+  case Arg::ARG_TYPE_UINT16:  return 2;
+  case Arg::ARG_TYPE_INT32:
+  case Arg::ARG_TYPE_UINT32:  return 4;
+  default:                    return 8;
+  }
+}
+
+// Integer argument as the type of its length modifier, eg. "%hhd" of 200 is -56 and "%hu" of -1 is 65535.
+// Without a modifier the argument keeps its own type, eg. "%x" of fsInt32 -1 is ffffffff.
+// Values of at most 32bits then convert with 32bit divisions.
+static fsInt64 modifier_value(const Arg& a_arg, int a_cflags, bool a_signed)
+{
+  fsInt64 value = a_arg.AsInt64();
+  int bytes = modifier_bytes(a_cflags);
+  if( bytes == 0 )
+  {
+    if( a_signed )
+    {
+      return value; // Already sign or zero extended from its own type
+    }
+    bytes = arg_bytes(a_arg);
+  }
+  switch (bytes)
+  {
+  case 1:   return a_signed ? (fsInt64)(fsInt8)value : (fsInt64)(fsUInt8)value;
+  case 2:   return a_signed ? (fsInt64)(fsInt16)value : (fsInt64)(fsUInt16)value;
+  case 4:   return a_signed ? (fsInt64)(fsInt32)value : (fsInt64)(fsUInt32)value;
+  default:  return value;
+  }
+}
+
+// Is ch a conversion type character which consumes an argument
+static bool is_conversion(char ch)
+{
+  switch (ch)
+  {
+  case 'd': case 'i': case 'o': case 'u': case 'x': case 'X': case 'b': case 'B':
+  case 'f': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A':
+  case 'c': case 's': case 'p':
+    return true;
+  default:
+    return false;
+  }
+}
+
+// Convert one argument, ch is the conversion type character
+static int fmt_conversion(char *buffer, size_t *currlen, size_t maxlen, char ch, const Arg& a_arg, int min, int max, int flags, int cflags)
+{
+#if !UDFS_USE_64BIT
+  long ivalue;
+#endif
+#if !UDFS_USE_MOREFLOAT
+  LDOUBLE fvalue;
+#endif
+  int total = 0;
+
+#if FS_HAS_INT128
+  if (a_arg.Is128Bit() && !modifier_bytes(cflags)) // 128bit integers keep full width for integer conversions, unless a length modifier narrows them
+  {
+    int base = 0;
+    switch (ch)
+    {
+    case 'd': case 'i': base = 10; break;
+    case 'u': base = 10; flags |= DP_F_UNSIGNED; break;
+    case 'o': base = 8; flags |= DP_F_UNSIGNED; break;
+    case 'X': case 'B': flags |= DP_F_UP; // Fall through
+    case 'x': case 'b': base = (ch == 'x' || ch == 'X') ? 16 : 2; flags |= DP_F_UNSIGNED; break;
+    default: break;
+    }
+    if (base)
+    {
+      if (a_arg.m_type == Arg::ARG_TYPE_UINT128)
+        flags |= DP_F_UNSIGNED;
+      return fmtint_128(buffer, currlen, maxlen, a_arg.AsInt128(), base, min, max, flags);
+    }
+  }
+#endif // FS_HAS_INT128
+
+  switch (ch) 
+  {
+  case 'd':
+  case 'i':
 #if UDFS_USE_64BIT //GD Just use maximum precision for type
-        total += fmtint_64(buffer, &currlen, maxlen, a_argList.GetNext().AsInt64(), 10, min, max, flags);
+    total += fmtint_64(buffer, currlen, maxlen, modifier_value(a_arg, cflags, true), 10, min, max, flags);
 #else
-        if (cflags == DP_C_SHORT) 
-          ivalue = a_argList.GetNext().m_valueInt16; //va_arg (args, short int);
-        else if (cflags == DP_C_LONG)
-          ivalue = a_argList.GetNext().m_valueInt32; //va_arg (args, long int);
-        else
-          ivalue = a_argList.GetNext().m_valueInt32; //va_arg (args, int);
-        total += fmtint(buffer, &currlen, maxlen, ivalue, 10, min, max, flags);
+    if (cflags == DP_C_SHORT) 
+      ivalue = a_arg.m_valueInt16; //va_arg (args, short int);
+    else if (cflags == DP_C_LONG)
+      ivalue = a_arg.m_valueInt32; //va_arg (args, long int);
+    else
+      ivalue = a_arg.m_valueInt32; //va_arg (args, int);
+    total += fmtint(buffer, currlen, maxlen, ivalue, 10, min, max, flags);
 #endif
-        break;
-      case 'o':
-        flags |= DP_F_UNSIGNED;
+    break;
+  case 'o':
+    flags |= DP_F_UNSIGNED;
 #if UDFS_USE_64BIT //GD Just use maximum precision for type
-        total += fmtint_64(buffer, &currlen, maxlen, a_argList.GetNext().AsInt64(), 8, min, max, flags);
+    total += fmtint_64(buffer, currlen, maxlen, modifier_value(a_arg, cflags, false), 8, min, max, flags);
 #else
-        if (cflags == DP_C_SHORT)
-          ivalue = a_argList.GetNext().m_valueUInt16; //va_arg (args, unsigned short int);
-        else if (cflags == DP_C_LONG)
-          ivalue = a_argList.GetNext().m_valueUInt32; //va_arg (args, unsigned long int);
-        else
-          ivalue = a_argList.GetNext().m_valueUInt32; //va_arg (args, unsigned int);
-        total += fmtint(buffer, &currlen, maxlen, ivalue, 8, min, max, flags);
+    if (cflags == DP_C_SHORT)
+      ivalue = a_arg.m_valueUInt16; //va_arg (args, unsigned short int);
+    else if (cflags == DP_C_LONG)
+      ivalue = a_arg.m_valueUInt32; //va_arg (args, unsigned long int);
+    else
+      ivalue = a_arg.m_valueUInt32; //va_arg (args, unsigned int);
+    total += fmtint(buffer, currlen, maxlen, ivalue, 8, min, max, flags);
 #endif
-        break;
-      case 'u':
-        flags |= DP_F_UNSIGNED;
+    break;
+  case 'u':
+    flags |= DP_F_UNSIGNED;
 #if UDFS_USE_64BIT //GD Just use maximum precision for type
-        total += fmtint_64(buffer, &currlen, maxlen, a_argList.GetNext().AsInt64(), 10, min, max, flags);
+    total += fmtint_64(buffer, currlen, maxlen, modifier_value(a_arg, cflags, false), 10, min, max, flags);
 #else
-        if (cflags == DP_C_SHORT)
-          ivalue = a_argList.GetNext().m_valueUInt16; //va_arg (args, unsigned short int);
-        else if (cflags == DP_C_LONG)
-          ivalue = a_argList.GetNext().m_valueUInt32; //va_arg (args, unsigned long int);
-        else
-          ivalue = a_argList.GetNext().m_valueUInt32; //va_arg (args, unsigned int);
-        total += fmtint(buffer, &currlen, maxlen, ivalue, 10, min, max, flags);
+    if (cflags == DP_C_SHORT)
+      ivalue = a_arg.m_valueUInt16; //va_arg (args, unsigned short int);
+    else if (cflags == DP_C_LONG)
+      ivalue = a_arg.m_valueUInt32; //va_arg (args, unsigned long int);
+    else
+      ivalue = a_arg.m_valueUInt32; //va_arg (args, unsigned int);
+    total += fmtint(buffer, currlen, maxlen, ivalue, 10, min, max, flags);
 #endif
-        break;
-      case 'X':
-        flags |= DP_F_UP;
-      case 'x':
-        flags |= DP_F_UNSIGNED;
+    break;
+  case 'X':
+    flags |= DP_F_UP;
+  case 'x':
+    flags |= DP_F_UNSIGNED;
 #if UDFS_USE_64BIT //GD Just use maximum precision for type
-        total += fmtint_64(buffer, &currlen, maxlen, a_argList.GetNext().AsInt64(), 16, min, max, flags);
+    total += fmtint_64(buffer, currlen, maxlen, modifier_value(a_arg, cflags, false), 16, min, max, flags);
 #else
-        if (cflags == DP_C_SHORT)
-          ivalue = a_argList.GetNext().m_valueUInt16; //va_arg (args, unsigned short int);
-        else if (cflags == DP_C_LONG)
-          ivalue = a_argList.GetNext().m_valueUInt32;//va_arg (args, unsigned long int);
-        else
-          ivalue = a_argList.GetNext().m_valueUInt32; //va_arg (args, unsigned int);
-        total += fmtint(buffer, &currlen, maxlen, ivalue, 16, min, max, flags);
+    if (cflags == DP_C_SHORT)
+      ivalue = a_arg.m_valueUInt16; //va_arg (args, unsigned short int);
+    else if (cflags == DP_C_LONG)
+      ivalue = a_arg.m_valueUInt32;//va_arg (args, unsigned long int);
+    else
+      ivalue = a_arg.m_valueUInt32; //va_arg (args, unsigned int);
+    total += fmtint(buffer, currlen, maxlen, ivalue, 16, min, max, flags);
 #endif
-        break;
-      case 'f':
+    break;
+  case 'B':
+  case 'b': // Binary, extension
+    flags |= DP_F_UNSIGNED;
+#if UDFS_USE_64BIT //GD Just use maximum precision for type
+    total += fmtint_64(buffer, currlen, maxlen, modifier_value(a_arg, cflags, false), 2, min, max, flags);
+#else
+    if (cflags == DP_C_SHORT)
+      ivalue = a_arg.m_valueUInt16; //va_arg (args, unsigned short int);
+    else
+      ivalue = a_arg.m_valueUInt32; //va_arg (args, unsigned int);
+    total += fmtint(buffer, currlen, maxlen, ivalue, 2, min, max, flags);
+#endif
+    break;
+  case 'f':
 #if UDFS_USE_MOREFLOAT //GD Just use maximum precision for type 
-        {
-          fsFloat64 fValue = a_argList.GetNext().AsFloat64();
-          if( isfpexception(fValue) )
-          {
-            total += fmtfp_exception(buffer, &currlen, maxlen, fValue, min, max, flags | DP_F_UP); // Note, using upper case as default for float exception format
-          }
-          else
-          {
-            total += fmtfp64(buffer, &currlen, maxlen, fValue, min, max, flags);
-          }
-        }
+    {
+      fsFloat64 fValue = a_arg.AsFloat64();
+      if( a_arg.IsDecimal() ) // Fixed point decimal digits, exact
+      {
+        total += fmtdec(buffer, currlen, maxlen, a_arg.m_valueDecimal64.m_units, a_arg.m_valueDecimal64.m_scale, min, max, flags);
+      }
+      else if( isfpexception(fValue) )
+      {
+        total += fmtfp_exception(buffer, currlen, maxlen, fValue, min, max, flags | DP_F_UP); // Note, using upper case as default for float exception format
+      }
+      else if( a_arg.m_type == Arg::ARG_TYPE_FLOAT32 ) // Float32 digits, not promoted
+      {
+        total += fmtfp32(buffer, currlen, maxlen, a_arg.m_valueFloat32, min, max, flags);
+      }
+      else
+      {
+        total += fmtfp64(buffer, currlen, maxlen, fValue, min, max, flags);
+      }
+    }
 #else
-        if (cflags == DP_C_LDOUBLE)
-          fvalue = a_argList.GetNext().AsFloat64(); //va_arg (args, LDOUBLE);
-        else
-          fvalue = a_argList.GetNext().AsFloat64(); //va_arg (args, double);
-        // um, floating point? 
-        total += fmtfp(buffer, &currlen, maxlen, fvalue, min, max, flags);
+    if (cflags == DP_C_LDOUBLE)
+      fvalue = a_arg.AsFloat64(); //va_arg (args, LDOUBLE);
+    else
+      fvalue = a_arg.AsFloat64(); //va_arg (args, double);
+    // um, floating point? 
+    total += fmtfp(buffer, currlen, maxlen, fvalue, min, max, flags);
 #endif
-        break;
-      case 'E':
-        flags |= DP_F_UP;
-      case 'e':
+    break;
+  case 'E':
+    flags |= DP_F_UP;
+  case 'e':
 #if UDFS_USE_MOREFLOAT //GD Just use maximum precision for type
-          total += fmtfp64_exp(buffer, &currlen, maxlen, a_argList.GetNext().AsFloat64(), min, max, flags);
+      total += fmtfp64_exp(buffer, currlen, maxlen, a_arg.AsFloat64(), min, max, flags);
 #else
-        if (cflags == DP_C_LDOUBLE)
-          fvalue = a_argList.GetNext().AsFloat64(); //va_arg (args, LDOUBLE);
-        else
-          fvalue = a_argList.GetNext().AsFloat64(); //va_arg (args, double);
-        // um, floating point? 
-        total += fmtfp(buffer, &currlen, maxlen, fvalue, min, max, flags);
+    if (cflags == DP_C_LDOUBLE)
+      fvalue = a_arg.AsFloat64(); //va_arg (args, LDOUBLE);
+    else
+      fvalue = a_arg.AsFloat64(); //va_arg (args, double);
+    // um, floating point? 
+    total += fmtfp(buffer, currlen, maxlen, fvalue, min, max, flags);
 #endif
-        break;
-      case 'G':
-        flags |= DP_F_UP;
-      case 'g':
+    break;
+  case 'G':
+    flags |= DP_F_UP;
+  case 'g':
 #if UDFS_USE_MOREFLOAT //GD Just use maximum precision for type
-        {
-          total += fmtfp64_gen(buffer, &currlen, maxlen, a_argList.GetNext().AsFloat64(), min, max, flags); 
-        }
+    if( (a_arg.m_type == Arg::ARG_TYPE_FLOAT32) && (max < 0) && !isfpexception(a_arg.AsFloat64()) ) // Shortest round trip digits
+    {
+      total += fmtfp32_gen(buffer, currlen, maxlen, a_arg.m_valueFloat32, min, flags);
+    }
+    else
+    {
+      total += fmtfp64_gen(buffer, currlen, maxlen, a_arg.AsFloat64(), min, max, flags); 
+    }
 #else
-        if (cflags == DP_C_LDOUBLE)
-          fvalue = a_argList.GetNext().AsFloat64(); //va_arg (args, LDOUBLE);
-        else
-          fvalue = a_argList.GetNext().AsFloat64(); //va_arg (args, double);
-        // um, floating point? 
-        total += fmtfp(buffer, &currlen, maxlen, fvalue, min, max, flags);
+    if (cflags == DP_C_LDOUBLE)
+      fvalue = a_arg.AsFloat64(); //va_arg (args, LDOUBLE);
+    else
+      fvalue = a_arg.AsFloat64(); //va_arg (args, double);
+    // um, floating point? 
+    total += fmtfp(buffer, currlen, maxlen, fvalue, min, max, flags);
 #endif
-        break;
-      case 'c':
-        total += dopr_outch(buffer, &currlen, maxlen, (char)a_argList.GetNext().AsInt32()); //va_arg (args, int));
-        break;
-      case 's':
+    break;
+  case 'A':
+    flags |= DP_F_UP; // Fall through
+  case 'a': // Hexadecimal float, exact
+    {
+      fsFloat64 fValue = a_arg.AsFloat64();
+      if( isfpexception(fValue) )
       {
-        const Arg& curArg = a_argList.GetNext();
-        const char* cstringPtr = curArg.m_valueCString;
-        if( !curArg.IsCString() ) // Check valid string pointer type
-        {
+        total += fmtfp_exception(buffer, currlen, maxlen, fValue, min, max, flags);
+      }
+      else
+      {
+        total += fmtfp_hex(buffer, currlen, maxlen, fValue, min, max, flags);
+      }
+    }
+    break;
+  case 'c':
+    total += dopr_outch(buffer, currlen, maxlen, (char)a_arg.AsInt32()); //va_arg (args, int));
+    break;
+  case 's':
+  {
+    const Arg& curArg = a_arg;
+    const char* cstringPtr = curArg.m_valueCString;
+    if( !curArg.IsCString() ) // Check valid string pointer type
+    {
 #if 0 // MAYBE Be forgiving and output values for known types?
-          if( curArg.IsFloat() )
-          {
-            total += fmtfp64_exp(buffer, &currlen, maxlen, curArg.AsFloat64(), min, max, flags); // Use max precision float
-            break;
-          }
-          else if( curArg.IsInteger() )
-          {
-            total += fmtint_64(buffer, &currlen, maxlen, curArg.AsInt64(), 10, min, max, flags); // Use max precision int
-            break;
-          }
-          else
-#endif // Known value types
-          {
-            // NOTE: If we wanted to be extra smart here we could try to convert integers into strings. Non-integer values would still be errors.
-            cstringPtr = "#err#"; // Insert error tag
-          }
-        }
-        total += fmtstr(buffer, &currlen, maxlen, cstringPtr, flags, min, max);
+      if( curArg.IsFloat() )
+      {
+        total += fmtfp64_exp(buffer, currlen, maxlen, curArg.AsFloat64(), min, max, flags); // Use max precision float
         break;
       }
-      case 'p':
-#if 1 //GD Just use maximum precision for type
-        total += fmtint_64(buffer, &currlen, maxlen, (fsUIntPtr)(const char*)a_argList.GetNext().m_valueConstPtr, 16, min, max, flags);
-#else
-        total += fmtint(buffer, &currlen, maxlen, (long)(const char*)a_argList.GetNext().m_valueConstPtr, 16, min, max, flags);
-#endif
-        break;
-#if 0 // GD I don't think we want to support this... (From help) 'Number of characters successfully written so far to the stream or buffer; this value is stored in the integer whose address is given as the argument'
-      case 'n':
-        if (cflags == DP_C_SHORT) 
-        {
-          short int *num;
-          num = (short int *)a_argList.GetNext().m_valuePtr; //va_arg (args, short int *);
-          *num = currlen;
-        } 
-        else if (cflags == DP_C_LONG) 
-        {
-          long int *num;
-          num = (long int *)a_argList.GetNext().m_valuePtr; //va_arg (args, long int *);
-          *num = currlen;
-        } 
-        else 
-        {
-          int *num;
-          num = (int *)a_argList.GetNext().m_valuePtr; //va_arg (args, int *);
-          *num = currlen;
-        }
-        break;
-#endif
-      case '%':
-        total += dopr_outch(buffer, &currlen, maxlen, ch);
-        break;
-      case 'w':
-        // not supported yet, treat as next char 
-        ch = *format++;
-        break;
-      default:
-        // Unknown, skip 
+      else if( curArg.IsInteger() )
+      {
+        total += fmtint_64(buffer, currlen, maxlen, curArg.AsInt64(), 10, min, max, flags); // Use max precision int
         break;
       }
-      ch = *format++;
-      state = DP_S_DEFAULT;
-      flags = cflags = min = 0;
-      max = -1;
-      break;
-    case DP_S_DONE:
-      break;
-    default:
-      // hmm? 
-      break; // some picky compilers need this 
+      else
+#endif // Known value types
+      {
+        // NOTE: If we wanted to be extra smart here we could try to convert integers into strings. Non-integer values would still be errors.
+        cstringPtr = "#err#"; // Insert error tag
+      }
     }
+    total += fmtstr(buffer, currlen, maxlen, cstringPtr, flags, min, max);
+    break;
   }
-  if (buffer != NULL)
-  {
-    if (currlen < maxlen - 1) 
-      buffer[currlen] = '\0';
+  case 'p':
+#if 1 //GD Just use maximum precision for type
+    total += fmtint_64(buffer, currlen, maxlen, (fsUIntPtr)(const char*)a_arg.m_valueConstPtr, 16, min, max, flags);
+#else
+    total += fmtint(buffer, currlen, maxlen, (long)(const char*)a_arg.m_valueConstPtr, 16, min, max, flags);
+#endif
+    break;
+#if 0 // GD I don't think we want to support this... (From help) 'Number of characters successfully written so far to the stream or buffer; this value is stored in the integer whose address is given as the argument'
+  case 'n':
+    if (cflags == DP_C_SHORT) 
+    {
+      short int *num;
+      num = (short int *)a_arg.m_valuePtr; //va_arg (args, short int *);
+      *num = *currlen;
+    } 
+    else if (cflags == DP_C_LONG) 
+    {
+      long int *num;
+      num = (long int *)a_arg.m_valuePtr; //va_arg (args, long int *);
+      *num = *currlen;
+    } 
     else 
-      buffer[maxlen - 1] = '\0';
+    {
+      int *num;
+      num = (int *)a_arg.m_valuePtr; //va_arg (args, int *);
+      *num = *currlen;
+    }
+    break;
+#endif
+  default:
+    // Unknown, skip 
+    break;
   }
+
   return total;
 }
 
@@ -485,6 +694,7 @@ static int fmtstr(char *buffer, size_t *currlen, size_t maxlen,
                   const char *value, int flags, int min, int max)
 {
   int padlen, strln;     // amount to pad 
+  int numBytes;          // chars of value output
   int cnt = 0;
   int total = 0;
   
@@ -493,21 +703,31 @@ static int fmtstr(char *buffer, size_t *currlen, size_t maxlen,
     value = "<NULL>";
   }
 
+#if FS_UTF8_MODE
+  size_t numUnits; // Width and precision count code points (or columns), never split a code point
+  numBytes = (int)Utf8::Prefix(value, strlen(value), max, FS_UTF8_MODE, &numUnits);
+  strln = (int)numUnits;
+#else // FS_UTF8_MODE
   for (strln = 0; value[strln]; ++strln); // strlen
   if (max >= 0 && max < strln)
     strln = max;
+  numBytes = strln;
+#endif // FS_UTF8_MODE
   padlen = min - strln;
   if (padlen < 0) 
     padlen = 0;
   if (flags & DP_F_MINUS) 
     padlen = -padlen; // Left Justify
 
+  if (*currlen + 1 >= maxlen) // Measuring or full, nothing more can be written
+    return numBytes + ((padlen < 0) ? -padlen : padlen);
+
   while (padlen > 0)
   {
     total += dopr_outch(buffer, currlen, maxlen, ' ');
     --padlen;
   }
-  while (*value && ((max < 0) || (cnt < max)))
+  while (cnt < numBytes)
   {
     total += dopr_outch(buffer, currlen, maxlen, *value++);
     ++cnt;
@@ -520,6 +740,30 @@ static int fmtstr(char *buffer, size_t *currlen, size_t maxlen,
   return total;
 }
 
+// Number of digits of a_value in a_base, without converting
+static int count_digits(fsUInt64 a_value, int a_base)
+{
+  int digits = 1;
+  if (a_base == 10)
+  {
+    fsUInt64 power = 10;
+    while ((digits < 20) && (a_value >= power)) // Compare with powers of ten rather than divide
+    {
+      ++digits;
+      power *= 10;
+    }
+  }
+  else
+  {
+    while (a_value >= (unsigned)a_base)
+    {
+      a_value /= (unsigned)a_base;
+      ++digits;
+    }
+  }
+  return digits;
+}
+
 // Have to handle DP_F_NUM (ie 0x and 0 alternates) 
 
 static int fmtint_64(char *buffer, size_t *currlen, size_t maxlen,
@@ -530,10 +774,7 @@ static int fmtint_64(char *buffer, size_t *currlen, size_t maxlen,
   const int MAX_CONVERT_CHARS = 64;
   char convert[MAX_CONVERT_CHARS];
   int place = 0;
-  int spadlen = 0; // amount to space pad 
-  int zpadlen = 0; // amount to zero pad 
   int caps = 0;
-  int total = 0;
 
   if (max < 0)
     max = 0;
@@ -557,25 +798,102 @@ static int fmtint_64(char *buffer, size_t *currlen, size_t maxlen,
 
   if (flags & DP_F_UP) caps = 1; // Should characters be upper case? 
 
-  int digitIndex = 0;
-  do 
+  bool measureOnly = (*currlen + 1 >= maxlen); // Measuring or full, only the length is needed
+  bool grouped = (flags & DP_F_SEPARATORS) && (base == 10);
+  int bitsPerDigit = (base == 16) ? 4 : (base == 8) ? 3 : (base == 2) ? 1 : 0; // Power of two bases shift and mask
+  bool forward = grouped || (bitsPerDigit > 0);
+  int forwardLength = 0; // Bytes of digits written forward into convert, otherwise convert is reversed
+  if (grouped) // Number format, thousands groups from the number format profile
+  {
+    if (measureOnly)
+      forwardLength = (int)NumberFormat::GroupedLength(uvalue, NumberFormat::GetProfile(), &place);
+    else
+      forwardLength = (int)NumberFormat::WriteGrouped(convert, uvalue, NumberFormat::GetProfile(), &place);
+  }
+  else if (bitsPerDigit > 0)
+  {
+    if (measureOnly)
+      place = NumberFormat::Pow2Length(uvalue, bitsPerDigit);
+    else
+      place = NumberFormat::WritePow2(convert, uvalue, bitsPerDigit, caps != 0);
+    forwardLength = place;
+  }
+  else if (measureOnly)
+  {
+    place = count_digits(uvalue, base);
+  }
+  else if (base == 10) // Two digits per division, 32bit once the value fits (see NumberFormat::WriteDecimal())
+  {
+    place = forwardLength = NumberFormat::WriteDecimal(convert, uvalue);
+    forward = true;
+  }
+  else
   {
-    convert[place++] =
-      (caps? "0123456789ABCDEF":"0123456789abcdef")
-      [uvalue % (unsigned)base  ];
-    uvalue = (uvalue / (unsigned)base );
+    do 
+    {
+      convert[place++] =
+        (caps? "0123456789ABCDEF":"0123456789abcdef")
+        [uvalue % (unsigned)base  ];
+      uvalue = (uvalue / (unsigned)base );
+    } while(uvalue && (place < MAX_CONVERT_CHARS));
+    if (place == MAX_CONVERT_CHARS) place--;
+    convert[place] = 0;
+  }
+
+  return fmtint_out(buffer, currlen, maxlen, signvalue, convert, place, forward ? forwardLength : 0, measureOnly, min, max, flags);
+}
 
-    if( (flags & DP_F_SEPARATORS) && (base == 10) && (uvalue > 0) ) // Number format
+#if FS_HAS_INT128
+
+// 128bit integer, decimal is converted in 19 digit chunks
+static int fmtint_128(char *buffer, size_t *currlen, size_t maxlen,
+                      fsInt128 a_value, int base, int min, int max, int flags)
+{
+  char signvalue = 0;
+  fsUInt128 uvalue = (fsUInt128)a_value;
+  char convert[NumberFormat::MAX_CONVERT_CHARS_128];
+  int place = 0;
+  int forwardLength = 0;
+
+  if (max < 0)
+    max = 0;
+
+  if(!(flags & DP_F_UNSIGNED))
+  {
+    if( a_value < 0 ) 
     {
-      ++digitIndex;
-      if( (digitIndex % 3) == 0 ) // Insert comma every 3 places
-      {
-        convert[place++] = ',';
-      }
+      signvalue = '-';
+      uvalue = 0 - uvalue;
     }
-  } while(uvalue && (place < MAX_CONVERT_CHARS));
-  if (place == MAX_CONVERT_CHARS) place--;
-  convert[place] = 0;
+    else
+      if (flags & DP_F_PLUS)  // Do a sign (+/i) 
+        signvalue = '+';
+      else
+        if (flags & DP_F_SPACE)
+          signvalue = ' ';
+  }
+
+  int bitsPerDigit = (base == 16) ? 4 : (base == 8) ? 3 : (base == 2) ? 1 : 0;
+  if ((flags & DP_F_SEPARATORS) && (base == 10)) // Number format, thousands groups from the number format profile
+    forwardLength = (int)NumberFormat::WriteGrouped128(convert, uvalue, NumberFormat::GetProfile(), &place);
+  else if (bitsPerDigit > 0)
+    place = forwardLength = NumberFormat::WritePow2_128(convert, uvalue, bitsPerDigit, (flags & DP_F_UP) != 0);
+  else
+    place = forwardLength = NumberFormat::WriteDecimal128(convert, uvalue);
+
+  return fmtint_out(buffer, currlen, maxlen, signvalue, convert, place, forwardLength, (*currlen + 1 >= maxlen), min, max, flags);
+}
+
+#endif // FS_HAS_INT128
+
+// Pad and output converted integer digits. forwardLength is the bytes of digits in order in convert,
+// or 0 when convert holds place digits in reverse. place is the width of the digits for alignment.
+static int fmtint_out(char *buffer, size_t *currlen, size_t maxlen, char signvalue, const char *convert, int place,
+                      int forwardLength, bool measureOnly, int min, int max, int flags)
+{
+  int spadlen = 0; // amount to space pad 
+  int zpadlen = 0; // amount to zero pad 
+  int total = 0;
 
   zpadlen = max - place;
   spadlen = min - MAX (max, place) - (signvalue ? 1 : 0);
@@ -589,6 +907,9 @@ static int fmtint_64(char *buffer, size_t *currlen, size_t maxlen,
   if (flags & DP_F_MINUS) 
     spadlen = -spadlen; // Left Justify 
 
+  if (measureOnly)
+    return ((spadlen < 0) ? -spadlen : spadlen) + (signvalue ? 1 : 0) + zpadlen + (forwardLength ? forwardLength : place);
+
 #ifdef DEBUG_SNPRINTF
   dprint (1, (debugfile, "zpad: %d, spad: %d, min: %d, max: %d, place: %d\n", zpadlen, spadlen, min, max, place));
 #endif
@@ -615,8 +936,11 @@ static int fmtint_64(char *buffer, size_t *currlen, size_t maxlen,
   }
 
   // Digits 
-  while (place > 0) 
-    total += dopr_outch(buffer, currlen, maxlen, convert[--place]);
+  if (forwardLength)
+    total += dopr_outstr(buffer, currlen, maxlen, convert, forwardLength);
+  else
+    while (place > 0) 
+      total += dopr_outch(buffer, currlen, maxlen, convert[--place]);
 
   // Left Justified spaces 
   while (spadlen < 0) 
@@ -663,25 +987,30 @@ static int fmtint(char *buffer, size_t *currlen, size_t maxlen,
 
   if (flags & DP_F_UP) caps = 1; // Should characters be upper case? 
 
-  int digitIndex = 0;
-  do 
+  bool grouped = (flags & DP_F_SEPARATORS) && (base == 10);
+  int bitsPerDigit = (base == 16) ? 4 : (base == 8) ? 3 : (base == 2) ? 1 : 0; // Power of two bases shift and mask
+  bool forward = grouped || (bitsPerDigit > 0);
+  int forwardLength = 0; // Bytes of digits written forward into convert, otherwise convert is reversed
+  if (grouped) // Number format, thousands groups from the number format profile
   {
-    convert[place++] =
-      (caps? "0123456789ABCDEF":"0123456789abcdef")
-      [uvalue % (unsigned)base  ];
-    uvalue = (uvalue / (unsigned)base );
-
-    if( (flags & DP_F_SEPARATORS) && (base == 10) && (uvalue > 0) ) // Number format
+    forwardLength = (int)NumberFormat::WriteGrouped(convert, uvalue, NumberFormat::GetProfile(), &place);
+  }
+  else if (bitsPerDigit > 0)
+  {
+    place = forwardLength = NumberFormat::WritePow2(convert, uvalue, bitsPerDigit, caps != 0);
+  }
+  else
+  {
+    do 
     {
-      ++digitIndex;
-      if( (digitIndex % 3) == 0 ) // Insert comma every 3 places
-      {
-        convert[place++] = ',';
-      }
-    }
-  } while(uvalue && (place < MAX_CONVERT_CHARS));
-  if (place == MAX_CONVERT_CHARS) place--;
-  convert[place] = 0;
+      convert[place++] =
+        (caps? "0123456789ABCDEF":"0123456789abcdef")
+        [uvalue % (unsigned)base  ];
+      uvalue = (uvalue / (unsigned)base );
+    } while(uvalue && (place < MAX_CONVERT_CHARS));
+    if (place == MAX_CONVERT_CHARS) place--;
+    convert[place] = 0;
+  }
 
   zpadlen = max - place;
   spadlen = min - MAX (max, place) - (signvalue ? 1 : 0);
@@ -721,8 +1050,11 @@ static int fmtint(char *buffer, size_t *currlen, size_t maxlen,
   }
 
   // Digits 
-  while (place > 0) 
-    total += dopr_outch(buffer, currlen, maxlen, convert[--place]);
+  if (forward)
+    total += dopr_outstr(buffer, currlen, maxlen, convert, forwardLength);
+  else
+    while (place > 0) 
+      total += dopr_outch(buffer, currlen, maxlen, convert[--place]);
 
   // Left Justified spaces 
   while (spadlen < 0) 
@@ -992,25 +1324,24 @@ static int fmtfp(char *buffer, size_t *currlen, size_t maxlen,
 #endif
 
   // Convert integer part 
-  int digitIndex = 0;
-  do 
+  const NumberFormatProfile& profile = NumberFormat::GetProfile();
+  bool grouped = (flags & DP_F_SEPARATORS) != 0;
+  int groupedLength = 0; // Bytes of grouped digits, written forward into iconvert
+  if (grouped) // Number format, thousands groups from the number format profile
   {
-    iconvert[iplace++] =
-      (caps? "0123456789ABCDEF":"0123456789abcdef")[intpart % 10];
-    intpart = (intpart / 10);
-
-    if( (flags & DP_F_SEPARATORS) && (intpart > 0) ) // Number format
+    groupedLength = (int)NumberFormat::WriteGrouped(iconvert, (fsUInt64)intpart, profile, &iplace);
+  }
+  else
+  {
+    do 
     {
-      ++digitIndex;
-      if( (digitIndex % 3) == 0 ) // Insert comma every 3 places
-      {
-        iconvert[iplace++] = ',';
-      }
-    }
-
-  } while(intpart && (iplace < MAX_CONVERT_CHARS));
-  if (iplace == MAX_CONVERT_CHARS) iplace--;
-  iconvert[iplace] = 0;
+      iconvert[iplace++] =
+        (caps? "0123456789ABCDEF":"0123456789abcdef")[intpart % 10];
+      intpart = (intpart / 10);
+    } while(intpart && (iplace < MAX_CONVERT_CHARS));
+    if (iplace == MAX_CONVERT_CHARS) iplace--;
+    iconvert[iplace] = 0;
+  }
 
   // Convert fractional part 
 #if 1 // Configurable trailing zeros for general numbers
@@ -1042,7 +1373,7 @@ static int fmtfp(char *buffer, size_t *currlen, size_t maxlen,
   //  -1 for decimal point if there are any, another -1 if we are printing a sign 
   padlen = min - iplace - max; 
   if( (max > 0) && (fplace > 0) ) // decimal point
-    { padlen -= 1; }
+    { padlen -= grouped ? profile.m_decimalSeparatorWidth : 1; }
   if( signvalue ) // sign
     { padlen -= 1; }
 
@@ -1083,8 +1414,11 @@ static int fmtfp(char *buffer, size_t *currlen, size_t maxlen,
   if (signvalue) 
     total += dopr_outch(buffer, currlen, maxlen, signvalue);
 
-  while (iplace > 0) 
-    total += dopr_outch(buffer, currlen, maxlen, iconvert[--iplace]);
+  if (grouped)
+    total += dopr_outstr(buffer, currlen, maxlen, iconvert, groupedLength);
+  else
+    while (iplace > 0) 
+      total += dopr_outch(buffer, currlen, maxlen, iconvert[--iplace]);
 
   //
   // Decimal point.  This should probably use locale to find the correct
@@ -1092,7 +1426,10 @@ static int fmtfp(char *buffer, size_t *currlen, size_t maxlen,
   //
   if( (max > 0) && (fplace > 0) )
   {
-    total += dopr_outch(buffer, currlen, maxlen, '.');
+    if (grouped)
+      total += dopr_outstr(buffer, currlen, maxlen, profile.m_decimalSeparator, profile.m_decimalSeparatorLength);
+    else
+      total += dopr_outch(buffer, currlen, maxlen, '.');
 
     while (fplace > 0) 
       total += dopr_outch(buffer, currlen, maxlen, fconvert[--fplace]);
@@ -1252,25 +1589,24 @@ static int fmtfp64(char *buffer, size_t *currlen, size_t maxlen,
 #endif
 
   // Convert integer part 
-  int digitIndex = 0;
-  do 
+  const NumberFormatProfile& profile = NumberFormat::GetProfile();
+  bool grouped = (flags & DP_F_SEPARATORS) != 0;
+  int groupedLength = 0; // Bytes of grouped digits, written forward into iconvert
+  if (grouped) // Number format, thousands groups from the number format profile
   {
-    iconvert[iplace++] =
-      (caps? "0123456789ABCDEF":"0123456789abcdef")[intpart % 10];
-    intpart = (intpart / 10);
-
-    if( (flags & DP_F_SEPARATORS) && (intpart > 0) ) // Number format
+    groupedLength = (int)NumberFormat::WriteGrouped(iconvert, (fsUInt64)intpart, profile, &iplace);
+  }
+  else
+  {
+    do 
     {
-      ++digitIndex;
-      if( (digitIndex % 3) == 0 ) // Insert comma every 3 places
-      {
-        iconvert[iplace++] = ',';
-      }
-    }
-
-  } while(intpart && (iplace < MAX_CONVERT_CHARS));
-  if (iplace == MAX_CONVERT_CHARS) iplace--;
-  iconvert[iplace] = 0;
+      iconvert[iplace++] =
+        (caps? "0123456789ABCDEF":"0123456789abcdef")[intpart % 10];
+      intpart = (intpart / 10);
+    } while(intpart && (iplace < MAX_CONVERT_CHARS));
+    if (iplace == MAX_CONVERT_CHARS) iplace--;
+    iconvert[iplace] = 0;
+  }
 
   // Convert fractional part 
 #if 1 // Configurable trailing zeros for general numbers
@@ -1302,7 +1638,7 @@ static int fmtfp64(char *buffer, size_t *currlen, size_t maxlen,
   //  -1 for decimal point if there are any, another -1 if we are printing a sign
   padlen = min - iplace - max;
   if( (max > 0) && (fplace > 0) ) // decimal point
-    { padlen -= 1; }
+    { padlen -= grouped ? profile.m_decimalSeparatorWidth : 1; }
   if( signvalue ) // sign
     { padlen -= 1; }
 
@@ -1343,8 +1679,11 @@ static int fmtfp64(char *buffer, size_t *currlen, size_t maxlen,
   if (signvalue) 
     total += dopr_outch(buffer, currlen, maxlen, signvalue);
 
-  while (iplace > 0) 
-    total += dopr_outch(buffer, currlen, maxlen, iconvert[--iplace]);
+  if (grouped)
+    total += dopr_outstr(buffer, currlen, maxlen, iconvert, groupedLength);
+  else
+    while (iplace > 0) 
+      total += dopr_outch(buffer, currlen, maxlen, iconvert[--iplace]);
 
   //
   // Decimal point.  This should probably use locale to find the correct
@@ -1352,7 +1691,10 @@ static int fmtfp64(char *buffer, size_t *currlen, size_t maxlen,
   //
   if( (max > 0) && (fplace > 0) )
   {
-    total += dopr_outch(buffer, currlen, maxlen, '.');
+    if (grouped)
+      total += dopr_outstr(buffer, currlen, maxlen, profile.m_decimalSeparator, profile.m_decimalSeparatorLength);
+    else
+      total += dopr_outch(buffer, currlen, maxlen, '.');
 
     while (fplace > 0) 
       total += dopr_outch(buffer, currlen, maxlen, fconvert[--fplace]);
@@ -1374,6 +1716,141 @@ static int fmtfp64(char *buffer, size_t *currlen, size_t maxlen,
 }
 
 
+// Sign, padding and trailing zeros around the unsigned digits of a float32 or fixed point decimal conversion
+static int fmtfp32_out(char *buffer, size_t *currlen, size_t maxlen, bool negative, const char *convert, size_t length,
+                       int width, int zpadlen, int min, int flags)
+{
+  int total = 0;
+  char signvalue = negative ? '-' : (flags & DP_F_PLUS) ? '+' : (flags & DP_F_SPACE) ? ' ' : 0;
+  int padlen = min - width - zpadlen - (signvalue ? 1 : 0);
+  if (padlen < 0)
+    padlen = 0;
+  if (flags & DP_F_MINUS)
+    padlen = -padlen; // Left Justify
+
+  if ((flags & DP_F_ZERO) && (padlen > 0))
+  {
+    if (signvalue)
+    {
+      total += dopr_outch(buffer, currlen, maxlen, signvalue);
+      signvalue = 0;
+    }
+    while (padlen > 0)
+    {
+      total += dopr_outch(buffer, currlen, maxlen, '0');
+      --padlen;
+    }
+  }
+  while (padlen > 0)
+  {
+    total += dopr_outch(buffer, currlen, maxlen, ' ');
+    --padlen;
+  }
+  if (signvalue)
+    total += dopr_outch(buffer, currlen, maxlen, signvalue);
+
+  total += dopr_outstr(buffer, currlen, maxlen, convert, length);
+  while (zpadlen > 0)
+  {
+    total += dopr_outch(buffer, currlen, maxlen, '0');
+    --zpadlen;
+  }
+
+  while (padlen < 0)
+  {
+    total += dopr_outch(buffer, currlen, maxlen, ' ');
+    ++padlen;
+  }
+  return total;
+}
+
+
+// Float32 in fixed point, from its shortest decimal in 32bit arithmetic rather than promoted to double,
+// so no digits past float precision are shown. Finite values only.
+static int fmtfp32(char *buffer, size_t *currlen, size_t maxlen, fsFloat32 fvalue, int min, int max, int flags)
+{
+  if (max < 0)
+    max = 6;
+
+  char convert[NumberFormat::MAX_FLOAT32_FIXED_CHARS];
+  int fractionDigits;
+  int width;
+  const NumberFormatProfile* profile = (flags & DP_F_SEPARATORS) ? &NumberFormat::GetProfile() : NULL;
+  size_t length = NumberFormat::WriteFloat32Fixed(convert, fvalue, max, profile, &fractionDigits, &width);
+  return fmtfp32_out(buffer, currlen, maxlen, fvalue < 0, convert, length, width, max - fractionDigits, min, flags);
+}
+
+
+// Float32 general format with default precision, the shortest decimal that reads back as the same float. Finite values only.
+static int fmtfp32_gen(char *buffer, size_t *currlen, size_t maxlen, fsFloat32 fvalue, int min, int flags)
+{
+  char convert[NumberFormat::MAX_FLOAT32_GENERAL_CHARS];
+  size_t length = NumberFormat::WriteFloat32General(convert, fvalue, (flags & DP_F_UP) != 0);
+  return fmtfp32_out(buffer, currlen, maxlen, fvalue < 0, convert, length, (int)length, 0, min, flags);
+}
+
+
+// Hexadecimal float, as C99 %a: the digits come straight from the IEEE bits. Zero padding goes between the "0x" and the
+// digits, and precision past the float64 mantissa pads fraction zeros before the exponent. Finite values only.
+static int fmtfp_hex(char *buffer, size_t *currlen, size_t maxlen, fsFloat64 fvalue, int min, int max, int flags)
+{
+  char convert[NumberFormat::MAX_HEX_FLOAT64_CHARS];
+  int precision = (max > NumberFormat::HEX_FLOAT64_DIGITS) ? (int)NumberFormat::HEX_FLOAT64_DIGITS : max;
+  size_t length = NumberFormat::WriteHexFloat64(convert, fvalue, precision, (flags & DP_F_UP) != 0);
+  size_t mantissaLength = (const char*)memchr(convert, (flags & DP_F_UP) ? 'P' : 'p', length) - convert;
+  int zpadlen = max - precision;
+  char signvalue = FS_FLOAT64_SIGN_BIT_SET(fvalue) ? '-' : (flags & DP_F_PLUS) ? '+' : (flags & DP_F_SPACE) ? ' ' : 0;
+  int padlen = min - (int)length - zpadlen - (signvalue ? 1 : 0);
+  if (padlen < 0)
+    padlen = 0;
+
+  int total = 0;
+  bool zeroPad = (flags & DP_F_ZERO) && !(flags & DP_F_MINUS);
+  if (!zeroPad && !(flags & DP_F_MINUS))
+  {
+    for (; padlen > 0; --padlen)
+      total += dopr_outch(buffer, currlen, maxlen, ' ');
+  }
+  if (signvalue)
+    total += dopr_outch(buffer, currlen, maxlen, signvalue);
+  total += dopr_outstr(buffer, currlen, maxlen, convert, 2);
+  if (zeroPad)
+  {
+    for (; padlen > 0; --padlen)
+      total += dopr_outch(buffer, currlen, maxlen, '0');
+  }
+  total += dopr_outstr(buffer, currlen, maxlen, convert + 2, mantissaLength - 2);
+  for (; zpadlen > 0; --zpadlen)
+    total += dopr_outch(buffer, currlen, maxlen, '0');
+  total += dopr_outstr(buffer, currlen, maxlen, convert + mantissaLength, length - mantissaLength);
+  for (; padlen > 0; --padlen)
+    total += dopr_outch(buffer, currlen, maxlen, ' ');
+  return total;
+}
+
+
+
+// Fixed point decimal (units * 10^-scale) from its integer digits, exact. Precision defaults to the scale, and digits
+// past the scale are zeros. A negative scale adds zeros to the integer.
+static int fmtdec(char *buffer, size_t *currlen, size_t maxlen, fsInt64 units, int scale, int min, int max, int flags)
+{
+  if (scale > NumberFormat::MAX_DECIMAL64_SCALE)
+    scale = NumberFormat::MAX_DECIMAL64_SCALE;
+  else if (scale < -NumberFormat::MAX_DECIMAL64_SCALE)
+    scale = -NumberFormat::MAX_DECIMAL64_SCALE;
+  if (max < 0)
+    max = (scale > 0) ? scale : 0;
+
+  char convert[NumberFormat::MAX_DECIMAL64_FIXED_CHARS];
+  int fractionDigits;
+  int width;
+  const NumberFormatProfile* profile = (flags & DP_F_SEPARATORS) ? &NumberFormat::GetProfile() : NULL;
+  fsUInt64 magnitude = (units < 0) ? (fsUInt64)0 - (fsUInt64)units : (fsUInt64)units;
+  size_t length = NumberFormat::WriteDecimal64Fixed(convert, magnitude, scale, max, profile, &fractionDigits, &width);
+  return fmtfp32_out(buffer, currlen, maxlen, units < 0, convert, length, width, max - fractionDigits, min, flags);
+}
+
+
 static int dopr_outch(char *buffer, size_t *currlen, size_t maxlen, char c)
 {
   if (*currlen + 1 < maxlen)
@@ -1381,6 +1858,34 @@ static int dopr_outch(char *buffer, size_t *currlen, size_t maxlen, char c)
   return 1;
 }
 
+// Output a run of chars, truncated the same as repeated dopr_outch()
+static int dopr_outstr(char *buffer, size_t *currlen, size_t maxlen, const char *str, size_t len)
+{
+  if (*currlen + len < maxlen)
+  {
+    memcpy(buffer + *currlen, str, len);
+    *currlen += len;
+  }
+  else if (*currlen + 1 < maxlen)
+  {
+    size_t avail = maxlen - 1 - *currlen;
+    memcpy(buffer + *currlen, str, avail);
+    *currlen += avail;
+  }
+  return (int)len;
+}
+
+static void dopr_terminate(char *buffer, size_t currlen, size_t maxlen)
+{
+  if ((buffer != NULL) && (maxlen > 0))
+  {
+    if (currlen < maxlen - 1) 
+      buffer[currlen] = '\0';
+    else 
+      buffer[maxlen - 1] = '\0';
+  }
+}
+
 #if 0 //GD
 
 #ifndef HAVE_VSNPRINTF
@@ -1496,10 +2001,21 @@ int main(void)
 
 #endif
 
-// GD Our wrapper
-fsInt FormatStringF(fsChar* a_str, size_t a_count, const fsChar* a_fmt, ArgList& a_args)
+static fsInt format_compiled_f(fsChar* a_str, size_t a_count, const CompiledFormatView& a_compiled, ArgList& a_args);
+
+
+static fsInt format_string_f(fsChar* a_str, size_t a_count, const fsChar* a_fmt, ArgList& a_args)
 {
-  if( a_str != NULL )
+  if( FormatCache::IsEnabled() )
+  {
+    CompiledFormat compiled;
+    if( FormatCache::Lookup(a_fmt, CompiledFormat::SYNTAX_PRINTF, compiled) )
+    {
+      return format_compiled_f(a_str, a_count, compiled.GetView(), a_args);
+    }
+  }
+
+  if( (a_str != NULL) && (a_count > 0) )
   {
     a_str[0] = 0;
   }
@@ -1508,4 +2024,935 @@ fsInt FormatStringF(fsChar* a_str, size_t a_count, const fsChar* a_fmt, ArgList&
 }
 
 
+// GD Our wrapper
+fsInt FormatStringF(fsChar* a_str, size_t a_count, const fsChar* a_fmt, ArgList& a_args)
+{
+#if FS_RECORDER
+  if( FormatRecorder::IsRecording() )
+  {
+    FormatRecorder::Sample(BinaryLog::SYNTAX_PRINTF, a_fmt, (a_str != NULL) ? a_count : 0, NULL, a_args);
+  }
+#endif // FS_RECORDER
+#if FS_TELEMETRY
+  if( FormatTelemetry::IsEnabled() )
+  {
+    fsUInt64 start = FormatTelemetry::Now();
+    fsInt result = format_string_f(a_str, a_count, a_fmt, a_args);
+    FormatTelemetry::Record(a_fmt, FormatTelemetry::FUNCTION_FORMAT_STRING_F, start, result, (a_str != NULL) && (result >= 0) && ((size_t)result >= a_count), false);
+    return result;
+  }
+#endif // FS_TELEMETRY
+  return format_string_f(a_str, a_count, a_fmt, a_args);
+}
+
+
+fsInt FormatStringFLength(const fsChar* a_fmt, ArgList& a_args)
+{
+  return FormatStringF(NULL, 0, a_fmt, a_args);
+}
+
+
+fsInt FormatStringFLength(const CompiledFormat& a_compiled, ArgList& a_args)
+{
+  return FormatStringF(NULL, 0, a_compiled, a_args);
+}
+
+
+// Bytecode op for a compiled field, see FormatOp. Argument types are only known per call, so the specialized
+// ops guard on the type and fall back to fmt_conversion().
+static fsUInt8 printf_opcode(const FormatField& a_field)
+{
+  if( !a_field.m_conversion )
+  {
+    return FormatOp::OP_LITERAL;
+  }
+  if( (a_field.m_minArgIndex != FormatField::NO_ARG) || (a_field.m_maxArgIndex != FormatField::NO_ARG) )
+  {
+    return FormatOp::OP_GENERIC;
+  }
+  int bytes = modifier_bytes(a_field.m_modifier);
+  fsBool plain = (a_field.m_min == 0) && (a_field.m_max < 0) && (a_field.m_flags == 0) && ((bytes == 0) || (bytes == 8));
+  switch( a_field.m_conversion )
+  {
+    case 'd':
+    case 'i':   return plain ? FormatOp::OP_INT_DEC : FormatOp::OP_GENERIC;
+    case 's':   return plain ? FormatOp::OP_STRING : FormatOp::OP_GENERIC;
+    case 'f':   return FormatOp::OP_FLOAT_FIXED;
+    default:    return FormatOp::OP_GENERIC;
+  }
+}
+
+
+// Argument index of a compiled conversion, width or precision, a_position from parse_position(). Sequential
+// arguments are numbered in order of use. Returns false for an invalid position.
+static fsBool compile_arg_index(int a_position, fsInt* a_numArgs, fsInt* a_numPositional, fsInt* a_maxPosition, fsInt16* a_index)
+{
+  if( a_position == DP_P_INVALID )
+  {
+    return false;
+  }
+  if( a_position == DP_P_NONE )
+  {
+    *a_index = (fsInt16)(*a_numArgs)++;
+    return true;
+  }
+  *a_index = (fsInt16)a_position;
+  ++(*a_numPositional);
+  if( a_position >= *a_maxPosition )
+  {
+    *a_maxPosition = a_position + 1;
+  }
+  return true;
+}
+
+
+// Parse format into literal runs and conversion fields, mirrors the dopr() state machine
+fsBool CompileFormatStringF(const fsChar* a_fmt, CompiledFormat& a_compiled)
+{
+  a_compiled.m_format = NULL;
+  a_compiled.m_syntax = CompiledFormat::SYNTAX_PRINTF;
+  a_compiled.m_numFields = 0;
+  a_compiled.m_numArgs = 0;
+  a_compiled.m_named = false;
+
+  if( a_fmt == NULL )
+  {
+    return false;
+  }
+
+  const fsChar* literal = a_fmt;   // Start of current literal run
+  const fsChar* pos = a_fmt;       // Scan position
+  fsInt numArgs = 0;               // Sequential arguments used
+  fsInt numPositional = 0;         // Positional uses ("%N$", "*N$")
+  fsInt maxPosition = 0;           // Highest argument position + 1
+
+  for(;;)
+  {
+    pos = CharScan::Find(pos, '%');
+
+    if( a_compiled.m_numFields >= CompiledFormat::MAX_FIELDS )
+    {
+      return false; // Format too complex, use FormatStringF() directly
+    }
+    FormatField& field = a_compiled.m_fields[a_compiled.m_numFields];
+    field.m_literalOffset = (fsInt32)(literal - a_fmt);
+    field.m_literalLength = (fsInt32)(pos - literal);
+    field.m_min = 0;
+    field.m_max = -1;
+    field.m_flags = 0;
+    field.m_argIndex = FormatField::NO_ARG;
+    field.m_minArgIndex = FormatField::NO_ARG;
+    field.m_maxArgIndex = FormatField::NO_ARG;
+    field.m_conversion = 0;
+    field.m_modifier = 0;
+
+    if( *pos == '\0' )
+    {
+      if( field.m_literalLength > 0 )
+      {
+        ++a_compiled.m_numFields;
+      }
+      break;
+    }
+    ++pos; // Skip '%'
+
+    // Position
+    int position = parse_position(&pos);
+    if( position == DP_P_INVALID )
+    {
+      return false;
+    }
+
+    // Flags
+    for(;;)
+    {
+      fsChar ch = *pos;
+      if( ch == '-' )       field.m_flags |= DP_F_MINUS;
+      else if( ch == '+' )  field.m_flags |= DP_F_PLUS;
+      else if( ch == ' ' )  field.m_flags |= DP_F_SPACE;
+      else if( ch == '#' )  field.m_flags |= DP_F_NUM;
+      else if( ch == '0' )  field.m_flags |= DP_F_ZERO;
+      else if( (ch == '\'') || (ch == ',') ) field.m_flags |= DP_F_SEPARATORS;
+      else break;
+      ++pos;
+    }
+
+    // Width
+    if( *pos == '*' )
+    {
+      ++pos;
+      int widthPosition = parse_position(&pos);
+      if( !compile_arg_index(widthPosition, &numArgs, &numPositional, &maxPosition, &field.m_minArgIndex) )
+      {
+        return false;
+      }
+    }
+    else
+    {
+      while( isdigit(*pos) )
+      {
+        field.m_min = 10 * field.m_min + char_to_int(*pos);
+        ++pos;
+      }
+    }
+
+    // Precision
+    if( *pos == '.' )
+    {
+      ++pos;
+      if( *pos == '*' )
+      {
+        ++pos;
+        int precisionPosition = parse_position(&pos);
+        if( !compile_arg_index(precisionPosition, &numArgs, &numPositional, &maxPosition, &field.m_maxArgIndex) )
+        {
+          return false;
+        }
+      }
+      else
+      {
+        while( isdigit(*pos) )
+        {
+          if( field.m_max < 0 )
+            field.m_max = 0;
+          field.m_max = 10 * field.m_max + char_to_int(*pos);
+          ++pos;
+        }
+      }
+    }
+
+    // Modifier
+    field.m_modifier = (fsChar)parse_modifier(&pos);
+
+    // Conversion
+    fsChar ch = *pos;
+    if( ch == '\0' )
+    {
+      ++a_compiled.m_numFields; // Incomplete conversion at end, dopr() outputs nothing for it
+      break;
+    }
+    ++pos;
+    if( ch == '%' )
+    {
+      ++a_compiled.m_numFields;
+      literal = pos - 1; // Literal '%' starts the next run
+      continue;
+    }
+    else if( ch == 'w' )
+    {
+      if( *pos ) // Not supported yet, skip next char too
+        ++pos;
+    }
+    else if( is_conversion(ch) )
+    {
+      field.m_conversion = ch;
+      compile_arg_index(position, &numArgs, &numPositional, &maxPosition, &field.m_argIndex);
+    }
+    // else Unknown, skip
+    ++a_compiled.m_numFields;
+    literal = pos;
+  }
+
+  if( (numPositional > 0) && (numArgs > 0) )
+  {
+    return false; // Positional and sequential arguments mixed, the positions could not be relied on
+  }
+
+  fsUInt8 opcodes[CompiledFormat::MAX_FIELDS];
+  for( fsInt fieldIndex = 0; fieldIndex < a_compiled.m_numFields; ++fieldIndex )
+  {
+    opcodes[fieldIndex] = printf_opcode(a_compiled.m_fields[fieldIndex]);
+  }
+  a_compiled.EmitCode(opcodes);
+  a_compiled.m_numArgs = (numPositional > 0) ? maxPosition : numArgs;
+  a_compiled.m_format = a_fmt;
+  return true;
+}
+
+
+// Full conversion of a compiled field, the OP_GENERIC case and the fallback of the specialized ops
+static inline int fmt_field(char* a_buffer, size_t* a_currlen, size_t a_maxlen, const FormatField& a_field, ArgList& a_args)
+{
+  int min = (a_field.m_minArgIndex == FormatField::NO_ARG) ? a_field.m_min : a_args.GetAt(a_field.m_minArgIndex).m_valueInt32;
+  int max = (a_field.m_maxArgIndex == FormatField::NO_ARG) ? a_field.m_max : a_args.GetAt(a_field.m_maxArgIndex).m_valueInt32;
+  return fmt_conversion(a_buffer, a_currlen, a_maxlen, a_field.m_conversion, a_args.GetAt(a_field.m_argIndex), min, max, a_field.m_flags, a_field.m_modifier);
+}
+
+
+// "%d" with no width, precision or flags, as fmtint_64() would output it
+static inline int fmt_int_dec(char* a_buffer, size_t* a_currlen, size_t a_maxlen, fsInt64 a_value)
+{
+  char convert[24];
+  char* end = convert + sizeof(convert);
+  char* start = fmt_dec_fast(end, a_value);
+  return dopr_outstr(a_buffer, a_currlen, a_maxlen, start, end - start);
+}
+
+
+// Run the compiled bytecode, one dispatch per op (see FormatOp)
+static fsInt format_compiled_f(fsChar* a_str, size_t a_count, const CompiledFormatView& a_compiled, ArgList& a_args)
+{
+  if( (a_str != NULL) && (a_count > 0) )
+  {
+    a_str[0] = 0;
+  }
+  FS_ASSERT( a_compiled.IsValid() && (a_compiled.m_syntax == CompiledFormat::SYNTAX_PRINTF) );
+  if( !a_compiled.IsValid() || (a_compiled.m_syntax != CompiledFormat::SYNTAX_PRINTF) )
+  {
+    return 0;
+  }
+
+#if FS_THREADED_DISPATCH
+  static void* const s_labels[FormatOp::NUM_OPCODES] =
+  {
+    &&op_end, &&op_literal, &&op_int_dec, &&op_int_dec_literal, &&op_string, &&op_string_literal, &&op_float_fixed, &&op_generic
+  };
+#endif // FS_THREADED_DISPATCH
+
+  const fsChar* format = a_compiled.m_format;
+  const FormatField* fields = a_compiled.m_fields;
+  const FormatOp* op = a_compiled.m_code;
+  size_t currlen = 0;
+  int total = 0;
+
+  FS_DISPATCH(op)
+  FS_OP(OP_LITERAL, op_literal)
+  {
+    const FormatField& field = fields[op->m_field];
+    total += dopr_outstr(a_str, &currlen, a_count, format + field.m_literalOffset, field.m_literalLength);
+    FS_NEXT(op);
+  }
+  FS_OP(OP_INT_DEC, op_int_dec)
+  {
+    const FormatField& field = fields[op->m_field];
+    total += dopr_outstr(a_str, &currlen, a_count, format + field.m_literalOffset, field.m_literalLength);
+    const Arg& arg = a_args.GetAt(field.m_argIndex);
+    total += !arg.Is128Bit() ? fmt_int_dec(a_str, &currlen, a_count, arg.AsInt64()) : fmt_field(a_str, &currlen, a_count, field, a_args);
+    FS_NEXT(op);
+  }
+  FS_OP(OP_INT_DEC_LITERAL, op_int_dec_literal)
+  {
+    const FormatField& field = fields[op->m_field];
+    total += dopr_outstr(a_str, &currlen, a_count, format + field.m_literalOffset, field.m_literalLength);
+    const Arg& arg = a_args.GetAt(field.m_argIndex);
+    total += !arg.Is128Bit() ? fmt_int_dec(a_str, &currlen, a_count, arg.AsInt64()) : fmt_field(a_str, &currlen, a_count, field, a_args);
+    const FormatField& next = fields[op->m_field + 1];
+    total += dopr_outstr(a_str, &currlen, a_count, format + next.m_literalOffset, next.m_literalLength);
+    FS_NEXT(op);
+  }
+  FS_OP(OP_STRING, op_string)
+  {
+    const FormatField& field = fields[op->m_field];
+    total += dopr_outstr(a_str, &currlen, a_count, format + field.m_literalOffset, field.m_literalLength);
+    const Arg& arg = a_args.GetAt(field.m_argIndex);
+    total += (arg.IsCString() && arg.m_valueCString) ? dopr_outstr(a_str, &currlen, a_count, arg.m_valueCString, strlen(arg.m_valueCString))
+                                                     : fmt_field(a_str, &currlen, a_count, field, a_args);
+    FS_NEXT(op);
+  }
+  FS_OP(OP_STRING_LITERAL, op_string_literal)
+  {
+    const FormatField& field = fields[op->m_field];
+    total += dopr_outstr(a_str, &currlen, a_count, format + field.m_literalOffset, field.m_literalLength);
+    const Arg& arg = a_args.GetAt(field.m_argIndex);
+    total += (arg.IsCString() && arg.m_valueCString) ? dopr_outstr(a_str, &currlen, a_count, arg.m_valueCString, strlen(arg.m_valueCString))
+                                                     : fmt_field(a_str, &currlen, a_count, field, a_args);
+    const FormatField& next = fields[op->m_field + 1];
+    total += dopr_outstr(a_str, &currlen, a_count, format + next.m_literalOffset, next.m_literalLength);
+    FS_NEXT(op);
+  }
+  FS_OP(OP_FLOAT_FIXED, op_float_fixed)
+  {
+    const FormatField& field = fields[op->m_field];
+    total += dopr_outstr(a_str, &currlen, a_count, format + field.m_literalOffset, field.m_literalLength);
+    const Arg& arg = a_args.GetAt(field.m_argIndex);
+    fsFloat64 value = arg.AsFloat64();
+    if( isfpexception(value) || arg.IsDecimal() )
+    {
+      total += fmt_field(a_str, &currlen, a_count, field, a_args);
+    }
+    else if( arg.m_type == Arg::ARG_TYPE_FLOAT32 )
+    {
+      total += fmtfp32(a_str, &currlen, a_count, arg.m_valueFloat32, field.m_min, field.m_max, field.m_flags);
+    }
+    else
+    {
+      total += fmtfp64(a_str, &currlen, a_count, value, field.m_min, field.m_max, field.m_flags);
+    }
+    FS_NEXT(op);
+  }
+  FS_OP(OP_GENERIC, op_generic)
+  {
+    const FormatField& field = fields[op->m_field];
+    total += dopr_outstr(a_str, &currlen, a_count, format + field.m_literalOffset, field.m_literalLength);
+    total += fmt_field(a_str, &currlen, a_count, field, a_args);
+    FS_NEXT(op);
+  }
+  FS_OP(OP_END, op_end)
+  {
+  }
+  FS_END_DISPATCH
+
+  dopr_terminate(a_str, currlen, a_count);
+  return total;
+}
+
+
+fsInt FormatStringF(fsChar* a_str, size_t a_count, const CompiledFormat& a_compiled, ArgList& a_args)
+{
+  return FormatStringF(a_str, a_count, a_compiled.GetView(), a_args);
+}
+
+
+fsInt FormatStringF(fsChar* a_str, size_t a_count, const CompiledFormatView& a_compiled, ArgList& a_args)
+{
+#if FS_RECORDER
+  if( FormatRecorder::IsRecording() )
+  {
+    FormatRecorder::Sample(BinaryLog::SYNTAX_PRINTF, a_compiled.m_format, (a_str != NULL) ? a_count : 0, NULL, a_args);
+  }
+#endif // FS_RECORDER
+#if FS_TELEMETRY
+  if( FormatTelemetry::IsEnabled() )
+  {
+    fsUInt64 start = FormatTelemetry::Now();
+    fsInt result = format_compiled_f(a_str, a_count, a_compiled, a_args);
+    FormatTelemetry::Record(a_compiled.m_format, FormatTelemetry::FUNCTION_FORMAT_STRING_F, start, result, (a_str != NULL) && (result >= 0) && ((size_t)result >= a_count), false);
+    return result;
+  }
+#endif // FS_TELEMETRY
+  return format_compiled_f(a_str, a_count, a_compiled, a_args);
+}
+
+
+// Compiled format from the FormatCache when enabled, otherwise compiled here
+static fsBool compile_cached(const fsChar* a_fmt, CompiledFormat& a_compiled)
+{
+  if( FormatCache::IsEnabled() && FormatCache::Lookup(a_fmt, CompiledFormat::SYNTAX_PRINTF, a_compiled) )
+  {
+    return true;
+  }
+  return CompileFormatStringF(a_fmt, a_compiled);
+}
+
+
+// Plain "%d" of a 64bit value, writes backwards from a_end. Returns start of digits.
+static char* fmt_dec_fast(char* a_end, fsInt64 a_value)
+{
+  fsUInt64 uvalue = (a_value < 0) ? (0 - (fsUInt64)a_value) : (fsUInt64)a_value;
+  const char* digitPairs = NumberFormat::DigitPairs();
+  char* out = a_end;
+  while( (uvalue >> 32) != 0 ) // 64bit divisions only while needed
+  {
+    unsigned pair = (unsigned)(uvalue % 100) * 2;
+    uvalue /= 100;
+    *--out = digitPairs[pair + 1];
+    *--out = digitPairs[pair];
+  }
+  fsUInt32 value = (fsUInt32)uvalue;
+  while( value >= 100 )
+  {
+    unsigned pair = (value % 100) * 2;
+    value /= 100;
+    *--out = digitPairs[pair + 1];
+    *--out = digitPairs[pair];
+  }
+  if( value >= 10 )
+  {
+    unsigned pair = value * 2;
+    *--out = digitPairs[pair + 1];
+    *--out = digitPairs[pair];
+  }
+  else
+  {
+    *--out = (char)('0' + value);
+  }
+  if( a_value < 0 )
+  {
+    *--out = '-';
+  }
+  return out;
+}
+
+// Per field conversion, resolved once from conversion and column type
+enum BatchFieldKind
+{
+  BATCH_LITERAL,                                  // Literal run only
+  BATCH_INT_DEC,                                  // "%d" / "%i" of an int64 column, no flags, width or precision
+  BATCH_STRING,                                   // "%s" of a string column, no flags, width or precision
+  BATCH_GENERIC,                                  // Box column value and use fmt_conversion()
+};
+
+static Arg batch_column_arg(const FormatColumn* a_columns, fsInt a_numColumns, fsInt a_column, fsInt a_row)
+{
+  if( (a_column < 0) || (a_column >= a_numColumns) )
+  {
+    return Arg();
+  }
+  const FormatColumn& column = a_columns[a_column];
+  switch( column.m_type )
+  {
+  case FormatColumn::COLUMN_INT64:    return Arg(((const fsInt64*)column.m_data)[a_row]);
+  case FormatColumn::COLUMN_FLOAT64:  return Arg(((const fsFloat64*)column.m_data)[a_row]);
+  case FormatColumn::COLUMN_CSTR:     return Arg(((const fsChar* const*)column.m_data)[a_row]);
+  default:                            return Arg();
+  }
+}
+
+fsInt FormatStringFBatch(fsChar* a_str, size_t a_count, const CompiledFormat& a_compiled,
+                         const FormatColumn* a_columns, fsInt a_numColumns, fsInt a_numRows, const fsChar* a_rowSeparator)
+{
+  if( (a_str != NULL) && (a_count > 0) )
+  {
+    a_str[0] = 0;
+  }
+  FS_ASSERT( a_compiled.IsValid() && (a_compiled.m_syntax == CompiledFormat::SYNTAX_PRINTF) );
+  if( !a_compiled.IsValid() || (a_compiled.m_syntax != CompiledFormat::SYNTAX_PRINTF) )
+  {
+    return 0;
+  }
+
+  // Specialize each field for its column type once, rather than per row
+  fsUInt8 kinds[CompiledFormat::MAX_FIELDS];
+  for( fsInt fieldIndex = 0; fieldIndex < a_compiled.m_numFields; ++fieldIndex )
+  {
+    const FormatField& field = a_compiled.m_fields[fieldIndex];
+    fsUInt8 kind = BATCH_GENERIC;
+    if( !field.m_conversion )
+    {
+      kind = BATCH_LITERAL;
+    }
+    else if( (field.m_argIndex < a_numColumns) && (field.m_flags == 0) && (field.m_min == 0) && (field.m_max < 0)
+             && (field.m_minArgIndex == FormatField::NO_ARG) && (field.m_maxArgIndex == FormatField::NO_ARG) )
+    {
+      fsInt columnType = a_columns[field.m_argIndex].m_type;
+      if( ((field.m_conversion == 'd') || (field.m_conversion == 'i')) && (columnType == FormatColumn::COLUMN_INT64) )
+      {
+        kind = BATCH_INT_DEC;
+      }
+      else if( (field.m_conversion == 's') && (columnType == FormatColumn::COLUMN_CSTR) )
+      {
+        kind = BATCH_STRING;
+      }
+    }
+    kinds[fieldIndex] = kind;
+  }
+
+  size_t separatorLength = a_rowSeparator ? strlen(a_rowSeparator) : 0;
+  size_t currlen = 0;
+  int total = 0;
+  for( fsInt row = 0; row < a_numRows; ++row )
+  {
+    for( fsInt fieldIndex = 0; fieldIndex < a_compiled.m_numFields; ++fieldIndex )
+    {
+      const FormatField& field = a_compiled.m_fields[fieldIndex];
+      total += dopr_outstr(a_str, &currlen, a_count, a_compiled.m_format + field.m_literalOffset, field.m_literalLength);
+
+      switch( kinds[fieldIndex] )
+      {
+      case BATCH_INT_DEC:
+        {
+          char convert[24];
+          char* end = convert + sizeof(convert);
+          char* start = fmt_dec_fast(end, ((const fsInt64*)a_columns[field.m_argIndex].m_data)[row]);
+          total += dopr_outstr(a_str, &currlen, a_count, start, end - start);
+        }
+        break;
+      case BATCH_STRING:
+        {
+          const fsChar* value = ((const fsChar* const*)a_columns[field.m_argIndex].m_data)[row];
+          if( value != NULL )
+            total += dopr_outstr(a_str, &currlen, a_count, value, strlen(value));
+          else
+            total += fmtstr(a_str, &currlen, a_count, value, 0, 0, -1);
+        }
+        break;
+      case BATCH_GENERIC:
+        {
+          int min = (field.m_minArgIndex == FormatField::NO_ARG) ? field.m_min : batch_column_arg(a_columns, a_numColumns, field.m_minArgIndex, row).AsInt32();
+          int max = (field.m_maxArgIndex == FormatField::NO_ARG) ? field.m_max : batch_column_arg(a_columns, a_numColumns, field.m_maxArgIndex, row).AsInt32();
+          total += fmt_conversion(a_str, &currlen, a_count, field.m_conversion, batch_column_arg(a_columns, a_numColumns, field.m_argIndex, row), min, max, field.m_flags, field.m_modifier);
+        }
+        break;
+      default:
+        break;
+      }
+    }
+    total += dopr_outstr(a_str, &currlen, a_count, a_rowSeparator, separatorLength);
+  }
+  dopr_terminate(a_str, currlen, a_count);
+  return total;
+}
+
+
+fsInt FormatStringFBatch(fsChar* a_str, size_t a_count, const fsChar* a_fmt,
+                         const FormatColumn* a_columns, fsInt a_numColumns, fsInt a_numRows, const fsChar* a_rowSeparator)
+{
+  CompiledFormat compiled;
+  if( !CompileFormatStringF(a_fmt, compiled) )
+  {
+    if( (a_str != NULL) && (a_count > 0) )
+    {
+      a_str[0] = 0;
+    }
+    return 0;
+  }
+  return FormatStringFBatch(a_str, a_count, compiled, a_columns, a_numColumns, a_numRows, a_rowSeparator);
+}
+
+
+
+// String and length output by "%s" conversion of an argument, as per fmt_conversion() and fmtstr().
+// a_width returns the length in width units for padding.
+static size_t string_arg(const Arg& a_arg, int a_max, const fsChar** a_value, size_t* a_width)
+{
+  const fsChar* value = a_arg.IsCString() ? a_arg.m_valueCString : "#err#";
+  if( value == NULL )
+  {
+    value = "<NULL>";
+  }
+  *a_value = value;
+  return Utf8::Prefix(value, strlen(value), a_max, FS_UTF8_MODE, a_width);
+}
+
+
+FormatStringFStream::FormatStringFStream()
+{
+  m_compiled = NULL;
+  m_args = NULL;
+  m_fieldIndex = 0;
+  m_inConversion = false;
+  m_done = true;
+  m_numSegments = 0;
+  m_segmentIndex = 0;
+  m_segmentOffset = 0;
+}
+
+
+fsBool FormatStringFStream::Begin(const fsChar* a_fmt, ArgList& a_args)
+{
+  if( !compile_cached(a_fmt, m_ownCompiled) )
+  {
+    m_done = true;
+    return false;
+  }
+  return Begin(m_ownCompiled, a_args);
+}
+
+
+fsBool FormatStringFStream::Begin(const CompiledFormat& a_compiled, ArgList& a_args)
+{
+  FS_ASSERT( a_compiled.IsValid() && (a_compiled.m_syntax == CompiledFormat::SYNTAX_PRINTF) );
+  m_compiled = &a_compiled;
+  m_args = &a_args;
+  m_fieldIndex = 0;
+  m_inConversion = false;
+  m_numSegments = 0;
+  m_segmentIndex = 0;
+  m_segmentOffset = 0;
+  m_done = !a_compiled.IsValid() || (a_compiled.m_syntax != CompiledFormat::SYNTAX_PRINTF);
+  return !m_done;
+}
+
+
+size_t FormatStringFStream::Next(fsChar* a_buffer, size_t a_count)
+{
+  size_t written = 0;
+  while( (written < a_count) && !m_done )
+  {
+    if( m_segmentIndex >= m_numSegments )
+    {
+      if( !InternalNextPart() )
+      {
+        m_done = true;
+      }
+      continue;
+    }
+
+    const Segment& segment = m_segments[m_segmentIndex];
+    size_t length = segment.m_length - m_segmentOffset;
+    if( length > a_count - written )
+    {
+      length = a_count - written;
+    }
+    if( segment.m_text != NULL )
+    {
+      memcpy(a_buffer + written, segment.m_text + m_segmentOffset, length);
+    }
+    else
+    {
+      memset(a_buffer + written, segment.m_fill, length);
+    }
+    written += length;
+    m_segmentOffset += length;
+    if( m_segmentOffset >= segment.m_length )
+    {
+      ++m_segmentIndex;
+      m_segmentOffset = 0;
+    }
+  }
+  return written;
+}
+
+
+// Load segments for the next literal run or conversion. Returns false at end of format.
+fsBool FormatStringFStream::InternalNextPart()
+{
+  m_numSegments = 0;
+  m_segmentIndex = 0;
+  m_segmentOffset = 0;
+  if( m_fieldIndex >= m_compiled->m_numFields )
+  {
+    return false;
+  }
+
+  const FormatField& field = m_compiled->m_fields[m_fieldIndex];
+  if( !m_inConversion )
+  {
+    InternalAddSegment(m_compiled->m_format + field.m_literalOffset, field.m_literalLength);
+    m_inConversion = true;
+  }
+  else
+  {
+    if( field.m_conversion )
+    {
+      InternalConversion(field);
+    }
+    m_inConversion = false;
+    ++m_fieldIndex;
+  }
+  return true;
+}
+
+
+void FormatStringFStream::InternalAddSegment(const fsChar* a_text, size_t a_length, fsChar a_fill)
+{
+  FS_ASSERT( m_numSegments < MAX_SEGMENTS );
+  if( a_length > 0 )
+  {
+    Segment& segment = m_segments[m_numSegments++];
+    segment.m_text = a_text;
+    segment.m_length = a_length;
+    segment.m_fill = a_fill;
+  }
+}
+
+
+// Precision rendered into the stream scratch, further digits are zeros. Float32 has at most 149 fraction digits,
+// and the widest rendering (309 integer digits of a double) still fits MAX_SCRATCH.
+static const int STREAM_MAX_PRECISION = 160;
+
+// Where precision zeros go in a conversion rendered with less precision: after the sign for integers (leading
+// zeros), before the exponent for 'e' and 'a', otherwise at the end (trailing fraction zeros)
+static size_t precision_zeros_offset(char a_conversion, const char* a_text, size_t a_length)
+{
+  switch (a_conversion)
+  {
+  case 'e': case 'E': case 'a': case 'A':
+    {
+      char exponent = ((a_conversion == 'a') || (a_conversion == 'A')) ? 'p' : 'e';
+      for( size_t offset = a_length; offset > 0; --offset )
+      {
+        if( (a_text[offset - 1] | 0x20) == exponent )
+        {
+          return offset - 1;
+        }
+      }
+      return a_length;
+    }
+  case 'f': case 'g': case 'G':
+    return a_length;
+  default:
+    return ((a_length > 0) && ((a_text[0] == '-') || (a_text[0] == '+') || (a_text[0] == ' '))) ? 1 : 0;
+  }
+}
+
+
+// Split a conversion into at most five segments, as per fmtstr(), fmtint_64() and fmtfp64() padding rules
+void FormatStringFStream::InternalConversion(const FormatField& a_field)
+{
+  int min = (a_field.m_minArgIndex == FormatField::NO_ARG) ? a_field.m_min : m_args->GetAt(a_field.m_minArgIndex).m_valueInt32;
+  int max = (a_field.m_maxArgIndex == FormatField::NO_ARG) ? a_field.m_max : m_args->GetAt(a_field.m_maxArgIndex).m_valueInt32;
+  int flags = a_field.m_flags;
+  const Arg& arg = m_args->GetAt(a_field.m_argIndex);
+
+  if( a_field.m_conversion == 's' ) // Reference string memory rather than copy
+  {
+    const fsChar* value;
+    size_t width;
+    size_t length = string_arg(arg, max, &value, &width);
+    size_t padlen = ((min > 0) && ((size_t)min > width)) ? (min - width) : 0;
+    if( flags & DP_F_MINUS )
+    {
+      InternalAddSegment(value, length);
+      InternalAddSegment(NULL, padlen, ' ');
+    }
+    else
+    {
+      InternalAddSegment(NULL, padlen, ' ');
+      InternalAddSegment(value, length);
+    }
+    return;
+  }
+
+  size_t currlen = 0;
+  size_t length = (size_t)fmt_conversion(m_scratch, &currlen, MAX_SCRATCH, a_field.m_conversion, arg, min, max, flags, a_field.m_modifier);
+  if( length < MAX_SCRATCH )
+  {
+    InternalAddSegment(m_scratch, currlen);
+    return;
+  }
+
+  // Too wide for scratch. Render without width, and with at most STREAM_MAX_PRECISION digits of precision (the
+  // rest are zeros), then generate the width padding and the precision zeros.
+  currlen = 0;
+  size_t unpadded = (size_t)fmt_conversion(NULL, &currlen, 0, a_field.m_conversion, arg, 0, max, flags, a_field.m_modifier);
+  currlen = 0;
+  fmt_conversion(m_scratch, &currlen, MAX_SCRATCH, a_field.m_conversion, arg, 0, MIN(max, STREAM_MAX_PRECISION), flags, a_field.m_modifier);
+  FS_ASSERT( currlen + 1 < MAX_SCRATCH );
+  size_t padlen = (length > unpadded) ? (length - unpadded) : 0;
+  size_t zeros = (unpadded > currlen) ? (unpadded - currlen) : 0;
+  size_t zerosOffset = precision_zeros_offset(a_field.m_conversion, m_scratch, currlen);
+  size_t signLength = 0;
+  bool isInteger = (strchr("diouxXbBp", a_field.m_conversion) != NULL);
+  bool zeroPad = (flags & DP_F_ZERO) && (isInteger || !(flags & DP_F_MINUS));
+  if( zeroPad )
+  {
+    signLength = ((currlen > 0) && ((m_scratch[0] == '-') || (m_scratch[0] == '+') || (m_scratch[0] == ' '))) ? 1 : 0;
+    if( (a_field.m_conversion == 'a') || (a_field.m_conversion == 'A') )
+    {
+      signLength += 2; // Zeros go after the "0x"
+    }
+    InternalAddSegment(m_scratch, signLength);
+    InternalAddSegment(NULL, padlen, '0');
+  }
+  else if( !(flags & DP_F_MINUS) )
+  {
+    InternalAddSegment(NULL, padlen, ' ');
+  }
+  if( zerosOffset < signLength ) // Integer precision zeros follow the sign, as do the width zeros
+  {
+    zerosOffset = signLength;
+  }
+  InternalAddSegment(m_scratch + signLength, zerosOffset - signLength);
+  InternalAddSegment(NULL, zeros, '0');
+  InternalAddSegment(m_scratch + zerosOffset, currlen - zerosOffset);
+  if( !zeroPad && (flags & DP_F_MINUS) )
+  {
+    InternalAddSegment(NULL, padlen, ' ');
+  }
+}
+
+
+
+// Append a span, extending the previous entry when contiguous (eg. padding then digits in scratch).
+// Returns false if out of entries.
+static bool iovec_add(FormatIoVec* a_vecs, fsInt a_maxVecs, fsInt* a_numVecs, const fsChar* a_base, size_t a_length)
+{
+  if( a_length == 0 )
+  {
+    return true;
+  }
+  if( (*a_numVecs > 0) && ((const fsChar*)a_vecs[*a_numVecs - 1].iov_base + a_vecs[*a_numVecs - 1].iov_len == a_base) )
+  {
+    a_vecs[*a_numVecs - 1].iov_len += a_length;
+    return true;
+  }
+  if( *a_numVecs >= a_maxVecs )
+  {
+    return false;
+  }
+  a_vecs[*a_numVecs].iov_base = (void*)a_base;
+  a_vecs[*a_numVecs].iov_len = a_length;
+  ++(*a_numVecs);
+  return true;
+}
+
+
+fsInt FormatStringFIoVec(FormatIoVec* a_vecs, fsInt a_maxVecs, fsChar* a_scratch, size_t a_scratchSize,
+                         const CompiledFormat& a_compiled, ArgList& a_args, size_t* a_totalLength)
+{
+  FS_ASSERT( a_compiled.IsValid() && (a_compiled.m_syntax == CompiledFormat::SYNTAX_PRINTF) );
+  if( !a_compiled.IsValid() || (a_compiled.m_syntax != CompiledFormat::SYNTAX_PRINTF) )
+  {
+    return -1;
+  }
+
+  fsInt numVecs = 0;
+  size_t scratchUsed = 0;
+
+  for( fsInt fieldIndex = 0; fieldIndex < a_compiled.m_numFields; ++fieldIndex )
+  {
+    const FormatField& field = a_compiled.m_fields[fieldIndex];
+    if( !iovec_add(a_vecs, a_maxVecs, &numVecs, a_compiled.m_format + field.m_literalOffset, (size_t)field.m_literalLength) ) return -1;
+    if( !field.m_conversion )
+    {
+      continue;
+    }
+
+    int min = (field.m_minArgIndex == FormatField::NO_ARG) ? field.m_min : a_args.GetAt(field.m_minArgIndex).m_valueInt32;
+    int max = (field.m_maxArgIndex == FormatField::NO_ARG) ? field.m_max : a_args.GetAt(field.m_maxArgIndex).m_valueInt32;
+    const Arg& arg = a_args.GetAt(field.m_argIndex);
+    fsChar* scratch = a_scratch + scratchUsed;
+    size_t scratchFree = a_scratchSize - scratchUsed;
+
+    if( field.m_conversion == 's' ) // Reference string memory, only padding goes in scratch
+    {
+      const fsChar* value;
+      size_t width;
+      size_t length = string_arg(arg, max, &value, &width);
+      size_t padlen = ((min > 0) && ((size_t)min > width)) ? (min - width) : 0;
+      if( padlen > scratchFree )
+      {
+        return -1;
+      }
+      memset(scratch, ' ', padlen);
+      scratchUsed += padlen;
+      if( field.m_flags & DP_F_MINUS )
+      {
+        if( !iovec_add(a_vecs, a_maxVecs, &numVecs, value, length) ) return -1;
+        if( !iovec_add(a_vecs, a_maxVecs, &numVecs, scratch, padlen) ) return -1;
+      }
+      else
+      {
+        if( !iovec_add(a_vecs, a_maxVecs, &numVecs, scratch, padlen) ) return -1;
+        if( !iovec_add(a_vecs, a_maxVecs, &numVecs, value, length) ) return -1;
+      }
+    }
+    else
+    {
+      size_t currlen = 0;
+      size_t length = (size_t)fmt_conversion(scratch, &currlen, scratchFree, field.m_conversion, arg, min, max, field.m_flags, field.m_modifier);
+      if( length >= scratchFree ) // Truncated
+      {
+        return -1;
+      }
+      scratchUsed += length;
+      if( !iovec_add(a_vecs, a_maxVecs, &numVecs, scratch, length) ) return -1;
+    }
+  }
+
+  if( a_totalLength != NULL )
+  {
+    *a_totalLength = 0;
+    for( fsInt vecIndex = 0; vecIndex < numVecs; ++vecIndex )
+    {
+      *a_totalLength += a_vecs[vecIndex].iov_len;
+    }
+  }
+  return numVecs;
+}
+
+
+fsInt FormatStringFIoVec(FormatIoVec* a_vecs, fsInt a_maxVecs, fsChar* a_scratch, size_t a_scratchSize,
+                         const fsChar* a_fmt, ArgList& a_args, size_t* a_totalLength)
+{
+  CompiledFormat compiled;
+  if( !compile_cached(a_fmt, compiled) )
+  {
+    return -1;
+  }
+  return FormatStringFIoVec(a_vecs, a_maxVecs, a_scratch, a_scratchSize, compiled, a_args, a_totalLength);
+}
+
+
 END_NAMESPACE_FORMATSTRINGLIB
\ No newline at end of file
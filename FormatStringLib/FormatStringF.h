@@ -7,18 +7,25 @@
 //
 
 #include "Arg.h"
+#include "CompiledFormat.h"
+
+#ifndef _WIN32
+#include <sys/uio.h>
+#endif // _WIN32
 
 //
-// The syntax for a format is "%[flags][width][.precision]type"
+// The syntax for a format is "%[position$][flags][width][.precision][length]type"
 // Standard library printf / snprintf style formatting
 //
 // Supported format types:
 //   d = Decimal integer
 //   i = Decimal integer
-//   f = Fixed point real number
+//   f = Fixed point real number. Exact for a fixed point decimal (Decimal64, see Arg.h), default precision is its scale
 //   e/E = Exponential (scientific) real number
 //   g/G = General real number
+//   a/A = Hexadecimal real number, "0x1.8p+1", exact and read back by ScanStringF
 //   x/X = Hexadecimal integer
+//   b/B = Binary integer (extension)
 //   u = Unsigned decimal integer
 //   o = Unsigned octol integer
 //   s = String
@@ -35,16 +42,38 @@
 //
 // width : Optional minimum width of converted value, negative for left justification
 //  '*'    The width is specified as an additional integer argument preceding the argument to be formatted.
+//  '*m$'  The width is argument m (1 based), with positional arguments.
 //
 // precision : Optional maximum precision for fixed point or zero padded values
 //  '*'    The precision is specified as an additional integer argument preceding the argument to be formatted.
+//  '*m$'  The precision is argument m (1 based), with positional arguments.
+//
+// position : Optional POSIX argument position, 1 based, so translated formats can reorder arguments.
+//  Eg. FormatStringF(buffer, 512, "%2$s has %1$d items", 3, "Cart") outputs "Cart has 3 items"
+//  Arguments may be used more than once. Positional and sequential use must not be mixed in one format,
+//  CompileFormatStringF() rejects that (as well as "%0$"), so compile formats to have them checked once.
+//
+// Width and precision of strings count bytes, or UTF-8 code points or columns when enabled (see FS_UTF8_MODE in Utf8.h)
 //
 // Eg. FormatStringF(buffer, 512, "Count: %d value: %.3f", 34, 123.456789);
 //     output buffer contains: "Count: 34 value: 123.457"
 // 
 //
-// NOTE: Handles 64bit integers and pointers WITHOUT size extended format types (eg. 'llu')
+// length : Optional length modifier for integer types, the value is converted as that C type (eg. "%hhu" of 300 is 44)
+//  'hh' char, 'h' short, 'l' long, 'll' long long, 'j' intmax_t, 'z' size_t, 't' ptrdiff_t ('L' as 'll')
+//  Without one the argument keeps its own type (eg. "%x" of fsInt32 -1 is ffffffff, "%d" of fsUInt32 4294967295
+//  is 4294967295), 64bit and 128bit integers are converted in full.
+//
 //   
+// Repeated use of the same format can skip parsing by compiling it once.
+// Eg. static CompiledFormat s_fmt; if( !s_fmt.IsValid() ) CompileFormatStringF("Count: %d value: %.3f", s_fmt);
+//     FormatStringF(buffer, 512, s_fmt, 34, 123.456789);
+//
+// Batch formatting applies one compiled format to every row of column arrays, argument N is column N.
+// Eg. fsInt64 ids[] = {1, 2}; fsFloat64 values[] = {0.5, 1.25};
+//     FormatColumn columns[] = { FormatColumn(ids), FormatColumn(values) };
+//     FormatStringFBatch(buffer, 512, "%d,%.2f", columns, 2, 2);
+//     output buffer contains: "1,0.50\n2,1.25\n"
 //
 
 BEGIN_NAMESPACE_FORMATSTRINGLIB
@@ -64,6 +93,167 @@ inline fsInt FormatStringF(fsChar* a_str, size_t a_count, const fsChar* a_fmt, A
 inline fsInt FormatStringF(fsChar* a_str, size_t a_count, const fsChar* a_fmt, Arg a_p1, Arg a_p2, Arg a_p3, Arg a_p4, Arg a_p5, Arg a_p6, Arg a_p7)            {  ArgListFixed args(a_p1, a_p2, a_p3, a_p4, a_p5, a_p6, a_p7);       return FormatStringF(a_str, a_count, a_fmt,  args); }
 inline fsInt FormatStringF(fsChar* a_str, size_t a_count, const fsChar* a_fmt, Arg a_p1, Arg a_p2, Arg a_p3, Arg a_p4, Arg a_p5, Arg a_p6, Arg a_p7, Arg a_p8)  {  ArgListFixed args(a_p1, a_p2, a_p3, a_p4, a_p5, a_p6, a_p7, a_p8); return FormatStringF(a_str, a_count, a_fmt,  args); }
 
+
+// Parse format once for repeated use. Returns false if the format has too many fields, mixes positional and
+// sequential arguments or has an invalid position.
+fsBool CompileFormatStringF(const fsChar* a_fmt, CompiledFormat& a_compiled);
+
+// Format string with compiled format and argument list
+fsInt FormatStringF(fsChar* a_str, size_t a_count, const CompiledFormat& a_compiled, ArgList& a_args);
+
+// Compiled format with variable argument overloads
+inline fsInt FormatStringF(fsChar* a_str, size_t a_count, const CompiledFormat& a_compiled)                                                                                  {  ArgListFixed args;                                                 return FormatStringF(a_str, a_count, a_compiled,  args); }
+inline fsInt FormatStringF(fsChar* a_str, size_t a_count, const CompiledFormat& a_compiled, Arg a_p1)                                                                        {  ArgListFixed args(a_p1);                                           return FormatStringF(a_str, a_count, a_compiled,  args); }
+inline fsInt FormatStringF(fsChar* a_str, size_t a_count, const CompiledFormat& a_compiled, Arg a_p1, Arg a_p2)                                                              {  ArgListFixed args(a_p1, a_p2);                                     return FormatStringF(a_str, a_count, a_compiled,  args); }
+inline fsInt FormatStringF(fsChar* a_str, size_t a_count, const CompiledFormat& a_compiled, Arg a_p1, Arg a_p2, Arg a_p3)                                                    {  ArgListFixed args(a_p1, a_p2, a_p3);                               return FormatStringF(a_str, a_count, a_compiled,  args); }
+inline fsInt FormatStringF(fsChar* a_str, size_t a_count, const CompiledFormat& a_compiled, Arg a_p1, Arg a_p2, Arg a_p3, Arg a_p4)                                          {  ArgListFixed args(a_p1, a_p2, a_p3, a_p4);                         return FormatStringF(a_str, a_count, a_compiled,  args); }
+inline fsInt FormatStringF(fsChar* a_str, size_t a_count, const CompiledFormat& a_compiled, Arg a_p1, Arg a_p2, Arg a_p3, Arg a_p4, Arg a_p5)                                {  ArgListFixed args(a_p1, a_p2, a_p3, a_p4, a_p5);                   return FormatStringF(a_str, a_count, a_compiled,  args); }
+inline fsInt FormatStringF(fsChar* a_str, size_t a_count, const CompiledFormat& a_compiled, Arg a_p1, Arg a_p2, Arg a_p3, Arg a_p4, Arg a_p5, Arg a_p6)                      {  ArgListFixed args(a_p1, a_p2, a_p3, a_p4, a_p5, a_p6);             return FormatStringF(a_str, a_count, a_compiled,  args); }
+inline fsInt FormatStringF(fsChar* a_str, size_t a_count, const CompiledFormat& a_compiled, Arg a_p1, Arg a_p2, Arg a_p3, Arg a_p4, Arg a_p5, Arg a_p6, Arg a_p7)            {  ArgListFixed args(a_p1, a_p2, a_p3, a_p4, a_p5, a_p6, a_p7);       return FormatStringF(a_str, a_count, a_compiled,  args); }
+inline fsInt FormatStringF(fsChar* a_str, size_t a_count, const CompiledFormat& a_compiled, Arg a_p1, Arg a_p2, Arg a_p3, Arg a_p4, Arg a_p5, Arg a_p6, Arg a_p7, Arg a_p8)  {  ArgListFixed args(a_p1, a_p2, a_p3, a_p4, a_p5, a_p6, a_p7, a_p8); return FormatStringF(a_str, a_count, a_compiled,  args); }
+
+// Format string with a compiled format view, eg. an entry of a FormatCatalog (see FormatCatalog.h)
+fsInt FormatStringF(fsChar* a_str, size_t a_count, const CompiledFormatView& a_view, ArgList& a_args);
+
+inline fsInt FormatStringF(fsChar* a_str, size_t a_count, const CompiledFormatView& a_view)                                                                                  {  ArgListFixed args;                                                 return FormatStringF(a_str, a_count, a_view,  args); }
+inline fsInt FormatStringF(fsChar* a_str, size_t a_count, const CompiledFormatView& a_view, Arg a_p1)                                                                        {  ArgListFixed args(a_p1);                                           return FormatStringF(a_str, a_count, a_view,  args); }
+inline fsInt FormatStringF(fsChar* a_str, size_t a_count, const CompiledFormatView& a_view, Arg a_p1, Arg a_p2)                                                              {  ArgListFixed args(a_p1, a_p2);                                     return FormatStringF(a_str, a_count, a_view,  args); }
+inline fsInt FormatStringF(fsChar* a_str, size_t a_count, const CompiledFormatView& a_view, Arg a_p1, Arg a_p2, Arg a_p3)                                                    {  ArgListFixed args(a_p1, a_p2, a_p3);                               return FormatStringF(a_str, a_count, a_view,  args); }
+inline fsInt FormatStringF(fsChar* a_str, size_t a_count, const CompiledFormatView& a_view, Arg a_p1, Arg a_p2, Arg a_p3, Arg a_p4)                                          {  ArgListFixed args(a_p1, a_p2, a_p3, a_p4);                         return FormatStringF(a_str, a_count, a_view,  args); }
+inline fsInt FormatStringF(fsChar* a_str, size_t a_count, const CompiledFormatView& a_view, Arg a_p1, Arg a_p2, Arg a_p3, Arg a_p4, Arg a_p5)                                {  ArgListFixed args(a_p1, a_p2, a_p3, a_p4, a_p5);                   return FormatStringF(a_str, a_count, a_view,  args); }
+inline fsInt FormatStringF(fsChar* a_str, size_t a_count, const CompiledFormatView& a_view, Arg a_p1, Arg a_p2, Arg a_p3, Arg a_p4, Arg a_p5, Arg a_p6)                      {  ArgListFixed args(a_p1, a_p2, a_p3, a_p4, a_p5, a_p6);             return FormatStringF(a_str, a_count, a_view,  args); }
+inline fsInt FormatStringF(fsChar* a_str, size_t a_count, const CompiledFormatView& a_view, Arg a_p1, Arg a_p2, Arg a_p3, Arg a_p4, Arg a_p5, Arg a_p6, Arg a_p7)            {  ArgListFixed args(a_p1, a_p2, a_p3, a_p4, a_p5, a_p6, a_p7);       return FormatStringF(a_str, a_count, a_view,  args); }
+inline fsInt FormatStringF(fsChar* a_str, size_t a_count, const CompiledFormatView& a_view, Arg a_p1, Arg a_p2, Arg a_p3, Arg a_p4, Arg a_p5, Arg a_p6, Arg a_p7, Arg a_p8)  {  ArgListFixed args(a_p1, a_p2, a_p3, a_p4, a_p5, a_p6, a_p7, a_p8); return FormatStringF(a_str, a_count, a_view,  args); }
+
+
+// Length of formatted output (excluding terminator) without writing anything, for sizing buffers exactly
+fsInt FormatStringFLength(const fsChar* a_fmt, ArgList& a_args);
+fsInt FormatStringFLength(const CompiledFormat& a_compiled, ArgList& a_args);
+
+// Length of formatted output with variable argument overloads
+inline fsInt FormatStringFLength(const fsChar* a_fmt)                                                                                  {  ArgListFixed args;                                                 return FormatStringFLength(a_fmt,  args); }
+inline fsInt FormatStringFLength(const fsChar* a_fmt, Arg a_p1)                                                                        {  ArgListFixed args(a_p1);                                           return FormatStringFLength(a_fmt,  args); }
+inline fsInt FormatStringFLength(const fsChar* a_fmt, Arg a_p1, Arg a_p2)                                                              {  ArgListFixed args(a_p1, a_p2);                                     return FormatStringFLength(a_fmt,  args); }
+inline fsInt FormatStringFLength(const fsChar* a_fmt, Arg a_p1, Arg a_p2, Arg a_p3)                                                    {  ArgListFixed args(a_p1, a_p2, a_p3);                               return FormatStringFLength(a_fmt,  args); }
+inline fsInt FormatStringFLength(const fsChar* a_fmt, Arg a_p1, Arg a_p2, Arg a_p3, Arg a_p4)                                          {  ArgListFixed args(a_p1, a_p2, a_p3, a_p4);                         return FormatStringFLength(a_fmt,  args); }
+inline fsInt FormatStringFLength(const fsChar* a_fmt, Arg a_p1, Arg a_p2, Arg a_p3, Arg a_p4, Arg a_p5)                                {  ArgListFixed args(a_p1, a_p2, a_p3, a_p4, a_p5);                   return FormatStringFLength(a_fmt,  args); }
+inline fsInt FormatStringFLength(const fsChar* a_fmt, Arg a_p1, Arg a_p2, Arg a_p3, Arg a_p4, Arg a_p5, Arg a_p6)                      {  ArgListFixed args(a_p1, a_p2, a_p3, a_p4, a_p5, a_p6);             return FormatStringFLength(a_fmt,  args); }
+inline fsInt FormatStringFLength(const fsChar* a_fmt, Arg a_p1, Arg a_p2, Arg a_p3, Arg a_p4, Arg a_p5, Arg a_p6, Arg a_p7)            {  ArgListFixed args(a_p1, a_p2, a_p3, a_p4, a_p5, a_p6, a_p7);       return FormatStringFLength(a_fmt,  args); }
+inline fsInt FormatStringFLength(const fsChar* a_fmt, Arg a_p1, Arg a_p2, Arg a_p3, Arg a_p4, Arg a_p5, Arg a_p6, Arg a_p7, Arg a_p8)  {  ArgListFixed args(a_p1, a_p2, a_p3, a_p4, a_p5, a_p6, a_p7, a_p8); return FormatStringFLength(a_fmt,  args); }
+
+
+// Column of values for batch formatting, one value per row
+struct FormatColumn
+{
+  enum Type
+  {
+    COLUMN_INT64,                                 // const fsInt64*
+    COLUMN_FLOAT64,                               // const fsFloat64*
+    COLUMN_CSTR,                                  // const fsChar* const*
+  };
+
+  fsInt m_type;                                   // Type enum
+  const void* m_data;                             // First row
+
+  FormatColumn(const fsInt64* a_data)             { m_type = COLUMN_INT64; m_data = a_data; }
+  FormatColumn(const fsFloat64* a_data)           { m_type = COLUMN_FLOAT64; m_data = a_data; }
+  FormatColumn(const fsChar* const* a_data)       { m_type = COLUMN_CSTR; m_data = a_data; }
+};
+
+// Format every row of the columns into one contiguous output, a_rowSeparator is appended after each row.
+// Returns total length as per FormatStringF, output is truncated to a_count.
+fsInt FormatStringFBatch(fsChar* a_str, size_t a_count, const CompiledFormat& a_compiled,
+                         const FormatColumn* a_columns, fsInt a_numColumns, fsInt a_numRows, const fsChar* a_rowSeparator = "\n");
+fsInt FormatStringFBatch(fsChar* a_str, size_t a_count, const fsChar* a_fmt,
+                         const FormatColumn* a_columns, fsInt a_numColumns, fsInt a_numRows, const fsChar* a_rowSeparator = "\n");
+
+
+// Resumable formatting, streams output of any length through a fixed size buffer without reformatting.
+// Literal text and %s strings are copied straight from the format and argument memory, other conversions
+// are rendered once into a small scratch buffer (width padding and long precision zeros are generated, not stored).
+// Eg. ArgListFixed args(name, count);
+//     FormatStringFStream stream;
+//     stream.Begin("Name: %s count: %d", args);
+//     while( size_t length = stream.Next(chunk, 4096) ) { send(socket, chunk, length, 0); }
+// NOTE: The format and argument list must remain valid until the stream is done.
+class FormatStringFStream
+{
+public:
+
+  enum
+  {
+    MAX_SCRATCH = 512,                            // Longest conversion, excluding width padding and precision zeros
+  };
+
+  FormatStringFStream();
+
+  // Start formatting. Returns false if the format could not be compiled.
+  fsBool Begin(const fsChar* a_fmt, ArgList& a_args);
+  fsBool Begin(const CompiledFormat& a_compiled, ArgList& a_args);
+
+  // Fill a_buffer with up to a_count chars of output, NOT null terminated. Returns chars written, 0 when done.
+  size_t Next(fsChar* a_buffer, size_t a_count);
+
+  // True when all output has been returned
+  fsBool IsDone() const                           { return m_done; }
+
+protected:
+
+  // Run of output, either text or a repeated fill char
+  struct Segment
+  {
+    const fsChar* m_text;                         // Text, or NULL to repeat m_fill
+    size_t m_length;
+    fsChar m_fill;
+  };
+
+  enum
+  {
+    MAX_SEGMENTS = 5,                             // Eg. sign, zero padding, digits, precision zeros, exponent
+  };
+
+  CompiledFormat m_ownCompiled;                   // Used by Begin(a_fmt)
+  const CompiledFormat* m_compiled;               // Format being streamed
+  ArgList* m_args;
+  fsInt m_fieldIndex;                             // Current field
+  fsBool m_inConversion;                          // Literal run of current field done, conversion next
+  fsBool m_done;
+  Segment m_segments[MAX_SEGMENTS];               // Pending output of current literal run or conversion
+  fsInt m_numSegments;
+  fsInt m_segmentIndex;                           // Segment being output
+  size_t m_segmentOffset;                         // Chars of segment already output
+  fsChar m_scratch[MAX_SCRATCH];                  // Rendered conversion
+
+  fsBool InternalNextPart();
+  void InternalConversion(const FormatField& a_field);
+  void InternalAddSegment(const fsChar* a_text, size_t a_length, fsChar a_fill = ' ');
+};
+
+
+#ifdef _WIN32
+// Same members as POSIX struct iovec
+struct FormatIoVec
+{
+  void* iov_base;
+  size_t iov_len;
+};
+#else // _WIN32
+typedef struct iovec FormatIoVec;               // Pass directly to writev() / sendmsg()
+#endif // _WIN32
+
+// Scatter-gather output. Fills a_vecs with spans referencing literal text in the format and %s string
+// argument memory, only numeric conversions and padding are written into a_scratch.
+// Returns number of entries used, or -1 if a_vecs or a_scratch is too small. Optionally returns total output length.
+// Eg. ArgListFixed args(payload, payloadLength);
+//     FormatIoVec vecs[16]; char scratch[256];
+//     fsInt numVecs = FormatStringFIoVec(vecs, 16, scratch, sizeof(scratch), s_compiledFmt, args);
+//     writev(fd, vecs, numVecs);
+// NOTE: Entries reference the format, arguments and scratch, which must remain valid until written. No terminator is output.
+fsInt FormatStringFIoVec(FormatIoVec* a_vecs, fsInt a_maxVecs, fsChar* a_scratch, size_t a_scratchSize,
+                         const CompiledFormat& a_compiled, ArgList& a_args, size_t* a_totalLength = NULL);
+fsInt FormatStringFIoVec(FormatIoVec* a_vecs, fsInt a_maxVecs, fsChar* a_scratch, size_t a_scratchSize,
+                         const fsChar* a_fmt, ArgList& a_args, size_t* a_totalLength = NULL);
+
 END_NAMESPACE_FORMATSTRINGLIB
 
 #endif //FORMATSTRINGF_H
\ No newline at end of file
@@ -0,0 +1,585 @@
+//
+// FormatTelemetry.cpp
+// Opt-in per format string counters and latency histograms for FormatString, FormatStringF and ScanStringF
+//
+
+#include <algorithm>
+#include <chrono>
+#include <mutex>
+#include <string.h>
+#include <vector>
+#include "FormatTelemetry.h"
+#include "FormatStringF.h"
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif // _MSC_VER
+
+BEGIN_NAMESPACE_FORMATSTRINGLIB
+
+enum
+{
+  MAX_PROBES = 16,                                // Entries tried before a call is dropped
+  MAX_ESCAPED_TEXT = FormatTelemetry::MAX_TEXT * 6, // Format text escaped for JSON, \u00XX for each byte
+};
+
+// Counts of one format in one thread's table. Only the owning thread writes, counters are atomic
+// so Collect() may read them at any time, updated by load and store rather than read-modify-write.
+struct TelemetryEntry
+{
+  std::atomic<const fsChar*> m_format;            // Key, NULL if empty. Set once, after m_function and m_text.
+  fsInt32 m_function;
+  fsChar m_text[FormatTelemetry::MAX_TEXT];
+  std::atomic<fsUInt64> m_calls;
+  std::atomic<fsUInt64> m_bytes;
+  std::atomic<fsUInt64> m_truncations;
+  std::atomic<fsUInt64> m_scanFailures;
+  std::atomic<fsUInt64> m_totalNanoseconds;
+  std::atomic<fsUInt64> m_maxNanoseconds;
+  std::atomic<fsUInt32> m_histogram[FormatTelemetry::HISTOGRAM_BUCKETS];
+};
+
+// One thread's table, on a list of all tables that is only ever added to
+struct TelemetryShard
+{
+  TelemetryEntry* m_entries;
+  fsUInt64 m_mask;                                // Number of entries - 1
+  std::atomic<fsUInt64> m_epoch;                  // Clear() count when last zeroed, stale tables are not collected
+  std::atomic<fsUInt64> m_dropped;
+  std::atomic<bool> m_owned;                      // In use by a thread
+  TelemetryShard* m_next;
+};
+
+// Table of the calling thread, released for reuse when the thread exits
+struct TelemetryOwner
+{
+  TelemetryShard* m_shard;
+  fsBool m_suspended;                             // Set while reporting, so the report's own formatting is not counted
+
+  TelemetryOwner() : m_shard(NULL), m_suspended(false) {}
+  ~TelemetryOwner()
+  {
+    if( m_shard != NULL )
+    {
+      m_shard->m_owned.store(false, std::memory_order_release);
+    }
+  }
+};
+
+std::atomic<bool> FormatTelemetry::s_enabled(false);
+static std::atomic<fsInt> s_capacity(0);          // Entries per table, set by the first Enable()
+static std::atomic<fsUInt64> s_epoch(0);          // Incremented by Clear()
+static std::atomic<TelemetryShard*> s_shards(NULL);
+static thread_local TelemetryOwner t_owner;
+
+static const fsChar* const s_functionNames[] = { "FormatString", "FormatStringF", "ScanStringF" };
+
+
+// Add to a counter only this thread writes
+template <class TYPE>
+static inline void add_relaxed(std::atomic<TYPE>& a_counter, TYPE a_value)
+{
+  a_counter.store(a_counter.load(std::memory_order_relaxed) + a_value, std::memory_order_relaxed);
+}
+
+
+// Table index from the format pointer
+static fsUInt64 pointer_hash(const fsChar* a_format, fsInt a_function)
+{
+  fsUInt64 key = ((fsUInt64)(size_t)a_format ^ (fsUInt64)a_function) * 0x9E3779B97F4A7C15ULL;
+  return key ^ (key >> 32);
+}
+
+
+// Index of the highest set bit, a_value not 0
+static inline fsInt highest_bit(fsUInt64 a_value)
+{
+#if defined(_MSC_VER)
+  unsigned long index;
+  _BitScanReverse64(&index, a_value);
+  return (fsInt)index;
+#else
+  return 63 - __builtin_clzll(a_value);
+#endif
+}
+
+
+static void zero_entry_counts(TelemetryEntry& a_entry)
+{
+  a_entry.m_calls.store(0, std::memory_order_relaxed);
+  a_entry.m_bytes.store(0, std::memory_order_relaxed);
+  a_entry.m_truncations.store(0, std::memory_order_relaxed);
+  a_entry.m_scanFailures.store(0, std::memory_order_relaxed);
+  a_entry.m_totalNanoseconds.store(0, std::memory_order_relaxed);
+  a_entry.m_maxNanoseconds.store(0, std::memory_order_relaxed);
+  for( fsInt bucket = 0; bucket < FormatTelemetry::HISTOGRAM_BUCKETS; ++bucket )
+  {
+    a_entry.m_histogram[bucket].store(0, std::memory_order_relaxed);
+  }
+}
+
+
+// Take over the table of an exited thread, or add a new one. Returns NULL if never enabled.
+static TelemetryShard* acquire_shard()
+{
+  fsInt capacity = s_capacity.load(std::memory_order_acquire);
+  if( capacity == 0 )
+  {
+    return NULL;
+  }
+
+  for( TelemetryShard* shard = s_shards.load(std::memory_order_acquire); shard != NULL; shard = shard->m_next )
+  {
+    bool owned = false;
+    if( !shard->m_owned.load(std::memory_order_relaxed) && shard->m_owned.compare_exchange_strong(owned, true, std::memory_order_acquire) )
+    {
+      return shard;
+    }
+  }
+
+  TelemetryShard* shard = new TelemetryShard;
+  shard->m_entries = new TelemetryEntry[capacity];
+  shard->m_mask = (fsUInt64)capacity - 1;
+  for( fsInt index = 0; index < capacity; ++index )
+  {
+    TelemetryEntry& entry = shard->m_entries[index];
+    entry.m_format.store(NULL, std::memory_order_relaxed);
+    entry.m_function = 0;
+    entry.m_text[0] = 0;
+    zero_entry_counts(entry);
+  }
+  shard->m_epoch.store(s_epoch.load(std::memory_order_relaxed), std::memory_order_relaxed);
+  shard->m_dropped.store(0, std::memory_order_relaxed);
+  shard->m_owned.store(true, std::memory_order_relaxed);
+
+  // Publish, the entries are initialised before any collector can reach the table
+  TelemetryShard* head = s_shards.load(std::memory_order_relaxed);
+  do
+  {
+    shard->m_next = head;
+  } while( !s_shards.compare_exchange_weak(head, shard, std::memory_order_release, std::memory_order_relaxed) );
+  return shard;
+}
+
+
+// Entry for a format in this thread's table, added on first use. Returns NULL if the table is full around its slot.
+static TelemetryEntry* find_entry(TelemetryShard* a_shard, const fsChar* a_format, fsInt a_function)
+{
+  fsUInt64 index = pointer_hash(a_format, a_function);
+  for( fsInt probe = 0; probe < MAX_PROBES; ++probe, ++index )
+  {
+    TelemetryEntry& entry = a_shard->m_entries[index & a_shard->m_mask];
+    const fsChar* format = entry.m_format.load(std::memory_order_relaxed);
+    if( (format == a_format) && (entry.m_function == a_function) )
+    {
+      return &entry;
+    }
+    if( format == NULL )
+    {
+      entry.m_function = a_function;
+      strncpy(entry.m_text, a_format, FormatTelemetry::MAX_TEXT - 1);
+      entry.m_text[FormatTelemetry::MAX_TEXT - 1] = 0;
+      entry.m_format.store(a_format, std::memory_order_release);
+      return &entry;
+    }
+  }
+  return NULL;
+}
+
+
+// Add a shard's entries into a_stats, merged by format through a_slots (indices + 1 into a_stats, 0 if empty)
+static void collect_shard(TelemetryShard* a_shard, std::vector<FormatTelemetry::Stats>& a_stats, std::vector<fsInt>& a_slots)
+{
+  for( fsUInt64 index = 0; index <= a_shard->m_mask; ++index )
+  {
+    TelemetryEntry& entry = a_shard->m_entries[index];
+    const fsChar* format = entry.m_format.load(std::memory_order_acquire);
+    fsUInt64 calls = entry.m_calls.load(std::memory_order_relaxed);
+    if( (format == NULL) || (calls == 0) )
+    {
+      continue;
+    }
+
+    fsUInt64 slotMask = a_slots.size() - 1;
+    fsUInt64 slot = pointer_hash(format, entry.m_function) & slotMask;
+    while( (a_slots[slot] != 0) &&
+           ((a_stats[a_slots[slot] - 1].m_format != format) || (a_stats[a_slots[slot] - 1].m_function != entry.m_function)) )
+    {
+      slot = (slot + 1) & slotMask;
+    }
+    if( a_slots[slot] == 0 )
+    {
+      a_stats.push_back(FormatTelemetry::Stats());
+      FormatTelemetry::Stats& added = a_stats.back();
+      memset(&added, 0, sizeof(added));
+      added.m_format = format;
+      added.m_function = entry.m_function;
+      memcpy(added.m_text, entry.m_text, sizeof(added.m_text));
+      a_slots[slot] = (fsInt)a_stats.size();
+    }
+
+    FormatTelemetry::Stats& stats = a_stats[a_slots[slot] - 1];
+    stats.m_calls += calls;
+    stats.m_bytes += entry.m_bytes.load(std::memory_order_relaxed);
+    stats.m_truncations += entry.m_truncations.load(std::memory_order_relaxed);
+    stats.m_scanFailures += entry.m_scanFailures.load(std::memory_order_relaxed);
+    stats.m_totalNanoseconds += entry.m_totalNanoseconds.load(std::memory_order_relaxed);
+    stats.m_maxNanoseconds = std::max(stats.m_maxNanoseconds, entry.m_maxNanoseconds.load(std::memory_order_relaxed));
+    for( fsInt bucket = 0; bucket < FormatTelemetry::HISTOGRAM_BUCKETS; ++bucket )
+    {
+      stats.m_histogram[bucket] += entry.m_histogram[bucket].load(std::memory_order_relaxed);
+    }
+  }
+}
+
+
+static bool more_total_time(const FormatTelemetry::Stats* a_first, const FormatTelemetry::Stats* a_second)
+{
+  return a_first->m_totalNanoseconds > a_second->m_totalNanoseconds;
+}
+
+
+// Sum of all current tables, most total time first
+static void collect_all(std::vector<FormatTelemetry::Stats>& a_stats, std::vector<const FormatTelemetry::Stats*>& a_sorted)
+{
+  fsUInt64 epoch = s_epoch.load(std::memory_order_relaxed);
+  size_t numEntries = 0;
+  TelemetryShard* shards = s_shards.load(std::memory_order_acquire);
+  for( TelemetryShard* shard = shards; shard != NULL; shard = shard->m_next )
+  {
+    numEntries += (size_t)shard->m_mask + 1;
+  }
+
+  size_t numSlots = 16;
+  while( numSlots < numEntries * 2 )
+  {
+    numSlots <<= 1;
+  }
+  std::vector<fsInt> slots(numSlots, 0);
+  for( TelemetryShard* shard = shards; shard != NULL; shard = shard->m_next )
+  {
+    if( shard->m_epoch.load(std::memory_order_acquire) == epoch )
+    {
+      collect_shard(shard, a_stats, slots);
+    }
+  }
+
+  a_sorted.resize(a_stats.size());
+  for( size_t index = 0; index < a_stats.size(); ++index )
+  {
+    a_sorted[index] = &a_stats[index];
+  }
+  std::sort(a_sorted.begin(), a_sorted.end(), more_total_time);
+}
+
+
+// Appends to a report buffer, measuring the full length once the buffer is full
+struct ReportWriter
+{
+  fsChar* m_str;
+  size_t m_count;
+  fsInt m_length;
+
+  ReportWriter(fsChar* a_str, size_t a_count) : m_str(a_str), m_count(a_count), m_length(0)
+  {
+    if( (m_str != NULL) && (m_count > 0) )
+    {
+      m_str[0] = 0;
+    }
+  }
+
+  void Add(const fsChar* a_fmt, ArgList& a_args)
+  {
+    if( (m_str != NULL) && ((size_t)m_length < m_count) )
+    {
+      m_length += FormatStringF(m_str + m_length, m_count - m_length, a_fmt, a_args);
+    }
+    else
+    {
+      m_length += FormatStringF(NULL, 0, a_fmt, a_args);
+    }
+  }
+};
+
+
+// Copy a_text with JSON escapes
+static void json_escape(fsChar* a_dest, const fsChar* a_text)
+{
+  static const fsChar s_hex[] = "0123456789abcdef";
+  for( ; *a_text; ++a_text )
+  {
+    fsUInt8 ch = (fsUInt8)*a_text;
+    if( (ch == '"') || (ch == '\\') )
+    {
+      *a_dest++ = '\\';
+      *a_dest++ = (fsChar)ch;
+    }
+    else if( ch < 0x20 )
+    {
+      memcpy(a_dest, "\\u00", 4);
+      a_dest[4] = s_hex[ch >> 4];
+      a_dest[5] = s_hex[ch & 15];
+      a_dest += 6;
+    }
+    else
+    {
+      *a_dest++ = (fsChar)ch;
+    }
+  }
+  *a_dest = 0;
+}
+
+
+// Copy a_text with control chars replaced by '.', to keep a report row on one line
+static void text_escape(fsChar* a_dest, const fsChar* a_text)
+{
+  for( ; *a_text; ++a_text )
+  {
+    *a_dest++ = ((fsUInt8)*a_text < 0x20) ? '.' : *a_text;
+  }
+  *a_dest = 0;
+}
+
+
+fsUInt64 FormatTelemetry::Stats::Percentile(fsFloat64 a_fraction) const
+{
+  fsUInt64 target = (fsUInt64)(a_fraction * (fsFloat64)m_calls + 0.5);
+  if( target == 0 )
+  {
+    target = 1;
+  }
+  fsUInt64 count = 0;
+  for( fsInt bucket = 0; bucket < HISTOGRAM_BUCKETS; ++bucket )
+  {
+    count += m_histogram[bucket];
+    if( count >= target )
+    {
+      return std::min(BucketUpperBound(bucket), m_maxNanoseconds);
+    }
+  }
+  return m_maxNanoseconds;
+}
+
+
+void FormatTelemetry::Enable(fsInt a_capacity)
+{
+  fsInt capacity = 1;
+  while( capacity < ((a_capacity > 0) ? a_capacity : (fsInt)DEFAULT_CAPACITY) )
+  {
+    capacity <<= 1;
+  }
+  fsInt unset = 0;
+  s_capacity.compare_exchange_strong(unset, capacity, std::memory_order_release);
+  s_enabled.store(true, std::memory_order_release);
+}
+
+
+void FormatTelemetry::Disable()
+{
+  s_enabled.store(false, std::memory_order_relaxed);
+}
+
+
+void FormatTelemetry::Clear()
+{
+  s_epoch.fetch_add(1, std::memory_order_relaxed);
+}
+
+
+fsInt FormatTelemetry::Collect(Stats* a_stats, fsInt a_maxStats)
+{
+  std::vector<Stats> stats;
+  std::vector<const Stats*> sorted;
+  collect_all(stats, sorted);
+  for( fsInt index = 0; (index < a_maxStats) && ((size_t)index < sorted.size()); ++index )
+  {
+    a_stats[index] = *sorted[index];
+  }
+  return (fsInt)sorted.size();
+}
+
+
+fsUInt64 FormatTelemetry::GetDropped()
+{
+  fsUInt64 epoch = s_epoch.load(std::memory_order_relaxed);
+  fsUInt64 dropped = 0;
+  for( TelemetryShard* shard = s_shards.load(std::memory_order_acquire); shard != NULL; shard = shard->m_next )
+  {
+    if( shard->m_epoch.load(std::memory_order_acquire) == epoch )
+    {
+      dropped += shard->m_dropped.load(std::memory_order_relaxed);
+    }
+  }
+  return dropped;
+}
+
+
+fsInt FormatTelemetry::DumpText(fsChar* a_str, size_t a_count)
+{
+  fsBool suspended = t_owner.m_suspended;
+  t_owner.m_suspended = true;
+  std::vector<Stats> stats;
+  std::vector<const Stats*> sorted;
+  collect_all(stats, sorted);
+
+  ReportWriter writer(a_str, a_count);
+  ArgListFixed header;
+  writer.Add("         Calls          Bytes  Truncated     Failed     Total ms     p50 ns     p90 ns     p99 ns     Max ns  Function       Format\n", header);
+  for( size_t index = 0; index < sorted.size(); ++index )
+  {
+    const Stats& entry = *sorted[index];
+    fsChar text[MAX_TEXT];
+    text_escape(text, entry.m_text);
+    ArgListFixed counts(entry.m_calls, entry.m_bytes, entry.m_truncations, entry.m_scanFailures, (fsFloat64)entry.m_totalNanoseconds / 1000000.0);
+    writer.Add("%14u %14u %10u %10u %12.3f ", counts);
+    ArgListFixed times(entry.Percentile(0.5), entry.Percentile(0.9), entry.Percentile(0.99), entry.m_maxNanoseconds, s_functionNames[entry.m_function], text);
+    writer.Add("%10u %10u %10u %10u  %-14s \"%s\"\n", times);
+  }
+  ArgListFixed dropped(GetDropped());
+  writer.Add("Dropped calls: %u\n", dropped);
+
+  t_owner.m_suspended = suspended;
+  return writer.m_length;
+}
+
+
+fsInt FormatTelemetry::DumpJson(fsChar* a_str, size_t a_count)
+{
+  fsBool suspended = t_owner.m_suspended;
+  t_owner.m_suspended = true;
+  std::vector<Stats> stats;
+  std::vector<const Stats*> sorted;
+  collect_all(stats, sorted);
+
+  ReportWriter writer(a_str, a_count);
+  ArgListFixed dropped(GetDropped());
+  writer.Add("{\"dropped\":%u,\"formats\":[", dropped);
+  for( size_t index = 0; index < sorted.size(); ++index )
+  {
+    const Stats& entry = *sorted[index];
+    fsChar text[MAX_ESCAPED_TEXT];
+    json_escape(text, entry.m_text);
+    ArgListFixed names((index > 0) ? "," : "", s_functionNames[entry.m_function], text);
+    writer.Add("%s\n{\"function\":\"%s\",\"format\":\"%s\",", names);
+    ArgListFixed counts(entry.m_calls, entry.m_bytes, entry.m_truncations, entry.m_scanFailures, entry.m_totalNanoseconds, entry.m_maxNanoseconds);
+    writer.Add("\"calls\":%u,\"bytes\":%u,\"truncations\":%u,\"scan_failures\":%u,\"total_ns\":%u,\"max_ns\":%u,", counts);
+    ArgListFixed times(entry.Percentile(0.5), entry.Percentile(0.9), entry.Percentile(0.99));
+    writer.Add("\"p50_ns\":%u,\"p90_ns\":%u,\"p99_ns\":%u,\"histogram\":[", times);
+
+    // Non-empty buckets as [upper bound ns, count]
+    fsBool first = true;
+    for( fsInt bucket = 0; bucket < HISTOGRAM_BUCKETS; ++bucket )
+    {
+      if( entry.m_histogram[bucket] != 0 )
+      {
+        ArgListFixed pair(first ? "" : ",", BucketUpperBound(bucket), entry.m_histogram[bucket]);
+        writer.Add("%s[%u,%u]", pair);
+        first = false;
+      }
+    }
+    ArgListFixed none;
+    writer.Add("]}", none);
+  }
+  ArgListFixed none;
+  writer.Add("\n]}\n", none);
+
+  t_owner.m_suspended = suspended;
+  return writer.m_length;
+}
+
+
+fsInt FormatTelemetry::BucketIndex(fsUInt64 a_nanoseconds)
+{
+  const fsUInt64 SUB_BUCKETS = 1 << HISTOGRAM_SUB_BITS;
+  if( a_nanoseconds < SUB_BUCKETS )
+  {
+    return (fsInt)a_nanoseconds;
+  }
+  if( a_nanoseconds > 0xFFFFFFFFULL )
+  {
+    return HISTOGRAM_BUCKETS - 1;
+  }
+  fsInt shift = highest_bit(a_nanoseconds) - HISTOGRAM_SUB_BITS;
+  return (shift + 1) * (fsInt)SUB_BUCKETS + (fsInt)((a_nanoseconds >> shift) & (SUB_BUCKETS - 1));
+}
+
+
+fsUInt64 FormatTelemetry::BucketUpperBound(fsInt a_bucket)
+{
+  const fsInt SUB_BUCKETS = 1 << HISTOGRAM_SUB_BITS;
+  if( a_bucket < SUB_BUCKETS )
+  {
+    return (fsUInt64)a_bucket;
+  }
+  fsInt shift = a_bucket / SUB_BUCKETS - 1;
+  fsUInt64 lower = (fsUInt64)(SUB_BUCKETS + a_bucket % SUB_BUCKETS) << shift;
+  return lower + ((fsUInt64)1 << shift) - 1;
+}
+
+
+fsUInt64 FormatTelemetry::Now()
+{
+  return (fsUInt64)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+
+void FormatTelemetry::Record(const fsChar* a_format, fsInt a_function, fsUInt64 a_start, fsInt64 a_bytes, fsBool a_truncated, fsBool a_failed)
+{
+  fsUInt64 elapsed = Now() - a_start;
+  if( t_owner.m_suspended || (a_format == NULL) )
+  {
+    return;
+  }
+
+  TelemetryShard* shard = t_owner.m_shard;
+  if( shard == NULL )
+  {
+    shard = acquire_shard();
+    if( shard == NULL )
+    {
+      return;
+    }
+    t_owner.m_shard = shard;
+  }
+
+  // Zero this thread's counts after a Clear(), then mark the table current for collectors
+  fsUInt64 epoch = s_epoch.load(std::memory_order_relaxed);
+  if( shard->m_epoch.load(std::memory_order_relaxed) != epoch )
+  {
+    for( fsUInt64 index = 0; index <= shard->m_mask; ++index )
+    {
+      zero_entry_counts(shard->m_entries[index]);
+    }
+    shard->m_dropped.store(0, std::memory_order_relaxed);
+    shard->m_epoch.store(epoch, std::memory_order_release);
+  }
+
+  TelemetryEntry* entry = find_entry(shard, a_format, a_function);
+  if( entry == NULL )
+  {
+    add_relaxed<fsUInt64>(shard->m_dropped, 1);
+    return;
+  }
+
+  add_relaxed<fsUInt64>(entry->m_calls, 1);
+  if( a_bytes > 0 )
+  {
+    add_relaxed<fsUInt64>(entry->m_bytes, (fsUInt64)a_bytes);
+  }
+  if( a_truncated )
+  {
+    add_relaxed<fsUInt64>(entry->m_truncations, 1);
+  }
+  if( a_failed )
+  {
+    add_relaxed<fsUInt64>(entry->m_scanFailures, 1);
+  }
+  add_relaxed<fsUInt64>(entry->m_totalNanoseconds, elapsed);
+  if( elapsed > entry->m_maxNanoseconds.load(std::memory_order_relaxed) )
+  {
+    entry->m_maxNanoseconds.store(elapsed, std::memory_order_relaxed);
+  }
+  add_relaxed<fsUInt32>(entry->m_histogram[BucketIndex(elapsed)], 1);
+}
+
+END_NAMESPACE_FORMATSTRINGLIB
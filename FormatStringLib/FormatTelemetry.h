@@ -0,0 +1,119 @@
+#ifndef FORMATTELEMETRY_H
+#define FORMATTELEMETRY_H
+
+//
+// FormatTelemetry.h
+// Opt-in per format string counters and latency histograms for FormatString, FormatStringF and ScanStringF
+//
+
+#include <atomic>
+#include <stddef.h>
+#include "Utils.h"
+
+// Instrument FormatString(), FormatStringF() and ScanStringF().
+// When 1 each call tests FormatTelemetry::IsEnabled() (a relaxed load), define as 0 to compile the test out.
+#ifndef FS_TELEMETRY
+#define FS_TELEMETRY 1
+#endif // FS_TELEMETRY
+
+//
+// When enabled, each call of FormatString() and FormatStringF() (and their Length and compiled format
+// overloads) and ScanStringF() is counted against its format string pointer:
+//   calls, output bytes (the length returned), truncations (output longer than the buffer),
+//   scan failures (EOF or fewer conversions than arguments), total and maximum call time, and a
+//   latency histogram of 8 buckets per power of two nanoseconds (values within 12.5%, as HdrHistogram).
+//
+// Each thread counts into its own table, written only by that thread with no locks or atomic read-modify-writes.
+// Collect() and the Dump functions add up the tables of all threads on demand. The table of a thread that
+// exits is kept (with its counts) and taken over by the next new thread.
+//
+// Eg. FormatTelemetry::Enable(); // Once at startup
+//     ...
+//     fsChar report[16384];
+//     FormatTelemetry::DumpText(report, sizeof(report)); // Formats using the most time first
+//
+// Formats are identified by pointer like FormatCache, the first MAX_TEXT - 1 bytes of the text are copied on a
+// thread's first call for reports. Calls for formats beyond a thread's capacity are counted by GetDropped() only.
+//
+// NOTE: Disabled by default. Stream, IoVec and Batch formatting are not counted.
+//
+
+BEGIN_NAMESPACE_FORMATSTRINGLIB
+
+class FormatTelemetry
+{
+public:
+
+  enum
+  {
+    DEFAULT_CAPACITY = 256,                       // Formats per thread
+    MAX_TEXT = 48,                                // Format text kept for reports, including terminator
+    HISTOGRAM_SUB_BITS = 3,                       // 8 buckets per power of two
+    HISTOGRAM_BUCKETS = 240,                      // 0 to 2^32 - 1 nanoseconds, longer calls count in the last bucket
+  };
+
+  enum Function
+  {
+    FUNCTION_FORMAT_STRING,
+    FUNCTION_FORMAT_STRING_F,
+    FUNCTION_SCAN_STRING_F,
+  };
+
+  // Counts of one format, summed over all threads
+  struct Stats
+  {
+    const fsChar* m_format;                       // Key, may no longer point to the format
+    fsInt m_function;                             // Function
+    fsChar m_text[MAX_TEXT];                      // Start of the format text
+    fsUInt64 m_calls;
+    fsUInt64 m_bytes;                             // Output bytes of format calls
+    fsUInt64 m_truncations;
+    fsUInt64 m_scanFailures;
+    fsUInt64 m_totalNanoseconds;
+    fsUInt64 m_maxNanoseconds;
+    fsUInt64 m_histogram[HISTOGRAM_BUCKETS];
+
+    // Nanoseconds within which a_fraction (0 to 1) of the calls completed, the upper bound of its bucket
+    fsUInt64 Percentile(fsFloat64 a_fraction) const;
+  };
+
+  // Start counting. The first call sets each thread's capacity (rounded up to a power of two),
+  // tables are kept for the life of the process so Collect() never sees them freed.
+  static void Enable(fsInt a_capacity = DEFAULT_CAPACITY);
+
+  // Stop counting, counts are kept
+  static void Disable();
+
+  static fsBool IsEnabled()                       { return s_enabled.load(std::memory_order_relaxed); }
+
+  // Zero all counts. Each thread zeroes its own table on its next call, until then its counts are not collected.
+  static void Clear();
+
+  // Copy the counts of up to a_maxStats formats into a_stats, most total time first.
+  // Returns the number of formats with counts, which may be more than a_maxStats.
+  static fsInt Collect(Stats* a_stats, fsInt a_maxStats);
+
+  // Calls not counted because a thread's table was full
+  static fsUInt64 GetDropped();
+
+  // Write all counts as a text table or a JSON array, terminated and truncated to fit.
+  // Returns the length of the full report (as FormatString, call with NULL, 0 for the size).
+  static fsInt DumpText(fsChar* a_str, size_t a_count);
+  static fsInt DumpJson(fsChar* a_str, size_t a_count);
+
+  // Histogram bucket of a call time and the largest time in a bucket
+  static fsInt BucketIndex(fsUInt64 a_nanoseconds);
+  static fsUInt64 BucketUpperBound(fsInt a_bucket);
+
+  // Used by the instrumented functions, a_start from Now()
+  static fsUInt64 Now();
+  static void Record(const fsChar* a_format, fsInt a_function, fsUInt64 a_start, fsInt64 a_bytes, fsBool a_truncated, fsBool a_failed);
+
+protected:
+
+  static std::atomic<bool> s_enabled;
+};
+
+END_NAMESPACE_FORMATSTRINGLIB
+
+#endif //FORMATTELEMETRY_H
@@ -0,0 +1,289 @@
+//
+// MappedFile.cpp
+// Minimal memory-mapped file wrapper
+//
+
+#ifdef _WIN32
+#include <windows.h>
+#else // _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif // _WIN32
+
+#include "MappedFile.h"
+
+BEGIN_NAMESPACE_FORMATSTRINGLIB
+
+MappedFile::MappedFile()
+{
+  m_data = NULL;
+  m_size = 0;
+  m_isOpen = false;
+  m_writable = false;
+#ifdef _WIN32
+  m_file = INVALID_HANDLE_VALUE;
+  m_mapping = NULL;
+#else // _WIN32
+  m_fd = -1;
+#endif // _WIN32
+}
+
+
+MappedFile::~MappedFile()
+{
+  Close();
+}
+
+
+#ifdef _WIN32
+
+fsBool MappedFile::OpenRead(const fsChar* a_path)
+{
+  Close();
+
+  m_file = CreateFileA(a_path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+  if( m_file == INVALID_HANDLE_VALUE )
+  {
+    return false;
+  }
+  LARGE_INTEGER fileSize;
+  if( !GetFileSizeEx((HANDLE)m_file, &fileSize) )
+  {
+    Close();
+    return false;
+  }
+  m_isOpen = true;
+  m_writable = false;
+  m_size = (size_t)fileSize.QuadPart;
+  if( !InternalMap() )
+  {
+    Close();
+    return false;
+  }
+  return true;
+}
+
+
+fsBool MappedFile::OpenWrite(const fsChar* a_path, size_t a_size)
+{
+  Close();
+
+  m_file = CreateFileA(a_path, GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+  if( m_file == INVALID_HANDLE_VALUE )
+  {
+    return false;
+  }
+  m_isOpen = true;
+  m_writable = true;
+  if( !Resize(a_size) )
+  {
+    Close();
+    return false;
+  }
+  return true;
+}
+
+
+fsBool MappedFile::Resize(size_t a_size)
+{
+  FS_ASSERT(m_isOpen && m_writable);
+  if( !m_isOpen || !m_writable )
+  {
+    return false;
+  }
+
+  InternalUnmap();
+
+  size_t oldSize = m_size;
+  LARGE_INTEGER newSize;
+  newSize.QuadPart = (LONGLONG)a_size;
+  if( SetFilePointerEx((HANDLE)m_file, newSize, NULL, FILE_BEGIN) && SetEndOfFile((HANDLE)m_file) )
+  {
+    m_size = a_size;
+    if( InternalMap() )
+    {
+      return true;
+    }
+    InternalUnmap();
+    newSize.QuadPart = (LONGLONG)oldSize;
+    if( !SetFilePointerEx((HANDLE)m_file, newSize, NULL, FILE_BEGIN) || !SetEndOfFile((HANDLE)m_file) )
+    {
+      return false; // Left unmapped
+    }
+  }
+
+  // Map the old size again, so data up to it stays readable and writable
+  m_size = oldSize;
+  InternalMap();
+  return false;
+}
+
+
+void MappedFile::Close()
+{
+  InternalUnmap();
+  if( m_file != INVALID_HANDLE_VALUE )
+  {
+    CloseHandle((HANDLE)m_file);
+    m_file = INVALID_HANDLE_VALUE;
+  }
+  m_size = 0;
+  m_isOpen = false;
+  m_writable = false;
+}
+
+
+fsBool MappedFile::InternalMap()
+{
+  if( m_size == 0 )
+  {
+    return true; // Nothing to map, empty files are valid
+  }
+  m_mapping = CreateFileMappingA((HANDLE)m_file, NULL, m_writable ? PAGE_READWRITE : PAGE_READONLY, 0, 0, NULL);
+  if( m_mapping == NULL )
+  {
+    return false;
+  }
+  m_data = (fsUInt8*)MapViewOfFile((HANDLE)m_mapping, m_writable ? FILE_MAP_WRITE : FILE_MAP_READ, 0, 0, m_size);
+  return (m_data != NULL);
+}
+
+
+void MappedFile::InternalUnmap()
+{
+  if( m_data != NULL )
+  {
+    UnmapViewOfFile(m_data);
+    m_data = NULL;
+  }
+  if( m_mapping != NULL )
+  {
+    CloseHandle((HANDLE)m_mapping);
+    m_mapping = NULL;
+  }
+}
+
+#else // _WIN32
+
+fsBool MappedFile::OpenRead(const fsChar* a_path)
+{
+  Close();
+
+  m_fd = open(a_path, O_RDONLY);
+  if( m_fd < 0 )
+  {
+    return false;
+  }
+  struct stat fileStat;
+  if( fstat(m_fd, &fileStat) != 0 )
+  {
+    Close();
+    return false;
+  }
+  m_isOpen = true;
+  m_writable = false;
+  m_size = (size_t)fileStat.st_size;
+  if( !InternalMap() )
+  {
+    Close();
+    return false;
+  }
+  return true;
+}
+
+
+fsBool MappedFile::OpenWrite(const fsChar* a_path, size_t a_size)
+{
+  Close();
+
+  m_fd = open(a_path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+  if( m_fd < 0 )
+  {
+    return false;
+  }
+  m_isOpen = true;
+  m_writable = true;
+  if( !Resize(a_size) )
+  {
+    Close();
+    return false;
+  }
+  return true;
+}
+
+
+fsBool MappedFile::Resize(size_t a_size)
+{
+  FS_ASSERT(m_isOpen && m_writable);
+  if( !m_isOpen || !m_writable )
+  {
+    return false;
+  }
+
+  InternalUnmap();
+
+  size_t oldSize = m_size;
+  if( ftruncate(m_fd, (off_t)a_size) == 0 )
+  {
+    m_size = a_size;
+    if( InternalMap() )
+    {
+      return true;
+    }
+    if( ftruncate(m_fd, (off_t)oldSize) != 0 )
+    {
+      return false; // Left unmapped
+    }
+  }
+
+  // Map the old size again, so data up to it stays readable and writable
+  m_size = oldSize;
+  InternalMap();
+  return false;
+}
+
+
+void MappedFile::Close()
+{
+  InternalUnmap();
+  if( m_fd >= 0 )
+  {
+    close(m_fd);
+    m_fd = -1;
+  }
+  m_size = 0;
+  m_isOpen = false;
+  m_writable = false;
+}
+
+
+fsBool MappedFile::InternalMap()
+{
+  if( m_size == 0 )
+  {
+    return true; // Nothing to map, empty files are valid
+  }
+  void* data = mmap(NULL, m_size, m_writable ? (PROT_READ | PROT_WRITE) : PROT_READ, MAP_SHARED, m_fd, 0);
+  if( data == MAP_FAILED )
+  {
+    return false;
+  }
+  m_data = (fsUInt8*)data;
+  return true;
+}
+
+
+void MappedFile::InternalUnmap()
+{
+  if( m_data != NULL )
+  {
+    munmap(m_data, m_size);
+    m_data = NULL;
+  }
+}
+
+#endif // _WIN32
+
+END_NAMESPACE_FORMATSTRINGLIB
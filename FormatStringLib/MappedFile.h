@@ -0,0 +1,67 @@
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+//
+// MappedFile.h
+// Minimal memory-mapped file wrapper used by the binary log and export modules
+//
+// Use at your own risk, please observe any replicated copyright notices in other modules.
+//
+
+#include <stddef.h>
+#include "Utils.h"
+
+BEGIN_NAMESPACE_FORMATSTRINGLIB
+
+// Map a whole file into memory, either read-only or read-write.
+// Note, not designed for reentrant use.
+class MappedFile
+{
+public:
+
+  MappedFile();
+  ~MappedFile();
+
+  // Map an existing file read-only.  Returns true if succeeded.
+  fsBool OpenRead(const fsChar* a_path);
+
+  // Create (or truncate) a file of the given size and map it read-write.  Returns true if succeeded.
+  fsBool OpenWrite(const fsChar* a_path, size_t a_size);
+
+  // Change size of a file opened for writing, content up to the smaller size is preserved.
+  // If it fails the old size is mapped again where possible, else GetData() is NULL.
+  // NOTE: Mapping address may change, also when it fails.
+  fsBool Resize(size_t a_size);
+
+  // Unmap and close the file
+  void Close();
+
+  fsBool IsOpen() const                           { return m_isOpen; }
+  fsUInt8* GetData()                              { return m_data; }
+  const fsUInt8* GetData() const                  { return m_data; }
+  size_t GetSize() const                          { return m_size; }
+
+protected:
+
+  fsUInt8* m_data;                                // Mapped view, NULL if not mapped
+  size_t m_size;                                  // Size of mapped view in bytes
+  fsBool m_isOpen;                                // File handle valid
+  fsBool m_writable;                              // Opened with OpenWrite()
+#ifdef _WIN32
+  void* m_file;                                   // HANDLE of file
+  void* m_mapping;                                // HANDLE of file mapping object
+#else // _WIN32
+  int m_fd;                                       // File descriptor
+#endif // _WIN32
+
+  fsBool InternalMap();
+  void InternalUnmap();
+
+private:
+  MappedFile(const MappedFile&);                  // Not copyable
+  MappedFile& operator=(const MappedFile&);
+};
+
+END_NAMESPACE_FORMATSTRINGLIB
+
+#endif //MAPPEDFILE_H
@@ -0,0 +1,1186 @@
+//
+// NumberFormat.cpp
+// Number formatting profile and grouped digit writer
+//
+
+#include <string.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#include "NumberFormat.h"
+#include "Utf8.h"
+
+BEGIN_NAMESPACE_FORMATSTRINGLIB
+
+const fsChar NumberFormat::s_digitPairs[201] =
+  "00010203040506070809"
+  "10111213141516171819"
+  "20212223242526272829"
+  "30313233343536373839"
+  "40414243444546474849"
+  "50515253545556575859"
+  "60616263646566676869"
+  "70717273747576777879"
+  "80818283848586878889"
+  "90919293949596979899";
+
+const NumberFormatProfile NumberFormat::s_defaultProfile;
+const NumberFormatProfile* NumberFormat::s_profile = &NumberFormat::s_defaultProfile;
+
+
+// Copy symbol, returns length in bytes
+static fsUInt8 copy_symbol(fsChar* a_dest, const fsChar* a_source)
+{
+  size_t length = a_source ? strlen(a_source) : 0;
+  if( length > NumberFormatProfile::MAX_SYMBOL - 1 )
+  {
+    length = NumberFormatProfile::MAX_SYMBOL - 1;
+  }
+  memcpy(a_dest, a_source, length);
+  a_dest[length] = 0;
+  return (fsUInt8)length;
+}
+
+
+static fsUInt8 symbol_width(const fsChar* a_symbol, size_t a_length)
+{
+  size_t width;
+  Utf8::Prefix(a_symbol, a_length, -1, FS_UTF8_MODE, &width);
+  return (fsUInt8)width;
+}
+
+
+NumberFormatProfile::NumberFormatProfile()
+{
+  Set(",", ".", "$", "");
+}
+
+
+NumberFormatProfile::NumberFormatProfile(const fsChar* a_groupSeparator, const fsChar* a_decimalSeparator,
+                                         const fsChar* a_currencyPrefix, const fsChar* a_currencySuffix)
+{
+  Set(a_groupSeparator, a_decimalSeparator, a_currencyPrefix, a_currencySuffix);
+}
+
+
+void NumberFormatProfile::Set(const fsChar* a_groupSeparator, const fsChar* a_decimalSeparator,
+                              const fsChar* a_currencyPrefix, const fsChar* a_currencySuffix)
+{
+  m_groupSeparatorLength = copy_symbol(m_groupSeparator, a_groupSeparator);
+  m_groupSeparatorWidth = symbol_width(m_groupSeparator, m_groupSeparatorLength);
+  m_decimalSeparatorLength = copy_symbol(m_decimalSeparator, a_decimalSeparator);
+  m_decimalSeparatorWidth = symbol_width(m_decimalSeparator, m_decimalSeparatorLength);
+  m_currencyPrefixLength = copy_symbol(m_currencyPrefix, a_currencyPrefix);
+  m_currencySuffixLength = copy_symbol(m_currencySuffix, a_currencySuffix);
+}
+
+
+void NumberFormat::SetProfile(const NumberFormatProfile* a_profile)
+{
+  s_profile = a_profile ? a_profile : &s_defaultProfile;
+}
+
+
+// Split into base 1000 groups, least significant first. Returns number of groups below the leading group.
+static int split_groups(fsUInt64* a_value, fsUInt32* a_groups)
+{
+  int numGroups = 0;
+  while( *a_value >= 1000 )
+  {
+    a_groups[numGroups++] = (fsUInt32)(*a_value % 1000);
+    *a_value /= 1000;
+  }
+  return numGroups;
+}
+
+
+size_t NumberFormat::WriteGrouped(fsChar* a_dest, fsUInt64 a_value, const NumberFormatProfile& a_profile, fsInt* a_width)
+{
+  fsUInt32 groups[7];
+  int numGroups = split_groups(&a_value, groups);
+  fsUInt32 lead = (fsUInt32)a_value;
+  fsChar* out = a_dest;
+
+  // Leading group, 1 to 3 digits
+  if( lead >= 100 )
+  {
+    *out++ = (fsChar)('0' + lead / 100);
+    memcpy(out, s_digitPairs + (lead % 100) * 2, 2);
+    out += 2;
+  }
+  else if( lead >= 10 )
+  {
+    memcpy(out, s_digitPairs + lead * 2, 2);
+    out += 2;
+  }
+  else
+  {
+    *out++ = (fsChar)('0' + lead);
+  }
+  int digits = (int)(out - a_dest) + numGroups * 3;
+
+  // Remaining groups, always 3 digits
+  while( numGroups > 0 )
+  {
+    fsUInt32 group = groups[--numGroups];
+    memcpy(out, a_profile.m_groupSeparator, a_profile.m_groupSeparatorLength);
+    out += a_profile.m_groupSeparatorLength;
+    out[0] = (fsChar)('0' + group / 100);
+    memcpy(out + 1, s_digitPairs + (group % 100) * 2, 2);
+    out += 3;
+  }
+
+  if( a_width )
+  {
+    *a_width = digits + ((digits - 1) / 3) * a_profile.m_groupSeparatorWidth;
+  }
+  return out - a_dest;
+}
+
+
+size_t NumberFormat::GroupedLength(fsUInt64 a_value, const NumberFormatProfile& a_profile, fsInt* a_width)
+{
+  fsUInt32 groups[7];
+  int numGroups = split_groups(&a_value, groups);
+  int digits = numGroups * 3 + ((a_value >= 100) ? 3 : (a_value >= 10) ? 2 : 1);
+  if( a_width )
+  {
+    *a_width = digits + numGroups * a_profile.m_groupSeparatorWidth;
+  }
+  return digits + numGroups * a_profile.m_groupSeparatorLength;
+}
+
+
+fsInt NumberFormat::CountLeadingZeros(fsUInt64 a_value)
+{
+  FS_ASSERT( a_value != 0 );
+#if defined(__GNUC__) || defined(__clang__)
+  return __builtin_clzll(a_value);
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_ARM64))
+  unsigned long index;
+  _BitScanReverse64(&index, a_value);
+  return 63 - (fsInt)index;
+#else
+  fsInt count = 0;
+  while( !(a_value & 0x8000000000000000ULL) )
+  {
+    a_value <<= 1;
+    ++count;
+  }
+  return count;
+#endif
+}
+
+
+// Base 2^BITS digits, a_length digits written from the least significant end with shift and mask
+template <typename UINT, int BITS>
+static fsInt write_pow2(fsChar* a_dest, fsInt a_length, UINT a_value, const fsChar* a_digits)
+{
+  fsChar* out = a_dest + a_length;
+  while( out != a_dest )
+  {
+    *--out = a_digits[(fsUInt32)a_value & ((1 << BITS) - 1)];
+    a_value >>= BITS;
+  }
+  return a_length;
+}
+
+
+// Hexadecimal, two nibbles per byte of the value
+template <typename UINT>
+static fsInt write_hex(fsChar* a_dest, fsInt a_length, UINT a_value, const fsChar* a_digits)
+{
+  fsChar* out = a_dest + a_length;
+  while( out - a_dest >= 2 )
+  {
+    fsUInt32 byte = (fsUInt32)a_value & 0xFF;
+    out -= 2;
+    out[0] = a_digits[byte >> 4];
+    out[1] = a_digits[byte & 0xF];
+    a_value >>= 8;
+  }
+  if( out != a_dest )
+  {
+    *--out = a_digits[(fsUInt32)a_value & 0xF];
+  }
+  return a_length;
+}
+
+
+template <typename UINT>
+static fsInt write_pow2_any(fsChar* a_dest, fsInt a_length, UINT a_value, fsInt a_bitsPerDigit, fsBool a_upperCase)
+{
+  const fsChar* digits = a_upperCase ? "0123456789ABCDEF" : "0123456789abcdef";
+  switch( a_bitsPerDigit )
+  {
+    case 4: return write_hex<UINT>(a_dest, a_length, a_value, digits);
+    case 3: return write_pow2<UINT, 3>(a_dest, a_length, a_value, digits);
+    case 1: return write_pow2<UINT, 1>(a_dest, a_length, a_value, digits);
+    default:
+    {
+      FS_ASSERT( false && "Unsupported base" );
+      return 0;
+    }
+  }
+}
+
+
+fsInt NumberFormat::WritePow2(fsChar* a_dest, fsUInt64 a_value, fsInt a_bitsPerDigit, fsBool a_upperCase)
+{
+  return write_pow2_any<fsUInt64>(a_dest, Pow2Length(a_value, a_bitsPerDigit), a_value, a_bitsPerDigit, a_upperCase);
+}
+
+
+fsInt NumberFormat::DecimalLength(fsUInt64 a_value)
+{
+  fsInt digits = 1;
+  fsUInt64 power = 10;
+  while( (digits < 20) && (a_value >= power) ) // Compare with powers of ten rather than divide
+  {
+    ++digits;
+    power *= 10;
+  }
+  return digits;
+}
+
+
+// Write a_numDigits digits of a_value ending at a_end, two digits per division. Divisions are 64bit only while the
+// value needs them, the rest (all of a value below 2^32) are 32bit, which are cheaper.
+static void write_decimal(fsChar* a_end, fsUInt64 a_value, fsInt a_numDigits, const fsChar* a_digitPairs)
+{
+  while( (a_value >> 32) != 0 )
+  {
+    fsUInt32 pair = (fsUInt32)(a_value % 100) * 2;
+    a_value /= 100;
+    a_end -= 2;
+    a_end[0] = a_digitPairs[pair];
+    a_end[1] = a_digitPairs[pair + 1];
+    a_numDigits -= 2;
+  }
+  fsUInt32 value = (fsUInt32)a_value;
+  while( a_numDigits >= 2 )
+  {
+    fsUInt32 pair = (value % 100) * 2;
+    value /= 100;
+    a_end -= 2;
+    a_end[0] = a_digitPairs[pair];
+    a_end[1] = a_digitPairs[pair + 1];
+    a_numDigits -= 2;
+  }
+  if( a_numDigits )
+  {
+    *--a_end = (fsChar)('0' + value % 10);
+  }
+}
+
+
+fsInt NumberFormat::WriteDecimal(fsChar* a_dest, fsUInt64 a_value)
+{
+  fsInt length = DecimalLength(a_value);
+  write_decimal(a_dest + length, a_value, length, s_digitPairs);
+  return length;
+}
+
+//
+// Float32 shortest decimal, Ryu (Ulf Adams, PLDI 2018) for binary32: the decimal interval of values that round
+// to the float is scaled by a 64bit power of five, then digits are removed while the interval still holds one
+//
+
+enum
+{
+  FLOAT32_MANTISSA_BITS = 23,
+  FLOAT32_EXPONENT_BIAS = 127,
+  FLOAT32_POW5_INV_BITCOUNT = 59,
+  FLOAT32_POW5_BITCOUNT = 61,
+};
+
+// floor(2^(bits(5^i) - 1 + 59) / 5^i) + 1
+static const fsUInt64 s_float32Pow5InvSplit[31] =
+{
+  0x0800000000000001ULL, 0x0666666666666667ULL, 0x051EB851EB851EB9ULL, 0x04189374BC6A7EFAULL,
+  0x068DB8BAC710CB2AULL, 0x053E2D6238DA3C22ULL, 0x0431BDE82D7B634EULL, 0x06B5FCA6AF2BD216ULL,
+  0x055E63B88C230E78ULL, 0x044B82FA09B5A52DULL, 0x06DF37F675EF6EAEULL, 0x057F5FF85E592558ULL,
+  0x0465E6604B7A8447ULL, 0x0709709A125DA071ULL, 0x05A126E1A84AE6C1ULL, 0x0480EBE7B9D58567ULL,
+  0x0734ACA5F6226F0BULL, 0x05C3BD5191B525A3ULL, 0x049C97747490EAE9ULL, 0x0760F253EDB4AB0EULL,
+  0x05E72843249088D8ULL, 0x04B8ED0283A6D3E0ULL, 0x078E480405D7B966ULL, 0x060B6CD004AC9452ULL,
+  0x04D5F0A66A23A9DBULL, 0x07BCB43D769F762BULL, 0x063090312BB2C4EFULL, 0x04F3A68DBC8F03F3ULL,
+  0x07EC3DAF94180651ULL, 0x065697BFA9ACD1DAULL, 0x051212FFBAF0A7E2ULL,
+};
+
+// 5^i normalized to 61 bits
+static const fsUInt64 s_float32Pow5Split[48] =
+{
+  0x1000000000000000ULL, 0x1400000000000000ULL, 0x1900000000000000ULL, 0x1F40000000000000ULL,
+  0x1388000000000000ULL, 0x186A000000000000ULL, 0x1E84800000000000ULL, 0x1312D00000000000ULL,
+  0x17D7840000000000ULL, 0x1DCD650000000000ULL, 0x12A05F2000000000ULL, 0x174876E800000000ULL,
+  0x1D1A94A200000000ULL, 0x12309CE540000000ULL, 0x16BCC41E90000000ULL, 0x1C6BF52634000000ULL,
+  0x11C37937E0800000ULL, 0x16345785D8A00000ULL, 0x1BC16D674EC80000ULL, 0x1158E460913D0000ULL,
+  0x15AF1D78B58C4000ULL, 0x1B1AE4D6E2EF5000ULL, 0x10F0CF064DD59200ULL, 0x152D02C7E14AF680ULL,
+  0x1A784379D99DB420ULL, 0x108B2A2C28029094ULL, 0x14ADF4B7320334B9ULL, 0x19D971E4FE8401E7ULL,
+  0x1027E72F1F128130ULL, 0x1431E0FAE6D7217CULL, 0x193E5939A08CE9DBULL, 0x1F8DEF8808B02452ULL,
+  0x13B8B5B5056E16B3ULL, 0x18A6E32246C99C60ULL, 0x1ED09BEAD87C0378ULL, 0x13426172C74D822BULL,
+  0x1812F9CF7920E2B6ULL, 0x1E17B84357691B64ULL, 0x12CED32A16A1B11EULL, 0x178287F49C4A1D66ULL,
+  0x1D6329F1C35CA4BFULL, 0x125DFA371A19E6F7ULL, 0x16F578C4E0A060B5ULL, 0x1CB2D6F618C878E3ULL,
+  0x11EFC659CF7D4B8DULL, 0x166BB7F0435C9E71ULL, 0x1C06A5EC5433C60DULL, 0x118427B3B4A05BC8ULL,
+};
+
+static const fsUInt32 s_pow10_32[10] = { 1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000 };
+
+
+// Bits of 5^a_e, ceil(log2(5^a_e)) with 5^0 counted as 1 bit
+static inline fsInt32 pow5_bits(fsInt32 a_e)
+{
+  return (fsInt32)(((fsUInt32)a_e * 1217359) >> 19) + 1;
+}
+
+// floor(log10(2^a_e))
+static inline fsUInt32 log10_pow2(fsInt32 a_e)
+{
+  return ((fsUInt32)a_e * 78913) >> 18;
+}
+
+// floor(log10(5^a_e))
+static inline fsUInt32 log10_pow5(fsInt32 a_e)
+{
+  return ((fsUInt32)a_e * 732923) >> 20;
+}
+
+static inline fsBool multiple_of_pow5(fsUInt32 a_value, fsUInt32 a_power)
+{
+  fsUInt32 count = 0;
+  while( (a_value % 5) == 0 )
+  {
+    a_value /= 5;
+    ++count;
+  }
+  return count >= a_power;
+}
+
+static inline fsBool multiple_of_pow2(fsUInt32 a_value, fsUInt32 a_power)
+{
+  return (a_value & ((1u << a_power) - 1)) == 0;
+}
+
+// (a_m * a_factor) >> a_shift, a_shift > 32
+static inline fsUInt32 mul_shift(fsUInt32 a_m, fsUInt64 a_factor, fsInt32 a_shift)
+{
+  fsUInt64 low = (fsUInt64)a_m * (fsUInt32)a_factor;
+  fsUInt64 high = (fsUInt64)a_m * (fsUInt32)(a_factor >> 32);
+  return (fsUInt32)(((low >> 32) + high) >> (a_shift - 32));
+}
+
+
+// Digits of a_value below 10^9, compared against each power so the count costs no mispredicted branch
+static inline fsInt decimal_length9(fsUInt32 a_value)
+{
+  return 1 + (a_value >= 10) + (a_value >= 100) + (a_value >= 1000) + (a_value >= 10000) + (a_value >= 100000)
+           + (a_value >= 1000000) + (a_value >= 10000000) + (a_value >= 100000000);
+}
+
+
+// Write a_value below 10^9 as 9 digits with leading zeros, the same steps for any value
+static inline void write_decimal9(fsChar* a_dest, fsUInt32 a_value, const fsChar* a_digitPairs)
+{
+  fsUInt32 high = a_value / 100000;               // 4 digits
+  fsUInt32 low = a_value % 100000;                // 5 digits
+  memcpy(a_dest, a_digitPairs + (high / 100) * 2, 2);
+  memcpy(a_dest + 2, a_digitPairs + (high % 100) * 2, 2);
+  a_dest[4] = (fsChar)('0' + low / 10000);
+  low %= 10000;
+  memcpy(a_dest + 5, a_digitPairs + (low / 100) * 2, 2);
+  memcpy(a_dest + 7, a_digitPairs + (low % 100) * 2, 2);
+}
+
+
+fsInt NumberFormat::ShortestFloat32(fsFloat32 a_value, fsUInt32* a_digits, fsInt* a_exponent)
+{
+  fsUInt32 bits;
+  memcpy(&bits, &a_value, sizeof(bits));
+  fsUInt32 ieeeMantissa = bits & ((1u << FLOAT32_MANTISSA_BITS) - 1);
+  fsUInt32 ieeeExponent = (bits >> FLOAT32_MANTISSA_BITS) & 0xFF;
+  if( (ieeeExponent == 0) && (ieeeMantissa == 0) )
+  {
+    *a_digits = 0;
+    *a_exponent = 0;
+    return 1;
+  }
+
+  // Value is m2 * 2^e2, with two extra bits for the half way bounds
+  fsInt32 e2 = ((ieeeExponent == 0) ? 1 : (fsInt32)ieeeExponent) - FLOAT32_EXPONENT_BIAS - FLOAT32_MANTISSA_BITS - 2;
+  fsUInt32 m2 = (ieeeExponent == 0) ? ieeeMantissa : ((1u << FLOAT32_MANTISSA_BITS) | ieeeMantissa);
+  fsBool acceptBounds = (m2 & 1) == 0;            // Round half to even reads the bounds back as this value
+
+  fsUInt32 mv = 4 * m2;
+  fsUInt32 mp = 4 * m2 + 2;
+  fsUInt32 mmShift = ((ieeeMantissa != 0) || (ieeeExponent <= 1)) ? 1 : 0; // Lower bound is closer at powers of two
+  fsUInt32 mm = 4 * m2 - 1 - mmShift;
+
+  // Interval [vm, vp] and value vr scaled to decimal, vr * 10^e10
+  fsUInt32 vr, vp, vm;
+  fsInt32 e10;
+  fsBool vmIsTrailingZeros = false;
+  fsBool vrIsTrailingZeros = false;
+  fsUInt32 lastRemovedDigit = 0;
+  if( e2 >= 0 )
+  {
+    fsUInt32 q = log10_pow2(e2);
+    e10 = (fsInt32)q;
+    fsInt32 shift = -e2 + (fsInt32)q + FLOAT32_POW5_INV_BITCOUNT + pow5_bits((fsInt32)q) - 1;
+    vr = mul_shift(mv, s_float32Pow5InvSplit[q], shift);
+    vp = mul_shift(mp, s_float32Pow5InvSplit[q], shift);
+    vm = mul_shift(mm, s_float32Pow5InvSplit[q], shift);
+    if( (q != 0) && ((vp - 1) / 10 <= vm / 10) )
+    {
+      // Only one digit is removed below, it decides the rounding so compute it exactly
+      fsInt32 lastShift = -e2 + (fsInt32)q - 1 + FLOAT32_POW5_INV_BITCOUNT + pow5_bits((fsInt32)q - 1) - 1;
+      lastRemovedDigit = mul_shift(mv, s_float32Pow5InvSplit[q - 1], lastShift) % 10;
+    }
+    if( q <= 9 )
+    {
+      // Only one of mp, mv and mm can be a multiple of 5, if any
+      if( (mv % 5) == 0 )
+      {
+        vrIsTrailingZeros = multiple_of_pow5(mv, q);
+      }
+      else if( acceptBounds )
+      {
+        vmIsTrailingZeros = multiple_of_pow5(mm, q);
+      }
+      else
+      {
+        vp -= multiple_of_pow5(mp, q) ? 1 : 0;
+      }
+    }
+  }
+  else
+  {
+    fsUInt32 q = log10_pow5(-e2);
+    e10 = (fsInt32)q + e2;
+    fsInt32 i = -e2 - (fsInt32)q;
+    fsInt32 shift = (fsInt32)q - (pow5_bits(i) - FLOAT32_POW5_BITCOUNT);
+    vr = mul_shift(mv, s_float32Pow5Split[i], shift);
+    vp = mul_shift(mp, s_float32Pow5Split[i], shift);
+    vm = mul_shift(mm, s_float32Pow5Split[i], shift);
+    if( (q != 0) && ((vp - 1) / 10 <= vm / 10) )
+    {
+      fsInt32 lastShift = (fsInt32)q - 1 - (pow5_bits(i + 1) - FLOAT32_POW5_BITCOUNT);
+      lastRemovedDigit = mul_shift(mv, s_float32Pow5Split[i + 1], lastShift) % 10;
+    }
+    if( q <= 1 )
+    {
+      // mv has at least q trailing zero bits, so vr has q trailing decimal zeros
+      vrIsTrailingZeros = true;
+      if( acceptBounds )
+      {
+        vmIsTrailingZeros = (mmShift == 1); // mm = mv - 2, so it has a trailing zero too
+      }
+      else
+      {
+        --vp; // mp = mv + 2, so has a trailing zero, exclude it
+      }
+    }
+    else if( q < 31 )
+    {
+      vrIsTrailingZeros = multiple_of_pow2(mv, q - 1);
+    }
+  }
+
+  // Remove digits while the interval still holds a shorter decimal
+  fsInt32 removed = 0;
+  fsUInt32 output;
+  if( vmIsTrailingZeros || vrIsTrailingZeros )
+  {
+    // Rare, exact ties need the removed digits tracked
+    while( vp / 10 > vm / 10 )
+    {
+      vmIsTrailingZeros &= (vm % 10) == 0;
+      vrIsTrailingZeros &= lastRemovedDigit == 0;
+      lastRemovedDigit = vr % 10;
+      vr /= 10;
+      vp /= 10;
+      vm /= 10;
+      ++removed;
+    }
+    if( vmIsTrailingZeros )
+    {
+      while( (vm % 10) == 0 )
+      {
+        vrIsTrailingZeros &= lastRemovedDigit == 0;
+        lastRemovedDigit = vr % 10;
+        vr /= 10;
+        vp /= 10;
+        vm /= 10;
+        ++removed;
+      }
+    }
+    if( vrIsTrailingZeros && (lastRemovedDigit == 5) && ((vr % 2) == 0) )
+    {
+      lastRemovedDigit = 4; // Exactly half way, round to even
+    }
+    output = vr + ((((vr == vm) && (!acceptBounds || !vmIsTrailingZeros)) || (lastRemovedDigit >= 5)) ? 1 : 0);
+  }
+  else
+  {
+    while( vp / 10 > vm / 10 )
+    {
+      lastRemovedDigit = vr % 10;
+      vr /= 10;
+      vp /= 10;
+      vm /= 10;
+      ++removed;
+    }
+    output = vr + (((vr == vm) || (lastRemovedDigit >= 5)) ? 1 : 0);
+  }
+
+  *a_digits = output;
+  *a_exponent = e10 + removed;
+  return decimal_length9(output);
+}
+
+
+// Write a run of decimal digits with group separators, as WriteGrouped()
+static size_t write_grouped_digits(fsChar* a_dest, const fsChar* a_digits, fsInt a_numDigits, const NumberFormatProfile& a_profile, fsInt* a_width)
+{
+  fsInt leadDigits = ((a_numDigits - 1) % 3) + 1;
+  fsInt numGroups = (a_numDigits - 1) / 3;
+  fsChar* out = a_dest;
+  memcpy(out, a_digits, leadDigits);
+  out += leadDigits;
+  for( const fsChar* group = a_digits + leadDigits; group < a_digits + a_numDigits; group += 3 )
+  {
+    memcpy(out, a_profile.m_groupSeparator, a_profile.m_groupSeparatorLength);
+    out += a_profile.m_groupSeparatorLength;
+    memcpy(out, group, 3);
+    out += 3;
+  }
+  *a_width = a_numDigits + numGroups * a_profile.m_groupSeparatorWidth;
+  return out - a_dest;
+}
+
+
+// Write integer digits, the decimal point if a_point, then fraction digits, grouped with a_profile separators if not NULL
+static size_t write_fixed_digits(fsChar* a_dest, const fsChar* a_digits, fsInt a_numInteger, fsInt a_numFraction, fsBool a_point,
+                                 const NumberFormatProfile* a_profile, fsInt* a_width)
+{
+  fsChar* out = a_dest;
+  fsInt width;
+  if( a_profile != NULL )
+  {
+    out += write_grouped_digits(out, a_digits, a_numInteger, *a_profile, &width);
+  }
+  else
+  {
+    memcpy(out, a_digits, a_numInteger);
+    out += a_numInteger;
+    width = a_numInteger;
+  }
+  if( a_point )
+  {
+    if( a_profile != NULL )
+    {
+      memcpy(out, a_profile->m_decimalSeparator, a_profile->m_decimalSeparatorLength);
+      out += a_profile->m_decimalSeparatorLength;
+      width += a_profile->m_decimalSeparatorWidth;
+    }
+    else
+    {
+      *out++ = '.';
+      ++width;
+    }
+    memcpy(out, a_digits + a_numInteger, a_numFraction);
+    out += a_numFraction;
+    width += a_numFraction;
+  }
+
+  if( a_width )
+  {
+    *a_width = width;
+  }
+  return out - a_dest;
+}
+
+
+// Digits of |a_value| (finite, below 2^23 when it has a fraction) to a_precision fraction digits, rounded half up from
+// its exact binary value. The fraction is a 160bit fixed point number (five 32bit limbs, least significant first)
+// and each multiply by 10 carries the next digit out of the top. a_text must hold MAX_FLOAT32_DIGITS + 8 + a_precision
+// chars, the first MAX_FLOAT32_DIGITS are slack. Returns the start of the integer digits then fraction digits, and the
+// number of integer digits.
+static const fsChar* float32_fixed_exact(fsChar* a_text, fsFloat32 a_value, fsInt a_precision, fsInt* a_numInteger)
+{
+  fsUInt32 bits;
+  memcpy(&bits, &a_value, sizeof(bits));
+  fsInt biased = (fsInt)((bits >> 23) & 0xFF);
+  fsUInt32 significand = (biased == 0) ? (bits & 0x7FFFFF) : ((bits & 0x7FFFFF) | 0x800000);
+  fsInt shift = (biased == 0) ? 149 : 150 - biased; // |a_value| = significand / 2^shift
+  FS_ASSERT( shift > 0 );
+
+  fsUInt32 integer = (shift < 32) ? (significand >> shift) : 0;
+  fsUInt32 fractionBits = (shift < 32) ? (significand & ((1U << shift) - 1)) : significand;
+  fsUInt32 fraction[5] = { 0, 0, 0, 0, 0 };
+  fsInt bitPosition = 160 - shift;                // fraction = fractionBits / 2^shift = limbs / 2^160
+  fsUInt64 placed = (fsUInt64)fractionBits << (bitPosition % 32);
+  fraction[bitPosition / 32] = (fsUInt32)placed;
+  if( bitPosition / 32 < 4 )
+  {
+    fraction[bitPosition / 32 + 1] = (fsUInt32)(placed >> 32);
+  }
+
+  fsChar* digits = a_text + NumberFormat::MAX_FLOAT32_DIGITS; // Slack for the leading zeros of the 9 digit block and a carry
+  fsInt numInteger = decimal_length9(integer);
+  write_decimal9(digits + numInteger - NumberFormat::MAX_FLOAT32_DIGITS, integer, NumberFormat::DigitPairs());
+  fsChar* out = digits + numInteger;
+  for( fsInt place = 0; place < a_precision; ++place )
+  {
+    fsUInt64 carry = 0;
+    for( fsInt limb = 0; limb < 5; ++limb )
+    {
+      carry += (fsUInt64)fraction[limb] * 10;
+      fraction[limb] = (fsUInt32)carry;
+      carry >>= 32;
+    }
+    *out++ = (fsChar)('0' + carry);
+  }
+
+  if( fraction[4] & 0x80000000 ) // Remainder at least half a unit of the last place
+  {
+    fsChar* last = out;
+    while( (last > digits) && (last[-1] == '9') )
+    {
+      *--last = '0';
+    }
+    if( last == digits ) // All nines, carry into a new leading digit
+    {
+      *--digits = '1';
+      ++numInteger;
+    }
+    else
+    {
+      ++last[-1];
+    }
+  }
+  *a_numInteger = numInteger;
+  return digits;
+}
+
+
+size_t NumberFormat::WriteFloat32Fixed(fsChar* a_dest, fsFloat32 a_value, fsInt a_precision, const NumberFormatProfile* a_profile,
+                                       fsInt* a_fractionDigits, fsInt* a_width)
+{
+  fsUInt32 digits;
+  fsInt exponent;
+  ShortestFloat32(a_value, &digits, &exponent);
+  if( a_precision < 0 )
+  {
+    a_precision = 0;
+  }
+
+  // The shortest decimal needs rounding. Rounding it would round twice (2.675f is 2.67499995..., so "2.67" not
+  // "2.68"), round the exact value instead.
+  if( -exponent > a_precision )
+  {
+    fsChar exact[MAX_FLOAT32_DIGITS + 8 + 64];     // Fractions end within 64 places, see MAX_FLOAT32_FIXED_CHARS
+    FS_ASSERT( a_precision <= 64 );
+    fsInt numInteger;
+    const fsChar* exactDigits = float32_fixed_exact(exact, a_value, a_precision, &numInteger);
+    *a_fractionDigits = a_precision;
+    return write_fixed_digits(a_dest, exactDigits, numInteger, a_precision, a_precision > 0, a_profile, a_width);
+  }
+
+  // Digits are integer digits then fraction digits, with zeros between the point and a small value. The text starts
+  // as zeros and the digits go in as a 9 digit block ending at the units or last fraction place, whose leading zeros
+  // fall in the zeros or the slack before the text.
+  fsChar text[MAX_FLOAT32_DIGITS + 39 + 54];
+  memset(text, '0', sizeof(text));
+  fsInt numFraction = (exponent < 0) ? -exponent : 0;
+  fsInt trailingZeros = (exponent > 0) ? exponent : 0;
+  fsInt numDigits = decimal_length9(digits);
+  fsInt numInteger = ((numDigits > numFraction) ? numDigits - numFraction : 1) + trailingZeros;
+  fsChar* digitsText = text + MAX_FLOAT32_DIGITS;
+  write_decimal9(digitsText + numInteger - trailingZeros + numFraction - MAX_FLOAT32_DIGITS, digits, s_digitPairs);
+
+  *a_fractionDigits = numFraction;
+  return write_fixed_digits(a_dest, digitsText, numInteger, numFraction, a_precision > 0, a_profile, a_width);
+}
+
+
+size_t NumberFormat::WriteFloat32General(fsChar* a_dest, fsFloat32 a_value, fsBool a_upperCase)
+{
+  fsUInt32 digits;
+  fsInt exponent;
+  fsChar block[MAX_FLOAT32_DIGITS];
+  fsInt numDigits = ShortestFloat32(a_value, &digits, &exponent);
+  write_decimal9(block, digits, s_digitPairs);
+  const fsChar* text = block + MAX_FLOAT32_DIGITS - numDigits;
+  fsInt leadExponent = exponent + numDigits - 1;  // Power of ten of the first digit
+  fsChar* out = a_dest;
+
+  if( (exponent >= 0) && (leadExponent < 18) )
+  {
+    // Integer
+    memcpy(out, text, numDigits);
+    out += numDigits;
+    memset(out, '0', exponent);
+    out += exponent;
+  }
+  else if( (leadExponent < -5) || (leadExponent >= 4) )
+  {
+    // Exponent style, "d.ddde-7"
+    *out++ = text[0];
+    if( numDigits > 1 )
+    {
+      *out++ = '.';
+      memcpy(out, text + 1, numDigits - 1);
+      out += numDigits - 1;
+    }
+    *out++ = a_upperCase ? 'E' : 'e';
+    if( leadExponent < 0 )
+    {
+      *out++ = '-';
+    }
+    out += WriteDecimal(out, (fsUInt64)((leadExponent < 0) ? -leadExponent : leadExponent));
+  }
+  else
+  {
+    // Fixed point, exponent < 0 here
+    fsInt numFraction = -exponent;
+    if( numDigits > numFraction )
+    {
+      memcpy(out, text, numDigits - numFraction);
+      out += numDigits - numFraction;
+      *out++ = '.';
+      memcpy(out, text + numDigits - numFraction, numFraction);
+      out += numFraction;
+    }
+    else
+    {
+      *out++ = '0';
+      *out++ = '.';
+      memset(out, '0', numFraction - numDigits);
+      out += numFraction - numDigits;
+      memcpy(out, text, numDigits);
+      out += numDigits;
+    }
+  }
+  return out - a_dest;
+}
+
+// Value of each char as a hex digit, -1 if not one. A lookup rather than range tests, whose branches mispredict on
+// random digits.
+static const fsInt8 s_hexDigitValues[256] =
+{
+  -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+  -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+  -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+   0,  1,  2,  3,  4,  5,  6,  7,  8,  9, -1, -1, -1, -1, -1, -1,
+  -1, 10, 11, 12, 13, 14, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+  -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+  -1, 10, 11, 12, 13, 14, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+  -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+  -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+  -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+  -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+  -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+  -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+  -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+  -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+  -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+};
+
+
+size_t NumberFormat::WriteHexFloat64(fsChar* a_dest, fsFloat64 a_value, fsInt a_precision, fsBool a_upperCase)
+{
+  const fsChar* hexDigits = a_upperCase ? "0123456789ABCDEF" : "0123456789abcdef";
+  fsUInt64 bits;
+  memcpy(&bits, &a_value, sizeof(bits));
+  fsUInt64 fraction = bits & ((1ULL << 52) - 1);
+  fsInt exponent = (fsInt)((bits >> 52) & 0x7FF);
+  fsUInt64 lead = 1;
+  if( exponent == 0 )
+  {
+    lead = 0;                                     // Zero or subnormal
+    exponent = (fraction != 0) ? -1022 : 0;
+  }
+  else
+  {
+    exponent -= 1023;
+  }
+
+  fsInt numDigits = HEX_FLOAT64_DIGITS;
+  if( a_precision < 0 )
+  {
+    // Exact, trailing zero digits dropped. The lowest set bit (fraction & -fraction) gives the trailing zero bits.
+    numDigits = (fraction != 0) ? HEX_FLOAT64_DIGITS - (63 - CountLeadingZeros(fraction & (0 - fraction))) / 4 : 0;
+  }
+  else if( a_precision < HEX_FLOAT64_DIGITS )
+  {
+    // Round half to even at the last digit kept, a carry can reach the lead digit ("0x2p+0")
+    fsInt shift = (HEX_FLOAT64_DIGITS - a_precision) * 4;
+    fsUInt64 mantissa = (lead << 52) | fraction;
+    fsUInt64 half = 1ULL << (shift - 1);
+    fsUInt64 remainder = mantissa & ((half << 1) - 1);
+    mantissa >>= shift;
+    mantissa += ((remainder > half) || ((remainder == half) && (mantissa & 1))) ? 1 : 0;
+    lead = mantissa >> (a_precision * 4);
+    fraction = (mantissa << shift) & ((1ULL << 52) - 1);
+    numDigits = a_precision;
+  }
+
+  fsChar* out = a_dest;
+  *out++ = '0';
+  *out++ = a_upperCase ? 'X' : 'x';
+  *out++ = hexDigits[lead];
+  *out = '.';
+  out += (numDigits > 0) ? 1 : 0;
+  for( fsInt digit = 0; digit < HEX_FLOAT64_DIGITS; ++digit ) // All digits, the same steps for any value, then the
+  {                                                            // exponent overwrites those past numDigits
+    out[digit] = hexDigits[(fraction >> (48 - digit * 4)) & 0xF];
+  }
+  out += numDigits;
+  *out++ = a_upperCase ? 'P' : 'p';
+  *out++ = (exponent < 0) ? '-' : '+';
+  out += WriteDecimal(out, (fsUInt64)((exponent < 0) ? -exponent : exponent));
+  return out - a_dest;
+}
+
+
+size_t NumberFormat::ReadHexFloat64(const fsChar* a_str, size_t a_maxLength, fsFloat64* a_value)
+{
+  size_t index = 0;
+  fsBool negative = false;
+  if( (index < a_maxLength) && ((a_str[index] == '+') || (a_str[index] == '-')) )
+  {
+    negative = (a_str[index] == '-');
+    ++index;
+  }
+  if( (index + 2 > a_maxLength) || (a_str[index] != '0') || ((a_str[index + 1] != 'x') && (a_str[index + 1] != 'X')) )
+  {
+    return 0;
+  }
+  index += 2;
+
+  // The first 16 significant digits fill a 64bit mantissa, later ones only matter to rounding if not zero
+  fsUInt64 mantissa = 0;
+  fsInt exponent = 0;                             // Power of two of the mantissa's lowest bit
+  fsInt numSignificant = 0;
+  fsBool sticky = false;
+  fsBool anyDigit = false;
+  fsBool point = false;
+  for( ; index < a_maxLength; ++index )
+  {
+    fsInt digit = s_hexDigitValues[(fsUInt8)a_str[index]];
+    if( digit < 0 )
+    {
+      if( (a_str[index] == '.') && !point )
+      {
+        point = true;
+        continue;
+      }
+      break;
+    }
+    anyDigit = true;
+    if( numSignificant < 16 )
+    {
+      mantissa = (mantissa << 4) | (fsUInt64)digit;
+      numSignificant += (mantissa != 0) ? 1 : 0;
+      exponent -= point ? 4 : 0;
+    }
+    else
+    {
+      sticky |= (digit != 0);
+      exponent += point ? 0 : 4;
+    }
+  }
+  if( !anyDigit )
+  {
+    return 0;
+  }
+
+  // Binary exponent, a 'p' without digits is not part of the number
+  if( (index < a_maxLength) && ((a_str[index] == 'p') || (a_str[index] == 'P')) )
+  {
+    size_t expIndex = index + 1;
+    fsBool expNegative = false;
+    if( (expIndex < a_maxLength) && ((a_str[expIndex] == '+') || (a_str[expIndex] == '-')) )
+    {
+      expNegative = (a_str[expIndex] == '-');
+      ++expIndex;
+    }
+    if( (expIndex < a_maxLength) && (a_str[expIndex] >= '0') && (a_str[expIndex] <= '9') )
+    {
+      fsInt binaryExponent = 0;
+      for( ; (expIndex < a_maxLength) && (a_str[expIndex] >= '0') && (a_str[expIndex] <= '9'); ++expIndex )
+      {
+        if( binaryExponent < 100000 )             // Saturate, far outside the float64 range
+        {
+          binaryExponent = binaryExponent * 10 + (a_str[expIndex] - '0');
+        }
+      }
+      exponent += expNegative ? -binaryExponent : binaryExponent;
+      index = expIndex;
+    }
+  }
+
+  fsUInt64 bits = 0;
+  if( mantissa != 0 )
+  {
+    fsInt leadingZeros = CountLeadingZeros(mantissa);
+    mantissa <<= leadingZeros;
+    fsInt leadExponent = exponent + 63 - leadingZeros; // Power of two of the leading bit
+
+    // Keep 53 bits, fewer below the normal range, and round the rest half to even
+    fsInt shift = 11 + ((leadExponent < -1022) ? -1022 - leadExponent : 0);
+    fsUInt64 kept = 0;
+    fsUInt64 remainder = 0;
+    fsUInt64 half = 1;
+    if( shift < 64 )
+    {
+      kept = mantissa >> shift;
+      remainder = mantissa & ((1ULL << shift) - 1);
+      half = 1ULL << (shift - 1);
+    }
+    else if( shift == 64 )
+    {
+      remainder = mantissa;
+      half = 1ULL << 63;
+    }
+    else
+    {
+      sticky = false;                             // Below half the smallest subnormal, rounds to zero
+    }
+    kept += ((remainder > half) || ((remainder == half) && (sticky || (kept & 1)))) ? 1 : 0;
+
+    if( leadExponent < -1022 )
+    {
+      bits = kept;                                // Subnormal, a carry into bit 52 makes the smallest normal
+    }
+    else
+    {
+      if( kept >> 53 )
+      {
+        kept >>= 1;                               // Rounded up to the next power of two
+        ++leadExponent;
+      }
+      bits = (leadExponent > 1023) ? 0x7FF0000000000000ULL : ((fsUInt64)(leadExponent + 1023) << 52) | (kept & ((1ULL << 52) - 1));
+    }
+  }
+  if( negative )
+  {
+    bits |= 1ULL << 63;
+  }
+  memcpy(a_value, &bits, sizeof(bits));
+  return index;
+}
+
+//
+// Fixed point decimals, scaled 64bit integers written and read in integer arithmetic
+//
+
+static const fsUInt64 s_pow10_64[20] =
+{
+  1ULL, 10ULL, 100ULL, 1000ULL, 10000ULL, 100000ULL, 1000000ULL, 10000000ULL, 100000000ULL, 1000000000ULL,
+  10000000000ULL, 100000000000ULL, 1000000000000ULL, 10000000000000ULL, 100000000000000ULL, 1000000000000000ULL,
+  10000000000000000ULL, 100000000000000000ULL, 1000000000000000000ULL, 10000000000000000000ULL
+};
+
+
+size_t NumberFormat::WriteDecimal64Fixed(fsChar* a_dest, fsUInt64 a_units, fsInt a_scale, fsInt a_precision,
+                                         const NumberFormatProfile* a_profile, fsInt* a_fractionDigits, fsInt* a_width)
+{
+  if( a_precision < 0 )
+  {
+    a_precision = 0;
+  }
+
+  // Round half up to a_precision fraction digits
+  if( a_scale > a_precision )
+  {
+    fsUInt64 divisor = s_pow10_64[a_scale - a_precision];
+    fsUInt64 remainder = a_units % divisor;
+    a_units = a_units / divisor + ((remainder >= divisor - remainder) ? 1 : 0);
+    a_scale = a_precision;
+  }
+
+  // Integer digits then fraction digits, with zeros between the point and a small value and after the units for a
+  // negative scale. The digits are written right aligned over zeros.
+  fsChar text[20 + 2 * MAX_DECIMAL64_SCALE];
+  fsInt numDigits = DecimalLength(a_units);
+  fsInt numFraction = (a_scale > 0) ? a_scale : 0;
+  fsInt trailingZeros = (a_scale < 0) ? -a_scale : 0;
+  fsInt numInteger = ((numDigits > numFraction) ? numDigits - numFraction : 1) + trailingZeros;
+  memset(text, '0', numInteger + numFraction);
+  write_decimal(text + numInteger + numFraction - trailingZeros, a_units, numDigits, s_digitPairs);
+
+  *a_fractionDigits = numFraction;
+  return write_fixed_digits(a_dest, text, numInteger, numFraction, a_precision > 0, a_profile, a_width);
+}
+
+
+size_t NumberFormat::ReadDecimal64(const fsChar* a_str, size_t a_maxLength, fsInt a_scale, fsInt64* a_units)
+{
+  size_t index = 0;
+  fsBool negative = false;
+  if( (index < a_maxLength) && ((a_str[index] == '+') || (a_str[index] == '-')) )
+  {
+    negative = (a_str[index] == '-');
+    ++index;
+  }
+  size_t integerStart = index;
+  while( (index < a_maxLength) && (a_str[index] >= '0') && (a_str[index] <= '9') )
+  {
+    ++index;
+  }
+  fsInt numInteger = (fsInt)(index - integerStart);
+  size_t fractionStart = index;
+  if( (index < a_maxLength) && (a_str[index] == '.') )
+  {
+    fractionStart = ++index;
+    while( (index < a_maxLength) && (a_str[index] >= '0') && (a_str[index] <= '9') )
+    {
+      ++index;
+    }
+  }
+  fsInt numFraction = (fsInt)(index - fractionStart);
+  if( (numInteger + numFraction) == 0 )
+  {
+    return 0;
+  }
+
+  // Decimal exponent, only if digits follow the 'e'. Saturated, far beyond any value that fits.
+  fsInt exponent = 0;
+  if( (index < a_maxLength) && ((a_str[index] == 'e') || (a_str[index] == 'E')) )
+  {
+    size_t exponentIndex = index + 1;
+    fsBool negativeExponent = false;
+    if( (exponentIndex < a_maxLength) && ((a_str[exponentIndex] == '+') || (a_str[exponentIndex] == '-')) )
+    {
+      negativeExponent = (a_str[exponentIndex] == '-');
+      ++exponentIndex;
+    }
+    if( (exponentIndex < a_maxLength) && (a_str[exponentIndex] >= '0') && (a_str[exponentIndex] <= '9') )
+    {
+      while( (exponentIndex < a_maxLength) && (a_str[exponentIndex] >= '0') && (a_str[exponentIndex] <= '9') )
+      {
+        if( exponent < 100000 )
+        {
+          exponent = exponent * 10 + (a_str[exponentIndex] - '0');
+        }
+        ++exponentIndex;
+      }
+      exponent = negativeExponent ? -exponent : exponent;
+      index = exponentIndex;
+    }
+  }
+
+  // Keep the digits down to 10^-a_scale, past the end of the text they are zeros, and round half up on the next one.
+  // Out of range values saturate, as strtoll().
+  fsInt numDigits = numInteger + numFraction;
+  fsInt numKept = numInteger + exponent + a_scale;
+  fsUInt64 limit = negative ? (1ULL << 63) : (1ULL << 63) - 1;
+  fsUInt64 units = 0;
+  fsInt digit = 0;
+  for( ; digit < numKept; ++digit )
+  {
+    if( (digit >= numDigits) && (units == 0) )
+    {
+      break;                                      // Zero, any further digits are zeros too
+    }
+    fsUInt32 value = (digit < numDigits) ? (fsUInt32)(a_str[(digit < numInteger) ? integerStart + digit : fractionStart + digit - numInteger] - '0') : 0;
+    if( units > (limit - value) / 10 )
+    {
+      units = limit;
+      break;
+    }
+    units = units * 10 + value;
+  }
+  if( (digit == numKept) && (numKept >= 0) && (numKept < numDigits) && (units < limit) )
+  {
+    fsInt next = (numKept < numInteger) ? (fsInt)integerStart + numKept : (fsInt)fractionStart + numKept - numInteger;
+    units += (a_str[next] >= '5') ? 1 : 0;
+  }
+
+  *a_units = negative ? (fsInt64)(0 - units) : (fsInt64)units;
+  return index;
+}
+
+#if FS_HAS_INT128
+
+static const fsUInt64 s_pow10_19 = 10000000000000000000ULL; // Largest power of ten in 64 bits
+
+
+fsInt NumberFormat::Pow2Length128(fsUInt128 a_value, fsInt a_bitsPerDigit)
+{
+  fsUInt64 high = (fsUInt64)(a_value >> 64);
+  fsInt bits = high ? (128 - CountLeadingZeros(high)) : (64 - CountLeadingZeros((fsUInt64)a_value | 1));
+  return (bits + a_bitsPerDigit - 1) / a_bitsPerDigit;
+}
+
+
+fsInt NumberFormat::WritePow2_128(fsChar* a_dest, fsUInt128 a_value, fsInt a_bitsPerDigit, fsBool a_upperCase)
+{
+  if( (a_value >> 64) == 0 )
+  {
+    return WritePow2(a_dest, (fsUInt64)a_value, a_bitsPerDigit, a_upperCase);
+  }
+  return write_pow2_any<fsUInt128>(a_dest, Pow2Length128(a_value, a_bitsPerDigit), a_value, a_bitsPerDigit, a_upperCase);
+}
+
+
+// Split into chunks of 19 decimal digits, each converted with 64bit arithmetic
+fsInt NumberFormat::WriteDecimal128(fsChar* a_dest, fsUInt128 a_value)
+{
+  if( (a_value >> 64) == 0 )
+  {
+    return WriteDecimal(a_dest, (fsUInt64)a_value);
+  }
+
+  fsUInt64 low = (fsUInt64)(a_value % s_pow10_19);
+  a_value /= s_pow10_19;
+  fsInt length;
+  if( (a_value >> 64) == 0 )
+  {
+    length = WriteDecimal(a_dest, (fsUInt64)a_value);
+  }
+  else
+  {
+    fsUInt64 middle = (fsUInt64)(a_value % s_pow10_19);
+    length = WriteDecimal(a_dest, (fsUInt64)(a_value / s_pow10_19));
+    write_decimal(a_dest + length + 19, middle, 19, s_digitPairs);
+    length += 19;
+  }
+  write_decimal(a_dest + length + 19, low, 19, s_digitPairs);
+  return length + 19;
+}
+
+
+size_t NumberFormat::WriteGrouped128(fsChar* a_dest, fsUInt128 a_value, const NumberFormatProfile& a_profile, fsInt* a_width)
+{
+  if( (a_value >> 64) == 0 )
+  {
+    return WriteGrouped(a_dest, (fsUInt64)a_value, a_profile, a_width);
+  }
+
+  fsChar digits[40];
+  fsInt numDigits = WriteDecimal128(digits, a_value);
+  fsInt leadDigits = ((numDigits - 1) % 3) + 1;
+  fsInt numGroups = (numDigits - 1) / 3;
+  fsChar* out = a_dest;
+  memcpy(out, digits, leadDigits);
+  out += leadDigits;
+  for( const fsChar* group = digits + leadDigits; group < digits + numDigits; group += 3 )
+  {
+    memcpy(out, a_profile.m_groupSeparator, a_profile.m_groupSeparatorLength);
+    out += a_profile.m_groupSeparatorLength;
+    memcpy(out, group, 3);
+    out += 3;
+  }
+
+  if( a_width )
+  {
+    *a_width = numDigits + numGroups * a_profile.m_groupSeparatorWidth;
+  }
+  return out - a_dest;
+}
+
+#endif // FS_HAS_INT128
+
+END_NAMESPACE_FORMATSTRINGLIB
@@ -0,0 +1,165 @@
+#ifndef NUMBERFORMAT_H
+#define NUMBERFORMAT_H
+
+//
+// NumberFormat.h
+// Number formatting profile (group and decimal separators, currency symbol), grouped digit writer
+// and decimal / hexadecimal / octal / binary digit writers, float32 shortest decimal and fixed point writers, hexadecimal floats,
+// fixed point decimals
+//
+
+#include <stddef.h>
+#include "Utils.h"
+
+//
+// The profile applies to grouped numbers: FormatString "N" and "C" formats and the FormatStringF ','
+// (or ''') flag. Plain "%f" / "{0:F}" always use '.' as the decimal separator.
+//
+// Eg. static NumberFormatProfile s_german(".", ",", "", " \xE2\x82\xAC"); // 1.234,50 €
+//     NumberFormat::SetProfile(&s_german);
+//
+
+BEGIN_NAMESPACE_FORMATSTRINGLIB
+
+// Separators and currency symbols, lengths are resolved once when the profile is set up
+struct NumberFormatProfile
+{
+  enum
+  {
+    MAX_SYMBOL = 8,                               // Bytes per symbol including terminator
+  };
+
+  fsChar m_groupSeparator[MAX_SYMBOL];            // Between groups of three digits, eg. ","
+  fsChar m_decimalSeparator[MAX_SYMBOL];          // Before fraction digits, eg. "."
+  fsChar m_currencyPrefix[MAX_SYMBOL];            // Before currency values, eg. "$"
+  fsChar m_currencySuffix[MAX_SYMBOL];            // After currency values, eg. " €"
+  fsUInt8 m_groupSeparatorLength;                 // Bytes
+  fsUInt8 m_groupSeparatorWidth;                  // Width units (see FS_UTF8_MODE), for alignment
+  fsUInt8 m_decimalSeparatorLength;
+  fsUInt8 m_decimalSeparatorWidth;
+  fsUInt8 m_currencyPrefixLength;
+  fsUInt8 m_currencySuffixLength;
+
+  // Default invariant profile "1,234.50" and "$1,234.50"
+  NumberFormatProfile();
+
+  // Symbols are UTF-8 and truncated to MAX_SYMBOL - 1 bytes
+  NumberFormatProfile(const fsChar* a_groupSeparator, const fsChar* a_decimalSeparator,
+                      const fsChar* a_currencyPrefix, const fsChar* a_currencySuffix);
+
+  void Set(const fsChar* a_groupSeparator, const fsChar* a_decimalSeparator,
+           const fsChar* a_currencyPrefix, const fsChar* a_currencySuffix);
+};
+
+
+class NumberFormat
+{
+public:
+
+  enum
+  {
+    MAX_GROUPED_CHARS = 20 + 6 * (NumberFormatProfile::MAX_SYMBOL - 1), // Longest 64bit grouped output
+    MAX_CONVERT_CHARS_128 = 128,                                          // Longest 128bit output, binary or grouped
+    MAX_FLOAT32_DIGITS = 9,                                               // Longest shortest decimal of a float32
+    MAX_FLOAT32_FIXED_CHARS = 39 + 13 * (NumberFormatProfile::MAX_SYMBOL - 1) + 54, // Grouped 3.4e38, or 53 fraction digits
+    MAX_FLOAT32_GENERAL_CHARS = 24,                                       // Longest WriteFloat32General() output
+    HEX_FLOAT64_DIGITS = 13,                                              // Fraction hex digits of a float64, 52 bits
+    MAX_HEX_FLOAT64_CHARS = 23,                                           // "0x1.fffffffffffffp+1023"
+    MAX_DECIMAL64_SCALE = 18,                                             // Largest fixed point decimal scale, 10^18 fits 63 bits
+    MAX_DECIMAL64_FIXED_CHARS = 38 + 13 * (NumberFormatProfile::MAX_SYMBOL - 1) + 18, // Grouped 2^64 * 10^18, or 18 fraction digits
+  };
+
+  // Profile used by FormatString and FormatStringF. Pass NULL to restore the default.
+  // NOTE: Profile is referenced, not copied. Set up before formatting on other threads.
+  static void SetProfile(const NumberFormatProfile* a_profile);
+  static const NumberFormatProfile& GetProfile()  { return *s_profile; }
+
+  // Write a_value with group separators in one forward pass, not terminated. Returns bytes written,
+  // a_dest must hold MAX_GROUPED_CHARS. Optionally returns width in units for alignment.
+  static size_t WriteGrouped(fsChar* a_dest, fsUInt64 a_value, const NumberFormatProfile& a_profile, fsInt* a_width = NULL);
+
+  // Bytes WriteGrouped() would write, without writing
+  static size_t GroupedLength(fsUInt64 a_value, const NumberFormatProfile& a_profile, fsInt* a_width = NULL);
+
+  // Write a_value in base 2, 8 or 16 (a_bitsPerDigit 1, 3 or 4) in one forward pass, not terminated.
+  // Returns bytes written, a_dest must hold 64 chars.
+  static fsInt WritePow2(fsChar* a_dest, fsUInt64 a_value, fsInt a_bitsPerDigit, fsBool a_upperCase);
+
+  // Digits WritePow2() would write, from the count of leading zero bits
+  static fsInt Pow2Length(fsUInt64 a_value, fsInt a_bitsPerDigit)
+  {
+    return (64 - CountLeadingZeros(a_value | 1) + a_bitsPerDigit - 1) / a_bitsPerDigit;
+  }
+
+  // Leading zero bits of a non-zero value
+  static fsInt CountLeadingZeros(fsUInt64 a_value);
+
+  // Write a_value in decimal, two digits per division, not terminated. Returns bytes written, a_dest must hold 20 chars.
+  static fsInt WriteDecimal(fsChar* a_dest, fsUInt64 a_value);
+
+  // Decimal digits of a_value
+  static fsInt DecimalLength(fsUInt64 a_value);
+
+#if FS_HAS_INT128
+  // 128bit versions, a_dest must hold MAX_CONVERT_CHARS_128. Decimal is converted in chunks of 19 digits
+  // (10^19 fits 64 bits), so a full width value costs about two 64bit conversions.
+  static fsInt WriteDecimal128(fsChar* a_dest, fsUInt128 a_value);
+  static size_t WriteGrouped128(fsChar* a_dest, fsUInt128 a_value, const NumberFormatProfile& a_profile, fsInt* a_width = NULL);
+  static fsInt WritePow2_128(fsChar* a_dest, fsUInt128 a_value, fsInt a_bitsPerDigit, fsBool a_upperCase);
+  static fsInt Pow2Length128(fsUInt128 a_value, fsInt a_bitsPerDigit);
+#endif // FS_HAS_INT128
+
+  // Shortest decimal a_digits * 10^a_exponent that reads back as |a_value|, the closest if several, found in
+  // 32 / 64bit integer arithmetic (Ryu). a_value must be finite. Returns the number of digits, 1 to MAX_FLOAT32_DIGITS.
+  static fsInt ShortestFloat32(fsFloat32 a_value, fsUInt32* a_digits, fsInt* a_exponent);
+
+  // Write |a_value| in fixed point to a_precision fraction digits, so a float shows no digits beyond its precision (0.1f
+  // is "0.100000", not "0.100000001"). The shortest decimal is used when it fits a_precision, otherwise the exact value
+  // is rounded half up (2.675f is 2.67499995, so "2.67"), never the shortest decimal. Not terminated. Zero fraction digits
+  // past the shortest decimal are not written, a_fractionDigits returns the number written and the caller pads to
+  // a_precision. Grouped with a_profile separators if not NULL. Returns bytes written, a_dest must hold
+  // MAX_FLOAT32_FIXED_CHARS. Optionally returns width in units for alignment.
+  static size_t WriteFloat32Fixed(fsChar* a_dest, fsFloat32 a_value, fsInt a_precision, const NumberFormatProfile* a_profile,
+                                  fsInt* a_fractionDigits, fsInt* a_width = NULL);
+
+  // Write |a_value| as its shortest decimal in the FormatString general style: integers below 10^18 as integers,
+  // "1.5e-7" below 0.00001 and from 10000, else fixed point. Not terminated. Returns bytes written, a_dest must hold
+  // MAX_FLOAT32_GENERAL_CHARS.
+  static size_t WriteFloat32General(fsChar* a_dest, fsFloat32 a_value, fsBool a_upperCase);
+
+  // Write |a_value| as a C99 hexadecimal float, "0x1.8p+1", the digits and exponent taken straight from the IEEE bits so
+  // it reads back exactly. Subnormals are written "0x0.8p-1022". a_precision fraction digits rounded half to even, up to
+  // HEX_FLOAT64_DIGITS (the caller pads zeros past that), or if negative all digits with trailing zeros dropped.
+  // a_value must be finite. Not terminated. Returns bytes written, a_dest must hold MAX_HEX_FLOAT64_CHARS.
+  static size_t WriteHexFloat64(fsChar* a_dest, fsFloat64 a_value, fsInt a_precision, fsBool a_upperCase);
+
+  // Read a C99 hexadecimal float from at most a_maxLength chars: optional sign, "0x", hex digits with an optional point,
+  // optional binary exponent "p-3". Rounded half to even in integer arithmetic, no strtod(). Returns chars read, 0 if
+  // a_str does not start with a hexadecimal float.
+  static size_t ReadHexFloat64(const fsChar* a_str, size_t a_maxLength, fsFloat64* a_value);
+
+  // Write a fixed point decimal a_units * 10^-a_scale (a_scale -MAX_DECIMAL64_SCALE to MAX_DECIMAL64_SCALE) in fixed point
+  // rounded half up to a_precision fraction digits, in integer arithmetic so the digits are exact. As WriteFloat32Fixed(),
+  // fraction digits past a_scale are not written, a_fractionDigits returns the number written and the caller pads to
+  // a_precision. Not terminated. Returns bytes written, a_dest must hold MAX_DECIMAL64_FIXED_CHARS.
+  static size_t WriteDecimal64Fixed(fsChar* a_dest, fsUInt64 a_units, fsInt a_scale, fsInt a_precision, const NumberFormatProfile* a_profile,
+                                    fsInt* a_fractionDigits, fsInt* a_width = NULL);
+
+  // Read a decimal number from at most a_maxLength chars: optional sign, digits with an optional point, optional exponent
+  // "e-3", as units of 10^-a_scale (a_scale 0 to MAX_DECIMAL64_SCALE) rounded half up, without floating point. Out of range
+  // values saturate. Returns chars read, 0 if a_str does not start with a number.
+  static size_t ReadDecimal64(const fsChar* a_str, size_t a_maxLength, fsInt a_scale, fsInt64* a_units);
+
+  // "00" .. "99" lookup, two chars per value
+  static const fsChar* DigitPairs()               { return s_digitPairs; }
+
+protected:
+
+  static const NumberFormatProfile* s_profile;
+  static const NumberFormatProfile s_defaultProfile;
+  static const fsChar s_digitPairs[201];
+};
+
+END_NAMESPACE_FORMATSTRINGLIB
+
+#endif //NUMBERFORMAT_H
@@ -10,13 +10,24 @@
 // Use at your own risk, based on FOSS code, please observe any replicated copyright notices.
 //
 
-#include <iostream> // For standard library string functions
+#include <ctype.h>
+#include <stdio.h> // For EOF
+#include <stdlib.h>
+#include <string.h>
 #include "ScanStringF.h"
+#include "FormatRecorder.h"
+#include "FormatTelemetry.h"
+#include "NumberFormat.h"
 
 //
 // Uses standard library functions: isdigit, isspace, memchr, strtol, strtoul, strtod
 //
 
+#ifndef _MSC_VER
+#define _strtoi64 strtoll
+#define _strtoui64 strtoull
+#endif // _MSC_VER
+
 #define SCANSTRING_USE_PARSER 0    // Enable to use our parser instead of standard or extended library functions
 #if SCANSTRING_USE_PARSER
 #include "Lexer.h"
@@ -24,7 +35,58 @@
 
 BEGIN_NAMESPACE_FORMATSTRINGLIB
 
-fsInt ScanStringF(const fsChar* a_string, const fsChar* a_format, ArgList& a_args)
+#if FS_HAS_INT128
+// Parse integer digits as 128bit, negative values are two's complement. Base 0 is decimal.
+// Digits are accumulated 15 at a time in 64bit before scaling the 128bit total.
+static fsUInt128 parse_uint128(const fsChar* a_str, fsInt a_base)
+{
+  fsBool negative = false;
+  if( *a_str == '+' || *a_str == '-' )
+  {
+    negative = (*a_str == '-');
+    ++a_str;
+  }
+  if( a_base == 0 )
+  {
+    a_base = 10;
+  }
+  if( (a_base == 16) && (a_str[0] == '0') && ((a_str[1] == 'x') || (a_str[1] == 'X')) )
+  {
+    a_str += 2;
+  }
+
+  fsUInt128 value = 0;
+  for( ;; )
+  {
+    fsUInt64 chunk = 0;
+    fsUInt64 scale = 1;
+    for( fsInt chunkDigits = 0; chunkDigits < 15; ++chunkDigits ) // 16^15 and 10^18 both fit 64 bits
+    {
+      fsInt digit;
+      if( (*a_str >= '0') && (*a_str <= '9') )      { digit = *a_str - '0'; }
+      else if( (*a_str >= 'a') && (*a_str <= 'f') ) { digit = *a_str - 'a' + 10; }
+      else if( (*a_str >= 'A') && (*a_str <= 'F') ) { digit = *a_str - 'A' + 10; }
+      else                                          { break; }
+      if( digit >= a_base )
+      {
+        break;
+      }
+      chunk = chunk * a_base + digit;
+      scale *= a_base;
+      ++a_str;
+    }
+    if( scale == 1 )
+    {
+      break;
+    }
+    value = value * scale + chunk;
+  }
+  return negative ? (0 - value) : value;
+}
+#endif // FS_HAS_INT128
+
+
+static fsInt scan_string_f(const fsChar* a_string, const fsChar* a_format, ArgList& a_args)
 {
 #if SCANSTRING_USE_PARSER
   Lexer parser(LF_NoErrors | LF_NoStringConcat | LF_NoStringEscapeChars | LF_NoDefines); // Parser for numeric types
@@ -128,6 +190,14 @@ fsInt ScanStringF(const fsChar* a_string, const fsChar* a_format, ArgList& a_arg
           *curBuf = '\0';
           if( doConvert )
           {
+            Arg& arg = a_args.GetNext();
+#if FS_HAS_INT128
+            if( (arg.m_type == Arg::ARG_TYPE_INT128_PTR) || (arg.m_type == Arg::ARG_TYPE_UINT128_PTR) ) // Full width
+            {
+              arg.WriteAsUInt128(parse_uint128(buffer, base));
+            }
+            else
+#endif // FS_HAS_INT128
             if( *format == 'd' || *format == 'i' )
             {
 #if SCANSTRING_USE_PARSER
@@ -138,7 +208,7 @@ fsInt ScanStringF(const fsChar* a_string, const fsChar* a_format, ArgList& a_arg
               fsInt64 data = _strtoi64(buffer, NULL, base);    // String to int64
 #endif //SCANSTRING_USE_PARSER
 
-              a_args.GetNext().WriteAsInt64(data);
+              arg.WriteAsInt64(data);
             }
             else
             {
@@ -150,14 +220,14 @@ fsInt ScanStringF(const fsChar* a_string, const fsChar* a_format, ArgList& a_arg
               fsUInt64 data = _strtoui64(buffer, NULL, base);      // String to uint64
 #endif //SCANSTRING_USE_PARSER
 
-              a_args.GetNext().WriteAsUInt64(data);
+              arg.WriteAsUInt64(data);
             }
             ++convertedCount;
           }
           break;
         }
  
-        case 'e': case 'E': case 'f': case 'g': case 'G': 
+        case 'e': case 'E': case 'f': case 'g': case 'G': case 'a': case 'A':
         {
           // Handle floating point numbers
           fsChar *curBuf = buffer;
@@ -166,6 +236,37 @@ fsInt ScanStringF(const fsChar* a_string, const fsChar* a_format, ArgList& a_arg
           {
             width = MAX_BUFFER;
           }
+
+          // Fixed point decimals read as integer units of their scale, without floating point
+          Arg& target = doConvert ? a_args.GetNext() : Arg::s_null;
+          if( target.m_type == Arg::ARG_TYPE_DECIMAL64_PTR )
+          {
+            fsInt scale = target.m_valueDecimal64Ptr.m_scale;
+            scale = (scale < 0) ? 0 : (scale > NumberFormat::MAX_DECIMAL64_SCALE) ? (fsInt)NumberFormat::MAX_DECIMAL64_SCALE : scale;
+            size_t decimalLength = NumberFormat::ReadDecimal64(string, width, scale, target.m_valueDecimal64Ptr.m_units);
+            if( decimalLength == 0 )
+            {
+              return FAIL_CODE;
+            }
+            string += decimalLength;
+            ++convertedCount;
+            break;
+          }
+
+          // Hexadecimal floats ("0x1.8p+1") convert exactly from their digits, without strtod()
+          fsFloat64 hexValue;
+          size_t hexLength = NumberFormat::ReadHexFloat64(string, width, &hexValue);
+          if( hexLength > 0 )
+          {
+            string += hexLength;
+            if( doConvert )
+            {
+              target.WriteAsFloat64(hexValue);
+              ++convertedCount;
+            }
+            break;
+          }
+
           if( width && (*string == '+' || *string == '-') )
           {
             *curBuf++ = *string++; --width;
@@ -213,7 +314,7 @@ fsInt ScanStringF(const fsChar* a_string, const fsChar* a_format, ArgList& a_arg
             fsFloat64 data = strtod(buffer, NULL);      // String to float32
 #endif //SCANSTRING_USE_PARSER
 
-            a_args.GetNext().WriteAsFloat64(data);
+            target.WriteAsFloat64(data);
 
             ++convertedCount;
           }
@@ -402,4 +503,25 @@ fsInt ScanStringF(const fsChar* a_string, const fsChar* a_format, ArgList& a_arg
 }
 
 
+fsInt ScanStringF(const fsChar* a_string, const fsChar* a_format, ArgList& a_args)
+{
+#if FS_RECORDER
+  if( FormatRecorder::IsRecording() )
+  {
+    FormatRecorder::Sample(BinaryLog::SYNTAX_SCAN, a_format, 0, a_string, a_args);
+  }
+#endif // FS_RECORDER
+#if FS_TELEMETRY
+  if( FormatTelemetry::IsEnabled() )
+  {
+    fsUInt64 start = FormatTelemetry::Now();
+    fsInt result = scan_string_f(a_string, a_format, a_args);
+    FormatTelemetry::Record(a_format, FormatTelemetry::FUNCTION_SCAN_STRING_F, start, 0, false, (result == EOF) || (result < a_args.Count()));
+    return result;
+  }
+#endif // FS_TELEMETRY
+  return scan_string_f(a_string, a_format, a_args);
+}
+
+
 END_NAMESPACE_FORMATSTRINGLIB
\ No newline at end of file
@@ -15,6 +15,8 @@
 // Supported format types:
 //   d/i = Decimal integer
 //   e/E/f/F/g/G = Floating point real number with optional sign and exponent
+//   a/A = Same as the above. Any of them also read hexadecimal floats ("0x1.8p+1", see %a in FormatStringF.h), exactly
+//         Into a Decimal64Ptr (see Arg.h) they read a decimal as integer units of its scale, exactly, without floating point
 //   x/X = Hexadecimal integer
 //   u = Unsigned decimal integer
 //   o = Unsigned octol integer
@@ -0,0 +1,221 @@
+//
+// Utf8.cpp
+// UTF-8 code point counting for string width and precision
+//
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#define UTF8_USE_SSE2 1
+#include <emmintrin.h>
+#endif
+#if defined(__AVX2__)
+#define UTF8_USE_AVX2 1
+#include <immintrin.h>
+#endif
+
+#include "Utf8.h"
+
+BEGIN_NAMESPACE_FORMATSTRINGLIB
+
+static inline fsInt popcount32(fsUInt32 a_bits)
+{
+  a_bits = a_bits - ((a_bits >> 1) & 0x55555555);
+  a_bits = (a_bits & 0x33333333) + ((a_bits >> 2) & 0x33333333);
+  return (fsInt)((((a_bits + (a_bits >> 4)) & 0x0F0F0F0F) * 0x01010101) >> 24);
+}
+
+
+static inline bool is_continuation(fsUInt8 a_byte)
+{
+  return (a_byte & 0xC0) == 0x80;
+}
+
+
+// Decode code point at a_str. Returns bytes used, invalid sequences decode as one byte.
+static size_t decode(const fsUInt8* a_str, size_t a_numBytes, fsUInt32* a_codePoint)
+{
+  fsUInt8 lead = a_str[0];
+  size_t length;
+  fsUInt32 codePoint;
+  if( lead < 0x80 )                   { *a_codePoint = lead; return 1; }
+  else if( (lead & 0xE0) == 0xC0 )    { length = 2; codePoint = lead & 0x1F; }
+  else if( (lead & 0xF0) == 0xE0 )    { length = 3; codePoint = lead & 0x0F; }
+  else if( (lead & 0xF8) == 0xF0 )    { length = 4; codePoint = lead & 0x07; }
+  else                                { *a_codePoint = lead; return 1; }
+
+  if( length > a_numBytes )
+  {
+    *a_codePoint = lead;
+    return 1;
+  }
+  for( size_t index = 1; index < length; ++index )
+  {
+    if( !is_continuation(a_str[index]) )
+    {
+      *a_codePoint = lead;
+      return 1;
+    }
+    codePoint = (codePoint << 6) | (a_str[index] & 0x3F);
+  }
+  *a_codePoint = codePoint;
+  return length;
+}
+
+
+fsInt Utf8::DisplayWidth(fsUInt32 a_codePoint)
+{
+  if( a_codePoint < 0x300 )
+  {
+    return 1;
+  }
+  // Combining marks
+  if( ((a_codePoint >= 0x0300) && (a_codePoint <= 0x036F)) ||
+      ((a_codePoint >= 0x1AB0) && (a_codePoint <= 0x1AFF)) ||
+      ((a_codePoint >= 0x1DC0) && (a_codePoint <= 0x1DFF)) ||
+      ((a_codePoint >= 0x200B) && (a_codePoint <= 0x200F)) ||
+      ((a_codePoint >= 0x20D0) && (a_codePoint <= 0x20FF)) ||
+      ((a_codePoint >= 0xFE00) && (a_codePoint <= 0xFE0F)) ||
+      ((a_codePoint >= 0xFE20) && (a_codePoint <= 0xFE2F)) )
+  {
+    return 0;
+  }
+  // East Asian wide and full width
+  if( ((a_codePoint >= 0x1100) && (a_codePoint <= 0x115F)) ||
+      ((a_codePoint >= 0x2E80) && (a_codePoint <= 0xA4CF) && (a_codePoint != 0x303F)) ||
+      ((a_codePoint >= 0xAC00) && (a_codePoint <= 0xD7A3)) ||
+      ((a_codePoint >= 0xF900) && (a_codePoint <= 0xFAFF)) ||
+      ((a_codePoint >= 0xFE30) && (a_codePoint <= 0xFE4F)) ||
+      ((a_codePoint >= 0xFF00) && (a_codePoint <= 0xFF60)) ||
+      ((a_codePoint >= 0xFFE0) && (a_codePoint <= 0xFFE6)) ||
+      ((a_codePoint >= 0x1F300) && (a_codePoint <= 0x1F64F)) ||
+      ((a_codePoint >= 0x1F900) && (a_codePoint <= 0x1F9FF)) ||
+      ((a_codePoint >= 0x20000) && (a_codePoint <= 0x3FFFD)) )
+  {
+    return 2;
+  }
+  return 1;
+}
+
+
+size_t Utf8::Prefix(const fsChar* a_str, size_t a_numBytes, fsInt a_maxUnits, fsInt a_unit, size_t* a_numUnits)
+{
+  const fsUInt8* str = (const fsUInt8*)a_str;
+  size_t maxUnits = (a_maxUnits < 0) ? (size_t)-1 : (size_t)a_maxUnits;
+  size_t pos = 0;
+  size_t units = 0;
+
+  if( a_unit == UNIT_BYTES )
+  {
+    pos = (a_numBytes < maxUnits) ? a_numBytes : maxUnits;
+    if( a_numUnits )
+    {
+      *a_numUnits = pos;
+    }
+    return pos;
+  }
+
+  while( pos < a_numBytes )
+  {
+#if UTF8_USE_AVX2
+    if( pos + 32 <= a_numBytes )
+    {
+      __m256i block = _mm256_loadu_si256((const __m256i*)(str + pos));
+      fsUInt32 nonAscii = (fsUInt32)_mm256_movemask_epi8(block);
+      if( nonAscii == 0 )
+      {
+        if( units + 32 <= maxUnits )
+        {
+          units += 32;
+          pos += 32;
+          continue;
+        }
+      }
+      else if( a_unit == UNIT_CODE_POINTS )
+      {
+        // Continuation bytes 0x80..0xBF are the signed bytes below -64
+        fsUInt32 continuation = (fsUInt32)_mm256_movemask_epi8(_mm256_cmpgt_epi8(_mm256_set1_epi8(-64), block));
+        size_t codePoints = 32 - popcount32(continuation);
+        if( units + codePoints <= maxUnits )
+        {
+          units += codePoints;
+          pos += 32;
+          continue;
+        }
+      }
+    }
+#endif // UTF8_USE_AVX2
+#if UTF8_USE_SSE2
+    if( pos + 16 <= a_numBytes )
+    {
+      __m128i block = _mm_loadu_si128((const __m128i*)(str + pos));
+      fsUInt32 nonAscii = (fsUInt32)_mm_movemask_epi8(block);
+      if( nonAscii == 0 )
+      {
+        if( units + 16 <= maxUnits )
+        {
+          units += 16;
+          pos += 16;
+          continue;
+        }
+      }
+      else if( a_unit == UNIT_CODE_POINTS )
+      {
+        fsUInt32 continuation = (fsUInt32)_mm_movemask_epi8(_mm_cmplt_epi8(block, _mm_set1_epi8(-64)));
+        size_t codePoints = 16 - popcount32(continuation);
+        if( units + codePoints <= maxUnits )
+        {
+          units += codePoints;
+          pos += 16;
+          continue;
+        }
+      }
+    }
+#else // UTF8_USE_SSE2
+    if( pos + 8 <= a_numBytes ) // Portable ASCII check 8 bytes at a time
+    {
+      fsUInt64 word = 0;
+      for( size_t index = 0; index < 8; ++index )
+      {
+        word |= (fsUInt64)str[pos + index] << (index * 8);
+      }
+      if( ((word & 0x8080808080808080ULL) == 0) && (units + 8 <= maxUnits) )
+      {
+        units += 8;
+        pos += 8;
+        continue;
+      }
+    }
+#endif // UTF8_USE_SSE2
+
+    // One code point at a time, stopping before the code point that would exceed the limit
+    size_t length = 1;
+    size_t width;
+    if( str[pos] < 0x80 )
+    {
+      width = 1;
+    }
+    else if( a_unit == UNIT_CODE_POINTS )
+    {
+      width = is_continuation(str[pos]) ? 0 : 1; // Block counting may resume mid code point
+    }
+    else
+    {
+      fsUInt32 codePoint;
+      length = decode(str + pos, a_numBytes - pos, &codePoint);
+      width = (length == 1 && str[pos] >= 0x80) ? 1 : DisplayWidth(codePoint);
+    }
+    if( units + width > maxUnits )
+    {
+      break;
+    }
+    units += width;
+    pos += length;
+  }
+
+  if( a_numUnits )
+  {
+    *a_numUnits = units;
+  }
+  return pos;
+}
+
+END_NAMESPACE_FORMATSTRINGLIB
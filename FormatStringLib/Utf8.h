@@ -0,0 +1,53 @@
+#ifndef UTF8_H
+#define UTF8_H
+
+//
+// Utf8.h
+// UTF-8 code point counting for string width and precision
+//
+
+#include <stddef.h>
+#include "Utils.h"
+
+// Unit of string width (alignment) and precision in FormatString and FormatStringF:
+//   0 = bytes (default, as snprintf, so "%.8s" never outputs more than 8 bytes)
+//   1 = UTF-8 code points, precision never splits a code point
+//   2 = UTF-8 display columns (East Asian wide chars count 2, combining marks 0)
+// NOTE: With 1 or 2 a precision no longer bounds the bytes written, a field of N code points may be up to 4N bytes.
+#ifndef FS_UTF8_MODE
+#define FS_UTF8_MODE 0
+#endif // FS_UTF8_MODE
+
+BEGIN_NAMESPACE_FORMATSTRINGLIB
+
+class Utf8
+{
+public:
+
+  enum Unit
+  {
+    UNIT_BYTES = 0,
+    UNIT_CODE_POINTS = 1,
+    UNIT_COLUMNS = 2,
+  };
+
+  // Length in bytes of the longest prefix of a_str (a_numBytes long) that is at most a_maxUnits units,
+  // ending on a code point boundary. a_maxUnits < 0 for no limit. Optionally returns units in the prefix.
+  // Pure ASCII is detected 16 (or 32 with AVX2) bytes at a time.
+  static size_t Prefix(const fsChar* a_str, size_t a_numBytes, fsInt a_maxUnits, fsInt a_unit, size_t* a_numUnits);
+
+  // Number of code points in a_str (a_numBytes long)
+  static size_t CountCodePoints(const fsChar* a_str, size_t a_numBytes)
+  {
+    size_t numUnits;
+    Prefix(a_str, a_numBytes, -1, UNIT_CODE_POINTS, &numUnits);
+    return numUnits;
+  }
+
+  // Display columns of a code point, 0, 1 or 2
+  static fsInt DisplayWidth(fsUInt32 a_codePoint);
+};
+
+END_NAMESPACE_FORMATSTRINGLIB
+
+#endif //UTF8_H
@@ -54,13 +54,22 @@
   typedef size_t                fsSizeT;                  ///< Size type for memory related sizes, unsigned, at least 32 bits (Usually the same as size_t)
 #endif
 
-#ifdef _M_X64
+// 128bit integers where the compiler provides them (GCC, Clang)
+#if defined(__SIZEOF_INT128__)
+  #define FS_HAS_INT128 1
+  typedef unsigned __int128     fsUInt128;                ///< 128bit unsigned integer
+  typedef signed __int128       fsInt128;                 ///< 128bit signed integer
+#else // __SIZEOF_INT128__
+  #define FS_HAS_INT128 0
+#endif // __SIZEOF_INT128__
+
+#if defined(_M_X64) || defined(_WIN64) || (defined(__SIZEOF_POINTER__) && (__SIZEOF_POINTER__ == 8)) // 64bit pointers
   typedef fsUInt64              fsUIntPtr;                ///< UInt same size as void* for pointer math or machine int. (NOTE: This is Data pointer size, Function and Member Function pointers may vary.)
   typedef fsInt64               fsIntPtr;                 ///< Int same size as void* pointer math or machine int.  (Used for pointer difference calcs eg. where ptrdiff_t would be used)
-#else // _M_X64
+#else // 64bit pointers
   typedef fsUInt32              fsUIntPtr;                ///< UInt same size as void* for pointer math or machine int. (NOTE: This is Data pointer size, Function and Member Function pointers may vary.)
   typedef fsInt32               fsIntPtr;                 ///< Int same size as void* pointer math or machine int.
-#endif //_M_X64
+#endif // 64bit pointers
 
 
 // Is float Not-A-Number (Produced by invalid operation or invalid float encoding)
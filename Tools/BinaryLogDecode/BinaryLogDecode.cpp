@@ -0,0 +1,66 @@
+//
+// BinaryLogDecode.cpp
+// Standalone decoder, renders a binary log file (see BinaryLog.h) to text
+//
+// Usage: BinaryLogDecode <logfile> [-t]
+//   -t  Prefix each line with the record timestamp
+//
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+
+#include "../../FormatStringLib/BinaryLog.h"
+
+USING_NAMESPACE_FORMATSTRINGLIB
+
+int main(int argc, char* argv[])
+{
+  if( argc < 2 )
+  {
+    fprintf(stderr, "Usage: %s <logfile> [-t]\n", argv[0]);
+    return 1;
+  }
+
+  bool showTimestamps = (argc > 2) && (strcmp(argv[2], "-t") == 0);
+
+  BinaryLogReader reader;
+  if( !reader.OpenFile(argv[1]) )
+  {
+    fprintf(stderr, "Failed to open '%s'\n", argv[1]);
+    return 1;
+  }
+
+  size_t lineSize = 4096;
+  char* line = (char*)malloc(lineSize);
+  BinaryLogMessage message;
+  while( line && reader.ReadNext(message) )
+  {
+    fsInt length = reader.Render(message, line, lineSize);
+    if( length >= (fsInt)lineSize ) // Grow and render again rather than truncate
+    {
+      lineSize = length + 1;
+      char* newLine = (char*)realloc(line, lineSize);
+      if( !newLine )
+      {
+        break;
+      }
+      line = newLine;
+      reader.Render(message, line, lineSize);
+    }
+
+    if( showTimestamps )
+    {
+      printf("%llu ", (unsigned long long)message.m_timestamp);
+    }
+    printf("%s\n", line);
+  }
+  free(line);
+
+  if( reader.IsCorrupt() )
+  {
+    fprintf(stderr, "Stopped at malformed record\n");
+    return 2;
+  }
+  return 0;
+}
@@ -0,0 +1,115 @@
+//
+// FormatCatalogBuild.cpp
+// Standalone builder, compiles a list of format strings into a catalog file (see FormatCatalog.h)
+//
+// Usage: FormatCatalogBuild <listfile> <catalogfile> [--braced | --printf]
+//   --braced  Lines without a prefix are FormatString formats (default)
+//   --printf  Lines without a prefix are FormatStringF formats
+//
+// The list has one format per line. A "braced:" or "printf:" prefix selects the syntax of that line,
+// lines starting with '#' and empty lines are skipped, and \n \t \\ in a format are unescaped.
+//
+
+#include <stdio.h>
+#include <string.h>
+#include <string>
+
+#include "../../FormatStringLib/FormatCatalog.h"
+
+USING_NAMESPACE_FORMATSTRINGLIB
+
+// Replace \n \t \\ escapes, others are kept as written
+static std::string unescape(const char* a_text)
+{
+  std::string text;
+  for( const char* pos = a_text; *pos; ++pos )
+  {
+    if( (pos[0] == '\\') && (pos[1] == 'n') )       { text += '\n'; ++pos; }
+    else if( (pos[0] == '\\') && (pos[1] == 't') )  { text += '\t'; ++pos; }
+    else if( (pos[0] == '\\') && (pos[1] == '\\') ) { text += '\\'; ++pos; }
+    else                                            { text += *pos; }
+  }
+  return text;
+}
+
+
+int main(int argc, char* argv[])
+{
+  if( argc < 3 )
+  {
+    fprintf(stderr, "Usage: %s <listfile> <catalogfile> [--braced | --printf]\n", argv[0]);
+    return 1;
+  }
+
+  CompiledFormat::Syntax defaultSyntax = CompiledFormat::SYNTAX_BRACED;
+  if( argc > 3 )
+  {
+    if( strcmp(argv[3], "--printf") == 0 )
+    {
+      defaultSyntax = CompiledFormat::SYNTAX_PRINTF;
+    }
+    else if( strcmp(argv[3], "--braced") != 0 )
+    {
+      fprintf(stderr, "Unknown option '%s'\n", argv[3]);
+      return 1;
+    }
+  }
+
+  FILE* list = fopen(argv[1], "rb");
+  if( !list )
+  {
+    fprintf(stderr, "Failed to open '%s'\n", argv[1]);
+    return 1;
+  }
+
+  FormatCatalogWriter writer;
+  int numRejected = 0;
+  int lineNumber = 0;
+  std::string line;
+  int ch = 0;
+  while( ch != EOF )
+  {
+    line.clear();
+    while( ((ch = fgetc(list)) != EOF) && (ch != '\n') )
+    {
+      line += (char)ch;
+    }
+    ++lineNumber;
+    if( !line.empty() && (line[line.size() - 1] == '\r') )
+    {
+      line.erase(line.size() - 1);
+    }
+    if( line.empty() || (line[0] == '#') )
+    {
+      continue;
+    }
+
+    CompiledFormat::Syntax syntax = defaultSyntax;
+    const char* format = line.c_str();
+    if( strncmp(format, "braced:", 7) == 0 )
+    {
+      syntax = CompiledFormat::SYNTAX_BRACED;
+      format += 7;
+    }
+    else if( strncmp(format, "printf:", 7) == 0 )
+    {
+      syntax = CompiledFormat::SYNTAX_PRINTF;
+      format += 7;
+    }
+
+    if( writer.Add(unescape(format).c_str(), syntax) < 0 )
+    {
+      fprintf(stderr, "%s(%d): can not compile '%s'\n", argv[1], lineNumber, format);
+      ++numRejected;
+    }
+  }
+  fclose(list);
+
+  if( !writer.Save(argv[2]) )
+  {
+    fprintf(stderr, "Failed to write '%s'\n", argv[2]);
+    return 1;
+  }
+  printf("%d formats, %d bytes\n", writer.GetNumFormats(), (int)writer.GetSize());
+  return (numRejected > 0) ? 2 : 0;
+}